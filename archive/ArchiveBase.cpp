@@ -3,12 +3,34 @@
 #include "parsers/DBParser.h"
 #include "parsers/SCSPParser.h"
 #include "core/Logger.h"
+#include "DedupeIndex.h"
 #include <filesystem>
 #include <fstream>
 #include <algorithm>
 #include <iostream>
 #include <functional>
 #include <variant>
+#include <memory>
+#include <optional>
+#include <thread>
+
+namespace
+{
+    // Publishes the outcome of a dedupe claim even when conversion throws,
+    // so duplicates waiting on it are never left blocked.
+    struct DedupeClaim
+    {
+        DedupeIndex* index = nullptr;
+        DedupeIndex::Key key;
+        std::string written_path;
+
+        ~DedupeClaim()
+        {
+            if (index)
+                index->Publish(key, written_path);
+        }
+    };
+}
 
 ArchiveBase::ArchiveBase()
 {
@@ -162,20 +184,21 @@ void ArchiveBase::ExtractAll(const std::wstring& output_path, std::atomic<float>
 
 void ArchiveBase::Extract(const Core::FileNode& node, const std::wstring& output_path, std::atomic<float>& progress, bool convert_sct_to_png, bool convert_db_to_json)
 {
+    DirectorySink sink(output_path);
+    ExtractOptions options;
+    options.convert_sct_to_png = convert_sct_to_png;
+    options.convert_db_to_json = convert_db_to_json;
+    Extract(node, sink, progress, options);
+}
+
+void ArchiveBase::Extract(const Core::FileNode& node, IOutputSink& sink, std::atomic<float>& progress, const ExtractOptions& options)
+{
+    std::vector<ExtractJob> jobs;
+    CollectFiles(node, "", jobs);
+
     uint64_t total_size_to_extract = 0;
-    std::function<void(const Core::FileNode&)> F = [&](const Core::FileNode& n)
-    {
-        if (std::holds_alternative<Core::FileInfo>(n.data))
-        {
-            total_size_to_extract += std::get<Core::FileInfo>(n.data).size;
-        }
-        else if (std::holds_alternative<Core::FolderInfo>(n.data))
-        {
-            for (const auto& child : std::get<Core::FolderInfo>(n.data).children)
-                F(child);
-        }
-    };
-    F(node);
+    for (const auto& job : jobs)
+        total_size_to_extract += std::get<Core::FileInfo>(job.node->data).size;
 
     if (total_size_to_extract == 0)
     {
@@ -183,143 +206,216 @@ void ArchiveBase::Extract(const Core::FileNode& node, const std::wstring& output
         return;
     }
     std::atomic<uint64_t> extracted_size = 0;
-    LogInfo("Extract begin for node");
-    ExtractNode(node, output_path, extracted_size, total_size_to_extract, progress, convert_sct_to_png, convert_db_to_json);
+    std::unique_ptr<DedupeIndex> dedupe;
+    if (options.deduplicate)
+        dedupe = std::make_unique<DedupeIndex>();
+
+    unsigned int thread_count = options.threads;
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    thread_count = static_cast<unsigned int>(std::min<size_t>(thread_count, jobs.size()));
+
+    LogInfo("Extract begin for node: " + std::to_string(jobs.size()) + " files, " + std::to_string(thread_count) + " threads");
+    std::atomic<size_t> next_job{0};
+    auto worker = [&]()
+    {
+        for (size_t i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1))
+            ExtractFile(*jobs[i].node, jobs[i].parent_path, sink, dedupe.get(), extracted_size, total_size_to_extract, progress, options);
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < thread_count; ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+
     progress = 1.0f;
+    if (dedupe)
+    {
+        LogInfo("Dedupe: " + std::to_string(dedupe->GetAliasCount()) + " duplicate files aliased, " +
+                std::to_string(dedupe->GetBytesSaved()) + " source bytes skipped");
+    }
     LogInfo("Extract end for node");
 }
 
-void ArchiveBase::ExtractNode(const Core::FileNode& node, const std::wstring& current_path, std::atomic<uint64_t>& extracted_size, const uint64_t total_size, std::atomic<float>& progress, bool convert_sct_to_png, bool convert_db_to_json)
+void ArchiveBase::CollectFiles(const Core::FileNode& node, const std::string& current_path, std::vector<ExtractJob>& jobs) const
 {
-    try
+    if (std::holds_alternative<Core::FileInfo>(node.data))
+    {
+        jobs.push_back({&node, current_path});
+    }
+    else if (std::holds_alternative<Core::FolderInfo>(node.data))
     {
-        if (std::holds_alternative<Core::FileInfo>(node.data))
+        std::string new_path = current_path;
+        if (node.name != "/")
         {
-            const auto& info = std::get<Core::FileInfo>(node.data);
-            std::filesystem::path final_path = std::filesystem::path(current_path) / node.name;
-            LogInfo(std::string("Extracting file: ") + node.name + " size=" + std::to_string(info.size));
-
-            std::string ext_lower = info.format;
-            std::transform(ext_lower.begin(), ext_lower.end(), ext_lower.begin(), ::tolower);
-            bool is_sct = (ext_lower == ".sct" || ext_lower == ".sct2");
-            bool is_db = (ext_lower == ".db");
-            bool is_scsp = (ext_lower == ".scsp");
-            bool is_atlas = (ext_lower == ".atlas");
-
-            if (is_sct && convert_sct_to_png)
-                final_path.replace_extension(".png");
-            if (is_db && convert_db_to_json)
-                final_path.replace_extension(".json");
-            if (is_scsp)
-                final_path.replace_extension(".json");
-
-            std::filesystem::create_directories(final_path.parent_path());
+            new_path = new_path.empty() ? node.name : new_path + "/" + node.name;
+        }
+        for (const auto& child : std::get<Core::FolderInfo>(node.data).children)
+            CollectFiles(child, new_path, jobs);
+    }
+}
 
-            std::vector<uint8_t> buffer = GetFileData(node);
+void ArchiveBase::ExtractFile(const Core::FileNode& node, const std::string& current_path, IOutputSink& sink, DedupeIndex* dedupe, std::atomic<uint64_t>& extracted_size, const uint64_t total_size, std::atomic<float>& progress, const ExtractOptions& options)
+{
+    try
+    {
+        const auto& info = std::get<Core::FileInfo>(node.data);
+        std::string final_path = current_path.empty() ? node.name : current_path + "/" + node.name;
+        if (LogEnabled(LogLevel::Debug)) LogDebug(std::string("Extracting file: ") + node.name + " size=" + std::to_string(info.size));
+
+        std::string ext_lower = info.format;
+        std::transform(ext_lower.begin(), ext_lower.end(), ext_lower.begin(), ::tolower);
+        bool is_sct = (ext_lower == ".sct" || ext_lower == ".sct2");
+        bool is_db = (ext_lower == ".db");
+        bool is_scsp = (ext_lower == ".scsp");
+        bool is_atlas = (ext_lower == ".atlas");
+        bool convert_sct = options.convert_sct_to_ktx2 || options.convert_sct_to_png;
+        const std::string sct_ext = options.convert_sct_to_ktx2 ? ".ktx2" : ".png";
+
+        auto replace_extension = [&](const char* ext)
+        {
+            size_t dot = final_path.find_last_of('.');
+            size_t slash = final_path.find_last_of('/');
+            if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+                final_path.erase(dot);
+            final_path += ext;
+        };
+
+        if (is_sct && convert_sct)
+            replace_extension(sct_ext.c_str());
+        if (is_db && options.convert_db_to_json)
+            replace_extension((std::string(".") + DBParser::TableFormatName(options.db_format)).c_str());
+        if (is_scsp)
+            replace_extension((std::string(".") + SCSPParser::SkeletonFormatName(options.spine_format)).c_str());
+
+        std::vector<uint8_t> buffer = GetFileData(node);
+
+        DedupeClaim claim;
+        bool aliased = false;
+        if (dedupe && !buffer.empty())
+        {
+            DedupeIndex::Key key = DedupeIndex::MakeKey(buffer.data(), buffer.size(), final_path);
+            if (std::optional<std::string> existing = dedupe->Claim(key))
+            {
+                aliased = sink.WriteAlias(final_path, *existing);
+                if (aliased)
+                    dedupe->RecordAlias(buffer.size());
+            }
+            else
+            {
+                claim.index = dedupe;
+                claim.key = std::move(key);
+            }
+        }
 
-            if (!buffer.empty())
+        if (!buffer.empty() && !aliased)
+        {
+            bool conversion_failed = false;
+            if (is_sct && convert_sct)
             {
-                if (is_sct && convert_sct_to_png)
+                try
                 {
-                    try
-                    {
-                        LogInfo(std::string("Converting SCT to PNG: ") + node.name);
-                        std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(buffer, false);
-                        if (!png_data.empty())
-                        {
-                            buffer = std::move(png_data);
-                        }
-                    }
-                    catch (const std::exception& e)
+                    if (LogEnabled(LogLevel::Debug)) LogDebug(std::string("Converting SCT to ") + sct_ext + ": " + node.name);
+                    std::vector<uint8_t> converted = options.convert_sct_to_ktx2
+                        ? SCTParser::ConvertToKTX2(buffer, false)
+                        : SCTParser::ConvertToPNG(buffer, false, options.png_level);
+                    if (!converted.empty())
                     {
-                        LogError(std::string("SCT conversion failed for ") + node.name + ": " + e.what());
+                        buffer = std::move(converted);
                     }
                 }
-
-                if (is_atlas && convert_sct_to_png)
+                catch (const std::exception& e)
                 {
-                    try
-                    {
-                        LogInfo(std::string("Rewriting atlas texture refs: ") + node.name);
-                        std::string atlas_text(buffer.begin(), buffer.end());
-
-                        size_t pos = 0;
-                        while ((pos = atlas_text.find(".sct2", pos)) != std::string::npos)
-                        {
-                            atlas_text.replace(pos, 5, ".png");
-                            pos += 4;
-                        }
-
-                        pos = 0;
-                        while ((pos = atlas_text.find(".sct", pos)) != std::string::npos)
-                        {
-                            atlas_text.replace(pos, 4, ".png");
-                            pos += 4;
-                        }
-
-                        buffer.assign(atlas_text.begin(), atlas_text.end());
-                    }
-                    catch (const std::exception& e)
-                    {
-                        LogError(std::string("Atlas rewrite failed for ") + node.name + ": " + e.what());
-                    }
+                    LogError(std::string("SCT conversion failed for ") + node.name + ": " + e.what());
                 }
+            }
 
-                if (is_db && convert_db_to_json)
+            if (is_atlas && convert_sct)
+            {
+                try
                 {
-                    try
+                    if (LogEnabled(LogLevel::Debug)) LogDebug(std::string("Rewriting atlas texture refs: ") + node.name);
+                    std::string atlas_text(buffer.begin(), buffer.end());
+
+                    size_t pos = 0;
+                    while ((pos = atlas_text.find(".sct2", pos)) != std::string::npos)
                     {
-                        LogInfo(std::string("Converting DB to JSON: ") + node.name);
-                        std::string json_str = DBParser::ConvertToJson(buffer);
-                        buffer.assign(json_str.begin(), json_str.end());
+                        atlas_text.replace(pos, 5, sct_ext);
+                        pos += sct_ext.size();
                     }
-                    catch (const std::exception& e)
+
+                    pos = 0;
+                    while ((pos = atlas_text.find(".sct", pos)) != std::string::npos)
                     {
-                        LogError(std::string("DB to JSON conversion failed for ") + node.name + ": " + e.what());
+                        atlas_text.replace(pos, 4, sct_ext);
+                        pos += sct_ext.size();
                     }
+
+                    buffer.assign(atlas_text.begin(), atlas_text.end());
+                }
+                catch (const std::exception& e)
+                {
+                    LogError(std::string("Atlas rewrite failed for ") + node.name + ": " + e.what());
                 }
+            }
 
-                if (is_scsp)
+            if (is_db && options.convert_db_to_json)
+            {
+                try
                 {
-                    try
+                    if (LogEnabled(LogLevel::Debug)) LogDebug(std::string("Converting DB to ") + DBParser::TableFormatName(options.db_format) + ": " + node.name);
+                    std::vector<uint8_t> converted;
+                    if (!DBParser::ConvertTable(buffer, converted, options.db_format,
+                            options.compact_json ? DBParser::JsonStyle::Compact : DBParser::JsonStyle::Pretty))
                     {
-                        LogInfo(std::string("Converting SCSP to JSON: ") + node.name);
-                        std::string json_str = SCSPParser::ConvertSCSPToJson(buffer);
-                        buffer.assign(json_str.begin(), json_str.end());
-                    }
-                    catch (const std::exception& e)
-                    {
-                        LogError(std::string("SCSP to JSON conversion failed for ") + node.name + ": " + e.what());
+                        LogError(std::string("DB conversion failed for ") + node.name);
+                        // Unreadable tables have always come out as an empty JSON
+                        // object; other formats have no such file, so none is written.
+                        if (options.db_format == DBParser::TableFormat::Json)
+                            converted = { '{', '}' };
+                        else
+                            conversion_failed = true;
                     }
+                    buffer = std::move(converted);
+                }
+                catch (const std::exception& e)
+                {
+                    LogError(std::string("DB conversion failed for ") + node.name + ": " + e.what());
+                    conversion_failed = options.db_format != DBParser::TableFormat::Json;
                 }
+            }
 
-                std::ofstream out(final_path, std::ios::binary);
-                if (out.is_open())
+            if (is_scsp)
+            {
+                try
                 {
-                    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+                    if (LogEnabled(LogLevel::Debug)) LogDebug(std::string("Converting SCSP to ") + SCSPParser::SkeletonFormatName(options.spine_format) + ": " + node.name);
+                    buffer = SCSPParser::ConvertSCSP(buffer, options.spine_format);
                 }
-                else
+                catch (const std::exception& e)
                 {
-                    LogError(std::string("Failed to open file for writing: ") + Core::PathToUtf8(final_path));
+                    LogError(std::string("SCSP conversion failed for ") + node.name + ": " + e.what());
                 }
             }
 
-            extracted_size.fetch_add(info.size, std::memory_order_relaxed);
-            progress = static_cast<float>(extracted_size.load()) / total_size;
-        }
-        else if (std::holds_alternative<Core::FolderInfo>(node.data))
-        {
-            const auto& folder_info = std::get<Core::FolderInfo>(node.data);
-            std::filesystem::path new_path = current_path;
-            if (node.name != "/")
+            if (conversion_failed)
             {
-                new_path /= node.name;
+                sink.ReportFailed(final_path);
             }
-            for (const auto& child : folder_info.children)
+            else if (sink.Write(final_path, buffer.data(), buffer.size()))
             {
-                ExtractNode(child, new_path.wstring(), extracted_size, total_size, progress, convert_sct_to_png, convert_db_to_json);
+                claim.written_path = final_path;
+            }
+            else
+            {
+                LogError(std::string("Failed to write extracted file: ") + final_path);
             }
         }
+
+        extracted_size.fetch_add(info.size, std::memory_order_relaxed);
+        progress = static_cast<float>(extracted_size.load()) / total_size;
     }
     catch (const std::exception& e)
     {
@@ -4,6 +4,8 @@
 #include <string>
 #include <atomic>
 
+class DedupeIndex;
+
 class ArchiveBase : public IArchive {
 public:
     ArchiveBase();
@@ -17,6 +19,7 @@ public:
 
     void Extract(const Core::FileNode& node, const std::wstring& output_path, std::atomic<float>& progress, bool convert_sct_to_png = false, bool convert_db_to_json = false) override;
     void ExtractAll(const std::wstring& output_path, std::atomic<float>& progress, bool convert_sct_to_png = false, bool convert_db_to_json = false) override;
+    void Extract(const Core::FileNode& node, IOutputSink& sink, std::atomic<float>& progress, const ExtractOptions& options) override;
 
     virtual void Scan(std::atomic<float>& progress) override = 0;
     virtual std::vector<uint8_t> GetFileData(const Core::FileNode& node) override = 0;
@@ -24,7 +27,12 @@ public:
 protected:
     void SortTree();
     void AddFileToTree(const std::string& path, uint64_t offset, uint64_t size, uint32_t archive_id = 0);
-    void ExtractNode(const Core::FileNode& node, const std::wstring& current_path, std::atomic<uint64_t>& extracted_size, const uint64_t total_size, std::atomic<float>& progress, bool convert_sct_to_png, bool convert_db_to_json);
+    struct ExtractJob {
+        const Core::FileNode* node;
+        std::string parent_path;
+    };
+    void CollectFiles(const Core::FileNode& node, const std::string& current_path, std::vector<ExtractJob>& jobs) const;
+    void ExtractFile(const Core::FileNode& node, const std::string& current_path, IOutputSink& sink, DedupeIndex* dedupe, std::atomic<uint64_t>& extracted_size, const uint64_t total_size, std::atomic<float>& progress, const ExtractOptions& options);
 
     std::wstring pack_path;
     std::atomic<uint32_t> parsed_file_count{0};
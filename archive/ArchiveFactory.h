@@ -0,0 +1,9 @@
+#pragma once
+#include "IArchive.h"
+#include <memory>
+#include <string>
+
+// Picks the archive type for a user supplied path: a manifest.ssra, a data.pack
+// with a sibling gameres/ folder of SSRA manifests, a plain data.pack or a
+// directory of already extracted files.
+std::unique_ptr<IArchive> CreateArchive(const std::wstring& wpath);
@@ -7,6 +7,13 @@
 #include <cctype>
 #include <cstring>
 #include "core/Logger.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -77,12 +84,11 @@ std::vector<std::wstring> DataPack::FindPackParts(const std::wstring &basePath)
     for (int i = 1; i < 1000; ++i)
     {
         std::wstring partPath = basePath + L"~" + std::to_wstring(i);
-        HANDLE hTest = CreateFileW(partPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (hTest == INVALID_HANDLE_VALUE)
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(Core::WidePath(partPath), ec))
         {
             break;
         }
-        CloseHandle(hTest);
         parts.push_back(partPath);
     }
 
@@ -99,13 +105,7 @@ bool DataPack::EnsureWindow(PackPart &part, uint64_t offset, size_t needed) cons
         return true;
     }
 
-    // unmap previous view
-    if (part.view.data)
-    {
-        UnmapViewOfFile(part.view.data);
-        part.view.data = nullptr;
-        part.view.size = 0;
-    }
+    UnmapWindow(part);
 
     uint64_t aligned_offset = (offset / alloc_granularity) * alloc_granularity;
     uint64_t adjustment = offset - aligned_offset;
@@ -122,6 +122,7 @@ bool DataPack::EnsureWindow(PackPart &part, uint64_t offset, size_t needed) cons
     if (window_size == 0)
         return false;
 
+#ifdef _WIN32
     DWORD offset_high = static_cast<DWORD>(aligned_offset >> 32);
     DWORD offset_low = static_cast<DWORD>(aligned_offset & 0xFFFFFFFF);
 
@@ -134,6 +135,16 @@ bool DataPack::EnsureWindow(PackPart &part, uint64_t offset, size_t needed) cons
         LogError("MapViewOfFile failed at offset " + std::to_string(aligned_offset) + " size " + std::to_string(window_size) + " error " + std::to_string(err));
         return false;
     }
+#else
+    void *view = mmap(nullptr, window_size, PROT_READ, MAP_PRIVATE, part.fd, static_cast<off_t>(aligned_offset));
+    if (view == MAP_FAILED)
+    {
+        int err = errno;
+        LogError("mmap failed at offset " + std::to_string(aligned_offset) + " size " + std::to_string(window_size) + " error " + std::to_string(err));
+        return false;
+    }
+    const uint8_t *mapped = static_cast<const uint8_t *>(view);
+#endif
 
     part.view.data = mapped;
     part.view.offset = aligned_offset;
@@ -141,21 +152,35 @@ bool DataPack::EnsureWindow(PackPart &part, uint64_t offset, size_t needed) cons
     return true;
 }
 
+void DataPack::UnmapWindow(PackPart &part) const
+{
+    if (!part.view.data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(part.view.data);
+#else
+    munmap(const_cast<uint8_t *>(part.view.data), part.view.size);
+#endif
+    part.view.data = nullptr;
+    part.view.size = 0;
+}
+
 bool DataPack::LoadPackPart(const std::wstring &path, size_t partIndex)
 {
     PackPart part;
 
+#ifdef _WIN32
     part.hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
     if (part.hFile == INVALID_HANDLE_VALUE)
     {
-        LogError("Failed to open file: " + std::filesystem::path(path).u8string());
+        LogError("Failed to open file: " + Core::WStringToUtf8(path));
         return false;
     }
 
     LARGE_INTEGER fs;
     if (!GetFileSizeEx(part.hFile, &fs))
     {
-        LogError("Failed to get file size for: " + std::filesystem::path(path).u8string());
+        LogError("Failed to get file size for: " + Core::WStringToUtf8(path));
         CloseHandle(part.hFile);
         return false;
     }
@@ -163,7 +188,7 @@ bool DataPack::LoadPackPart(const std::wstring &path, size_t partIndex)
 
     if (part.fileSize == 0)
     {
-        LogError("Empty file, skipping: " + std::filesystem::path(path).u8string());
+        LogError("Empty file, skipping: " + Core::WStringToUtf8(path));
         CloseHandle(part.hFile);
         return false;
     }
@@ -171,10 +196,34 @@ bool DataPack::LoadPackPart(const std::wstring &path, size_t partIndex)
     part.hMapFile = CreateFileMapping(part.hFile, NULL, PAGE_READONLY, 0, 0, NULL);
     if (part.hMapFile == NULL)
     {
-        LogError("Failed to create file mapping for: " + std::filesystem::path(path).u8string());
+        LogError("Failed to create file mapping for: " + Core::WStringToUtf8(path));
         CloseHandle(part.hFile);
         return false;
     }
+#else
+    part.fd = open(Core::WidePath(path).c_str(), O_RDONLY);
+    if (part.fd < 0)
+    {
+        LogError("Failed to open file: " + Core::WStringToUtf8(path));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(part.fd, &st) != 0)
+    {
+        LogError("Failed to get file size for: " + Core::WStringToUtf8(path));
+        close(part.fd);
+        return false;
+    }
+    part.fileSize = static_cast<uint64_t>(st.st_size);
+
+    if (part.fileSize == 0)
+    {
+        LogError("Empty file, skipping: " + Core::WStringToUtf8(path));
+        close(part.fd);
+        return false;
+    }
+#endif
 
     parts.push_back(part);
     total_file_size += part.fileSize;
@@ -243,11 +292,17 @@ DataPack::DataPack(const std::wstring &path)
     this->type = PackType::Unknown;
     root_node.name = "root";
     root_node.data = Core::FolderInfo{};
+#ifdef _WIN32
     SYSTEM_INFO sysInfo;
     GetSystemInfo(&sysInfo);
     alloc_granularity = sysInfo.dwAllocationGranularity;
+#else
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size > 0)
+        alloc_granularity = static_cast<uint64_t>(page_size);
+#endif
 
-    std::filesystem::path fs_path(path);
+    std::filesystem::path fs_path = Core::WidePath(path);
     if (std::filesystem::is_directory(fs_path))
     {
         type = PackType::LocalDirectory;
@@ -258,7 +313,7 @@ DataPack::DataPack(const std::wstring &path)
     auto packParts = FindPackParts(path);
     if (packParts.empty())
     {
-        LogError("No pack files found: " + std::filesystem::path(path).u8string());
+        LogError("No pack files found: " + Core::WStringToUtf8(path));
         return;
     }
 
@@ -267,14 +322,14 @@ DataPack::DataPack(const std::wstring &path)
     {
         if (!LoadPackPart(packParts[i], i))
         {
-            LogError("Failed to load pack part: " + std::filesystem::path(packParts[i]).u8string());
+            LogError("Failed to load pack part: " + Core::WStringToUtf8(packParts[i]));
             // continue
         }
     }
 
     if (parts.empty())
     {
-        LogError("Failed to load any pack parts from: " + std::filesystem::path(path).u8string());
+        LogError("Failed to load any pack parts from: " + Core::WStringToUtf8(path));
         return;
     }
 
@@ -301,15 +356,16 @@ DataPack::~DataPack()
 {
     for (auto &part : parts)
     {
-        if (part.view.data)
-        {
-            UnmapViewOfFile(part.view.data);
-            part.view.data = nullptr;
-        }
+        UnmapWindow(part);
+#ifdef _WIN32
         if (part.hMapFile)
             CloseHandle(part.hMapFile);
         if (part.hFile != INVALID_HANDLE_VALUE)
             CloseHandle(part.hFile);
+#else
+        if (part.fd >= 0)
+            close(part.fd);
+#endif
     }
     parts.clear();
 }
@@ -325,7 +381,7 @@ std::vector<uint8_t> DataPack::GetFileData(const Core::FileNode &node)
 
     if (type == PackType::LocalDirectory)
     {
-        std::filesystem::path full_path = std::filesystem::path(pack_path) / node.full_path;
+        std::filesystem::path full_path = Core::WidePath(pack_path) / std::filesystem::u8path(node.full_path);
         try
         {
             std::ifstream file(full_path, std::ios::binary);
@@ -336,7 +392,7 @@ std::vector<uint8_t> DataPack::GetFileData(const Core::FileNode &node)
             }
             else
             {
-                LogError("Could not open local file: " + full_path.u8string());
+                LogError("Could not open local file: " + Core::PathToUtf8(full_path));
             }
         }
         catch (const std::exception &e)
@@ -359,7 +415,11 @@ std::vector<uint8_t> DataPack::GetFileData(const Core::FileNode &node)
     {
         data.resize(info.size);
 
-        size_t bytes_read = ReadBytes(info.offset, data.data(), info.size);
+        size_t bytes_read = 0;
+        {
+            std::lock_guard<std::mutex> lock(read_mutex);
+            bytes_read = ReadBytes(info.offset, data.data(), info.size);
+        }
         if (bytes_read != info.size)
         {
             LogError("Failed to read full file data for: " + std::filesystem::path(node.name).u8string() + " (read " + std::to_string(bytes_read) + " of " + std::to_string(info.size) + ")");
@@ -431,7 +491,7 @@ void DataPack::Scan(std::atomic<float> &progress)
 
 void DataPack::ScanLocalDirectory(std::atomic<float>& progress)
 {
-    std::filesystem::path base_path(pack_path);
+    std::filesystem::path base_path = Core::WidePath(pack_path);
     uint32_t count = 0;
     uint64_t total = 0;
 
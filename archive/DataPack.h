@@ -4,7 +4,10 @@
 #include <vector>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include "ArchiveBase.h"
 
 class DataPack : public ArchiveBase {
@@ -20,14 +23,18 @@ public:
 private:
     // this maps only a portion of file at a time.
     struct SlidingView {
-        const uint8_t* data = nullptr;   // pointer returned by MapViewOfFile
+        const uint8_t* data = nullptr;   // pointer returned by MapViewOfFile / mmap
         uint64_t       offset = 0;       // file offset this view starts at
         size_t         size = 0;         // number of bytes mapped in this view
     };
 
     struct PackPart {
+#ifdef _WIN32
         HANDLE       hFile = INVALID_HANDLE_VALUE;
         HANDLE       hMapFile = NULL;
+#else
+        int          fd = -1;
+#endif
         uint64_t     fileSize = 0;
         SlidingView  view;
     };
@@ -36,7 +43,7 @@ private:
     static constexpr size_t WINDOW_SIZE = 64ULL * 1024 * 1024;
 
     // queried once in constructor
-    DWORD alloc_granularity = 65536;
+    uint64_t alloc_granularity = 65536;
 
     void ScanEncrypted(std::atomic<float>& progress);
     void ScanDecrypted(std::atomic<float>& progress);
@@ -46,9 +53,13 @@ private:
     bool LoadPackPart(const std::wstring& path, size_t partIndex);
 
     bool EnsureWindow(PackPart& part, uint64_t offset, size_t needed) const;
+    void UnmapWindow(PackPart& part) const;
     const uint8_t* GetDataAtOffset(uint64_t offset, size_t& outSize);
     size_t ReadBytes(uint64_t offset, void* dest, size_t count);
 
     std::vector<PackPart> parts;
     uint64_t total_file_size = 0;
-};
\ No newline at end of file
+
+    // The views above are shared state; extraction workers read one at a time.
+    std::mutex read_mutex;
+};
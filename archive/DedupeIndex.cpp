@@ -0,0 +1,47 @@
+#include "DedupeIndex.h"
+#include "core/Hash.h"
+
+DedupeIndex::Key DedupeIndex::MakeKey(const uint8_t* data, size_t size, const std::string& output_path)
+{
+    Key key;
+    key.hash = Core::Hash64(data, size);
+    key.size = size;
+    size_t dot = output_path.find_last_of('.');
+    size_t slash = output_path.find_last_of('/');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+        key.output_ext = output_path.substr(dot);
+    return key;
+}
+
+std::optional<std::string> DedupeIndex::Claim(const Key& key)
+{
+    std::unique_lock<std::mutex> lock(entries_mutex);
+    auto [it, inserted] = entries.try_emplace(key);
+    if (inserted)
+        return std::nullopt;
+
+    // Another worker is still converting the first copy.
+    published_cv.wait(lock, [&] { return it->second.published; });
+    if (it->second.path.empty())
+        return std::nullopt;
+    return it->second.path;
+}
+
+void DedupeIndex::Publish(const Key& key, const std::string& written_path)
+{
+    {
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        Entry& entry = entries[key];
+        if (entry.published)
+            return;
+        entry.published = true;
+        entry.path = written_path;
+    }
+    published_cv.notify_all();
+}
+
+void DedupeIndex::RecordAlias(uint64_t bytes)
+{
+    alias_count.fetch_add(1, std::memory_order_relaxed);
+    bytes_saved.fetch_add(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <optional>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Remembers which source payloads were already written during one extraction,
+// so byte-identical files are converted once and aliased afterwards.
+class DedupeIndex {
+public:
+    struct Key {
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        std::string output_ext; // same bytes can convert differently per type
+
+        bool operator==(const Key& other) const
+        {
+            return hash == other.hash && size == other.size && output_ext == other.output_ext;
+        }
+    };
+
+    static Key MakeKey(const uint8_t* data, size_t size, const std::string& output_path);
+
+    // Returns the path the payload was written to. Returns std::nullopt when the
+    // caller is the first to see it; the caller must then call Publish().
+    std::optional<std::string> Claim(const Key& key);
+
+    // Empty written_path means writing failed; later duplicates write their own copy.
+    void Publish(const Key& key, const std::string& written_path);
+
+    void RecordAlias(uint64_t bytes_saved);
+    uint64_t GetAliasCount() const { return alias_count.load(); }
+    uint64_t GetBytesSaved() const { return bytes_saved.load(); }
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash); }
+    };
+
+    struct Entry {
+        bool published = false;
+        std::string path;
+    };
+
+    std::mutex entries_mutex;
+    std::condition_variable published_cv;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    std::atomic<uint64_t> alias_count{0};
+    std::atomic<uint64_t> bytes_saved{0};
+};
@@ -1,9 +1,32 @@
 #pragma once
 #include "core/Core.h"
+#include "OutputSink.h"
+#include "PngWriter.h"
+#include "DBParser.h"
+#include "SCSPParser.h"
 #include <vector>
 #include <string>
 #include <atomic>
 
+struct ExtractOptions {
+    bool convert_sct_to_png = false;
+    // Writes SCT textures as KTX2 holding the original compressed blocks
+    // instead of decoding them; takes precedence over convert_sct_to_png.
+    bool convert_sct_to_ktx2 = false;
+    // Converts DB tables to db_format; the flag keeps its historical name.
+    bool convert_db_to_json = false;
+    DBParser::TableFormat db_format = DBParser::TableFormat::Json;
+    // SCSP skeletons are always converted, to this format.
+    SCSPParser::SkeletonFormat spine_format = SCSPParser::SkeletonFormat::Json;
+    // JSON DB tables are written on one line instead of indented.
+    bool compact_json = false;
+    PngWriter::Level png_level = PngWriter::Level::Default;
+    // Byte-identical source files are converted once and aliased by the sink.
+    bool deduplicate = false;
+    // Files are read, converted and written by this many workers; 0 uses every core.
+    unsigned int threads = 1;
+};
+
 class IArchive {
 public:
     enum class PackType { Unknown, Encrypted, Decrypted, LocalDirectory, Composite, SSRA };
@@ -19,5 +42,6 @@ public:
     virtual void Scan(std::atomic<float>& progress) = 0;
     virtual void Extract(const Core::FileNode& node, const std::wstring& output_path, std::atomic<float>& progress, bool convert_sct_to_png = false, bool convert_db_to_json = false) = 0;
     virtual void ExtractAll(const std::wstring& output_path, std::atomic<float>& progress, bool convert_sct_to_png = false, bool convert_db_to_json = false) = 0;
+    virtual void Extract(const Core::FileNode& node, IOutputSink& sink, std::atomic<float>& progress, const ExtractOptions& options) = 0;
     virtual std::vector<uint8_t> GetFileData(const Core::FileNode& node) = 0;
 };
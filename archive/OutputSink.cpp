@@ -0,0 +1,260 @@
+#include "OutputSink.h"
+#include "core/Core.h"
+#include "core/Logger.h"
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+namespace
+{
+    constexpr size_t TAR_BLOCK = 512;
+
+    std::string parent_of(const std::string& relative_path)
+    {
+        size_t slash = relative_path.find_last_of('/');
+        return (slash == std::string::npos) ? std::string() : relative_path.substr(0, slash);
+    }
+
+    void write_octal(char* field, size_t width, uint64_t value)
+    {
+        // width includes the terminating NUL
+        std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+    }
+}
+
+DirectorySink::DirectorySink(const std::wstring& root_path) : root_path(root_path)
+{
+}
+
+bool DirectorySink::EnsureParentDirectory(const std::string& relative_path)
+{
+    std::string parent = parent_of(relative_path);
+    {
+        std::lock_guard<std::mutex> lock(dir_mutex);
+        if (created_dirs.count(parent))
+            return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(Core::WidePath(root_path) / std::filesystem::u8path(parent), ec);
+    if (ec)
+    {
+        LogError("Failed to create directory: " + parent + " - " + ec.message());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(dir_mutex);
+    // Every ancestor now exists as well.
+    while (true)
+    {
+        if (!created_dirs.insert(parent).second || parent.empty())
+            break;
+        parent = parent_of(parent);
+    }
+    return true;
+}
+
+bool DirectorySink::Write(const std::string& relative_path, const uint8_t* data, size_t size)
+{
+    if (!EnsureParentDirectory(relative_path))
+        return false;
+
+    std::filesystem::path final_path = Core::WidePath(root_path) / std::filesystem::u8path(relative_path);
+    std::ofstream out(final_path, std::ios::binary);
+    if (!out.is_open())
+    {
+        LogError("Failed to open file for writing: " + Core::PathToUtf8(final_path));
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(data), size);
+    return static_cast<bool>(out);
+}
+
+bool DirectorySink::WriteAlias(const std::string& relative_path, const std::string& target_path)
+{
+    if (!EnsureParentDirectory(relative_path))
+        return false;
+
+    std::filesystem::path root = Core::WidePath(root_path);
+    std::filesystem::path final_path = root / std::filesystem::u8path(relative_path);
+    std::filesystem::path existing_path = root / std::filesystem::u8path(target_path);
+
+    std::error_code ec;
+    std::filesystem::remove(final_path, ec);
+    std::filesystem::create_hard_link(existing_path, final_path, ec);
+    if (!ec)
+        return true;
+
+    ec.clear();
+    std::filesystem::copy_file(existing_path, final_path, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec)
+    {
+        LogError("Failed to alias " + relative_path + " to " + target_path + " - " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+TarSink::TarSink(const std::wstring& archive_path)
+{
+    out.open(Core::WidePath(archive_path), std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        LogError("Failed to create tar archive: " + Core::WStringToUtf8(archive_path));
+    }
+}
+
+TarSink::~TarSink()
+{
+    Finish();
+}
+
+bool TarSink::WriteHeader(const std::string& name, uint64_t size, char type_flag, const std::string& link_name)
+{
+    char header[TAR_BLOCK];
+
+    // Names that fit neither the ustar name nor prefix/name split get a GNU long name record first.
+    std::string field_name = name;
+    std::string field_prefix;
+    if (name.size() > 100)
+    {
+        size_t split = name.find_last_of('/', 155);
+        if (split != std::string::npos && split > 0 && name.size() - split - 1 <= 100)
+        {
+            field_prefix = name.substr(0, split);
+            field_name = name.substr(split + 1);
+        }
+        else
+        {
+            if (!WriteHeader("././@LongLink", name.size() + 1, 'L'))
+                return false;
+            out.write(name.c_str(), name.size() + 1);
+            WritePadding(name.size() + 1);
+            field_name = name.substr(0, 100);
+        }
+    }
+
+    if (link_name.size() > 100)
+    {
+        if (!WriteHeader("././@LongLink", link_name.size() + 1, 'K'))
+            return false;
+        out.write(link_name.c_str(), link_name.size() + 1);
+        WritePadding(link_name.size() + 1);
+    }
+
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, field_name.data(), std::min<size_t>(field_name.size(), 100));
+    write_octal(header + 100, 8, 0644);
+    write_octal(header + 108, 8, 0);
+    write_octal(header + 116, 8, 0);
+    write_octal(header + 124, 12, size);
+    write_octal(header + 136, 12, static_cast<uint64_t>(std::time(nullptr)));
+    header[156] = type_flag;
+    std::memcpy(header + 157, link_name.data(), std::min<size_t>(link_name.size(), 100));
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 263, "00", 2);
+    std::memcpy(header + 345, field_prefix.data(), std::min<size_t>(field_prefix.size(), 155));
+
+    std::memset(header + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; ++i)
+        checksum += static_cast<unsigned char>(header[i]);
+    std::snprintf(header + 148, 8, "%06o", checksum);
+    header[155] = ' ';
+
+    out.write(header, TAR_BLOCK);
+    return static_cast<bool>(out);
+}
+
+void TarSink::WritePadding(uint64_t size)
+{
+    static const char zeros[TAR_BLOCK] = {};
+    size_t remainder = static_cast<size_t>(size % TAR_BLOCK);
+    if (remainder != 0)
+        out.write(zeros, TAR_BLOCK - remainder);
+}
+
+bool TarSink::Write(const std::string& relative_path, const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (!out.is_open() || finished)
+        return false;
+
+    if (!WriteHeader(relative_path, size, '0'))
+    {
+        LogError("Failed to write tar header for: " + relative_path);
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(data), size);
+    WritePadding(size);
+    return static_cast<bool>(out);
+}
+
+bool TarSink::WriteAlias(const std::string& relative_path, const std::string& target_path)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (!out.is_open() || finished)
+        return false;
+
+    return WriteHeader(relative_path, 0, '1', target_path);
+}
+
+void TarSink::Finish()
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (!out.is_open() || finished)
+        return;
+
+    static const char zeros[TAR_BLOCK * 2] = {};
+    out.write(zeros, sizeof(zeros));
+    out.flush();
+    out.close();
+    finished = true;
+}
+
+bool MemorySink::Write(const std::string& relative_path, const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(files_mutex);
+    files[relative_path].assign(data, data + size);
+    return true;
+}
+
+bool MemorySink::WriteAlias(const std::string& relative_path, const std::string& target_path)
+{
+    std::lock_guard<std::mutex> lock(files_mutex);
+    aliases[relative_path] = target_path;
+    return true;
+}
+
+std::map<std::string, std::vector<uint8_t>> MemorySink::TakeFiles()
+{
+    std::lock_guard<std::mutex> lock(files_mutex);
+    return std::move(files);
+}
+
+std::map<std::string, std::string> MemorySink::TakeAliases()
+{
+    std::lock_guard<std::mutex> lock(files_mutex);
+    return std::move(aliases);
+}
+
+size_t MemorySink::GetFileCount()
+{
+    std::lock_guard<std::mutex> lock(files_mutex);
+    return files.size();
+}
+
+bool NullSink::Write(const std::string&, const uint8_t*, size_t size)
+{
+    file_count.fetch_add(1, std::memory_order_relaxed);
+    byte_count.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+bool NullSink::WriteAlias(const std::string&, const std::string&)
+{
+    file_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <unordered_set>
+
+// Destination for extracted files. Paths handed to a sink are UTF-8, relative
+// to the extraction root and always use '/' as separator.
+class IOutputSink {
+public:
+    virtual ~IOutputSink() = default;
+
+    virtual bool Write(const std::string& relative_path, const uint8_t* data, size_t size) = 0;
+
+    // Records relative_path as an identical copy of an already written target_path.
+    // Sinks that cannot alias return false and the caller writes the bytes instead.
+    virtual bool WriteAlias(const std::string& /*relative_path*/, const std::string& /*target_path*/) { return false; }
+
+    // Reports a file that could not be produced, so nothing was written for it.
+    virtual void ReportFailed(const std::string& /*relative_path*/) {}
+
+    virtual void Finish() {}
+};
+
+// Writes a regular directory tree. Parent directories are created once and
+// remembered, so sibling files skip the create_directories round trip.
+class DirectorySink : public IOutputSink {
+public:
+    explicit DirectorySink(const std::wstring& root_path);
+
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    // Hard link, falling back to a plain copy on filesystems without links.
+    bool WriteAlias(const std::string& relative_path, const std::string& target_path) override;
+
+private:
+    bool EnsureParentDirectory(const std::string& relative_path);
+
+    std::wstring root_path;
+    std::mutex dir_mutex;
+    std::unordered_set<std::string> created_dirs;
+};
+
+// Streams every file into a single uncompressed ustar archive.
+class TarSink : public IOutputSink {
+public:
+    explicit TarSink(const std::wstring& archive_path);
+    ~TarSink() override;
+    TarSink(const TarSink&) = delete;
+    TarSink& operator=(const TarSink&) = delete;
+
+    bool IsOpen() const { return out.is_open(); }
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    // Stored as a tar hard link entry.
+    bool WriteAlias(const std::string& relative_path, const std::string& target_path) override;
+    void Finish() override;
+
+private:
+    bool WriteHeader(const std::string& name, uint64_t size, char type_flag, const std::string& link_name = "");
+    void WritePadding(uint64_t size);
+
+    std::ofstream out;
+    std::mutex write_mutex;
+    bool finished = false;
+};
+
+// Keeps every file in memory, mainly for tests and tooling.
+class MemorySink : public IOutputSink {
+public:
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    bool WriteAlias(const std::string& relative_path, const std::string& target_path) override;
+
+    std::map<std::string, std::vector<uint8_t>> TakeFiles();
+    std::map<std::string, std::string> TakeAliases();
+    size_t GetFileCount();
+
+private:
+    std::mutex files_mutex;
+    std::map<std::string, std::vector<uint8_t>> files;
+    std::map<std::string, std::string> aliases;
+};
+
+// Discards everything; only counts what went through it.
+class NullSink : public IOutputSink {
+public:
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    bool WriteAlias(const std::string& relative_path, const std::string& target_path) override;
+
+    uint64_t GetFileCount() const { return file_count.load(); }
+    uint64_t GetByteCount() const { return byte_count.load(); }
+
+private:
+    std::atomic<uint64_t> file_count{0};
+    std::atomic<uint64_t> byte_count{0};
+};
@@ -51,8 +51,8 @@ SSRArchive::SSRArchive(const std::wstring& manifest_path) : manifest_path(manife
 {
     this->pack_path = manifest_path;
     this->type = PackType::SSRA;
-    std::filesystem::path p(manifest_path);
-    chunks_dir = (p.parent_path() / L"chunks").wstring();
+    std::filesystem::path p = Core::WidePath(manifest_path);
+    chunks_dir = Core::PathToWString(p.parent_path() / L"chunks");
 }
 
 std::string SSRArchive::GetStringFromTable(const std::vector<uint8_t>& string_table, uint64_t offset) const
@@ -72,7 +72,7 @@ void SSRArchive::Scan(std::atomic<float>& progress)
 {
     LogInfo("Scanning SSRA manifest: " + Core::WStringToUtf8(manifest_path));
 
-    std::ifstream file(manifest_path, std::ios::binary | std::ios::ate);
+    std::ifstream file(Core::WidePath(manifest_path), std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         LogError("Failed to open manifest.ssra: " + Core::WStringToUtf8(manifest_path));
         return;
@@ -279,7 +279,7 @@ std::vector<uint8_t> SSRArchive::GetFileData(const Core::FileNode& node)
     SSRAFileInfo s_info = s_info_orig;
     s_info.offset = global_off - c_info.global_offset; // local offset
 
-    std::filesystem::path manifest_p(manifest_path);
+    std::filesystem::path manifest_p = Core::WidePath(manifest_path);
     std::filesystem::path manifest_dir = manifest_p.parent_path();
 
     std::vector<std::filesystem::path> search_dirs = {
@@ -289,7 +289,7 @@ std::vector<uint8_t> SSRArchive::GetFileData(const Core::FileNode& node)
         manifest_dir.parent_path(),
         manifest_dir.parent_path().parent_path() / L"chunks",
         manifest_dir.parent_path().parent_path(),
-        std::filesystem::path(chunks_dir)
+        Core::WidePath(chunks_dir)
     };
 
     std::vector<std::string> candidate_names;
@@ -323,7 +323,7 @@ std::vector<uint8_t> SSRArchive::GetFileData(const Core::FileNode& node)
     for (const auto& dir : search_dirs) {
         if (!std::filesystem::exists(dir)) continue;
         for (const auto& name : candidate_names) {
-            std::filesystem::path test_path = dir / Core::Utf8ToWString(name);
+            std::filesystem::path test_path = dir / std::filesystem::u8path(name);
             if (std::filesystem::exists(test_path)) {
                 chunk_path = test_path;
                 found = true;
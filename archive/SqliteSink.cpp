@@ -0,0 +1,194 @@
+#include "SqliteSink.h"
+#include "DBParser.h"
+#include "core/Core.h"
+#include "core/Logger.h"
+#include <sqlite3.h>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    std::string quote_identifier(const std::string& name)
+    {
+        std::string quoted = "\"";
+        for (char c : name)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+}
+
+SqliteSink::SqliteSink(const std::wstring& database_path)
+{
+    std::filesystem::path file_path = Core::WidePath(database_path);
+    std::error_code ec;
+    std::filesystem::remove(file_path, ec);
+
+    if (sqlite3_open_v2(Core::PathToUtf8(file_path).c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
+    {
+        LogError("Failed to create SQLite database: " + Core::PathToUtf8(file_path) + " - " + (db ? sqlite3_errmsg(db) : "out of memory"));
+        sqlite3_close(db);
+        db = nullptr;
+        return;
+    }
+
+    // The file is rebuilt from scratch on every export, so the journal only
+    // has to roll back a table that fails part way and can stay in memory.
+    if (!Exec("PRAGMA journal_mode=MEMORY; PRAGMA synchronous=OFF;") ||
+        !Exec("CREATE TABLE \"_tables\" (name TEXT PRIMARY KEY, source TEXT, columns INTEGER, rows INTEGER);") ||
+        !Exec("BEGIN;"))
+    {
+        sqlite3_close(db);
+        db = nullptr;
+        return;
+    }
+    table_names.insert("_tables");
+}
+
+SqliteSink::~SqliteSink()
+{
+    Finish();
+    sqlite3_close(db);
+}
+
+bool SqliteSink::Exec(const char* sql)
+{
+    char* message = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &message) == SQLITE_OK)
+        return true;
+    LogError(std::string("SQLite: ") + (message ? message : sqlite3_errmsg(db)));
+    sqlite3_free(message);
+    return false;
+}
+
+std::string SqliteSink::UniqueName(std::string name, std::unordered_set<std::string>& used)
+{
+    if (DBParser::LowerAscii(name).rfind("sqlite_", 0) == 0)
+        name = "t_" + name;
+    std::string candidate = name;
+    for (int suffix = 2; !used.insert(DBParser::LowerAscii(candidate)).second; ++suffix)
+        candidate = name + "_" + std::to_string(suffix);
+    return candidate;
+}
+
+bool SqliteSink::Write(const std::string& relative_path, const uint8_t* data, size_t size)
+{
+    if (!DBParser::IsDBPath(relative_path))
+        return true;
+
+    DBParser::Table table;
+    std::string error;
+    if (!table.Load(std::vector<uint8_t>(data, data + size), error))
+    {
+        LogError("Failed to read DB for SQLite export: " + relative_path + " - " + error);
+        return false;
+    }
+
+    if (table.ColumnNames().empty())
+    {
+        LogInfo("DB has no columns, skipped in SQLite export: " + relative_path);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(db_mutex);
+    if (!db || finished)
+        return false;
+
+    // Each table lands together with its "_tables" row or not at all.
+    if (!Exec("SAVEPOINT t;"))
+        return false;
+
+    std::string table_name = UniqueName(relative_path.substr(0, relative_path.size() - 3), table_names);
+    std::unordered_set<std::string> column_set;
+    std::vector<std::string> columns;
+    for (const std::string& column : table.ColumnNames())
+        columns.push_back(UniqueName(column.empty() ? "column_" + std::to_string(columns.size() + 1) : column, column_set));
+
+    // Columns are declared without a type, so values keep the storage class
+    // they are bound with.
+    std::string create = "CREATE TABLE " + quote_identifier(table_name) + " (";
+    std::string insert = "INSERT INTO " + quote_identifier(table_name) + " VALUES (";
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        create += (i ? ", " : "") + quote_identifier(columns[i]);
+        insert += i ? ", ?" : "?";
+    }
+    create += ");";
+    insert += ");";
+    bool ok = Exec(create.c_str());
+
+    sqlite3_stmt* statement = nullptr;
+    if (ok && sqlite3_prepare_v2(db, insert.c_str(), -1, &statement, nullptr) != SQLITE_OK)
+    {
+        LogError("SQLite: " + std::string(sqlite3_errmsg(db)));
+        ok = false;
+    }
+
+    uint64_t rows = 0;
+    std::vector<std::string_view> values;
+    for (uint32_t row = 0; row < table.RowCount() && ok; ++row)
+    {
+        if (!table.GetRow(row, values))
+            continue;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            int parameter = static_cast<int>(i + 1);
+            int64_t number;
+            if (i >= values.size())
+                sqlite3_bind_null(statement, parameter);
+            else if (DBParser::ParseInteger(values[i], number))
+                sqlite3_bind_int64(statement, parameter, number);
+            else
+                sqlite3_bind_text(statement, parameter, values[i].data(), static_cast<int>(values[i].size()), SQLITE_STATIC);
+        }
+        ok = sqlite3_step(statement) == SQLITE_DONE;
+        sqlite3_reset(statement);
+        rows++;
+        if (!ok)
+            LogError("SQLite insert into " + table_name + " failed: " + sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(statement);
+
+    sqlite3_stmt* manifest = nullptr;
+    if (ok)
+    {
+        ok = sqlite3_prepare_v2(db, "INSERT INTO \"_tables\" VALUES (?, ?, ?, ?);", -1, &manifest, nullptr) == SQLITE_OK;
+        if (ok)
+        {
+            sqlite3_bind_text(manifest, 1, table_name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(manifest, 2, relative_path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(manifest, 3, static_cast<int64_t>(columns.size()));
+            sqlite3_bind_int64(manifest, 4, static_cast<int64_t>(rows));
+            ok = sqlite3_step(manifest) == SQLITE_DONE;
+        }
+        if (!ok)
+            LogError("SQLite: " + std::string(sqlite3_errmsg(db)));
+    }
+    sqlite3_finalize(manifest);
+
+    if (ok && Exec("RELEASE t;"))
+    {
+        table_count++;
+        row_count += rows;
+        return true;
+    }
+
+    LogError("SQLite export skipped " + relative_path);
+    Exec("ROLLBACK TO t; RELEASE t;");
+    table_names.erase(DBParser::LowerAscii(table_name));
+    return false;
+}
+
+void SqliteSink::Finish()
+{
+    std::lock_guard<std::mutex> lock(db_mutex);
+    if (!db || finished)
+        return;
+    finished = true;
+    if (Exec("COMMIT;"))
+        LogInfo("SQLite export: " + std::to_string(table_count) + " tables, " + std::to_string(row_count) + " rows");
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "OutputSink.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+struct sqlite3;
+
+// Loads every .db file written to it as a table of a single SQLite database,
+// named after the file's path without the extension; other files are skipped.
+// Files are decrypted and indexed on the calling worker thread, then inserted
+// under one lock inside a single transaction that Finish commits. A table
+// that fails part way is rolled back to its savepoint and left out.
+class SqliteSink : public IOutputSink {
+public:
+    explicit SqliteSink(const std::wstring& database_path);
+    ~SqliteSink() override;
+    SqliteSink(const SqliteSink&) = delete;
+    SqliteSink& operator=(const SqliteSink&) = delete;
+
+    bool IsOpen() const { return db != nullptr; }
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    void Finish() override;
+
+    uint64_t GetTableCount() const { return table_count; }
+    uint64_t GetRowCount() const { return row_count; }
+
+private:
+    bool Exec(const char* sql);
+    // Case-insensitively unique among names already handed out.
+    static std::string UniqueName(std::string name, std::unordered_set<std::string>& used);
+
+    sqlite3* db = nullptr;
+    std::mutex db_mutex;
+    std::unordered_set<std::string> table_names;
+    uint64_t table_count = 0;
+    uint64_t row_count = 0;
+    bool finished = false;
+};
@@ -0,0 +1,907 @@
+#include "TableStore.h"
+#include "DBParser.h"
+#include "core/Hash.h"
+#include "core/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr size_t STRING_BLOCK_SIZE = 1 << 20;
+
+    // Reals only order and compare rows; results are printed from the
+    // interned text, so "5.10" may count as a number too.
+    bool parse_real(std::string_view text, double& value)
+    {
+        if (text.empty() || text.size() > 32)
+            return false;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size() && std::isfinite(value);
+    }
+
+    // Literals in a query are read leniently; only stored values need to be canonical.
+    template <typename T>
+    bool parse_literal(std::string_view text, T& value)
+    {
+        if (!text.empty() && text[0] == '+')
+            text.remove_prefix(1);
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    std::string file_name(const std::string& name)
+    {
+        size_t slash = name.find_last_of('/');
+        return slash == std::string::npos ? name : name.substr(slash + 1);
+    }
+
+    enum class TokenKind { Word, Identifier, String, Symbol, End };
+
+    struct Token
+    {
+        TokenKind kind = TokenKind::End;
+        std::string text;
+    };
+
+    bool is_word_char(char c)
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        return std::isalnum(u) || c == '_' || c == '/' || c == '-' || u >= 0x80;
+    }
+
+    bool is_number(const std::string& word)
+    {
+        size_t start = !word.empty() && word[0] == '-' ? 1 : 0;
+        return start < word.size() && std::all_of(word.begin() + start, word.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) || c == '.'; });
+    }
+
+    // Words run over letters, digits and "_/-" so table paths need no quotes;
+    // a '.' only stays in a word between the digits of a number.
+    bool tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error)
+    {
+        size_t i = 0;
+        while (i < text.size())
+        {
+            char c = text[i];
+            if (std::isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+                continue;
+            }
+
+            Token token;
+            if (c == '\'' || c == '"')
+            {
+                token.kind = c == '\'' ? TokenKind::String : TokenKind::Identifier;
+                for (++i; ; ++i)
+                {
+                    if (i >= text.size())
+                    {
+                        error = std::string("unterminated ") + (c == '\'' ? "string" : "identifier");
+                        return false;
+                    }
+                    if (text[i] == c)
+                    {
+                        if (i + 1 < text.size() && text[i + 1] == c)
+                            ++i;
+                        else
+                            break;
+                    }
+                    token.text += text[i];
+                }
+                ++i;
+            }
+            else if (is_word_char(c))
+            {
+                token.kind = TokenKind::Word;
+                while (i < text.size())
+                {
+                    if (is_word_char(text[i]))
+                        token.text += text[i++];
+                    else if (text[i] == '.' && i + 1 < text.size() && std::isdigit(static_cast<unsigned char>(text[i + 1])) && is_number(token.text))
+                        token.text += text[i++];
+                    else
+                        break;
+                }
+            }
+            else
+            {
+                token.kind = TokenKind::Symbol;
+                static const char* pairs[] = { "!=", "<>", "<=", ">=" };
+                for (const char* pair : pairs)
+                {
+                    if (text.compare(i, 2, pair) == 0)
+                        token.text = pair;
+                }
+                if (token.text.empty())
+                {
+                    if (!std::strchr("=<>,.*();", c))
+                    {
+                        error = std::string("unexpected character '") + c + "'";
+                        return false;
+                    }
+                    token.text = c;
+                }
+                i += token.text.size();
+            }
+            tokens.push_back(std::move(token));
+        }
+        tokens.push_back(Token());
+        return true;
+    }
+
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+    bool parse_op(const std::string& text, Op& op)
+    {
+        if (text == "=") op = Op::Equal;
+        else if (text == "!=" || text == "<>") op = Op::NotEqual;
+        else if (text == "<") op = Op::Less;
+        else if (text == "<=") op = Op::LessEqual;
+        else if (text == ">") op = Op::Greater;
+        else if (text == ">=") op = Op::GreaterEqual;
+        else return false;
+        return true;
+    }
+
+    template <typename T>
+    int compare(const T& a, const T& b)
+    {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+
+    bool apply_op(Op op, int order)
+    {
+        switch (op)
+        {
+        case Op::Equal: return order == 0;
+        case Op::NotEqual: return order != 0;
+        case Op::Less: return order < 0;
+        case Op::LessEqual: return order <= 0;
+        case Op::Greater: return order > 0;
+        default: return order >= 0;
+        }
+    }
+}
+
+// A parsed query with its names resolved against the store.
+struct TableStore::Query
+{
+    struct Name
+    {
+        std::string qualifier;
+        std::string column;
+        std::string text;
+    };
+
+    struct Ref
+    {
+        size_t table = 0;
+        Column* column = nullptr;
+    };
+
+    struct Condition
+    {
+        Name name;
+        Ref ref;
+        Op op = Op::Equal;
+        std::string literal;
+        // Set when the column is numeric and the literal reads as a number.
+        bool numeric = false;
+        bool integer = false;
+        int64_t integer_value = 0;
+        double real_value = 0.0;
+        // The literal's string id when it is compared as text.
+        uint32_t text_id = MISSING;
+        // Equality that holds exactly when the string ids are equal.
+        bool by_id = false;
+    };
+
+    struct Join
+    {
+        Name left_name, right_name;
+        Ref left, right;
+    };
+
+    std::vector<Table*> tables;
+    std::vector<std::string> table_names;
+    std::vector<std::string> aliases;
+    // joins[k] attaches tables[k + 1].
+    std::vector<Join> joins;
+    std::vector<Condition> conditions;
+    bool select_all = false;
+    std::vector<Name> select_names;
+    std::vector<Ref> select;
+    std::vector<std::string> headers;
+    size_t limit = std::numeric_limits<size_t>::max();
+
+    std::vector<Token> tokens;
+    size_t position = 0;
+
+    const Token& Peek() const { return tokens[position]; }
+
+    bool IsKeyword(const char* keyword) const
+    {
+        const Token& token = Peek();
+        return token.kind == TokenKind::Word && DBParser::LowerAscii(token.text) == keyword;
+    }
+
+    bool Accept(const char* keyword)
+    {
+        if (!IsKeyword(keyword))
+            return false;
+        ++position;
+        return true;
+    }
+
+    bool AcceptSymbol(const char* symbol)
+    {
+        if (Peek().kind != TokenKind::Symbol || Peek().text != symbol)
+            return false;
+        ++position;
+        return true;
+    }
+
+    bool Expect(const char* keyword, std::string& error)
+    {
+        if (Accept(keyword))
+            return true;
+        error = std::string("expected ") + keyword + Near();
+        return false;
+    }
+
+    std::string Near() const
+    {
+        return Peek().kind == TokenKind::End ? " at end of query" : " near '" + Peek().text + "'";
+    }
+
+    bool ParseIdentifier(std::string& name, std::string& error)
+    {
+        const Token& token = Peek();
+        if (token.kind != TokenKind::Word && token.kind != TokenKind::Identifier)
+        {
+            error = "expected a name" + Near();
+            return false;
+        }
+        name = token.text;
+        ++position;
+        return true;
+    }
+
+    bool ParseName(Name& name, std::string& error)
+    {
+        if (!ParseIdentifier(name.column, error))
+            return false;
+        name.text = name.column;
+        if (AcceptSymbol("."))
+        {
+            name.qualifier = std::move(name.column);
+            if (!ParseIdentifier(name.column, error))
+                return false;
+            name.text = name.qualifier + "." + name.column;
+        }
+        return true;
+    }
+
+    bool ParseTable(TableStore& store, std::string& error)
+    {
+        std::string name;
+        if (!ParseIdentifier(name, error))
+            return false;
+        Table* table = store.FindTable(name, error);
+        if (!table)
+            return false;
+        std::string alias;
+        if (Accept("as"))
+        {
+            if (!ParseIdentifier(alias, error))
+                return false;
+        }
+        else if (Peek().kind == TokenKind::Identifier || (Peek().kind == TokenKind::Word && !IsKeyword("join") && !IsKeyword("inner") &&
+                 !IsKeyword("on") && !IsKeyword("where") && !IsKeyword("limit")))
+        {
+            ParseIdentifier(alias, error);
+        }
+        tables.push_back(table);
+        table_names.push_back(name);
+        aliases.push_back(alias);
+        return true;
+    }
+
+    bool Parse(const std::string& text, TableStore& store, std::string& error)
+    {
+        if (!tokenize(text, tokens, error))
+            return false;
+
+        if (!Expect("select", error))
+            return false;
+        if (AcceptSymbol("*"))
+        {
+            select_all = true;
+        }
+        else
+        {
+            do
+            {
+                select_names.emplace_back();
+                if (!ParseName(select_names.back(), error))
+                    return false;
+            } while (AcceptSymbol(","));
+        }
+
+        if (!Expect("from", error) || !ParseTable(store, error))
+            return false;
+        while (IsKeyword("join") || IsKeyword("inner"))
+        {
+            if (Accept("inner") && !IsKeyword("join"))
+            {
+                error = "expected join" + Near();
+                return false;
+            }
+            ++position;
+            Join join;
+            if (!ParseTable(store, error) || !Expect("on", error) || !ParseName(join.left_name, error))
+                return false;
+            if (!AcceptSymbol("="))
+            {
+                error = "joins only match on equal columns" + Near();
+                return false;
+            }
+            if (!ParseName(join.right_name, error))
+                return false;
+            joins.push_back(std::move(join));
+        }
+
+        if (Accept("where"))
+        {
+            do
+            {
+                Condition condition;
+                if (!ParseName(condition.name, error))
+                    return false;
+                if (Peek().kind != TokenKind::Symbol || !parse_op(Peek().text, condition.op))
+                {
+                    error = "expected a comparison" + Near();
+                    return false;
+                }
+                ++position;
+                if (Peek().kind != TokenKind::String && Peek().kind != TokenKind::Word)
+                {
+                    error = "expected a value" + Near();
+                    return false;
+                }
+                condition.literal = Peek().text;
+                ++position;
+                conditions.push_back(std::move(condition));
+            } while (Accept("and"));
+        }
+
+        if (Accept("limit"))
+        {
+            if (Peek().kind != TokenKind::Word || !parse_literal(Peek().text, limit))
+            {
+                error = "expected a row count" + Near();
+                return false;
+            }
+            ++position;
+        }
+        AcceptSymbol(";");
+        if (Peek().kind != TokenKind::End)
+        {
+            error = "unexpected '" + Peek().text + "'";
+            return false;
+        }
+
+        return Resolve(store, error);
+    }
+
+    bool Lookup(const Name& name, Ref& ref, std::string& error) const
+    {
+        size_t found = 0;
+        for (size_t t = 0; t < tables.size(); ++t)
+        {
+            if (!name.qualifier.empty() && name.qualifier != aliases[t] && name.qualifier != table_names[t] && name.qualifier != tables[t]->name)
+                continue;
+            for (Column& column : tables[t]->columns)
+            {
+                if (column.name != name.column)
+                    continue;
+                if (found++ == 0)
+                {
+                    ref.table = t;
+                    ref.column = &column;
+                }
+                break;
+            }
+        }
+        if (found == 1)
+            return true;
+        error = found ? "ambiguous column " + name.text : "no column " + name.text;
+        return false;
+    }
+
+    bool Resolve(TableStore& store, std::string& error)
+    {
+        for (size_t k = 0; k < joins.size(); ++k)
+        {
+            Join& join = joins[k];
+            if (!Lookup(join.left_name, join.left, error) || !Lookup(join.right_name, join.right, error))
+                return false;
+            if (join.left.table == k + 1)
+                std::swap(join.left, join.right);
+            if (join.right.table != k + 1 || join.left.table > k)
+            {
+                error = "join with " + table_names[k + 1] + " must match one of its columns with an earlier table";
+                return false;
+            }
+        }
+
+        for (Condition& condition : conditions)
+        {
+            if (!Lookup(condition.name, condition.ref, error))
+                return false;
+            ColumnType type = condition.ref.column->type;
+            if (type == ColumnType::Integer && parse_literal(condition.literal, condition.integer_value))
+            {
+                condition.numeric = condition.integer = true;
+                int64_t canonical;
+                condition.by_id = DBParser::ParseInteger(condition.literal, canonical);
+            }
+            else if (type != ColumnType::Text && parse_literal(condition.literal, condition.real_value) && std::isfinite(condition.real_value))
+            {
+                condition.numeric = true;
+            }
+            else
+            {
+                condition.by_id = true;
+            }
+            condition.by_id = condition.by_id && (condition.op == Op::Equal || condition.op == Op::NotEqual);
+            condition.text_id = store.FindString(condition.literal);
+        }
+
+        if (select_all)
+        {
+            for (size_t t = 0; t < tables.size(); ++t)
+            {
+                const std::string& prefix = aliases[t].empty() ? table_names[t] : aliases[t];
+                for (Column& column : tables[t]->columns)
+                {
+                    select.push_back({ t, &column });
+                    headers.push_back(tables.size() == 1 ? column.name : prefix + "." + column.name);
+                }
+            }
+        }
+        for (const Name& name : select_names)
+        {
+            select.emplace_back();
+            if (!Lookup(name, select.back(), error))
+                return false;
+            headers.push_back(name.text);
+        }
+        return true;
+    }
+
+    static bool Matches(const TableStore& store, const Condition& condition, uint32_t row)
+    {
+        const Column& column = *condition.ref.column;
+        uint32_t id = column.text[row];
+        if (id == MISSING)
+            return false;
+        if (condition.by_id)
+            return (id == condition.text_id) == (condition.op == Op::Equal);
+
+        int order;
+        if (condition.integer)
+            order = compare(column.integers[row], condition.integer_value);
+        else if (condition.numeric)
+            order = compare(column.type == ColumnType::Integer ? static_cast<double>(column.integers[row]) : column.reals[row], condition.real_value);
+        else
+            order = compare(store.Text(id), std::string_view(condition.literal));
+        return apply_op(condition.op, order);
+    }
+};
+
+uint32_t TableStore::StringIds::Insert(std::string_view text, std::vector<std::string_view>& strings, bool& added)
+{
+    if ((strings.size() + 1) * 2 > slots.size())
+        Grow();
+    uint64_t tag = static_cast<uint32_t>(Core::Hash64(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+    size_t mask = slots.size() - 1;
+    for (size_t slot = tag & mask; ; slot = (slot + 1) & mask)
+    {
+        uint64_t entry = slots[slot];
+        if (entry == 0)
+        {
+            strings.push_back(text);
+            slots[slot] = tag << 32 | strings.size();
+            added = true;
+            return static_cast<uint32_t>(strings.size()) - 1;
+        }
+        uint32_t id = static_cast<uint32_t>(entry) - 1;
+        if (entry >> 32 == tag && strings[id] == text)
+        {
+            added = false;
+            return id;
+        }
+    }
+}
+
+uint32_t TableStore::StringIds::Find(std::string_view text, const std::vector<std::string_view>& strings) const
+{
+    if (slots.empty())
+        return MISSING;
+    uint64_t tag = static_cast<uint32_t>(Core::Hash64(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+    size_t mask = slots.size() - 1;
+    for (size_t slot = tag & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        uint64_t entry = slots[slot];
+        uint32_t id = static_cast<uint32_t>(entry) - 1;
+        if (entry >> 32 == tag && strings[id] == text)
+            return id;
+    }
+    return MISSING;
+}
+
+// Slot positions come from the stored tags, so nothing is hashed again.
+void TableStore::StringIds::Grow()
+{
+    std::vector<uint64_t> old = std::move(slots);
+    slots.assign(std::max<size_t>(old.size() * 2, 1024), 0);
+    size_t mask = slots.size() - 1;
+    for (uint64_t entry : old)
+    {
+        if (entry == 0)
+            continue;
+        size_t slot = (entry >> 32) & mask;
+        while (slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = entry;
+    }
+}
+
+uint32_t TableStore::Intern(std::string_view text)
+{
+    bool added;
+    uint32_t id = string_ids.Insert(text, strings, added);
+    if (!added)
+        return id;
+
+    if (string_blocks.empty() || block_used + text.size() > block_size)
+    {
+        block_size = std::max(STRING_BLOCK_SIZE, text.size());
+        string_blocks.push_back(std::make_unique<char[]>(block_size));
+        block_used = 0;
+    }
+    char* copy = string_blocks.back().get() + block_used;
+    if (!text.empty())
+        std::memcpy(copy, text.data(), text.size());
+    block_used += text.size();
+
+    strings[id] = std::string_view(copy, text.size());
+    return id;
+}
+
+uint32_t TableStore::FindString(std::string_view text) const
+{
+    return string_ids.Find(text, strings);
+}
+
+TableStore::Table* TableStore::FindTable(const std::string& name, std::string& error) const
+{
+    auto exact = table_names.find(name);
+    if (exact != table_names.end())
+        return exact->second;
+
+    for (const auto* names : { &folded_names, &file_names })
+    {
+        auto found = names->find(DBParser::LowerAscii(name));
+        if (found == names->end())
+            continue;
+        if (!found->second)
+        {
+            error = "table name " + name + " is ambiguous, use its full path";
+            return nullptr;
+        }
+        return found->second;
+    }
+    error = "no table " + name;
+    return nullptr;
+}
+
+const TableStore::Index& TableStore::GetIndex(Column& column)
+{
+    if (column.index)
+        return *column.index;
+
+    // Counts first, so every id's rows land in one slice of a single array.
+    auto index = std::make_unique<Index>();
+    for (uint32_t id : column.text)
+    {
+        if (id != MISSING)
+            index->ranges[id].second++;
+    }
+    uint32_t offset = 0;
+    for (auto& [id, range] : index->ranges)
+    {
+        range.first = offset;
+        offset += range.second;
+        range.second = 0;
+    }
+    index->rows.resize(offset);
+    for (uint32_t row = 0; row < column.text.size(); ++row)
+    {
+        uint32_t id = column.text[row];
+        if (id == MISSING)
+            continue;
+        auto& range = index->ranges[id];
+        index->rows[range.first + range.second++] = row;
+    }
+    column.index = std::move(index);
+    return *column.index;
+}
+
+bool TableStore::Write(const std::string& relative_path, const uint8_t* data, size_t size)
+{
+    if (!DBParser::IsDBPath(relative_path))
+        return true;
+
+    DBParser::Table source;
+    std::string error;
+    if (!source.Load(std::vector<uint8_t>(data, data + size), error))
+    {
+        LogError("Failed to load DB for queries: " + relative_path + " - " + error);
+        return false;
+    }
+    if (source.ColumnNames().empty())
+    {
+        LogInfo("DB has no columns, not loaded for queries: " + relative_path);
+        return true;
+    }
+
+    auto table = std::make_unique<Table>();
+    table->source = relative_path;
+    for (const std::string& name : source.ColumnNames())
+    {
+        table->columns.emplace_back();
+        table->columns.back().name = name;
+    }
+
+    // Values are numbered per table first, so the shared pool only sees each
+    // distinct value once and the lock is held for that alone.
+    StringIds local_ids;
+    std::vector<std::string_view> local_strings;
+    std::vector<std::string_view> values;
+    for (uint32_t row = 0; row < source.RowCount(); ++row)
+    {
+        if (!source.GetRow(row, values))
+            continue;
+        for (size_t j = 0; j < table->columns.size(); ++j)
+        {
+            uint32_t id = MISSING;
+            if (j < values.size())
+            {
+                bool added;
+                id = local_ids.Insert(values[j], local_strings, added);
+            }
+            table->columns[j].text.push_back(id);
+        }
+        table->row_count++;
+    }
+
+    // A column is numeric when every value it has is; an empty one stays text.
+    enum : uint8_t { IS_INTEGER = 1, IS_REAL = 2 };
+    std::vector<uint8_t> kinds(local_strings.size());
+    std::vector<int64_t> integers(local_strings.size());
+    std::vector<double> reals(local_strings.size());
+    for (size_t i = 0; i < local_strings.size(); ++i)
+    {
+        if (DBParser::ParseInteger(local_strings[i], integers[i]))
+            kinds[i] |= IS_INTEGER;
+        if (parse_real(local_strings[i], reals[i]))
+            kinds[i] |= IS_REAL;
+    }
+    for (Column& column : table->columns)
+    {
+        uint8_t common = IS_INTEGER | IS_REAL;
+        bool any = false;
+        for (uint32_t id : column.text)
+        {
+            if (id == MISSING)
+                continue;
+            common &= kinds[id];
+            any = true;
+        }
+        if (!any || !common)
+            continue;
+        column.type = (common & IS_INTEGER) ? ColumnType::Integer : ColumnType::Real;
+        for (uint32_t id : column.text)
+        {
+            if (column.type == ColumnType::Integer)
+                column.integers.push_back(id == MISSING ? 0 : integers[id]);
+            else
+                column.reals.push_back(id == MISSING ? 0.0 : reals[id]);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(store_mutex);
+    if (finished)
+        return false;
+
+    std::vector<uint32_t> global_ids(local_strings.size());
+    for (size_t i = 0; i < local_strings.size(); ++i)
+        global_ids[i] = Intern(local_strings[i]);
+    for (Column& column : table->columns)
+    {
+        for (uint32_t& id : column.text)
+        {
+            if (id != MISSING)
+                id = global_ids[id];
+        }
+    }
+
+    std::string name = relative_path.substr(0, relative_path.size() - 3); // without ".db"
+    table->name = name;
+    for (int suffix = 2; table_names.count(table->name); ++suffix)
+        table->name = name + "_" + std::to_string(suffix);
+    table_names[table->name] = table.get();
+    row_count += table->row_count;
+    tables.push_back(std::move(table));
+    return true;
+}
+
+void TableStore::Finish()
+{
+    std::lock_guard<std::mutex> lock(store_mutex);
+    if (finished)
+        return;
+    finished = true;
+
+    // Workers finish in any order; sorting keeps SELECT * and names stable.
+    std::sort(tables.begin(), tables.end(), [](const auto& a, const auto& b) { return a->name < b->name; });
+    auto add_name = [](std::unordered_map<std::string, Table*>& names, const std::string& name, Table* table)
+    {
+        auto [found, inserted] = names.try_emplace(DBParser::LowerAscii(name), table);
+        if (!inserted)
+            found->second = nullptr;
+    };
+    for (const auto& table : tables)
+    {
+        add_name(folded_names, table->name, table.get());
+        add_name(file_names, file_name(table->name), table.get());
+    }
+    LogInfo("Loaded " + std::to_string(tables.size()) + " tables for queries: " + std::to_string(row_count) + " rows, " +
+            std::to_string(strings.size()) + " distinct values");
+}
+
+bool TableStore::BuildIndex(const std::string& reference, std::string& error)
+{
+    size_t dot = reference.find_last_of('.');
+    if (dot == std::string::npos || dot == 0 || dot + 1 == reference.size())
+    {
+        error = "expected table.column, got " + reference;
+        return false;
+    }
+    if (!finished)
+    {
+        error = "tables are still loading";
+        return false;
+    }
+    Table* table = FindTable(reference.substr(0, dot), error);
+    if (!table)
+        return false;
+    std::string name = reference.substr(dot + 1);
+    for (Column& column : table->columns)
+    {
+        if (column.name == name)
+        {
+            GetIndex(column);
+            return true;
+        }
+    }
+    error = "no column " + name + " in " + table->name;
+    return false;
+}
+
+bool TableStore::Run(const std::string& text, Result& result, std::string& error)
+{
+    result = Result();
+    if (!finished)
+    {
+        error = "tables are still loading";
+        return false;
+    }
+    Query query;
+    if (!query.Parse(text, *this, error))
+        return false;
+
+    std::vector<std::vector<const Query::Condition*>> filters(query.tables.size());
+    for (const Query::Condition& condition : query.conditions)
+        filters[condition.ref.table].push_back(&condition);
+    auto passes = [&](size_t table, uint32_t row)
+    {
+        for (const Query::Condition* condition : filters[table])
+        {
+            if (!Query::Matches(*this, *condition, row))
+                return false;
+        }
+        return true;
+    };
+
+    // Each stage extends every partial row by one table. Rows are taken in
+    // table order, so the last stage can stop as soon as it has enough.
+    size_t stages = query.tables.size();
+    size_t wanted = query.limit;
+    auto enough = [&](const std::vector<uint32_t>& rows, size_t stage)
+    {
+        return stage + 1 == stages && rows.size() / stages >= wanted;
+    };
+
+    std::vector<uint32_t> tuples;
+    const Query::Condition* lookup = nullptr;
+    for (const Query::Condition* condition : filters[0])
+    {
+        if (condition->by_id && condition->op == Op::Equal)
+        {
+            lookup = condition;
+            break;
+        }
+    }
+    if (lookup)
+    {
+        const Index& index = GetIndex(*lookup->ref.column);
+        auto found = index.ranges.find(lookup->text_id);
+        if (found != index.ranges.end())
+        {
+            for (uint32_t i = 0; i < found->second.second && !enough(tuples, 0); ++i)
+            {
+                uint32_t row = index.rows[found->second.first + i];
+                if (passes(0, row))
+                    tuples.push_back(row);
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t row = 0; row < query.tables[0]->row_count && !enough(tuples, 0); ++row)
+        {
+            if (passes(0, row))
+                tuples.push_back(row);
+        }
+    }
+
+    for (size_t stage = 1; stage < stages && !tuples.empty(); ++stage)
+    {
+        const Query::Join& join = query.joins[stage - 1];
+        const Index& index = GetIndex(*join.right.column);
+        std::vector<uint32_t> joined;
+        for (size_t start = 0; start < tuples.size() && !enough(joined, stage); start += stage)
+        {
+            auto found = index.ranges.find(join.left.column->text[tuples[start + join.left.table]]);
+            if (found == index.ranges.end())
+                continue;
+            for (uint32_t i = 0; i < found->second.second && !enough(joined, stage); ++i)
+            {
+                uint32_t row = index.rows[found->second.first + i];
+                if (!passes(stage, row))
+                    continue;
+                joined.insert(joined.end(), tuples.begin() + start, tuples.begin() + start + stage);
+                joined.push_back(row);
+            }
+        }
+        tuples = std::move(joined);
+    }
+
+    result.columns = std::move(query.headers);
+    size_t rows = tuples.size() / stages;
+    result.cells.reserve(rows * query.select.size());
+    for (size_t r = 0; r < rows; ++r)
+    {
+        for (const Query::Ref& ref : query.select)
+            result.cells.push_back(ref.column->text[tuples[r * stages + ref.table]]);
+    }
+    return true;
+}
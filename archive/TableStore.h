@@ -0,0 +1,126 @@
+#pragma once
+#include "OutputSink.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Loads every .db file written to it into memory so tables from a whole archive
+// can be filtered and joined without exporting them. Each table is stored as
+// columns of ids into one pool of interned strings; columns whose values are
+// all integers or all numbers also keep them typed. Tables are named after the
+// file's path without the extension and can be referred to by their file name
+// alone when that is unique. Files are decrypted and split on the calling
+// worker thread; the lock is only taken to intern a table's distinct values.
+//
+// Queries take a small subset of SQL:
+//   SELECT * | column, ... FROM table [AS alias]
+//       [JOIN table [AS alias] ON column = column]...
+//       [WHERE column op literal [AND column op literal]...] [LIMIT n]
+// where op is one of = != <> < <= > >=. Columns are written as name or
+// table.column, identifiers may be double-quoted and text literals are
+// single-quoted. Numeric columns compare numerically against numeric literals,
+// everything else compares as text; joins match values by their text. Missing
+// values never match.
+//
+// Equality filters and joins use a hash index on the column, built the first
+// time it is needed. Run and BuildIndex must not be called concurrently.
+class TableStore : public IOutputSink {
+public:
+    enum class ColumnType { Text, Integer, Real };
+
+    // String id of a value the row does not have.
+    static constexpr uint32_t MISSING = UINT32_MAX;
+
+    struct Result {
+        std::vector<std::string> columns;
+        // Row-major string ids; Text() resolves them.
+        std::vector<uint32_t> cells;
+
+        size_t RowCount() const { return columns.empty() ? 0 : cells.size() / columns.size(); }
+    };
+
+    TableStore() = default;
+    TableStore(const TableStore&) = delete;
+    TableStore& operator=(const TableStore&) = delete;
+
+    bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override;
+    // Sorts the tables by name; queries are refused before this.
+    void Finish() override;
+
+    // Indexes column of table, written as table.column.
+    bool BuildIndex(const std::string& reference, std::string& error);
+    bool Run(const std::string& query, Result& result, std::string& error);
+
+    std::string_view Text(uint32_t id) const { return strings[id]; }
+
+    size_t GetTableCount() const { return tables.size(); }
+    uint64_t GetRowCount() const { return row_count; }
+    size_t GetStringCount() const { return strings.size(); }
+
+private:
+    // Rows holding each string id, grouped by id and in row order.
+    struct Index {
+        std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> ranges;
+        std::vector<uint32_t> rows;
+    };
+
+    struct Column {
+        std::string name;
+        ColumnType type = ColumnType::Text;
+        std::vector<uint32_t> text;
+        // Filled for Integer and Real columns only; missing values hold 0.
+        std::vector<int64_t> integers;
+        std::vector<double> reals;
+        std::unique_ptr<Index> index;
+    };
+
+    struct Table {
+        std::string name;
+        std::string source;
+        uint32_t row_count = 0;
+        std::vector<Column> columns;
+    };
+
+    // Open-addressed map from text to its position in a string list. Loading
+    // looks up every value of every table, which std::unordered_map's node
+    // per entry makes several times slower.
+    class StringIds {
+    public:
+        // Appends text to strings when it is not there yet.
+        uint32_t Insert(std::string_view text, std::vector<std::string_view>& strings, bool& added);
+        uint32_t Find(std::string_view text, const std::vector<std::string_view>& strings) const;
+
+    private:
+        void Grow();
+
+        // Low 32 bits of the hash over id + 1, so most mismatches are
+        // rejected without touching the string; 0 marks a free slot.
+        std::vector<uint64_t> slots;
+    };
+
+    struct Query;
+
+    uint32_t Intern(std::string_view text);
+    uint32_t FindString(std::string_view text) const;
+    Table* FindTable(const std::string& name, std::string& error) const;
+    const Index& GetIndex(Column& column);
+
+    std::mutex store_mutex;
+    std::vector<std::unique_ptr<char[]>> string_blocks;
+    size_t block_used = 0;
+    size_t block_size = 0;
+    std::vector<std::string_view> strings;
+    StringIds string_ids;
+
+    std::vector<std::unique_ptr<Table>> tables;
+    std::unordered_map<std::string, Table*> table_names;
+    // Lower-cased full names and file names; nullptr marks an ambiguous one.
+    std::unordered_map<std::string, Table*> folded_names;
+    std::unordered_map<std::string, Table*> file_names;
+    uint64_t row_count = 0;
+    bool finished = false;
+};
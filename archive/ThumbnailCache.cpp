@@ -0,0 +1,297 @@
+#include "ThumbnailCache.h"
+#include "core/Core.h"
+#include "core/Hash.h"
+#include "core/LZ4.h"
+#include "core/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    constexpr char MAGIC[8] = { 'C', 'Z', 'N', 'T', 'H', 'M', 'B', '2' };
+
+    // hash, max_size, width, height, compressed size, checksum of the pixels
+    constexpr size_t RECORD_HEADER = 8 + 4 + 2 + 2 + 4 + 8;
+
+    void encode_header(uint8_t* out, uint64_t hash, uint32_t max_size, uint16_t width, uint16_t height,
+        uint32_t stored_size, uint64_t checksum)
+    {
+        std::memcpy(out, &hash, 8);
+        std::memcpy(out + 8, &max_size, 4);
+        std::memcpy(out + 12, &width, 2);
+        std::memcpy(out + 14, &height, 2);
+        std::memcpy(out + 16, &stored_size, 4);
+        std::memcpy(out + 20, &checksum, 8);
+    }
+
+    // Each pixel minus the one to its left, as PNG's Sub filter; thumbnails
+    // compress to well under half their size this way.
+    void filter_rows(std::vector<uint8_t>& pixels, int width, int height)
+    {
+        size_t row_bytes = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < height; ++y)
+        {
+            uint8_t* row = pixels.data() + y * row_bytes;
+            for (size_t x = row_bytes; x-- > 4;)
+                row[x] = static_cast<uint8_t>(row[x] - row[x - 4]);
+        }
+    }
+
+    void unfilter_rows(std::vector<uint8_t>& pixels, int width, int height)
+    {
+        size_t row_bytes = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < height; ++y)
+        {
+            uint8_t* row = pixels.data() + y * row_bytes;
+            for (size_t x = 4; x < row_bytes; ++x)
+                row[x] = static_cast<uint8_t>(row[x] + row[x - 4]);
+        }
+    }
+}
+
+ThumbnailCache::ThumbnailCache(const std::wstring& path, uint64_t max_bytes)
+    : path(path), max_bytes(max_bytes)
+{
+    Open();
+}
+
+void ThumbnailCache::Open()
+{
+    std::filesystem::path file_path = Core::WidePath(path);
+    std::error_code ec;
+    uint64_t valid_end = 0;
+
+    // Index every complete record; anything after the last one (an interrupted
+    // write) is cut off so appends start from a clean end.
+    {
+        std::ifstream in(file_path, std::ios::binary);
+        char magic[sizeof(MAGIC)] = {};
+        if (in && in.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0)
+        {
+            uint64_t size = std::filesystem::file_size(file_path, ec);
+            valid_end = sizeof(MAGIC);
+            uint8_t header[RECORD_HEADER];
+            while (!ec && valid_end + RECORD_HEADER <= size)
+            {
+                in.seekg(static_cast<std::streamoff>(valid_end));
+                if (!in.read(reinterpret_cast<char*>(header), RECORD_HEADER))
+                    break;
+                Key key;
+                uint16_t width;
+                uint16_t height;
+                Entry entry;
+                std::memcpy(&key.hash, header, 8);
+                std::memcpy(&key.max_size, header + 8, 4);
+                std::memcpy(&width, header + 12, 2);
+                std::memcpy(&height, header + 14, 2);
+                std::memcpy(&entry.stored_size, header + 16, 4);
+                std::memcpy(&entry.checksum, header + 20, 8);
+                if (width == 0 || height == 0 || valid_end + RECORD_HEADER + entry.stored_size > size)
+                    break;
+                entry.offset = valid_end + RECORD_HEADER;
+                entry.width = width;
+                entry.height = height;
+                index[key] = entry;
+                valid_end = entry.offset + entry.stored_size;
+            }
+        }
+    }
+
+    if (valid_end == 0)
+    {
+        std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(MAGIC, sizeof(MAGIC)))
+        {
+            LogError("Failed to create thumbnail cache: " + Core::PathToUtf8(file_path));
+            return;
+        }
+        valid_end = sizeof(MAGIC);
+    }
+    else if (std::filesystem::file_size(file_path, ec) != valid_end)
+    {
+        std::filesystem::resize_file(file_path, valid_end, ec);
+        if (ec)
+            LogError("Failed to trim thumbnail cache: " + ec.message());
+    }
+
+    file.open(file_path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file)
+    {
+        LogError("Failed to open thumbnail cache: " + Core::PathToUtf8(file_path));
+        index.clear();
+        return;
+    }
+    file_size = valid_end;
+    LogInfo("Thumbnail cache: " + std::to_string(index.size()) + " entries, " + std::to_string(file_size) + " bytes");
+}
+
+void ThumbnailCache::Reset()
+{
+    file.close();
+    index.clear();
+    std::filesystem::path file_path = Core::WidePath(path);
+    {
+        std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+        out.write(MAGIC, sizeof(MAGIC));
+    }
+    file.open(file_path, std::ios::binary | std::ios::in | std::ios::out);
+    file_size = sizeof(MAGIC);
+}
+
+bool ThumbnailCache::Find(uint64_t content_hash, int max_size, SCTParser::RGBAImage& image)
+{
+    std::lock_guard<std::mutex> lock(file_mutex);
+    auto it = index.find({content_hash, static_cast<uint32_t>(max_size)});
+    if (it == index.end() || !file.is_open())
+        return false;
+
+    const Entry& entry = it->second;
+    std::vector<uint8_t> stored(entry.stored_size);
+    std::vector<uint8_t> pixels(static_cast<size_t>(entry.width) * entry.height * 4);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(entry.offset));
+    bool ok = false;
+    if (file.read(reinterpret_cast<char*>(stored.data()), stored.size()) &&
+        Core::LZ4DecodeBlock(stored.data(), stored.size(), pixels.data(), pixels.size(), &ok) == pixels.size() && ok)
+    {
+        unfilter_rows(pixels, entry.width, entry.height);
+        ok = Core::Hash64(pixels.data(), pixels.size()) == entry.checksum;
+    }
+    if (!ok)
+    {
+        file.clear();
+        index.erase(it);
+        return false;
+    }
+
+    image.data = std::move(pixels);
+    image.width = entry.width;
+    image.height = entry.height;
+    return true;
+}
+
+void ThumbnailCache::Evict(uint64_t budget)
+{
+    std::vector<std::pair<Key, Entry>> entries(index.begin(), index.end());
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.second.offset < b.second.offset; });
+
+    // Keep the newest entries, in file order.
+    size_t first = entries.size();
+    uint64_t kept = sizeof(MAGIC);
+    while (first > 0 && kept + RECORD_HEADER + entries[first - 1].second.stored_size <= budget)
+    {
+        --first;
+        kept += RECORD_HEADER + entries[first].second.stored_size;
+    }
+
+    std::filesystem::path file_path = Core::WidePath(path);
+    std::filesystem::path temp_path = file_path;
+    temp_path += ".tmp";
+    std::unordered_map<Key, Entry, KeyHash> kept_index;
+    uint64_t kept_size = sizeof(MAGIC);
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(MAGIC, sizeof(MAGIC));
+        std::vector<char> record;
+        for (size_t i = first; i < entries.size() && out; ++i)
+        {
+            Entry entry = entries[i].second;
+            record.resize(RECORD_HEADER + entry.stored_size);
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(entry.offset - RECORD_HEADER));
+            if (!file.read(record.data(), record.size()))
+                break;
+            out.write(record.data(), record.size());
+            entry.offset = kept_size + RECORD_HEADER;
+            kept_size += record.size();
+            kept_index[entries[i].first] = entry;
+        }
+        if (!out)
+            kept_size = 0;
+    }
+
+    file.close();
+    std::error_code ec;
+    if (kept_size != 0)
+        std::filesystem::rename(temp_path, file_path, ec);
+    if (kept_size == 0 || ec)
+    {
+        LogError("Failed to compact thumbnail cache; starting over");
+        std::filesystem::remove(temp_path, ec);
+        Reset();
+        return;
+    }
+
+    file.open(file_path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file)
+    {
+        index.clear();
+        return;
+    }
+    index = std::move(kept_index);
+    file_size = kept_size;
+    LogInfo("Thumbnail cache: kept " + std::to_string(index.size()) + " newest entries, " + std::to_string(file_size) + " bytes");
+}
+
+void ThumbnailCache::Store(uint64_t content_hash, int max_size, const SCTParser::RGBAImage& image)
+{
+    if (image.width <= 0 || image.height <= 0 || image.width > 0xFFFF || image.height > 0xFFFF ||
+        image.data.size() < static_cast<size_t>(image.width) * image.height * 4)
+        return;
+
+    size_t pixel_bytes = static_cast<size_t>(image.width) * image.height * 4;
+    std::vector<uint8_t> filtered(image.data.begin(), image.data.begin() + pixel_bytes);
+    filter_rows(filtered, image.width, image.height);
+    std::vector<uint8_t> record(RECORD_HEADER);
+    Core::LZ4CompressBlock(filtered.data(), filtered.size(), record);
+    uint32_t stored_size = static_cast<uint32_t>(record.size() - RECORD_HEADER);
+
+    Entry entry;
+    entry.stored_size = stored_size;
+    entry.width = image.width;
+    entry.height = image.height;
+    entry.checksum = Core::Hash64(image.data.data(), pixel_bytes);
+    encode_header(record.data(), content_hash, static_cast<uint32_t>(max_size), static_cast<uint16_t>(image.width),
+        static_cast<uint16_t>(image.height), stored_size, entry.checksum);
+
+    std::lock_guard<std::mutex> lock(file_mutex);
+    if (!file.is_open() || sizeof(MAGIC) + record.size() > max_bytes)
+        return;
+
+    if (file_size + record.size() > max_bytes)
+    {
+        uint64_t target = max_bytes - max_bytes / 4;
+        Evict(target > record.size() ? target - record.size() : 0);
+    }
+    if (!file.is_open())
+        return;
+
+    entry.offset = file_size + RECORD_HEADER;
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(file_size));
+    file.write(reinterpret_cast<const char*>(record.data()), record.size());
+    file.flush();
+    if (!file)
+    {
+        // The partial record is past file_size and gets overwritten by the next store.
+        file.clear();
+        LogError("Failed to write thumbnail cache entry");
+        return;
+    }
+    file_size = entry.offset + stored_size;
+    index[{content_hash, static_cast<uint32_t>(max_size)}] = entry;
+}
+
+SCTParser::RGBAImage ThumbnailCache::Get(const std::vector<uint8_t>& sct_data, int max_size)
+{
+    SCTParser::RGBAImage image;
+    uint64_t hash = Core::Hash64(sct_data.data(), sct_data.size());
+    if (Find(hash, max_size, image))
+        return image;
+
+    image = SCTParser::ConvertToThumbnail(sct_data, max_size);
+    if (!image.data.empty())
+        Store(hash, max_size, image);
+    return image;
+}
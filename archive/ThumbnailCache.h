@@ -0,0 +1,61 @@
+#pragma once
+#include "SCTParser.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Keeps SCT thumbnails on disk between runs, so textures are only decoded the
+// first time they are previewed. Entries are keyed by the hash of the source
+// file and the requested size, and appended to a single file whose index is
+// rebuilt when it is opened. Pixels are stored row-delta filtered and LZ4
+// compressed.
+class ThumbnailCache {
+public:
+    // When the file would grow past max_bytes, the oldest entries are dropped
+    // until it is back to three quarters of that.
+    explicit ThumbnailCache(const std::wstring& path, uint64_t max_bytes = 256ull * 1024 * 1024);
+
+    bool IsOpen() const { return file.is_open(); }
+
+    // Returns the cached thumbnail, decoding and storing it on a miss.
+    // Returns an empty image if the data cannot be decoded.
+    SCTParser::RGBAImage Get(const std::vector<uint8_t>& sct_data, int max_size);
+
+    bool Find(uint64_t content_hash, int max_size, SCTParser::RGBAImage& image);
+    void Store(uint64_t content_hash, int max_size, const SCTParser::RGBAImage& image);
+
+private:
+    struct Key {
+        uint64_t hash = 0;
+        uint32_t max_size = 0;
+
+        bool operator==(const Key& other) const { return hash == other.hash && max_size == other.max_size; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash ^ key.max_size); }
+    };
+
+    struct Entry {
+        uint64_t offset = 0;    // of the compressed pixels
+        uint32_t stored_size = 0;
+        int width = 0;
+        int height = 0;
+        uint64_t checksum = 0;  // of the decoded pixels
+    };
+
+    void Open();
+    void Reset();
+    // Rewrites the file with the newest entries that fit in budget bytes.
+    void Evict(uint64_t budget);
+
+    std::mutex file_mutex;
+    std::wstring path;
+    std::fstream file;
+    uint64_t file_size = 0;
+    uint64_t max_bytes = 0;
+    std::unordered_map<Key, Entry, KeyHash> index;
+};
@@ -0,0 +1,421 @@
+#define NOMINMAX
+#include "SyntheticPack.h"
+#include "archive/DataPack.h"
+#include "archive/SSRArchive.h"
+#include "archive/OutputSink.h"
+#include "archive/TableStore.h"
+#include "parsers/SCTParser.h"
+#include "parsers/DBParser.h"
+#include "parsers/SCSPParser.h"
+#include "core/Logger.h"
+#include "json.hpp"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::ordered_json;
+
+namespace
+{
+    struct BenchOptions
+    {
+        Bench::SyntheticConfig data;
+        std::filesystem::path work_dir = "ripper_bench_data";
+        std::string report_path;
+        uint32_t random_reads = 2000;
+        bool keep_data = false;
+        bool verbose = false;
+    };
+
+    uint64_t peak_rss_bytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    uint64_t directory_size(const std::filesystem::path& dir)
+    {
+        uint64_t total = 0;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir))
+        {
+            if (entry.is_regular_file())
+                total += entry.file_size();
+        }
+        return total;
+    }
+
+    void collect_files(const Core::FileNode& node, std::vector<const Core::FileNode*>& out)
+    {
+        if (std::holds_alternative<Core::FileInfo>(node.data))
+        {
+            out.push_back(&node);
+            return;
+        }
+        for (const auto& child : std::get<Core::FolderInfo>(node.data).children)
+            collect_files(child, out);
+    }
+
+    // Runs body once and reports throughput over the given input volume.
+    json measure(const std::string& phase, const std::string& target, const std::function<void(uint64_t& files, uint64_t& bytes, json& extra)>& body)
+    {
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        json extra = json::object();
+
+        auto start = std::chrono::steady_clock::now();
+        body(files, bytes, extra);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        json result;
+        result["phase"] = phase;
+        result["target"] = target;
+        result["seconds"] = seconds;
+        result["files"] = files;
+        result["bytes"] = bytes;
+        result["mb_per_s"] = seconds > 0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
+        result["files_per_s"] = seconds > 0 ? files / seconds : 0.0;
+        result["peak_rss_bytes"] = peak_rss_bytes();
+        for (auto& [key, value] : extra.items())
+            result[key] = value;
+
+        std::cerr << phase << " [" << target << "]: " << seconds << " s\n";
+        return result;
+    }
+
+    void bench_archive(IArchive& archive, const std::string& name, const std::filesystem::path& dir, const BenchOptions& options, json& results)
+    {
+        std::atomic<float> progress{0.0f};
+        const uint64_t on_disk = directory_size(dir);
+
+        results.push_back(measure("scan", name, [&](uint64_t& files, uint64_t& bytes, json&)
+        {
+            archive.Scan(progress);
+            files = archive.GetParsedFileCount();
+            bytes = on_disk;
+        }));
+
+        std::vector<const Core::FileNode*> nodes;
+        collect_files(archive.GetFileTree(), nodes);
+        if (nodes.empty())
+            throw std::runtime_error(name + ": scan found no files");
+
+        results.push_back(measure("random_read", name, [&](uint64_t& files, uint64_t& bytes, json&)
+        {
+            std::mt19937 order(options.data.seed);
+            for (uint32_t i = 0; i < options.random_reads; ++i)
+            {
+                const Core::FileNode* node = nodes[order() % nodes.size()];
+                bytes += archive.GetFileData(*node).size();
+                ++files;
+            }
+        }));
+
+        for (bool convert : { false, true })
+        {
+            results.push_back(measure(convert ? "extract_null_convert" : "extract_null", name, [&](uint64_t& files, uint64_t& bytes, json& extra)
+            {
+                NullSink sink;
+                ExtractOptions extract_options;
+                extract_options.convert_sct_to_png = convert;
+                extract_options.convert_db_to_json = convert;
+                archive.Extract(archive.GetFileTree(), sink, progress, extract_options);
+                files = sink.GetFileCount();
+                bytes = archive.GetParsedTotalSize();
+                extra["output_bytes"] = sink.GetByteCount();
+            }));
+        }
+    }
+
+    void bench_converters(const std::vector<Bench::SyntheticFile>& files, json& results)
+    {
+        auto run = [&](const char* phase, Bench::PayloadKind kind, const std::function<size_t(const std::vector<uint8_t>&)>& convert)
+        {
+            results.push_back(measure(phase, "memory", [&](uint64_t& count, uint64_t& bytes, json& extra)
+            {
+                uint64_t output = 0;
+                uint64_t failures = 0;
+                for (const auto& file : files)
+                {
+                    if (file.kind != kind)
+                        continue;
+                    size_t produced = convert(file.data);
+                    if (produced == 0)
+                        ++failures;
+                    output += produced;
+                    bytes += file.data.size();
+                    ++count;
+                }
+                extra["output_bytes"] = output;
+                extra["failures"] = failures;
+            }));
+        };
+
+        run("sct_to_rgba", Bench::PayloadKind::SCT, [](const std::vector<uint8_t>& data) { return SCTParser::ConvertToRGBA(data).data.size(); });
+        run("sct_to_png", Bench::PayloadKind::SCT, [](const std::vector<uint8_t>& data) { return SCTParser::ConvertToPNG(data).size(); });
+        run("sct_to_png_fast", Bench::PayloadKind::SCT, [](const std::vector<uint8_t>& data) { return SCTParser::ConvertToPNG(data, false, PngWriter::Level::Fast).size(); });
+        run("sct_to_png_best", Bench::PayloadKind::SCT, [](const std::vector<uint8_t>& data) { return SCTParser::ConvertToPNG(data, false, PngWriter::Level::Best).size(); });
+        run("sct_thumbnail_256", Bench::PayloadKind::SCT, [](const std::vector<uint8_t>& data) { return SCTParser::ConvertToThumbnail(data, 256).data.size(); });
+        run("db_to_json", Bench::PayloadKind::DB, [](const std::vector<uint8_t>& data)
+        {
+            std::vector<uint8_t> out;
+            return DBParser::ConvertToJson(data, out) ? out.size() : size_t(0);
+        });
+        run("db_to_json_compact", Bench::PayloadKind::DB, [](const std::vector<uint8_t>& data)
+        {
+            std::vector<uint8_t> out;
+            return DBParser::ConvertToJson(data, out, DBParser::JsonStyle::Compact) ? out.size() : size_t(0);
+        });
+        run("db_to_csv", Bench::PayloadKind::DB, [](const std::vector<uint8_t>& data)
+        {
+            std::vector<uint8_t> out;
+            return DBParser::ConvertTable(data, out, DBParser::TableFormat::Csv) ? out.size() : size_t(0);
+        });
+        run("scsp_to_json", Bench::PayloadKind::SCSP, [](const std::vector<uint8_t>& data)
+        {
+            try
+            {
+                return SCSPParser::ConvertSCSPToJson(data).size();
+            }
+            catch (const std::exception&)
+            {
+                return size_t(0);
+            }
+        });
+        run("scsp_to_skel", Bench::PayloadKind::SCSP, [](const std::vector<uint8_t>& data)
+        {
+            try
+            {
+                return SCSPParser::ConvertSCSP(data, SCSPParser::SkeletonFormat::Skel).size();
+            }
+            catch (const std::exception&)
+            {
+                return size_t(0);
+            }
+        });
+    }
+
+    // Loads every synthetic DB into one store, then times indexed lookups of
+    // random ids in the first table.
+    void bench_table_store(const std::vector<Bench::SyntheticFile>& files, const BenchOptions& options, json& results)
+    {
+        TableStore store;
+        std::string first_table;
+        results.push_back(measure("db_store_load", "memory", [&](uint64_t& count, uint64_t& bytes, json& extra)
+        {
+            for (const auto& file : files)
+            {
+                if (file.kind != Bench::PayloadKind::DB)
+                    continue;
+                if (first_table.empty())
+                    first_table = file.path.substr(0, file.path.find_last_of('.'));
+                store.Write(file.path, file.data.data(), file.data.size());
+                bytes += file.data.size();
+                ++count;
+            }
+            store.Finish();
+            extra["rows"] = store.GetRowCount();
+            extra["strings"] = store.GetStringCount();
+        }));
+        if (first_table.empty() || options.data.db_rows == 0)
+            return;
+
+        std::string error;
+        store.BuildIndex(first_table + ".id", error);
+        results.push_back(measure("db_point_lookup", "memory", [&](uint64_t& count, uint64_t&, json& extra)
+        {
+            std::mt19937 order(options.data.seed);
+            uint64_t found = 0;
+            TableStore::Result result;
+            for (uint32_t i = 0; i < options.random_reads; ++i)
+            {
+                std::string query = "SELECT * FROM \"" + first_table + "\" WHERE id = " + std::to_string(100000 + order() % options.data.db_rows);
+                if (store.Run(query, result, error))
+                    found += result.RowCount();
+                ++count;
+            }
+            extra["rows_found"] = found;
+        }));
+    }
+
+    void print_usage()
+    {
+        std::cerr <<
+            "usage: ripper_bench [options]\n"
+            "  --dir PATH        working directory for generated data (default ripper_bench_data)\n"
+            "  --report PATH     write the JSON report to PATH instead of stdout\n"
+            "  --seed N          generator seed (default 1)\n"
+            "  --files N         opaque files (default 512)\n"
+            "  --file-size N     average opaque file size in bytes (default 65536)\n"
+            "  --sct N           SCT2/ASTC textures (default 32)\n"
+            "  --sct-size N      texture edge in pixels (default 512)\n"
+            "  --db N            databases (default 16)\n"
+            "  --db-rows N       rows per database (default 2000)\n"
+            "  --db-cols N       columns per database (default 12)\n"
+            "  --scsp N          skeletons (default 16)\n"
+            "  --scsp-bones N    bones per skeleton (default 64)\n"
+            "  --scsp-anims N    animations per skeleton (default 8)\n"
+            "  --parts N         data.pack parts (default 3)\n"
+            "  --chunk-mb N      SSRA chunk size in MB (default 16)\n"
+            "  --reads N         random reads per archive and DB lookups (default 2000)\n"
+            "  --keep            keep generated data afterwards\n"
+            "  --verbose         write info-level messages to the log file\n";
+    }
+
+    BenchOptions parse_args(int argc, char** argv)
+    {
+        BenchOptions options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string
+            {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("missing value for " + arg);
+                return argv[++i];
+            };
+            auto number = [&]() -> uint32_t { return static_cast<uint32_t>(std::stoul(next())); };
+
+            if (arg == "--dir") options.work_dir = std::filesystem::u8path(next());
+            else if (arg == "--report") options.report_path = next();
+            else if (arg == "--seed") options.data.seed = number();
+            else if (arg == "--files") options.data.opaque_files = number();
+            else if (arg == "--file-size") options.data.opaque_size = number();
+            else if (arg == "--sct") options.data.sct_files = number();
+            else if (arg == "--sct-size") options.data.sct_size = number();
+            else if (arg == "--db") options.data.db_files = number();
+            else if (arg == "--db-rows") options.data.db_rows = number();
+            else if (arg == "--db-cols") options.data.db_cols = number();
+            else if (arg == "--scsp") options.data.scsp_files = number();
+            else if (arg == "--scsp-bones") options.data.scsp_bones = number();
+            else if (arg == "--scsp-anims") options.data.scsp_animations = number();
+            else if (arg == "--parts") options.data.pack_parts = number();
+            else if (arg == "--chunk-mb") options.data.ssra_chunk_size = static_cast<uint64_t>(number()) * 1024 * 1024;
+            else if (arg == "--reads") options.random_reads = number();
+            else if (arg == "--keep") options.keep_data = true;
+            else if (arg == "--verbose") options.verbose = true;
+            else if (arg == "--help" || arg == "-h")
+            {
+                print_usage();
+                std::exit(0);
+            }
+            else
+            {
+                throw std::runtime_error("unknown option " + arg);
+            }
+        }
+        return options;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        BenchOptions options = parse_args(argc, argv);
+        SetLogLevel(options.verbose ? LogLevel::Info : LogLevel::Error);
+
+        json report;
+        report["config"] = {
+            {"seed", options.data.seed},
+            {"opaque_files", options.data.opaque_files},
+            {"opaque_size", options.data.opaque_size},
+            {"sct_files", options.data.sct_files},
+            {"sct_size", options.data.sct_size},
+            {"db_files", options.data.db_files},
+            {"db_rows", options.data.db_rows},
+            {"db_cols", options.data.db_cols},
+            {"scsp_files", options.data.scsp_files},
+            {"scsp_bones", options.data.scsp_bones},
+            {"scsp_animations", options.data.scsp_animations},
+            {"pack_parts", options.data.pack_parts},
+            {"ssra_chunk_size", options.data.ssra_chunk_size},
+            {"random_reads", options.random_reads},
+        };
+
+        std::cerr << "generating synthetic data in " << Core::PathToUtf8(options.work_dir) << "\n";
+        auto generate_start = std::chrono::steady_clock::now();
+        std::vector<Bench::SyntheticFile> files = Bench::GenerateFiles(options.data);
+        const std::filesystem::path encrypted_dir = options.work_dir / "encrypted";
+        const std::filesystem::path decrypted_dir = options.work_dir / "decrypted";
+        const std::filesystem::path ssra_dir = options.work_dir / "ssra";
+        std::filesystem::path encrypted_pack = Bench::WriteDataPack(files, encrypted_dir, true, options.data.pack_parts);
+        std::filesystem::path decrypted_pack = Bench::WriteDataPack(files, decrypted_dir, false, options.data.pack_parts);
+        std::filesystem::path manifest = Bench::WriteSSRA(files, ssra_dir, options.data.ssra_chunk_size);
+
+        uint64_t payload_bytes = 0;
+        for (const auto& file : files)
+            payload_bytes += file.data.size();
+        report["dataset"] = {
+            {"files", files.size()},
+            {"payload_bytes", payload_bytes},
+            {"generate_seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - generate_start).count()},
+        };
+
+        json results = json::array();
+        {
+            DataPack pack(Core::PathToWString(encrypted_pack));
+            bench_archive(pack, "data.pack encrypted", encrypted_dir, options, results);
+        }
+        {
+            DataPack pack(Core::PathToWString(decrypted_pack));
+            bench_archive(pack, "data.pack decrypted", decrypted_dir, options, results);
+        }
+        {
+            SSRArchive archive(Core::PathToWString(manifest));
+            bench_archive(archive, "ssra", ssra_dir, options, results);
+        }
+        bench_converters(files, results);
+        bench_table_store(files, options, results);
+
+        report["results"] = std::move(results);
+        report["peak_rss_bytes"] = peak_rss_bytes();
+
+        if (!options.keep_data)
+            std::filesystem::remove_all(options.work_dir);
+
+        std::string text = report.dump(2);
+        if (options.report_path.empty())
+        {
+            std::cout << text << "\n";
+        }
+        else
+        {
+            std::ofstream out(std::filesystem::u8path(options.report_path), std::ios::binary | std::ios::trunc);
+            out << text << "\n";
+            if (!out)
+                throw std::runtime_error("failed to write report " + options.report_path);
+        }
+        LogFlush();
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ripper_bench: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,899 @@
+#define NOMINMAX
+#include "SyntheticPack.h"
+#include "core/Core.h"
+#include "core/Hash.h"
+#include "core/LZ4.h"
+#include "parsers/DBParser.h"
+#include <astcenc.h>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    // splitmix64; std distributions differ between standard libraries.
+    class Rng
+    {
+    public:
+        explicit Rng(uint64_t seed) : state(seed) {}
+
+        uint64_t Next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        uint32_t Below(uint32_t bound) { return bound == 0 ? 0 : static_cast<uint32_t>(Next() % bound); }
+        float Unit() { return static_cast<float>(Next() >> 40) / static_cast<float>(1 << 24); }
+        float Range(float lo, float hi) { return lo + (hi - lo) * Unit(); }
+
+    private:
+        uint64_t state;
+    };
+
+    class ByteWriter
+    {
+    public:
+        template <typename T>
+        void Put(T value)
+        {
+            size_t at = bytes.size();
+            bytes.resize(at + sizeof(T));
+            std::memcpy(bytes.data() + at, &value, sizeof(T));
+        }
+
+        template <typename T>
+        void PutAt(size_t at, T value)
+        {
+            std::memcpy(bytes.data() + at, &value, sizeof(T));
+        }
+
+        void PutBytes(const void* data, size_t size)
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            bytes.insert(bytes.end(), p, p + size);
+        }
+
+        void PutString(const std::string& s) { PutBytes(s.data(), s.size()); }
+        void PutZeros(size_t count) { bytes.resize(bytes.size() + count, 0); }
+
+        // High byte first, then the low 32 bits, as DB offsets are stored.
+        void PutUInt40(uint64_t value)
+        {
+            Put<uint8_t>(static_cast<uint8_t>(value >> 32));
+            Put<uint32_t>(static_cast<uint32_t>(value));
+        }
+
+        size_t Size() const { return bytes.size(); }
+        std::vector<uint8_t>& Bytes() { return bytes; }
+
+    private:
+        std::vector<uint8_t> bytes;
+    };
+
+    // NUL-terminated string pool addressed by byte offset, shared by SCSP and SSRA.
+    class StringPool
+    {
+    public:
+        uint32_t Add(const std::string& s)
+        {
+            auto it = offsets.find(s);
+            if (it != offsets.end())
+                return it->second;
+            uint32_t offset = static_cast<uint32_t>(data.size());
+            data.insert(data.end(), s.begin(), s.end());
+            data.push_back('\0');
+            offsets.emplace(s, offset);
+            return offset;
+        }
+
+        const std::vector<char>& Data() const { return data; }
+
+    private:
+        std::vector<char> data;
+        std::map<std::string, uint32_t> offsets;
+    };
+
+    constexpr uint32_t NO_STRING = 0xFFFFFFFF;
+
+    std::string format(const char* fmt, uint32_t a, uint32_t b = 0)
+    {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), fmt, a, b);
+        return buf;
+    }
+
+    void write_file(const std::filesystem::path& path, const uint8_t* data, size_t size)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            throw std::runtime_error("cannot create " + Core::PathToUtf8(path));
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!out)
+            throw std::runtime_error("write failed for " + Core::PathToUtf8(path));
+    }
+
+    // [decompressed size][compressed size][LZ4 block], as used by SCT2 and SCSP.
+    std::vector<uint8_t> wrap_lz4(const std::vector<uint8_t>& raw)
+    {
+        std::vector<uint8_t> block;
+        Core::LZ4CompressBlock(raw.data(), raw.size(), block);
+        ByteWriter w;
+        w.Put<int32_t>(static_cast<int32_t>(raw.size()));
+        w.Put<int32_t>(static_cast<int32_t>(block.size()));
+        w.PutBytes(block.data(), block.size());
+        return std::move(w.Bytes());
+    }
+
+    std::vector<uint8_t> make_opaque(Rng& rng, uint32_t average_size, bool text_like)
+    {
+        uint32_t size = average_size / 2 + rng.Below(average_size + 1);
+        std::vector<uint8_t> data;
+        data.reserve(size);
+        if (text_like)
+        {
+            static const char* words[] = { "hero", "skill", "damage", "buff", "stage", "reward", "level", "item", "quest", "enemy", "shield", "crit" };
+            while (data.size() < size)
+            {
+                const char* word = words[rng.Below(12)];
+                data.insert(data.end(), word, word + std::strlen(word));
+                std::string number = std::to_string(rng.Below(1000));
+                data.push_back('=');
+                data.insert(data.end(), number.begin(), number.end());
+                data.push_back(rng.Below(8) == 0 ? '\n' : ' ');
+            }
+            data.resize(size);
+        }
+        else
+        {
+            while (data.size() < size)
+            {
+                uint64_t v = rng.Next();
+                if ((v & 7) == 0)
+                    data.insert(data.end(), 16 + (v >> 58), static_cast<uint8_t>(v >> 8));
+                else
+                    for (int i = 0; i < 8; ++i)
+                        data.push_back(static_cast<uint8_t>(v >> (i * 8)));
+            }
+            data.resize(size);
+        }
+        return data;
+    }
+
+    // Sprite-like RGBA: transparent margin, gradients and a few noisy tiles.
+    std::vector<uint8_t> make_sprite(Rng& rng, int width, int height)
+    {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4, 0);
+        float hue_r = rng.Range(0.2f, 1.0f), hue_g = rng.Range(0.2f, 1.0f), hue_b = rng.Range(0.2f, 1.0f);
+        int margin_x = width / 8, margin_y = height / 8;
+        for (int y = margin_y; y < height - margin_y; ++y)
+        {
+            for (int x = margin_x; x < width - margin_x; ++x)
+            {
+                float fx = static_cast<float>(x) / width, fy = static_cast<float>(y) / height;
+                float ring = 0.5f + 0.5f * std::sin((fx * fx + fy * fy) * 40.0f);
+                bool noisy = ((x / 32) + (y / 32)) % 5 == 0;
+                uint8_t noise = noisy ? static_cast<uint8_t>(rng.Below(48)) : 0;
+                uint8_t* p = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+                p[0] = static_cast<uint8_t>(std::min(255.0f, hue_r * 255.0f * ring + noise));
+                p[1] = static_cast<uint8_t>(std::min(255.0f, hue_g * 255.0f * fx + noise));
+                p[2] = static_cast<uint8_t>(std::min(255.0f, hue_b * 255.0f * fy + noise));
+                p[3] = 255;
+            }
+        }
+        return rgba;
+    }
+
+    void write_curves(ByteWriter& w, Rng& rng, uint32_t frames)
+    {
+        // One 19-float block per frame gap: type followed by nine sampled points.
+        uint32_t count = frames > 1 ? (frames - 1) * 19 : 0;
+        w.Put<uint16_t>(static_cast<uint16_t>(count));
+        for (uint32_t f = 0; f + 1 < frames; ++f)
+        {
+            uint32_t kind = rng.Below(4);
+            if (kind != 0)
+            {
+                w.Put<float>(kind == 1 ? 1.0f : 0.0f);
+                w.PutZeros(18 * sizeof(float));
+                continue;
+            }
+
+            float cx1 = rng.Range(0.0f, 1.0f), cy1 = rng.Range(0.0f, 1.0f);
+            float cx2 = rng.Range(0.0f, 1.0f), cy2 = rng.Range(0.0f, 1.0f);
+            float tmpx = (-cx1 * 2 + cx2) * 0.03f, tmpy = (-cy1 * 2 + cy2) * 0.03f;
+            float dddfx = ((cx1 - cx2) * 3 + 1) * 0.006f, dddfy = ((cy1 - cy2) * 3 + 1) * 0.006f;
+            float ddfx = tmpx * 2 + dddfx, ddfy = tmpy * 2 + dddfy;
+            float dfx = cx1 * 0.3f + tmpx + dddfx * 0.16666667f, dfy = cy1 * 0.3f + tmpy + dddfy * 0.16666667f;
+            float x = dfx, y = dfy;
+            w.Put<float>(2.0f);
+            for (int i = 0; i < 9; ++i)
+            {
+                w.Put<float>(x);
+                w.Put<float>(y);
+                dfx += ddfx;
+                dfy += ddfy;
+                ddfx += dddfx;
+                ddfy += dddfy;
+                x += dfx;
+                y += dfy;
+            }
+        }
+    }
+
+    // Logical data.pack stream split over fixed-size part files.
+    class PackPartWriter
+    {
+    public:
+        PackPartWriter(const std::filesystem::path& base_path, uint64_t part_size, bool encrypted)
+            : base_path(base_path), part_size(part_size), encrypted(encrypted)
+        {
+        }
+
+        void Write(const uint8_t* data, size_t size)
+        {
+            scratch.assign(data, data + size);
+            if (encrypted)
+                Core::xor_buffer(scratch.data(), scratch.size(), static_cast<size_t>(offset));
+
+            size_t done = 0;
+            while (done < size)
+            {
+                if (!out.is_open() || part_written == part_size)
+                    OpenNext();
+                size_t n = static_cast<size_t>(std::min<uint64_t>(size - done, part_size - part_written));
+                out.write(reinterpret_cast<const char*>(scratch.data() + done), static_cast<std::streamsize>(n));
+                done += n;
+                part_written += n;
+                offset += n;
+            }
+        }
+
+        void Close()
+        {
+            if (out.is_open())
+            {
+                out.close();
+                if (!out)
+                    throw std::runtime_error("write failed for " + Core::PathToUtf8(base_path));
+            }
+        }
+
+    private:
+        void OpenNext()
+        {
+            Close();
+            std::filesystem::path path = base_path;
+            if (part_index > 0)
+                path += "~" + std::to_string(part_index);
+            out.open(path, std::ios::binary | std::ios::trunc);
+            if (!out.is_open())
+                throw std::runtime_error("cannot create " + Core::PathToUtf8(path));
+            ++part_index;
+            part_written = 0;
+        }
+
+        std::filesystem::path base_path;
+        uint64_t part_size;
+        bool encrypted;
+        std::ofstream out;
+        uint32_t part_index = 0;
+        uint64_t part_written = 0;
+        uint64_t offset = 0;
+        std::vector<uint8_t> scratch;
+    };
+}
+
+namespace Bench
+{
+    std::vector<uint8_t> MakeZstdRawFrame(const uint8_t* data, size_t size)
+    {
+        constexpr size_t MAX_BLOCK = 128 * 1024;
+
+        ByteWriter w;
+        w.Put<uint32_t>(0xFD2FB528);
+        // Single segment, 8-byte content size, no checksum, no dictionary.
+        w.Put<uint8_t>(0xE0);
+        w.Put<uint64_t>(static_cast<uint64_t>(size));
+
+        size_t pos = 0;
+        do
+        {
+            size_t n = std::min(MAX_BLOCK, size - pos);
+            bool last = pos + n == size;
+            uint32_t block_header = (static_cast<uint32_t>(n) << 3) | (last ? 1u : 0u); // type 0 = raw
+            w.Put<uint8_t>(static_cast<uint8_t>(block_header));
+            w.Put<uint8_t>(static_cast<uint8_t>(block_header >> 8));
+            w.Put<uint8_t>(static_cast<uint8_t>(block_header >> 16));
+            w.PutBytes(data + pos, n);
+            pos += n;
+        } while (pos < size);
+
+        return std::move(w.Bytes());
+    }
+
+    std::vector<uint8_t> MakeSCT2(uint32_t seed, int width, int height)
+    {
+        constexpr int SCT2_SIGNATURE = 844383059;
+        constexpr int ASTC_4x4 = 40;
+        constexpr int DATA_OFFSET = 48;
+
+        Rng rng(seed);
+        std::vector<uint8_t> rgba = make_sprite(rng, width, height);
+
+        astcenc_config config;
+        if (astcenc_config_init(ASTCENC_PRF_LDR, 4, 4, 1, ASTCENC_PRE_FASTEST, 0, &config) != ASTCENC_SUCCESS)
+            throw std::runtime_error("astcenc_config_init failed");
+        astcenc_context* context = nullptr;
+        if (astcenc_context_alloc(&config, 1, &context) != ASTCENC_SUCCESS)
+            throw std::runtime_error("astcenc_context_alloc failed");
+
+        astcenc_image image;
+        image.dim_x = width;
+        image.dim_y = height;
+        image.dim_z = 1;
+        image.data_type = ASTCENC_TYPE_U8;
+        void* slices[] = { rgba.data() };
+        image.data = slices;
+        astcenc_swizzle swizzle = { ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A };
+
+        std::vector<uint8_t> blocks(static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 16);
+        astcenc_error status = astcenc_compress_image(context, &image, &swizzle, blocks.data(), blocks.size(), 0);
+        astcenc_context_free(context);
+        if (status != ASTCENC_SUCCESS)
+            throw std::runtime_error(std::string("astcenc_compress_image failed: ") + astcenc_get_error_string(status));
+
+        std::vector<uint8_t> payload = wrap_lz4(blocks);
+
+        ByteWriter w;
+        w.Put<int32_t>(SCT2_SIGNATURE);
+        w.Put<int32_t>(static_cast<int32_t>(DATA_OFFSET + payload.size()));
+        w.Put<int32_t>(0);
+        w.Put<int32_t>(DATA_OFFSET);
+        w.Put<int32_t>(0);
+        w.Put<int32_t>(ASTC_4x4);
+        w.Put<uint16_t>(static_cast<uint16_t>(width));
+        w.Put<uint16_t>(static_cast<uint16_t>(height));
+        w.Put<uint16_t>(static_cast<uint16_t>(width));
+        w.Put<uint16_t>(static_cast<uint16_t>(height));
+        w.Put<uint8_t>(0x80); // LZ4 compressed
+        w.PutZeros(DATA_OFFSET - w.Size());
+        w.PutBytes(payload.data(), payload.size());
+        return std::move(w.Bytes());
+    }
+
+    std::vector<uint8_t> MakeDB(uint32_t seed, uint32_t rows, uint32_t cols)
+    {
+        Rng rng(seed);
+        std::vector<std::pair<std::string, std::vector<uint8_t>>> entries;
+        auto add_text = [&](std::string name, const std::string& value)
+        {
+            entries.emplace_back(std::move(name), std::vector<uint8_t>(value.begin(), value.end()));
+        };
+        auto add_u32 = [&](std::string name, uint32_t value)
+        {
+            std::vector<uint8_t> bytes(4);
+            std::memcpy(bytes.data(), &value, 4);
+            entries.emplace_back(std::move(name), std::move(bytes));
+        };
+
+        cols = std::max<uint32_t>(cols, 1);
+        add_u32("\trows", rows);
+        add_u32("\tcols", cols);
+        for (uint32_t c = 0; c < cols; ++c)
+            add_text("\t" + std::to_string(c), c == 0 ? "id" : format("col_%u", c));
+
+        static const char* words[] = { "Aster", "Brine", "Cobalt", "Dusk", "Ember", "Frost", "Gale", "Haze" };
+        for (uint32_t r = 0; r < rows; ++r)
+        {
+            std::string key = format("row_%u_%u", seed, r);
+            add_text("\t\t" + std::to_string(r), key);
+
+            std::string values = std::to_string(100000 + r);
+            values.push_back('\0');
+            for (uint32_t c = 1; c < cols; ++c)
+            {
+                switch (c % 3)
+                {
+                case 0: values += std::to_string(rng.Below(100000)); break;
+                case 1: values += format("%u.%02u", rng.Below(1000), rng.Below(100)); break;
+                default: values += std::string(words[rng.Below(8)]) + " " + words[rng.Below(8)]; break;
+                }
+                values.push_back('\0');
+            }
+            add_text(key, values);
+        }
+
+        uint32_t bucket_count = 16;
+        while (bucket_count < entries.size() / 2)
+            bucket_count *= 2;
+        std::vector<std::vector<size_t>> buckets(bucket_count);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const std::string& name = entries[i].first;
+            buckets[Core::Hash64(reinterpret_cast<const uint8_t*>(name.data()), name.size()) & (bucket_count - 1)].push_back(i);
+        }
+
+        constexpr uint64_t HEADER_SIZE = 0x26;
+        constexpr uint64_t CHUNK_HEADER_SIZE = 15;
+        uint64_t entries_start = HEADER_SIZE + 5 + 5ULL * bucket_count;
+
+        // Chains are laid out contiguously bucket by bucket.
+        std::vector<uint64_t> entry_offsets(entries.size());
+        std::vector<uint64_t> bucket_heads(bucket_count, 0);
+        uint64_t cursor = entries_start;
+        for (uint32_t b = 0; b < bucket_count; ++b)
+        {
+            for (size_t i : buckets[b])
+            {
+                if (bucket_heads[b] == 0)
+                    bucket_heads[b] = cursor;
+                entry_offsets[i] = cursor;
+                cursor += CHUNK_HEADER_SIZE + entries[i].first.size() + entries[i].second.size();
+            }
+        }
+
+        ByteWriter w;
+        w.PutString("PLPcK");
+        w.Put<uint8_t>(1);
+        w.Put<uint16_t>(static_cast<uint16_t>(HEADER_SIZE));
+        w.Put<uint8_t>(0);
+        w.Put<uint64_t>(0);
+        w.Put<uint32_t>(static_cast<uint32_t>(entries.size()));
+        w.Put<uint32_t>(bucket_count);
+        w.PutUInt40(HEADER_SIZE);
+        w.Put<uint64_t>(0);
+
+        w.Put<uint32_t>(5 * (bucket_count + 1));
+        w.Put<uint8_t>(1);
+        for (uint32_t b = 0; b < bucket_count; ++b)
+            w.PutUInt40(bucket_heads[b]);
+
+        for (uint32_t b = 0; b < bucket_count; ++b)
+        {
+            const std::vector<size_t>& chain = buckets[b];
+            for (size_t k = 0; k < chain.size(); ++k)
+            {
+                const auto& entry = entries[chain[k]];
+                w.Put<uint32_t>(static_cast<uint32_t>(CHUNK_HEADER_SIZE + entry.first.size() + entry.second.size()));
+                w.Put<uint8_t>(2);
+                w.Put<uint8_t>(static_cast<uint8_t>(entry.first.size()));
+                w.Put<uint32_t>(static_cast<uint32_t>(entry.second.size()));
+                w.PutUInt40(k + 1 < chain.size() ? entry_offsets[chain[k + 1]] : 0);
+                w.PutString(entry.first);
+                w.PutBytes(entry.second.data(), entry.second.size());
+            }
+        }
+
+        return DBParser::EncryptDB(w.Bytes(), static_cast<uint8_t>(rng.Below(256)));
+    }
+
+    std::vector<uint8_t> MakeSCSP(uint32_t seed, uint32_t bones, uint32_t animations)
+    {
+        constexpr uint32_t HEADER_VERSION = 0x7531; // newer layout with skin indices on deforms
+        constexpr uint32_t FRAMES = 24;
+        constexpr uint32_t MESH_VERTICES = 16;
+
+        Rng rng(seed);
+        StringPool strings;
+        bones = std::max<uint32_t>(bones, 1);
+        const uint32_t slots = bones;
+        auto is_mesh = [](uint32_t slot) { return slot % 4 == 3; };
+
+        ByteWriter w;
+        w.PutZeros(0x08 + 0x62);
+        std::memcpy(w.Bytes().data() + 0x08, "scsp", 4);
+        w.PutAt<uint32_t>(0x08 + 0x04, HEADER_VERSION);
+        w.PutAt<float>(0x08 + 0x0E, 1024.0f);
+        w.PutAt<float>(0x08 + 0x12, 1024.0f);
+        w.PutAt<uint32_t>(0x08 + 0x4A, strings.Add(format("synthetic%08x", seed)));
+        w.PutAt<uint32_t>(0x08 + 0x4E, strings.Add("3.8.99.scsp"));
+        w.PutAt<uint32_t>(0x08 + 0x5A, strings.Add("./images/"));
+        w.PutAt<uint32_t>(0x08 + 0x5E, NO_STRING);
+
+        // Bones: binary tree so parents always precede children.
+        w.Put<uint16_t>(static_cast<uint16_t>(bones));
+        for (uint32_t i = 0; i < bones; ++i)
+        {
+            w.Put<int16_t>(static_cast<int16_t>(i));
+            w.Put<uint32_t>(strings.Add(i == 0 ? std::string("root") : format("bone_%u", i)));
+            w.Put<int16_t>(i == 0 ? -1 : static_cast<int16_t>((i - 1) / 2));
+            w.Put<float>(rng.Range(10.0f, 80.0f));
+            w.Put<float>(rng.Range(-50.0f, 50.0f));
+            w.Put<float>(rng.Range(-50.0f, 50.0f));
+            w.Put<float>(rng.Range(-180.0f, 180.0f));
+            w.Put<float>(1.0f);
+            w.Put<float>(1.0f);
+            w.Put<float>(0.0f);
+            w.Put<float>(0.0f);
+            w.Put<uint16_t>(0);
+            w.Put<uint8_t>(0);
+        }
+
+        w.Put<uint16_t>(0); // IK constraints
+
+        w.Put<uint16_t>(static_cast<uint16_t>(slots));
+        for (uint32_t i = 0; i < slots; ++i)
+        {
+            w.Put<int16_t>(static_cast<int16_t>(i));
+            w.Put<uint32_t>(strings.Add(format("slot_%u", i)));
+            w.Put<int16_t>(static_cast<int16_t>(i % bones));
+            for (float v : { 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f })
+                w.Put<float>(v);
+            w.Put<uint8_t>(0);
+            w.Put<uint32_t>(strings.Add(format("att_%u", i)));
+            w.Put<uint16_t>(i % 7 == 0 ? 1 : 0);
+        }
+
+        w.Put<uint16_t>(0); // transform constraints
+        w.Put<uint16_t>(0); // path constraints
+
+        std::map<uint32_t, std::vector<float>> mesh_setup;
+        w.Put<uint16_t>(1);
+        w.Put<uint32_t>(strings.Add("default"));
+        w.Put<uint16_t>(0);
+        w.Put<uint16_t>(0);
+        w.Put<uint16_t>(static_cast<uint16_t>(slots));
+        for (uint32_t i = 0; i < slots; ++i)
+        {
+            w.Put<uint16_t>(static_cast<uint16_t>(i));
+            w.Put<uint32_t>(strings.Add(format("att_%u", i)));
+            w.Put<int16_t>(is_mesh(i) ? 2 : 0);
+            w.Put<uint32_t>(NO_STRING);
+
+            if (!is_mesh(i))
+            {
+                for (float v : { rng.Range(-20.0f, 20.0f), rng.Range(-20.0f, 20.0f), rng.Range(-90.0f, 90.0f), 1.0f, 1.0f, rng.Range(16.0f, 256.0f), rng.Range(16.0f, 256.0f) })
+                    w.Put<float>(v);
+                w.PutZeros(24);
+                w.Put<uint16_t>(0);
+                w.Put<uint16_t>(0);
+                w.Put<uint32_t>(strings.Add(format("tex/part_%u", i)));
+                for (float v : { 1.0f, 1.0f, 1.0f, 1.0f })
+                    w.Put<float>(v);
+                continue;
+            }
+
+            std::vector<float>& setup = mesh_setup[i];
+            for (uint32_t v = 0; v < MESH_VERTICES; ++v)
+            {
+                float angle = 6.2831853f * v / MESH_VERTICES;
+                setup.push_back(std::cos(angle) * 64.0f);
+                setup.push_back(std::sin(angle) * 64.0f);
+            }
+            w.Put<uint16_t>(0); // unweighted
+            w.Put<uint16_t>(static_cast<uint16_t>(setup.size()));
+            for (float v : setup)
+                w.Put<float>(v);
+            w.Put<uint32_t>(static_cast<uint32_t>(setup.size()));
+            w.Put<uint32_t>(strings.Add(format("tex/mesh_%u", i)));
+            w.PutZeros(24);
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                w.Put<uint16_t>(static_cast<uint16_t>(setup.size()));
+                for (float v : setup)
+                    w.Put<float>(0.5f + v / 128.0f);
+            }
+            w.Put<uint16_t>(static_cast<uint16_t>((MESH_VERTICES - 2) * 3));
+            for (uint32_t t = 1; t + 1 < MESH_VERTICES; ++t)
+            {
+                w.Put<uint16_t>(0);
+                w.Put<uint16_t>(static_cast<uint16_t>(t));
+                w.Put<uint16_t>(static_cast<uint16_t>(t + 1));
+            }
+            w.Put<uint16_t>(0); // edges
+            w.Put<uint32_t>(NO_STRING);
+            for (float v : { 0.0f, 0.0f, 1.0f, 1.0f, 128.0f, 128.0f, 1.0f, 1.0f, 1.0f, 1.0f })
+                w.Put<float>(v);
+            w.Put<uint32_t>(MESH_VERTICES);
+            w.Put<uint8_t>(0);
+            w.PutZeros(4);
+            w.Put<uint32_t>(NO_STRING);
+            w.PutZeros(5);
+        }
+
+        w.Put<uint16_t>(0); // events
+
+        w.Put<uint16_t>(static_cast<uint16_t>(animations));
+        for (uint32_t a = 0; a < animations; ++a)
+        {
+            const float duration = (FRAMES - 1) / 30.0f;
+            w.Put<uint32_t>(strings.Add(format("anim_%u", a)));
+            w.Put<float>(duration);
+
+            size_t count_at = w.Size();
+            w.Put<uint16_t>(0);
+            uint16_t timelines = 0;
+
+            for (uint32_t b = 0; b < bones; ++b)
+            {
+                for (uint16_t ttype = 0; ttype < 2; ++ttype)
+                {
+                    uint32_t stride = ttype == 0 ? 2 : 3;
+                    w.Put<uint16_t>(ttype);
+                    w.Put<uint16_t>(static_cast<uint16_t>(b));
+                    w.Put<uint16_t>(static_cast<uint16_t>(FRAMES * stride));
+                    for (uint32_t f = 0; f < FRAMES; ++f)
+                    {
+                        w.Put<float>(f / 30.0f);
+                        for (uint32_t k = 1; k < stride; ++k)
+                            w.Put<float>(rng.Range(-45.0f, 45.0f));
+                    }
+                    write_curves(w, rng, FRAMES);
+                    ++timelines;
+                }
+            }
+
+            for (uint32_t s = 0; s < slots; s += 8)
+            {
+                w.Put<uint16_t>(5);
+                w.Put<uint16_t>(static_cast<uint16_t>(s));
+                w.Put<uint16_t>(static_cast<uint16_t>(FRAMES * 5));
+                for (uint32_t f = 0; f < FRAMES; ++f)
+                {
+                    w.Put<float>(f / 30.0f);
+                    for (int k = 0; k < 4; ++k)
+                        w.Put<float>(rng.Unit());
+                }
+                write_curves(w, rng, FRAMES);
+                ++timelines;
+            }
+
+            for (const auto& [slot, setup] : mesh_setup)
+            {
+                if ((slot / 4 + a) % 2 != 0)
+                    continue;
+                w.Put<uint16_t>(6);
+                w.Put<uint16_t>(static_cast<uint16_t>(slot));
+                w.Put<uint16_t>(static_cast<uint16_t>(FRAMES));
+                for (uint32_t f = 0; f < FRAMES; ++f)
+                    w.Put<float>(f / 30.0f);
+                write_curves(w, rng, FRAMES);
+                w.Put<uint16_t>(static_cast<uint16_t>(FRAMES));
+                for (uint32_t f = 0; f < FRAMES; ++f)
+                {
+                    w.Put<uint16_t>(static_cast<uint16_t>(setup.size()));
+                    for (size_t k = 0; k < setup.size(); ++k)
+                        w.Put<float>(setup[k] + (k >= 4 ? rng.Range(-4.0f, 4.0f) : 0.0f));
+                }
+                w.Put<uint32_t>(strings.Add(format("att_%u", slot)));
+                w.Put<uint16_t>(0);
+                ++timelines;
+            }
+
+            w.PutAt<uint16_t>(count_at, timelines);
+        }
+
+        const std::vector<char>& pool = strings.Data();
+        w.PutAt<uint32_t>(0x00, static_cast<uint32_t>(w.Size() - 8));
+        w.PutAt<uint32_t>(0x04, static_cast<uint32_t>(pool.size()));
+        w.PutBytes(pool.data(), pool.size());
+
+        return wrap_lz4(w.Bytes());
+    }
+
+    std::vector<SyntheticFile> GenerateFiles(const SyntheticConfig& config)
+    {
+        std::vector<SyntheticFile> files;
+        Rng rng(config.seed);
+        int sct_size = static_cast<int>(std::max<uint32_t>(4, config.sct_size & ~3u));
+
+        for (uint32_t i = 0; i < config.opaque_files; ++i)
+        {
+            SyntheticFile file;
+            file.path = format("bundles/b%02u/asset_%05u.bytes", i % 16, i);
+            file.kind = PayloadKind::Opaque;
+            file.data = make_opaque(rng, config.opaque_size, i % 2 == 0);
+            files.push_back(std::move(file));
+        }
+
+        for (uint32_t i = 0; i < config.sct_files; ++i)
+        {
+            SyntheticFile file;
+            file.path = format("textures/tex_%04u.sct2", i);
+            file.kind = PayloadKind::SCT;
+            file.data = MakeSCT2(static_cast<uint32_t>(rng.Next()), sct_size, sct_size);
+            files.push_back(std::move(file));
+        }
+
+        for (uint32_t i = 0; i < config.db_files; ++i)
+        {
+            SyntheticFile file;
+            file.path = format("tables/table_%03u.db", i);
+            file.kind = PayloadKind::DB;
+            file.data = MakeDB(static_cast<uint32_t>(rng.Next()), config.db_rows, config.db_cols);
+            files.push_back(std::move(file));
+        }
+
+        for (uint32_t i = 0; i < config.scsp_files; ++i)
+        {
+            SyntheticFile skeleton;
+            skeleton.path = format("spine/char_%03u.scsp", i);
+            skeleton.kind = PayloadKind::SCSP;
+            skeleton.data = MakeSCSP(static_cast<uint32_t>(rng.Next()), config.scsp_bones, config.scsp_animations);
+            files.push_back(std::move(skeleton));
+
+            SyntheticFile atlas;
+            atlas.path = format("spine/char_%03u.atlas", i);
+            atlas.kind = PayloadKind::Atlas;
+            std::string text = format("\nchar_%03u.sct2\nsize: %u,", i, static_cast<uint32_t>(sct_size)) + std::to_string(sct_size) +
+                               "\nformat: RGBA8888\nfilter: Linear,Linear\nrepeat: none\n";
+            for (uint32_t s = 0; s < config.scsp_bones; ++s)
+                text += format("tex/part_%u\n  rotate: false\n  xy: %u, 0\n  size: 32, 32\n  orig: 32, 32\n  offset: 0, 0\n  index: -1\n", s, s * 32);
+            atlas.data.assign(text.begin(), text.end());
+            files.push_back(std::move(atlas));
+        }
+
+        return files;
+    }
+
+    std::filesystem::path WriteDataPack(const std::vector<SyntheticFile>& files, const std::filesystem::path& dir, bool encrypted, uint32_t parts)
+    {
+        constexpr uint64_t ENTRY_OVERHEAD = 15 + 8;
+        static const uint8_t prefix[8] = { 'P', 'L', 'P', 'c', 'K', 0, 0, 0 };
+
+        std::filesystem::create_directories(dir);
+        std::filesystem::path base_path = dir / "data.pack";
+
+        uint64_t total = sizeof(prefix);
+        for (const SyntheticFile& file : files)
+            total += ENTRY_OVERHEAD + file.path.size() + file.data.size();
+        parts = std::max<uint32_t>(parts, 1);
+        uint64_t part_size = (total + parts - 1) / parts;
+
+        // Leftover parts from an earlier run with more parts would be picked up by the scanner.
+        for (uint32_t i = 1;; ++i)
+        {
+            std::filesystem::path stale = base_path;
+            stale += "~" + std::to_string(i);
+            if (!std::filesystem::remove(stale) && i >= parts)
+                break;
+        }
+
+        PackPartWriter writer(base_path, part_size, encrypted);
+        writer.Write(prefix, sizeof(prefix));
+
+        static const uint8_t trailer[8] = {};
+        for (const SyntheticFile& file : files)
+        {
+            if (file.path.size() > 255 || file.data.size() > 0xFFFFFFFFull - 300)
+                throw std::runtime_error("entry does not fit data.pack limits: " + file.path);
+
+            uint8_t header[15] = {};
+            uint32_t data_len = static_cast<uint32_t>(file.data.size());
+            uint32_t container_len = static_cast<uint32_t>(file.path.size()) + data_len + 19;
+            std::memcpy(header, &container_len, 4);
+            header[4] = 0x02;
+            header[5] = static_cast<uint8_t>(file.path.size());
+            std::memcpy(header + 6, &data_len, 4);
+
+            writer.Write(header, sizeof(header));
+            writer.Write(reinterpret_cast<const uint8_t*>(file.path.data()), file.path.size());
+            writer.Write(file.data.data(), file.data.size());
+            writer.Write(trailer, sizeof(trailer));
+        }
+        writer.Close();
+        return base_path;
+    }
+
+    std::filesystem::path WriteSSRA(const std::vector<SyntheticFile>& files, const std::filesystem::path& dir, uint64_t chunk_size)
+    {
+        constexpr uint16_t GROUP = 0;
+        const std::string group_name = "base";
+
+        std::filesystem::path chunks_dir = dir / "chunks";
+        std::filesystem::remove_all(chunks_dir);
+        std::filesystem::create_directories(chunks_dir);
+
+        struct Chunk
+        {
+            uint64_t uncompressed = 0;
+            uint64_t compressed = 0;
+            uint64_t checksum = 0;
+        };
+
+        StringPool names;
+        ByteWriter file_table;
+        std::vector<Chunk> chunks;
+        std::vector<uint8_t> chunk_bytes;
+        uint64_t group_offset = 0;
+
+        uint64_t chunk_uncompressed = 0;
+        auto flush_chunk = [&]()
+        {
+            if (chunk_bytes.empty())
+                return;
+            uint32_t id = static_cast<uint32_t>(chunks.size());
+            write_file(chunks_dir / (group_name + format("_%04u.ssrc", id)), chunk_bytes.data(), chunk_bytes.size());
+            Chunk chunk;
+            chunk.uncompressed = chunk_uncompressed;
+            chunk.compressed = chunk_bytes.size();
+            chunk.checksum = Core::Hash64(chunk_bytes.data(), chunk_bytes.size());
+            chunks.push_back(chunk);
+            group_offset += chunk_bytes.size();
+            chunk_bytes.clear();
+            chunk_uncompressed = 0;
+        };
+
+        for (const SyntheticFile& file : files)
+        {
+            std::vector<uint8_t> frame = MakeZstdRawFrame(file.data.data(), file.data.size());
+            // A file never straddles chunks; readers locate it by its start offset.
+            if (!chunk_bytes.empty() && chunk_bytes.size() + frame.size() > chunk_size)
+                flush_chunk();
+
+            uint64_t global_offset = group_offset + chunk_bytes.size();
+            chunk_bytes.insert(chunk_bytes.end(), frame.begin(), frame.end());
+            chunk_uncompressed += file.data.size();
+
+            file_table.Put<uint32_t>(static_cast<uint32_t>(Core::Hash64(reinterpret_cast<const uint8_t*>(file.path.data()), file.path.size())));
+            file_table.Put<uint32_t>(0);
+            file_table.Put<uint64_t>(global_offset);
+            file_table.Put<uint32_t>(static_cast<uint32_t>(frame.size()));
+            file_table.Put<uint32_t>(static_cast<uint32_t>(file.data.size()));
+            file_table.Put<uint32_t>(0);
+            file_table.Put<uint32_t>(names.Add(file.path));
+            file_table.Put<uint8_t>(1); // zstd
+            file_table.Put<uint8_t>(0);
+            file_table.Put<uint16_t>(GROUP);
+            file_table.Put<uint32_t>(0);
+        }
+        flush_chunk();
+
+        constexpr uint64_t HEADER_SIZE = 64;
+        const std::vector<char>& pool = names.Data();
+        const uint64_t string_table_offset = HEADER_SIZE;
+        const uint64_t grps_offset = string_table_offset + pool.size();
+        const uint64_t grps_size = 16 + 24 + group_name.size() + 1;
+        const uint64_t chunk_table_offset = grps_offset + grps_size;
+        const uint64_t file_table_offset = chunk_table_offset + chunks.size() * 32;
+
+        ByteWriter w;
+        w.PutString("SSRA");
+        w.Put<uint32_t>(1);
+        w.Put<uint32_t>(0);
+        w.Put<uint32_t>(static_cast<uint32_t>(chunks.size()));
+        w.Put<uint32_t>(static_cast<uint32_t>(files.size()));
+        w.Put<uint32_t>(0);
+        w.Put<uint64_t>(string_table_offset);
+        w.Put<uint64_t>(pool.size());
+        w.Put<uint64_t>(chunk_table_offset);
+        w.Put<uint64_t>(file_table_offset);
+        w.Put<uint64_t>(0);
+
+        w.PutBytes(pool.data(), pool.size());
+
+        w.PutString("GRPS");
+        w.Put<uint32_t>(1);
+        w.Put<uint32_t>(static_cast<uint32_t>(group_name.size() + 1));
+        w.Put<uint32_t>(0);
+        w.Put<uint16_t>(GROUP);
+        w.Put<uint16_t>(0);
+        w.Put<uint32_t>(0); // name offset in the group string table
+        w.PutZeros(16);
+        w.PutString(group_name);
+        w.Put<uint8_t>(0);
+
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            w.Put<uint32_t>(static_cast<uint32_t>(i));
+            w.Put<uint16_t>(GROUP);
+            w.Put<uint16_t>(0);
+            w.Put<uint64_t>(chunks[i].uncompressed);
+            w.Put<uint64_t>(chunks[i].compressed);
+            w.Put<uint64_t>(chunks[i].checksum);
+        }
+
+        w.PutBytes(file_table.Bytes().data(), file_table.Size());
+
+        std::filesystem::path manifest_path = dir / "manifest.ssra";
+        write_file(manifest_path, w.Bytes().data(), w.Size());
+        return manifest_path;
+    }
+}
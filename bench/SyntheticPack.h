@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Deterministic synthetic game data for benchmarking. The same config and seed
+// always produce byte-identical payloads and archives on every platform.
+namespace Bench {
+    struct SyntheticConfig {
+        uint32_t seed = 1;
+
+        uint32_t opaque_files = 512;
+        uint32_t opaque_size = 64 * 1024;   // average, actual sizes vary +-50%
+
+        uint32_t sct_files = 32;
+        uint32_t sct_size = 512;            // square ASTC 4x4 textures, multiple of 4
+
+        uint32_t db_files = 16;
+        uint32_t db_rows = 2000;
+        uint32_t db_cols = 12;
+
+        uint32_t scsp_files = 16;
+        uint32_t scsp_bones = 64;
+        uint32_t scsp_animations = 8;
+
+        uint32_t pack_parts = 3;
+        uint64_t ssra_chunk_size = 16ULL * 1024 * 1024;
+    };
+
+    enum class PayloadKind { Opaque, SCT, DB, SCSP, Atlas };
+
+    struct SyntheticFile {
+        std::string path;
+        PayloadKind kind = PayloadKind::Opaque;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<SyntheticFile> GenerateFiles(const SyntheticConfig& config);
+
+    // Writes data.pack plus data.pack~1.. into dir and returns the data.pack path.
+    std::filesystem::path WriteDataPack(const std::vector<SyntheticFile>& files, const std::filesystem::path& dir, bool encrypted, uint32_t parts);
+
+    // Writes manifest.ssra and chunks/*.ssrc into dir and returns the manifest path.
+    std::filesystem::path WriteSSRA(const std::vector<SyntheticFile>& files, const std::filesystem::path& dir, uint64_t chunk_size);
+
+    std::vector<uint8_t> MakeSCT2(uint32_t seed, int width, int height);
+    std::vector<uint8_t> MakeDB(uint32_t seed, uint32_t rows, uint32_t cols);
+    std::vector<uint8_t> MakeSCSP(uint32_t seed, uint32_t bones, uint32_t animations);
+
+    // Zstandard frame made of raw blocks. Valid for any decoder, no entropy stage.
+    std::vector<uint8_t> MakeZstdRawFrame(const uint8_t* data, size_t size);
+}
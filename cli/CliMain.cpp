@@ -0,0 +1,1059 @@
+#define NOMINMAX
+#include "archive/ArchiveFactory.h"
+#include "archive/IArchive.h"
+#include "archive/OutputSink.h"
+#include "archive/TableStore.h"
+#ifdef RIPPER_WITH_SQLITE
+#include "archive/SqliteSink.h"
+#endif
+#include "parsers/SCTParser.h"
+#include "parsers/PngWriter.h"
+#include "parsers/DBParser.h"
+#include "parsers/SCSPParser.h"
+#include "core/Core.h"
+#include "core/Logger.h"
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::ordered_json;
+
+namespace
+{
+    enum class OutputFormat { Text, Json };
+
+    struct CliOptions
+    {
+        std::string command;
+        std::vector<std::string> positional;
+        std::vector<std::string> includes;
+        std::vector<std::string> excludes;
+        OutputFormat format = OutputFormat::Text;
+        unsigned int threads = 0;
+        bool convert = false;
+        PngWriter::Level png_level = PngWriter::Level::Default;
+        bool ktx2 = false;
+        bool compact_json = false;
+        DBParser::TableFormat db_format = DBParser::TableFormat::Json;
+        SCSPParser::SkeletonFormat spine_format = SCSPParser::SkeletonFormat::Json;
+        // export-db only: every table goes into one SQLite file.
+        bool db_sqlite = false;
+        // query only: table.column pairs to index before the first query.
+        std::vector<std::string> indexes;
+        bool tar = false;
+        bool deduplicate = false;
+        bool verbose = false;
+    };
+
+    // Thrown for bad command lines; main prints usage for these.
+    struct UsageError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    std::mutex g_output_mutex;
+    OutputFormat g_format = OutputFormat::Text;
+
+    // In JSON mode every line on stdout is one self-contained event object.
+    void emit(const json& event)
+    {
+        std::lock_guard<std::mutex> lock(g_output_mutex);
+        std::cout << event.dump() << "\n" << std::flush;
+    }
+
+    void say(const std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(g_output_mutex);
+        std::cout << text << "\n";
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string pack_type_name(IArchive::PackType type)
+    {
+        switch (type)
+        {
+        case IArchive::PackType::Encrypted: return "encrypted";
+        case IArchive::PackType::Decrypted: return "decrypted";
+        case IArchive::PackType::LocalDirectory: return "directory";
+        case IArchive::PackType::Composite: return "composite";
+        case IArchive::PackType::SSRA: return "ssra";
+        default: return "unknown";
+        }
+    }
+
+    std::string lower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    // '*' and '?' stay within one path segment, '**' crosses separators.
+    // Matching is ASCII case-insensitive.
+    bool glob_match(const char* pattern, const char* text)
+    {
+        while (*pattern)
+        {
+            if (pattern[0] == '*' && pattern[1] == '*')
+            {
+                pattern += 2;
+                if (*pattern == '/')
+                {
+                    // "**/" also matches zero directories
+                    if (glob_match(pattern + 1, text))
+                        return true;
+                }
+                for (const char* t = text; ; ++t)
+                {
+                    if (glob_match(pattern, t))
+                        return true;
+                    if (!*t)
+                        return false;
+                }
+            }
+            if (*pattern == '*')
+            {
+                ++pattern;
+                for (const char* t = text; ; ++t)
+                {
+                    if (glob_match(pattern, t))
+                        return true;
+                    if (!*t || *t == '/')
+                        return false;
+                }
+            }
+            if (!*text)
+                return false;
+            if (*pattern == '?')
+            {
+                if (*text == '/')
+                    return false;
+            }
+            else if (std::tolower(static_cast<unsigned char>(*pattern)) != std::tolower(static_cast<unsigned char>(*text)))
+            {
+                return false;
+            }
+            ++pattern;
+            ++text;
+        }
+        return *text == '\0';
+    }
+
+    // Patterns without a '/' are tested against the file name only, like .gitignore.
+    bool matches_any(const std::vector<std::string>& patterns, const std::string& path)
+    {
+        size_t slash = path.find_last_of('/');
+        const char* name = path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+        for (const auto& pattern : patterns)
+        {
+            const char* subject = pattern.find('/') == std::string::npos ? name : path.c_str();
+            if (glob_match(pattern.c_str(), subject))
+                return true;
+        }
+        return false;
+    }
+
+    bool is_selected(const CliOptions& options, const std::string& path)
+    {
+        if (!options.includes.empty() && !matches_any(options.includes, path))
+            return false;
+        return !matches_any(options.excludes, path);
+    }
+
+    // Copies the tree keeping only selected files and the folders leading to them.
+    // Returns false when nothing below node survived.
+    bool filter_tree(const Core::FileNode& node, const std::function<bool(const Core::FileNode&)>& keep, Core::FileNode& out)
+    {
+        if (std::holds_alternative<Core::FileInfo>(node.data))
+        {
+            if (!keep(node))
+                return false;
+            out = node;
+            return true;
+        }
+
+        out.name = node.name;
+        out.full_path = node.full_path;
+        Core::FolderInfo folder;
+        for (const auto& child : std::get<Core::FolderInfo>(node.data).children)
+        {
+            Core::FileNode kept;
+            if (filter_tree(child, keep, kept))
+                folder.children.push_back(std::move(kept));
+        }
+        bool any = !folder.children.empty();
+        out.data = std::move(folder);
+        return any;
+    }
+
+    void for_each_file(const Core::FileNode& node, const std::function<void(const Core::FileNode&, const Core::FileInfo&)>& visit)
+    {
+        if (std::holds_alternative<Core::FileInfo>(node.data))
+        {
+            visit(node, std::get<Core::FileInfo>(node.data));
+            return;
+        }
+        for (const auto& child : std::get<Core::FolderInfo>(node.data).children)
+            for_each_file(child, visit);
+    }
+
+    // Runs body while a monitor thread reports the shared progress value.
+    void with_progress(const std::string& phase, const std::function<void(std::atomic<float>&)>& body)
+    {
+        std::atomic<float> progress{0.0f};
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        bool done = false;
+        auto start = std::chrono::steady_clock::now();
+
+        std::thread monitor([&]()
+        {
+            float last = -1.0f;
+            std::unique_lock<std::mutex> lock(done_mutex);
+            while (!done_cv.wait_for(lock, std::chrono::milliseconds(250), [&] { return done; }))
+            {
+                float current = progress.load(std::memory_order_relaxed);
+                if (current == last)
+                    continue;
+                last = current;
+                if (g_format == OutputFormat::Json)
+                {
+                    emit({{"event", "progress"}, {"phase", phase}, {"progress", current}, {"elapsed", seconds_since(start)}});
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> out_lock(g_output_mutex);
+                    std::cerr << "\r" << phase << " " << std::setw(3) << static_cast<int>(current * 100.0f) << "%" << std::flush;
+                }
+            }
+        });
+
+        auto stop_monitor = [&]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done = true;
+            }
+            done_cv.notify_one();
+            monitor.join();
+        };
+
+        try
+        {
+            body(progress);
+        }
+        catch (...)
+        {
+            stop_monitor();
+            throw;
+        }
+        stop_monitor();
+
+        if (g_format == OutputFormat::Json)
+            emit({{"event", "progress"}, {"phase", phase}, {"progress", 1.0}, {"elapsed", seconds_since(start)}});
+        else
+            std::cerr << "\r" << phase << " 100%\n";
+    }
+
+    std::unique_ptr<IArchive> open_and_scan(const std::string& path)
+    {
+        std::error_code ec;
+        if (!std::filesystem::exists(std::filesystem::u8path(path), ec))
+            throw std::runtime_error("no such file or directory: " + path);
+
+        std::unique_ptr<IArchive> archive = CreateArchive(Core::Utf8ToWString(path));
+        if (archive->GetType() == IArchive::PackType::Unknown)
+            throw std::runtime_error("not a recognised pack: " + path);
+
+        auto start = std::chrono::steady_clock::now();
+        with_progress("scan", [&](std::atomic<float>& progress) { archive->Scan(progress); });
+        double elapsed = seconds_since(start);
+
+        if (g_format == OutputFormat::Json)
+        {
+            emit({{"event", "scanned"}, {"archive", path}, {"type", pack_type_name(archive->GetType())},
+                  {"files", archive->GetParsedFileCount()}, {"bytes", archive->GetParsedTotalSize()}, {"seconds", elapsed}});
+        }
+        return archive;
+    }
+
+    const std::string& positional(const CliOptions& options, size_t index, const char* what)
+    {
+        if (index >= options.positional.size())
+            throw UsageError(std::string("missing ") + what);
+        return options.positional[index];
+    }
+
+    // Forwards to another sink and counts what actually reached it.
+    class CountingSink : public IOutputSink {
+    public:
+        explicit CountingSink(IOutputSink& inner) : inner(inner) {}
+
+        bool Write(const std::string& relative_path, const uint8_t* data, size_t size) override
+        {
+            if (!inner.Write(relative_path, data, size))
+            {
+                failed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            written.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(size, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool WriteAlias(const std::string& relative_path, const std::string& target_path) override
+        {
+            if (!inner.WriteAlias(relative_path, target_path))
+                return false;
+            aliased.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void ReportFailed(const std::string& relative_path) override
+        {
+            inner.ReportFailed(relative_path);
+            failed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Finish() override { inner.Finish(); }
+
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> aliased{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> bytes{0};
+
+    private:
+        IOutputSink& inner;
+    };
+
+    bool is_convertible(const std::string& format)
+    {
+        std::string ext = lower(format);
+        return ext == ".sct" || ext == ".sct2" || ext == ".db" || ext == ".scsp" || ext == ".atlas";
+    }
+
+    int run_scan(const CliOptions& options)
+    {
+        const std::string& path = positional(options, 0, "<pack>");
+        auto start = std::chrono::steady_clock::now();
+        auto archive = open_and_scan(path);
+
+        if (g_format == OutputFormat::Text)
+        {
+            std::ostringstream text;
+            text << path << ": " << pack_type_name(archive->GetType()) << ", " << archive->GetParsedFileCount()
+                 << " files, " << archive->GetParsedTotalSize() << " bytes, " << std::fixed << std::setprecision(2)
+                 << seconds_since(start) << " s";
+            say(text.str());
+        }
+        return 0;
+    }
+
+    int run_list(const CliOptions& options)
+    {
+        auto archive = open_and_scan(positional(options, 0, "<pack>"));
+        for_each_file(archive->GetFileTree(), [&](const Core::FileNode& node, const Core::FileInfo& info)
+        {
+            if (!is_selected(options, node.full_path))
+                return;
+            if (g_format == OutputFormat::Json)
+                emit({{"event", "file"}, {"path", node.full_path}, {"size", info.size}, {"format", info.format}});
+            else
+                say(std::to_string(info.size) + "\t" + node.full_path);
+        });
+        return 0;
+    }
+
+    int run_stats(const CliOptions& options)
+    {
+        auto archive = open_and_scan(positional(options, 0, "<pack>"));
+
+        struct Totals { uint64_t files = 0; uint64_t bytes = 0; uint64_t largest = 0; };
+        std::map<std::string, Totals> by_format;
+        Totals all;
+        for_each_file(archive->GetFileTree(), [&](const Core::FileNode& node, const Core::FileInfo& info)
+        {
+            if (!is_selected(options, node.full_path))
+                return;
+            for (Totals* totals : { &by_format[lower(info.format)], &all })
+            {
+                totals->files++;
+                totals->bytes += info.size;
+                totals->largest = std::max(totals->largest, info.size);
+            }
+        });
+
+        if (g_format == OutputFormat::Json)
+        {
+            json formats = json::array();
+            for (const auto& [format, totals] : by_format)
+                formats.push_back({{"format", format}, {"files", totals.files}, {"bytes", totals.bytes}, {"largest", totals.largest}});
+            emit({{"event", "stats"}, {"type", pack_type_name(archive->GetType())}, {"files", all.files},
+                  {"bytes", all.bytes}, {"largest", all.largest}, {"formats", std::move(formats)}});
+            return 0;
+        }
+
+        std::ostringstream text;
+        text << std::left << std::setw(12) << "format" << std::right << std::setw(10) << "files"
+             << std::setw(16) << "bytes" << std::setw(14) << "largest" << "\n";
+        auto row = [&](const std::string& name, const Totals& totals)
+        {
+            text << std::left << std::setw(12) << name << std::right << std::setw(10) << totals.files
+                 << std::setw(16) << totals.bytes << std::setw(14) << totals.largest << "\n";
+        };
+        for (const auto& [format, totals] : by_format)
+            row(format.empty() ? "(none)" : format, totals);
+        row("total", all);
+        say(text.str());
+        return 0;
+    }
+
+    // Shared by extract and convert: runs the archive extraction into a
+    // directory or tar sink for every file accepted by keep.
+    int extract_selected(const CliOptions& options, IArchive& archive, const std::string& output, const std::function<bool(const Core::FileNode&)>& keep, const ExtractOptions& extract_options)
+    {
+        Core::FileNode selection;
+        if (!filter_tree(archive.GetFileTree(), keep, selection))
+        {
+            if (g_format == OutputFormat::Json)
+                emit({{"event", "done"}, {"files", 0}, {"aliased", 0}, {"failed", 0}, {"bytes", 0}, {"seconds", 0.0}});
+            else
+                say("nothing matched");
+            return 0;
+        }
+        // Files land directly under the output root whatever the archive calls its root.
+        selection.name = "/";
+
+        std::unique_ptr<IOutputSink> target;
+        if (options.db_sqlite)
+        {
+#ifdef RIPPER_WITH_SQLITE
+            auto database = std::make_unique<SqliteSink>(Core::Utf8ToWString(output));
+            if (!database->IsOpen())
+                throw std::runtime_error("cannot create SQLite database: " + output);
+            target = std::move(database);
+#else
+            throw std::runtime_error("this build has no SQLite support");
+#endif
+        }
+        else if (options.tar)
+        {
+            auto tar = std::make_unique<TarSink>(Core::Utf8ToWString(output));
+            if (!tar->IsOpen())
+                throw std::runtime_error("cannot create tar archive: " + output);
+            target = std::move(tar);
+        }
+        else
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::u8path(output), ec);
+            if (ec)
+                throw std::runtime_error("cannot create output directory: " + output + " - " + ec.message());
+            target = std::make_unique<DirectorySink>(Core::Utf8ToWString(output));
+        }
+
+        CountingSink sink(*target);
+        auto start = std::chrono::steady_clock::now();
+        with_progress("extract", [&](std::atomic<float>& progress)
+        {
+            archive.Extract(selection, sink, progress, extract_options);
+        });
+        sink.Finish();
+        double elapsed = seconds_since(start);
+
+        if (g_format == OutputFormat::Json)
+        {
+            emit({{"event", "done"}, {"files", sink.written.load()}, {"aliased", sink.aliased.load()}, {"failed", sink.failed.load()},
+                  {"bytes", sink.bytes.load()}, {"seconds", elapsed}});
+        }
+        else
+        {
+            std::ostringstream text;
+            text << sink.written.load() << " files written";
+            if (sink.aliased.load())
+                text << ", " << sink.aliased.load() << " aliased";
+            if (sink.failed.load())
+                text << ", " << sink.failed.load() << " failed";
+            text << ", " << sink.bytes.load() << " bytes in " << std::fixed << std::setprecision(2) << elapsed << " s";
+            say(text.str());
+        }
+        return sink.failed.load() == 0 ? 0 : 2;
+    }
+
+    ExtractOptions make_extract_options(const CliOptions& options, bool convert)
+    {
+        ExtractOptions extract_options;
+        extract_options.convert_sct_to_png = convert;
+        extract_options.convert_db_to_json = convert;
+        extract_options.png_level = options.png_level;
+        extract_options.convert_sct_to_ktx2 = convert && options.ktx2;
+        extract_options.compact_json = options.compact_json;
+        extract_options.db_format = options.db_format;
+        extract_options.spine_format = options.spine_format;
+        extract_options.deduplicate = options.deduplicate;
+        extract_options.threads = options.threads;
+        return extract_options;
+    }
+
+    void reject_sqlite(const CliOptions& options)
+    {
+        if (options.db_sqlite)
+            throw UsageError("--db-format sqlite is only supported by export-db");
+    }
+
+    int run_extract(const CliOptions& options)
+    {
+        reject_sqlite(options);
+        const std::string& pack = positional(options, 0, "<pack>");
+        const std::string& output = positional(options, 1, "<output>");
+        auto archive = open_and_scan(pack);
+        return extract_selected(options, *archive, output,
+            [&](const Core::FileNode& node) { return is_selected(options, node.full_path); },
+            make_extract_options(options, options.convert));
+    }
+
+    // A single loose file is converted straight to the output path.
+    int convert_single_file(const std::string& input, const std::string& output, const CliOptions& options)
+    {
+        std::filesystem::path in_path = std::filesystem::u8path(input);
+        std::ifstream in(in_path, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("cannot read " + input);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::string ext = lower(in_path.extension().u8string());
+        std::vector<uint8_t> converted;
+        if (ext == ".sct" || ext == ".sct2")
+        {
+            converted = options.ktx2
+                ? SCTParser::ConvertToKTX2(data, false)
+                : SCTParser::ConvertToPNG(data, false, options.png_level);
+        }
+        else if (ext == ".db")
+        {
+            DBParser::ConvertTable(data, converted, options.db_format,
+                options.compact_json ? DBParser::JsonStyle::Compact : DBParser::JsonStyle::Pretty);
+        }
+        else if (ext == ".scsp")
+        {
+            converted = SCSPParser::ConvertSCSP(data, options.spine_format);
+        }
+        else
+        {
+            throw std::runtime_error("no converter for " + input);
+        }
+        if (converted.empty())
+            throw std::runtime_error("conversion failed for " + input);
+
+        std::filesystem::path out_path = std::filesystem::u8path(output);
+        std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(converted.data()), converted.size());
+        if (!out)
+            throw std::runtime_error("cannot write " + output);
+
+        if (g_format == OutputFormat::Json)
+            emit({{"event", "done"}, {"files", 1}, {"bytes", converted.size()}});
+        else
+            say(input + " -> " + output);
+        return 0;
+    }
+
+    int run_convert(const CliOptions& options)
+    {
+        reject_sqlite(options);
+        const std::string& input = positional(options, 0, "<input>");
+        const std::string& output = positional(options, 1, "<output>");
+
+        std::error_code ec;
+        std::filesystem::path in_path = std::filesystem::u8path(input);
+        std::string ext = lower(in_path.extension().u8string());
+        if (std::filesystem::is_regular_file(in_path, ec) && is_convertible(ext) && ext != ".atlas")
+            return convert_single_file(input, output, options);
+
+        // A pack or a directory of extracted files: convert every supported
+        // asset and skip the rest.
+        auto archive = open_and_scan(input);
+        return extract_selected(options, *archive, output,
+            [&](const Core::FileNode& node)
+            {
+                return is_convertible(std::get<Core::FileInfo>(node.data).format) && is_selected(options, node.full_path);
+            },
+            make_extract_options(options, true));
+    }
+
+    // Converts every selected .db file on the extraction workers; with
+    // --db-format sqlite they all become tables of one database file.
+    int run_export_db(const CliOptions& options)
+    {
+        const std::string& pack = positional(options, 0, "<pack>");
+        const std::string& output = positional(options, 1, "<output>");
+        auto archive = open_and_scan(pack);
+        return extract_selected(options, *archive, output,
+            [&](const Core::FileNode& node)
+            {
+                return lower(std::get<Core::FileInfo>(node.data).format) == ".db" && is_selected(options, node.full_path);
+            },
+            make_extract_options(options, !options.db_sqlite));
+    }
+
+    // Loads every selected .db file once, then answers each query given after
+    // the pack, or one per line from stdin when there are none. Results go to
+    // stdout as TSV with a header line, or as one JSON event per query.
+    int run_query(const CliOptions& options)
+    {
+        reject_sqlite(options);
+        const std::string& pack = positional(options, 0, "<pack>");
+        auto archive = open_and_scan(pack);
+
+        TableStore store;
+        auto start = std::chrono::steady_clock::now();
+        Core::FileNode selection;
+        if (filter_tree(archive->GetFileTree(), [&](const Core::FileNode& node)
+            {
+                return lower(std::get<Core::FileInfo>(node.data).format) == ".db" && is_selected(options, node.full_path);
+            }, selection))
+        {
+            selection.name = "/";
+            ExtractOptions extract_options;
+            extract_options.threads = options.threads;
+            with_progress("load", [&](std::atomic<float>& progress)
+            {
+                archive->Extract(selection, store, progress, extract_options);
+            });
+        }
+        store.Finish();
+
+        std::string error;
+        for (const std::string& reference : options.indexes)
+        {
+            if (!store.BuildIndex(reference, error))
+                throw std::runtime_error(error);
+        }
+        double elapsed = seconds_since(start);
+
+        if (g_format == OutputFormat::Json)
+        {
+            emit({{"event", "loaded"}, {"tables", store.GetTableCount()}, {"rows", store.GetRowCount()},
+                  {"strings", store.GetStringCount()}, {"seconds", elapsed}});
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(g_output_mutex);
+            std::cerr << store.GetTableCount() << " tables, " << store.GetRowCount() << " rows, " << store.GetStringCount()
+                      << " distinct values loaded in " << std::fixed << std::setprecision(2) << elapsed << " s\n";
+        }
+
+        uint64_t queries = 0;
+        uint64_t failed = 0;
+        auto run_one = [&](const std::string& text)
+        {
+            queries++;
+            TableStore::Result result;
+            auto query_start = std::chrono::steady_clock::now();
+            bool ok = store.Run(text, result, error);
+            double query_seconds = seconds_since(query_start);
+            if (!ok)
+                failed++;
+
+            if (g_format == OutputFormat::Json)
+            {
+                if (!ok)
+                {
+                    emit({{"event", "query"}, {"query", text}, {"error", error}});
+                    return;
+                }
+                json rows = json::array();
+                for (size_t r = 0; r < result.RowCount(); ++r)
+                {
+                    json row = json::array();
+                    for (size_t c = 0; c < result.columns.size(); ++c)
+                    {
+                        uint32_t id = result.cells[r * result.columns.size() + c];
+                        row.push_back(id == TableStore::MISSING ? json() : json(std::string(store.Text(id))));
+                    }
+                    rows.push_back(std::move(row));
+                }
+                emit({{"event", "query"}, {"query", text}, {"columns", result.columns}, {"rows", std::move(rows)}, {"seconds", query_seconds}});
+                return;
+            }
+
+            if (!ok)
+            {
+                std::lock_guard<std::mutex> lock(g_output_mutex);
+                std::cerr << "ripper_cli: " << error << "\n";
+                return;
+            }
+            std::string out;
+            auto put = [&](std::string_view piece) { out += piece; };
+            for (size_t c = 0; c < result.columns.size(); ++c)
+            {
+                if (c)
+                    out += '\t';
+                DBParser::PutTsvField(result.columns[c], put);
+            }
+            for (size_t r = 0; r < result.RowCount(); ++r)
+            {
+                out += '\n';
+                for (size_t c = 0; c < result.columns.size(); ++c)
+                {
+                    uint32_t id = result.cells[r * result.columns.size() + c];
+                    if (c)
+                        out += '\t';
+                    if (id != TableStore::MISSING)
+                        DBParser::PutTsvField(store.Text(id), put);
+                }
+            }
+            say(out);
+            std::lock_guard<std::mutex> lock(g_output_mutex);
+            std::cerr << result.RowCount() << " rows in " << std::fixed << std::setprecision(3) << query_seconds * 1000.0 << " ms\n";
+        };
+
+        if (options.positional.size() > 1)
+        {
+            for (size_t i = 1; i < options.positional.size(); ++i)
+                run_one(options.positional[i]);
+        }
+        else
+        {
+            std::string line;
+            while (std::getline(std::cin, line))
+            {
+                if (line.find_first_not_of(" \t\r") != std::string::npos)
+                    run_one(line);
+            }
+        }
+
+        if (g_format == OutputFormat::Json)
+            emit({{"event", "done"}, {"queries", queries}, {"failed", failed}});
+        return failed == 0 ? 0 : 2;
+    }
+
+    std::string csv_field(const std::string& text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string::npos)
+            return text;
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    // Reads only SCT headers, so a pack's texture inventory costs about as much
+    // as reading its texture files once.
+    int run_inventory(const CliOptions& options)
+    {
+        const std::string& pack = positional(options, 0, "<pack>");
+        const std::string& output = positional(options, 1, "<output>");
+        std::string out_ext = lower(std::filesystem::u8path(output).extension().u8string());
+        if (out_ext != ".csv" && out_ext != ".json")
+            throw UsageError("inventory output must end in .csv or .json");
+
+        auto archive = open_and_scan(pack);
+
+        struct Entry
+        {
+            const Core::FileNode* node = nullptr;
+            bool valid = false;
+            SCTParser::ProbeInfo info;
+        };
+        std::vector<Entry> entries;
+        for_each_file(archive->GetFileTree(), [&](const Core::FileNode& node, const Core::FileInfo& info)
+        {
+            std::string ext = lower(info.format);
+            if ((ext == ".sct" || ext == ".sct2") && is_selected(options, node.full_path))
+                entries.push_back({&node, false, {}});
+        });
+
+        unsigned int thread_count = options.threads;
+        if (thread_count == 0)
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        thread_count = static_cast<unsigned int>(std::min<size_t>(thread_count, std::max<size_t>(entries.size(), 1)));
+
+        auto start = std::chrono::steady_clock::now();
+        with_progress("inventory", [&](std::atomic<float>& progress)
+        {
+            std::atomic<size_t> next_entry{0};
+            std::atomic<size_t> finished{0};
+            auto worker = [&]()
+            {
+                for (size_t i = next_entry.fetch_add(1); i < entries.size(); i = next_entry.fetch_add(1))
+                {
+                    std::vector<uint8_t> data = archive->GetFileData(*entries[i].node);
+                    entries[i].valid = SCTParser::Probe(data.data(), data.size(), entries[i].info);
+                    progress = static_cast<float>(finished.fetch_add(1) + 1) / entries.size();
+                }
+            };
+            std::vector<std::thread> workers;
+            for (unsigned int t = 1; t < thread_count; ++t)
+                workers.emplace_back(worker);
+            worker();
+            for (auto& w : workers)
+                w.join();
+        });
+
+        std::ofstream out(std::filesystem::u8path(output), std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("cannot write " + output);
+
+        uint64_t textures = 0;
+        uint64_t unreadable = 0;
+        uint64_t stored_bytes = 0;
+        uint64_t payload_bytes = 0;
+        if (out_ext == ".csv")
+            out << "path,container,pixel_format,type,width,height,texture_width,texture_height,flags,lz4,compressed_size,decompressed_size\n";
+        else
+            out << "[";
+        for (const Entry& entry : entries)
+        {
+            if (!entry.valid)
+            {
+                unreadable++;
+                continue;
+            }
+            const SCTParser::ProbeInfo& info = entry.info;
+            if (out_ext == ".csv")
+            {
+                out << csv_field(entry.node->full_path) << ',' << info.container << ',' << info.pixel_format << ','
+                    << info.pixel_type << ',' << info.width << ',' << info.height << ',' << info.texture_width << ','
+                    << info.texture_height << ',' << static_cast<int>(info.flags) << ',' << (info.lz4 ? 1 : 0) << ','
+                    << info.compressed_size << ',' << info.decompressed_size << '\n';
+            }
+            else
+            {
+                json row = {{"path", entry.node->full_path}, {"container", info.container}, {"pixel_format", info.pixel_format},
+                            {"type", info.pixel_type}, {"width", info.width}, {"height", info.height},
+                            {"texture_width", info.texture_width}, {"texture_height", info.texture_height},
+                            {"flags", info.flags}, {"lz4", info.lz4}, {"compressed_size", info.compressed_size},
+                            {"decompressed_size", info.decompressed_size}};
+                out << (textures ? ",\n  " : "\n  ") << row.dump();
+            }
+            textures++;
+            stored_bytes += info.compressed_size;
+            payload_bytes += info.decompressed_size;
+        }
+        if (out_ext == ".json")
+            out << (textures ? "\n]\n" : "]\n");
+        out.close();
+        if (!out)
+            throw std::runtime_error("cannot write " + output);
+        double elapsed = seconds_since(start);
+
+        if (g_format == OutputFormat::Json)
+        {
+            emit({{"event", "done"}, {"textures", textures}, {"unreadable", unreadable}, {"stored_bytes", stored_bytes},
+                  {"decompressed_bytes", payload_bytes}, {"seconds", elapsed}});
+        }
+        else
+        {
+            std::ostringstream text;
+            text << textures << " textures";
+            if (unreadable)
+                text << ", " << unreadable << " unreadable";
+            text << ", " << stored_bytes << " bytes stored, " << payload_bytes << " bytes decompressed, "
+                 << std::fixed << std::setprecision(2) << elapsed << " s";
+            say(text.str());
+        }
+        return unreadable == 0 ? 0 : 2;
+    }
+
+    void print_usage()
+    {
+        std::cerr <<
+            "usage: ripper_cli <command> [options] <args>\n"
+            "\n"
+            "commands:\n"
+            "  scan <pack>                  scan and print a summary\n"
+            "  list <pack>                  print every file with its size\n"
+            "  stats <pack>                 file counts and sizes per format\n"
+            "  extract <pack> <output>      extract files into a directory (or a tar with --tar)\n"
+            "  convert <input> <output>     convert SCT/DB/SCSP assets; <input> is a pack, a\n"
+            "                               directory of extracted files or a single asset\n"
+            "  inventory <pack> <output>    list SCT formats, sizes and compression from the\n"
+            "                               headers alone; <output> ends in .csv or .json\n"
+            "  export-db <pack> <output>    convert every DB table into a directory, or into\n"
+            "                               one SQLite file with --db-format sqlite\n"
+            "  query <pack> [query...]      load every DB table into memory and run SELECT\n"
+            "                               queries; reads one per line from stdin if none given\n"
+            "\n"
+            "<pack> is a data.pack, a manifest.ssra or a directory of extracted files.\n"
+            "\n"
+            "options:\n"
+            "  --include GLOB     only files matching GLOB (repeatable)\n"
+            "  --exclude GLOB     skip files matching GLOB (repeatable)\n"
+            "                     '*' and '?' stay in one folder, '**' spans folders; globs\n"
+            "                     without '/' match the file name; matching ignores case\n"
+            "  --threads N        extraction/inventory workers, 0 = all cores (default 0)\n"
+            "  --format F         text or json; json writes one event object per line\n"
+            "  --convert          extract: SCT to PNG and DB to JSON\n"
+            "  --png-level L      PNG compression: fast, default (default) or best\n"
+            "  --ktx2             write SCT textures as KTX2 with their original ASTC/ETC2\n"
+            "                     blocks instead of decoding them to PNG\n"
+            "  --db-format F      DB tables as json (default), csv, tsv or ndjson;\n"
+            "                     export-db also takes sqlite\n"
+            "  --compact-json     write DB tables as single-line JSON\n"
+            "  --spine-format F   SCSP skeletons as Spine json (default) or binary skel\n"
+            "  --index T.C        query: build a hash index on column C of table T up front\n"
+            "                     (repeatable); other columns are indexed on first use\n"
+            "  --tar              extract/convert: write <output> as a tar archive\n"
+            "  --dedupe           alias byte-identical files instead of writing them again\n"
+            "  --verbose          write info-level messages to the log file\n";
+    }
+
+    CliOptions parse_args(const std::vector<std::string>& args)
+    {
+        CliOptions options;
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            const std::string& arg = args[i];
+            auto next = [&]() -> const std::string&
+            {
+                if (i + 1 >= args.size())
+                    throw UsageError("missing value for " + arg);
+                return args[++i];
+            };
+            if (arg == "--include") options.includes.push_back(next());
+            else if (arg == "--exclude") options.excludes.push_back(next());
+            else if (arg == "--threads")
+            {
+                const std::string& value = next();
+                const char* end = value.data() + value.size();
+                auto [ptr, ec] = std::from_chars(value.data(), end, options.threads);
+                if (value.empty() || ec != std::errc() || ptr != end)
+                    throw UsageError("invalid thread count " + value);
+            }
+            else if (arg == "--format")
+            {
+                const std::string& value = next();
+                if (value == "text") options.format = OutputFormat::Text;
+                else if (value == "json") options.format = OutputFormat::Json;
+                else throw UsageError("unknown format " + value);
+            }
+            else if (arg == "--convert") options.convert = true;
+            else if (arg == "--ktx2") options.ktx2 = true;
+            else if (arg == "--compact-json") options.compact_json = true;
+            else if (arg == "--db-format")
+            {
+                const std::string& value = next();
+                if (lower(value) == "sqlite") options.db_sqlite = true;
+                else if (!DBParser::ParseTableFormat(value, options.db_format))
+                    throw UsageError("unknown DB format " + value);
+            }
+            else if (arg == "--spine-format")
+            {
+                const std::string& value = next();
+                if (!SCSPParser::ParseSkeletonFormat(value, options.spine_format))
+                    throw UsageError("unknown Spine format " + value);
+            }
+            else if (arg == "--index") options.indexes.push_back(next());
+            else if (arg == "--png-level")
+            {
+                const std::string& value = next();
+                if (!PngWriter::ParseLevel(value, options.png_level))
+                    throw UsageError("unknown PNG level " + value);
+            }
+            else if (arg == "--tar") options.tar = true;
+            else if (arg == "--dedupe") options.deduplicate = true;
+            else if (arg == "--verbose") options.verbose = true;
+            else if (arg == "--help" || arg == "-h")
+            {
+                print_usage();
+                std::exit(0);
+            }
+            else if (arg.size() > 1 && arg[0] == '-')
+                throw UsageError("unknown option " + arg);
+            else if (options.command.empty())
+                options.command = arg;
+            else
+                options.positional.push_back(arg);
+        }
+        if (options.command.empty())
+            throw UsageError("missing command");
+        return options;
+    }
+
+    int run(const std::vector<std::string>& args)
+    {
+        CliOptions options;
+        try
+        {
+            options = parse_args(args);
+            g_format = options.format;
+            SetLogLevel(options.verbose ? LogLevel::Info : LogLevel::Error);
+
+            static const std::map<std::string, std::function<int(const CliOptions&)>> commands = {
+                {"scan", run_scan},
+                {"list", run_list},
+                {"stats", run_stats},
+                {"extract", run_extract},
+                {"convert", run_convert},
+                {"inventory", run_inventory},
+                {"export-db", run_export_db},
+                {"query", run_query},
+            };
+            auto command = commands.find(options.command);
+            if (command == commands.end())
+                throw UsageError("unknown command " + options.command);
+
+            int status = command->second(options);
+            LogFlush();
+            return status;
+        }
+        catch (const UsageError& e)
+        {
+            std::cerr << "ripper_cli: " << e.what() << "\n\n";
+            print_usage();
+            return 64;
+        }
+        catch (const std::exception& e)
+        {
+            if (g_format == OutputFormat::Json)
+                emit({{"event", "error"}, {"message", e.what()}});
+            else
+                std::cerr << "ripper_cli: " << e.what() << "\n";
+            LogFlush();
+            return 1;
+        }
+    }
+}
+
+#ifdef _WIN32
+// wmain keeps non-ASCII paths intact; the narrow argv uses the ANSI code page.
+int wmain(int argc, wchar_t** argv)
+{
+    SetConsoleOutputCP(CP_UTF8);
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i)
+        args.push_back(Core::WStringToUtf8(argv[i]));
+    return run(args);
+}
+#else
+int main(int argc, char** argv)
+{
+    return run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
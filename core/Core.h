@@ -19,7 +19,28 @@ namespace Core {
         WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.size(), &str[0], size_needed, NULL, NULL);
         return str;
 #else
-        return std::string(wstr.begin(), wstr.end());
+        // wchar_t holds a full code point here
+        std::string str;
+        str.reserve(wstr.size());
+        for (wchar_t wc : wstr) {
+            uint32_t cp = static_cast<uint32_t>(wc);
+            if (cp < 0x80) {
+                str += static_cast<char>(cp);
+            } else if (cp < 0x800) {
+                str += static_cast<char>(0xC0 | (cp >> 6));
+                str += static_cast<char>(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                str += static_cast<char>(0xE0 | (cp >> 12));
+                str += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                str += static_cast<char>(0x80 | (cp & 0x3F));
+            } else {
+                str += static_cast<char>(0xF0 | (cp >> 18));
+                str += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                str += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                str += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+        return str;
 #endif
     }
 
@@ -32,12 +53,51 @@ namespace Core {
         MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), &wstr[0], size_needed);
         return wstr;
 #else
-        return std::wstring(str.begin(), str.end());
+        std::wstring wstr;
+        wstr.reserve(str.size());
+        for (size_t i = 0; i < str.size();) {
+            uint8_t c = static_cast<uint8_t>(str[i]);
+            size_t extra = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : 0;
+            uint32_t cp = (extra == 0) ? c : (c & (0x3F >> extra));
+            if (extra > 0 && i + extra >= str.size()) {
+                // truncated sequence, keep the raw byte
+                wstr += static_cast<wchar_t>(c);
+                ++i;
+                continue;
+            }
+            for (size_t k = 1; k <= extra; ++k)
+                cp = (cp << 6) | (static_cast<uint8_t>(str[i + k]) & 0x3F);
+            wstr += static_cast<wchar_t>(cp);
+            i += extra + 1;
+        }
+        return wstr;
+#endif
+    }
+
+    // libstdc++ cannot convert non-ASCII wide strings to native POSIX paths,
+    // so wide paths go through UTF-8 everywhere but Windows.
+    inline std::filesystem::path WidePath(const std::wstring& wstr) {
+#ifdef _WIN32
+        return std::filesystem::path(wstr);
+#else
+        return std::filesystem::u8path(WStringToUtf8(wstr));
+#endif
+    }
+
+    inline std::wstring PathToWString(const std::filesystem::path& p) {
+#ifdef _WIN32
+        return p.wstring();
+#else
+        return Utf8ToWString(p.u8string());
 #endif
     }
 
     inline std::string PathToUtf8(const std::filesystem::path& p) {
+#ifdef _WIN32
         return WStringToUtf8(p.wstring());
+#else
+        return p.u8string();
+#endif
     }
     
     static constexpr uint32_t INITIAL = 0x24D1C;
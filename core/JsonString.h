@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace Core {
+    // What PutJsonString does with bytes that are not valid UTF-8.
+    enum class InvalidUtf8 {
+        Replace, // write U+FFFD in their place
+        Reject   // stop and return false
+    };
+
+    // Length of the well-formed UTF-8 sequence starting at text[pos], or 0.
+    inline size_t Utf8Length(std::string_view text, size_t pos) {
+        uint8_t c = static_cast<uint8_t>(text[pos]);
+        size_t length;
+        uint8_t low = 0x80, high = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF)
+            length = 2;
+        else if (c >= 0xE0 && c <= 0xEF) {
+            length = 3;
+            if (c == 0xE0) low = 0xA0;
+            if (c == 0xED) high = 0x9F;
+        }
+        else if (c >= 0xF0 && c <= 0xF4) {
+            length = 4;
+            if (c == 0xF0) low = 0x90;
+            if (c == 0xF4) high = 0x8F;
+        }
+        else
+            return 0;
+
+        if (text.size() - pos < length)
+            return 0;
+        for (size_t i = 1; i < length; ++i) {
+            uint8_t next = static_cast<uint8_t>(text[pos + i]);
+            if (next < low || next > high)
+                return 0;
+            low = 0x80;
+            high = 0xBF;
+        }
+        return length;
+    }
+
+    // Writes text as a quoted JSON string, escaped the way nlohmann::json dumps
+    // it without ensure_ascii. put receives the output in pieces, mostly whole
+    // runs of the input. Returns false if invalid UTF-8 was rejected, after
+    // writing everything before it.
+    template <typename Put>
+    bool PutJsonString(std::string_view text, InvalidUtf8 invalid, Put&& put) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        put(std::string_view("\"", 1));
+        size_t run = 0;
+        size_t i = 0;
+        while (i < text.size()) {
+            uint8_t c = static_cast<uint8_t>(text[i]);
+            if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+                ++i;
+                continue;
+            }
+            if (c >= 0x80) {
+                if (size_t length = Utf8Length(text, i)) {
+                    i += length;
+                    continue;
+                }
+            }
+
+            put(text.substr(run, i - run));
+            switch (c) {
+            case '"': put(std::string_view("\\\"")); break;
+            case '\\': put(std::string_view("\\\\")); break;
+            case '\b': put(std::string_view("\\b")); break;
+            case '\f': put(std::string_view("\\f")); break;
+            case '\n': put(std::string_view("\\n")); break;
+            case '\r': put(std::string_view("\\r")); break;
+            case '\t': put(std::string_view("\\t")); break;
+            default:
+                if (c < 0x20) {
+                    const char escape[] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15] };
+                    put(std::string_view(escape, sizeof(escape)));
+                }
+                else if (invalid == InvalidUtf8::Reject)
+                    return false;
+                else
+                    put(std::string_view("\xEF\xBF\xBD"));
+                break;
+            }
+            run = ++i;
+        }
+        put(text.substr(run));
+        put(std::string_view("\"", 1));
+        return true;
+    }
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace Core {
+    // Raw LZ4 blocks (no frame header): decoding shared by the SCT and SCSP
+    // parsers, and a greedy compressor for the thumbnail cache and test data.
+    namespace LZ4Internal {
+        // Wild copies may write up to this many bytes past the requested end,
+        // so the fast paths only run while that much output room is left.
+        static constexpr size_t WILD_MARGIN = 16;
+
+        inline void copy8(uint8_t* dst, const uint8_t* src) { std::memcpy(dst, src, 8); }
+        inline void copy16(uint8_t* dst, const uint8_t* src) { std::memcpy(dst, src, 16); }
+
+        // Reads the 255-continued length extension. Returns false on truncated input.
+        inline bool read_length(const uint8_t*& ip, const uint8_t* iend, size_t& length) {
+            uint8_t b;
+            do {
+                if (ip >= iend)
+                    return false;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+            return true;
+        }
+    }
+
+    // Decodes one LZ4 block into dst and returns the number of bytes written.
+    // Decoding stops when dst is full or the input ends. ok (if given) is set to
+    // false when the input is malformed; the bytes decoded up to that point are
+    // still valid. Never reads outside src or writes outside dst.
+    inline size_t LZ4DecodeBlock(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size, bool* ok = nullptr) {
+        using namespace LZ4Internal;
+
+        const uint8_t* ip = src;
+        const uint8_t* const iend = src + src_size;
+        uint8_t* op = dst;
+        uint8_t* const oend = dst + dst_size;
+        bool valid = true;
+
+        while (ip < iend && op < oend) {
+            const uint8_t token = *ip++;
+
+            // Literals
+            size_t literal_length = token >> 4;
+            if (literal_length != 15 && ip + WILD_MARGIN <= iend && op + WILD_MARGIN <= oend) {
+                copy16(op, ip);
+            }
+            else {
+                if (literal_length == 15 && !read_length(ip, iend, literal_length)) {
+                    valid = false;
+                    break;
+                }
+                if (literal_length > static_cast<size_t>(iend - ip)) {
+                    valid = false;
+                    break;
+                }
+                if (literal_length > static_cast<size_t>(oend - op)) {
+                    // Output is full; keep what fits.
+                    literal_length = static_cast<size_t>(oend - op);
+                    std::memcpy(op, ip, literal_length);
+                    op += literal_length;
+                    break;
+                }
+                std::memcpy(op, ip, literal_length);
+            }
+            ip += literal_length;
+            op += literal_length;
+
+            // The last sequence of a block carries literals only.
+            if (ip >= iend || op >= oend)
+                break;
+
+            // Match
+            if (iend - ip < 2) {
+                valid = false;
+                break;
+            }
+            const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+                valid = false;
+                break;
+            }
+
+            size_t match_length = token & 0x0F;
+            if (match_length == 15 && !read_length(ip, iend, match_length)) {
+                valid = false;
+                break;
+            }
+            match_length += 4;
+
+            const uint8_t* match = op - offset;
+            uint8_t* const match_end = op + match_length;
+
+            if (match_length > static_cast<size_t>(oend - op) || static_cast<size_t>(oend - match_end) < WILD_MARGIN) {
+                // Too close to the end of dst for wild copies.
+                size_t count = match_length;
+                if (count > static_cast<size_t>(oend - op))
+                    count = static_cast<size_t>(oend - op);
+                for (size_t i = 0; i < count; ++i)
+                    op[i] = match[i];
+                op += count;
+                continue;
+            }
+
+            if (offset >= 16) {
+                // Source and destination never overlap within one 16-byte move.
+                do {
+                    copy16(op, match);
+                    op += 16;
+                    match += 16;
+                } while (op < match_end);
+            }
+            else if (offset >= 8) {
+                do {
+                    copy8(op, match);
+                    op += 8;
+                    match += 8;
+                } while (op < match_end);
+            }
+            else {
+                // Short offsets repeat a pattern of offset bytes. Write the first
+                // eight bytes one at a time, then copy from a distance that is a
+                // multiple of offset and at least eight, which repeats the same
+                // pattern with non-overlapping 8-byte moves.
+                for (int i = 0; i < 8; ++i)
+                    op[i] = match[i];
+                const size_t distance = offset * ((8 + offset - 1) / offset);
+                uint8_t* out = op + 8;
+                while (out < match_end) {
+                    copy8(out, out - distance);
+                    out += 8;
+                }
+            }
+            op = match_end;
+        }
+
+        if (ok)
+            *ok = valid;
+        return static_cast<size_t>(op - dst);
+    }
+
+    // Greedy single-probe LZ4 block compressor; appends to out.
+    inline void LZ4CompressBlock(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_START_LIMIT = 12;
+        constexpr int HASH_BITS = 16;
+
+        out.reserve(out.size() + size + size / 255 + 16);
+
+        auto put_length = [&](size_t length) {
+            while (length >= 255) {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<uint8_t>(length));
+        };
+
+        auto emit = [&](size_t literal_start, size_t literal_end, size_t offset, size_t match_length) {
+            size_t literal_length = literal_end - literal_start;
+            uint8_t token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+            if (match_length != 0)
+                token |= static_cast<uint8_t>(std::min<size_t>(match_length - MIN_MATCH, 15));
+            out.push_back(token);
+            if (literal_length >= 15)
+                put_length(literal_length - 15);
+            out.insert(out.end(), data + literal_start, data + literal_end);
+            if (match_length == 0)
+                return;
+            out.push_back(static_cast<uint8_t>(offset & 0xFF));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (match_length - MIN_MATCH >= 15)
+                put_length(match_length - MIN_MATCH - 15);
+        };
+
+        size_t anchor = 0;
+        if (size > MATCH_START_LIMIT) {
+            std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // position + 1, 0 = empty
+            const size_t match_limit = size - MATCH_START_LIMIT;
+            const size_t end_limit = size - LAST_LITERALS;
+            size_t ip = 0;
+            while (ip < match_limit) {
+                uint32_t sequence;
+                std::memcpy(&sequence, data + ip, 4);
+                uint32_t h = (sequence * 2654435761u) >> (32 - HASH_BITS);
+                size_t candidate = table[h];
+                table[h] = static_cast<uint32_t>(ip + 1);
+
+                if (candidate != 0 && ip - (candidate - 1) <= 0xFFFF && std::memcmp(data + candidate - 1, data + ip, 4) == 0) {
+                    size_t ref = candidate - 1;
+                    size_t length = MIN_MATCH;
+                    while (ip + length < end_limit && data[ref + length] == data[ip + length])
+                        ++length;
+                    emit(anchor, ip, ip - ref, length);
+                    ip += length;
+                    anchor = ip;
+                }
+                else {
+                    ++ip;
+                }
+            }
+        }
+        emit(anchor, size, 0, 0);
+    }
+}
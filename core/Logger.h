@@ -5,37 +5,247 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+enum class LogLevel : int {
+	Debug = 0,
+	Info = 1,
+	Error = 2,
+	Off = 3
+};
+
+// Anything below this level is compiled out of LogEnabled() checks.
+#ifndef CZN_LOG_MIN_LEVEL
+#define CZN_LOG_MIN_LEVEL 0
+#endif
 
 namespace LoggerInternal {
-	inline std::mutex& mutexRef() {
-		static std::mutex m; return m;
-	}
-	inline std::string nowTimestamp() {
-		using namespace std::chrono;
-		auto now = system_clock::now();
-		auto t = system_clock::to_time_t(now);
-		auto tm = *std::localtime(&t);
-		std::ostringstream oss;
-		oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-		return oss.str();
-	}
-	inline void writeLine(const char* level, const std::string& msg) {
-		std::lock_guard<std::mutex> lock(mutexRef());
-		std::ofstream out("czn_ripper.log", std::ios::app);
-		if (!out.is_open()) return;
-		out << nowTimestamp() << " [" << level << "] " << msg << "\n";
-		out.flush();
-	}
+	struct Record {
+		std::chrono::system_clock::time_point time;
+		LogLevel level = LogLevel::Info;
+		std::string message;
+	};
+
+	// Single-producer/single-consumer ring, one per logging thread.
+	class RecordRing {
+	public:
+		static constexpr size_t CAPACITY = 1024;
+
+		bool tryPush(Record&& record) {
+			const size_t head = head_.load(std::memory_order_relaxed);
+			if (head - tail_.load(std::memory_order_acquire) >= CAPACITY) return false;
+			slots_[head % CAPACITY] = std::move(record);
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t size() const {
+			return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+		}
+
+		template <typename F>
+		void drain(F&& consume) {
+			size_t tail = tail_.load(std::memory_order_relaxed);
+			const size_t head = head_.load(std::memory_order_acquire);
+			for (; tail != head; ++tail) {
+				consume(std::move(slots_[tail % CAPACITY]));
+			}
+			tail_.store(tail, std::memory_order_release);
+		}
+
+	private:
+		std::array<Record, CAPACITY> slots_;
+		std::atomic<size_t> head_{0};
+		std::atomic<size_t> tail_{0};
+	};
+
+	// Owns the log file and a worker thread that drains every ring in batches.
+	class Backend {
+	public:
+		static Backend& instance() {
+			static Backend backend;
+			return backend;
+		}
+
+		std::atomic<int>& minLevel() { return minLevel_; }
+
+		void push(LogLevel level, std::string message) {
+			Record record;
+			record.time = std::chrono::system_clock::now();
+			record.level = level;
+			record.message = std::move(message);
+
+			RecordRing& ring = localRing();
+			while (!ring.tryPush(std::move(record))) {
+				// Full ring: debug chatter is expendable, everything else waits for the writer.
+				if (level == LogLevel::Debug) {
+					dropped_.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				wake();
+				std::this_thread::yield();
+			}
+			if (level >= LogLevel::Error || ring.size() >= RecordRing::CAPACITY / 2) wake();
+		}
+
+		void flush() {
+			std::unique_lock<std::mutex> lock(stateMutex_);
+			const uint64_t ticket = ++flushRequested_;
+			wakeup_ = true;
+			cv_.notify_all();
+			flushedCv_.wait(lock, [&] { return flushCompleted_ >= ticket || stopping_; });
+		}
+
+		~Backend() {
+			{
+				std::lock_guard<std::mutex> lock(stateMutex_);
+				stopping_ = true;
+				wakeup_ = true;
+			}
+			cv_.notify_all();
+			if (worker_.joinable()) worker_.join();
+		}
+
+	private:
+		Backend() : worker_([this] { run(); }) {}
+
+		RecordRing& localRing() {
+			thread_local std::shared_ptr<RecordRing> ring = registerRing();
+			return *ring;
+		}
+
+		std::shared_ptr<RecordRing> registerRing() {
+			auto ring = std::make_shared<RecordRing>();
+			std::lock_guard<std::mutex> lock(ringsMutex_);
+			rings_.push_back(ring);
+			return ring;
+		}
+
+		void wake() {
+			{
+				std::lock_guard<std::mutex> lock(stateMutex_);
+				wakeup_ = true;
+			}
+			cv_.notify_one();
+		}
+
+		const std::string& timestampFor(std::chrono::system_clock::time_point time) {
+			const auto t = std::chrono::system_clock::to_time_t(time);
+			if (t != cachedSecond_) {
+				auto tm = *std::localtime(&t);
+				std::ostringstream oss;
+				oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+				cachedStamp_ = oss.str();
+				cachedSecond_ = t;
+			}
+			return cachedStamp_;
+		}
+
+		void writeBatch() {
+			std::vector<std::shared_ptr<RecordRing>> rings;
+			{
+				std::lock_guard<std::mutex> lock(ringsMutex_);
+				// Rings of finished threads are only referenced from here once emptied.
+				rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<RecordRing>& ring) {
+					return ring.use_count() == 1 && ring->size() == 0;
+				}), rings_.end());
+				rings = rings_;
+			}
+
+			batch_.clear();
+			for (auto& ring : rings) {
+				ring->drain([&](Record&& record) { batch_.push_back(std::move(record)); });
+			}
+			const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+			if (batch_.empty() && dropped == 0) return;
+
+			std::stable_sort(batch_.begin(), batch_.end(), [](const Record& a, const Record& b) { return a.time < b.time; });
+
+			text_.clear();
+			for (const Record& record : batch_) {
+				text_ += timestampFor(record.time);
+				text_ += record.level == LogLevel::Error ? " [ERROR] " : (record.level == LogLevel::Debug ? " [DEBUG] " : " [INFO] ");
+				text_ += record.message;
+				text_ += '\n';
+			}
+			if (dropped != 0) {
+				text_ += timestampFor(std::chrono::system_clock::now());
+				text_ += " [INFO] Logger queue full, dropped " + std::to_string(dropped) + " debug lines\n";
+			}
+
+			if (!out_.is_open()) out_.open("czn_ripper.log", std::ios::app | std::ios::binary);
+			if (!out_.is_open()) return;
+			out_.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+			out_.flush();
+		}
+
+		void run() {
+			std::unique_lock<std::mutex> lock(stateMutex_);
+			while (true) {
+				cv_.wait_for(lock, std::chrono::milliseconds(200), [&] { return wakeup_; });
+				wakeup_ = false;
+				const bool stopping = stopping_;
+				const uint64_t ticket = flushRequested_;
+
+				lock.unlock();
+				writeBatch();
+				lock.lock();
+
+				flushCompleted_ = ticket;
+				flushedCv_.notify_all();
+				if (stopping) break;
+			}
+		}
+
+		std::mutex ringsMutex_;
+		std::vector<std::shared_ptr<RecordRing>> rings_;
+		std::atomic<uint64_t> dropped_{0};
+		std::atomic<int> minLevel_{static_cast<int>(LogLevel::Info)};
+
+		std::mutex stateMutex_;
+		std::condition_variable cv_;
+		std::condition_variable flushedCv_;
+		bool wakeup_ = false;
+		bool stopping_ = false;
+		uint64_t flushRequested_ = 0;
+		uint64_t flushCompleted_ = 0;
+
+		// Only touched by the worker thread.
+		std::ofstream out_;
+		std::vector<Record> batch_;
+		std::string text_;
+		std::time_t cachedSecond_ = 0;
+		std::string cachedStamp_;
+
+		std::thread worker_;
+	};
+}
+
+inline void SetLogLevel(LogLevel level) {
+	LoggerInternal::Backend::instance().minLevel().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+// Cheap check so hot paths can skip building messages nobody will see.
+inline bool LogEnabled(LogLevel level) {
+	if (static_cast<int>(level) < CZN_LOG_MIN_LEVEL) return false;
+	return static_cast<int>(level) >= LoggerInternal::Backend::instance().minLevel().load(std::memory_order_relaxed);
 }
 
+inline void LogDebug(const std::string& message) {
+	if (LogEnabled(LogLevel::Debug)) LoggerInternal::Backend::instance().push(LogLevel::Debug, message);
+}
 inline void LogInfo(const std::string& message) {
-	LoggerInternal::writeLine("INFO", message);
+	if (LogEnabled(LogLevel::Info)) LoggerInternal::Backend::instance().push(LogLevel::Info, message);
 }
 inline void LogError(const std::string& message) {
-	LoggerInternal::writeLine("ERROR", message);
+	if (LogEnabled(LogLevel::Error)) LoggerInternal::Backend::instance().push(LogLevel::Error, message);
 }
 inline void LogFlush() {
-	std::lock_guard<std::mutex> lock(LoggerInternal::mutexRef());
-	std::ofstream out("czn_ripper.log", std::ios::app);
-	if (out.is_open()) out.flush();
+	LoggerInternal::Backend::instance().flush();
 }
@@ -2,12 +2,19 @@
 #include <algorithm>
 #include <fstream>
 #include <string>
+#include "parsers/PngWriter.h"
+#include "parsers/DBParser.h"
 
 struct RipperOptions
 {
     bool exportSctAsPng = true;
+    PngWriter::Level sctPngLevel = PngWriter::Level::Default;
     bool exportDbAsJson = true;
+    DBParser::TableFormat dbFormat = DBParser::TableFormat::Json;
     bool enableOpenFolder = false;
+    bool exportAsTar = false;
+    bool deduplicate = false;
+    bool verboseLogging = false;
 };
 
 namespace RipperOptionsInternal
@@ -40,6 +47,34 @@ namespace RipperOptionsInternal
 
         return defaultValue;
     }
+
+    // export_sct_as_png takes a boolean or, as older files wrote it, a PNG
+    // level name (fast, default, best); a level name also turns the export on.
+    inline void parseSctPng(const std::string &value, RipperOptions &options)
+    {
+        PngWriter::Level level;
+        if (PngWriter::ParseLevel(trimCopy(value), level))
+        {
+            options.exportSctAsPng = true;
+            options.sctPngLevel = level;
+            return;
+        }
+        options.exportSctAsPng = parseBool(value, options.exportSctAsPng);
+    }
+
+    // export_db_as_json likewise takes a boolean or, from older files, a table
+    // format name (json, csv, tsv, ndjson); a format name also turns it on.
+    inline void parseDbFormat(const std::string &value, RipperOptions &options)
+    {
+        DBParser::TableFormat format;
+        if (DBParser::ParseTableFormat(trimCopy(value), format))
+        {
+            options.exportDbAsJson = true;
+            options.dbFormat = format;
+            return;
+        }
+        options.exportDbAsJson = parseBool(value, options.exportDbAsJson);
+    }
 }
 
 inline void SaveRipperOptions(const RipperOptions &options, const std::string &iniPath = "czn_ripper.ini")
@@ -52,8 +87,13 @@ inline void SaveRipperOptions(const RipperOptions &options, const std::string &i
 
     out << "[options]\n";
     out << "export_sct_as_png=" << (options.exportSctAsPng ? true : false) << "\n";
+    out << "sct_png_level=" << PngWriter::LevelName(options.sctPngLevel) << "\n";
     out << "export_db_as_json=" << (options.exportDbAsJson ? true : false) << "\n";
+    out << "db_table_format=" << DBParser::TableFormatName(options.dbFormat) << "\n";
     out << "enable_open_folder=" << (options.enableOpenFolder ? true : false) << "\n";
+    out << "export_as_tar=" << (options.exportAsTar ? true : false) << "\n";
+    out << "deduplicate=" << (options.deduplicate ? true : false) << "\n";
+    out << "verbose_logging=" << (options.verboseLogging ? true : false) << "\n";
     out.flush();
 }
 
@@ -88,16 +128,36 @@ inline RipperOptions LoadRipperOptions(const std::string &iniPath = "czn_ripper.
 
         if (key == "export_sct_as_png")
         {
-            options.exportSctAsPng = RipperOptionsInternal::parseBool(value, options.exportSctAsPng);
+            RipperOptionsInternal::parseSctPng(value, options);
+        }
+        else if (key == "sct_png_level")
+        {
+            PngWriter::ParseLevel(value, options.sctPngLevel);
         }
         else if (key == "export_db_as_json")
         {
-            options.exportDbAsJson = RipperOptionsInternal::parseBool(value, options.exportDbAsJson);
+            RipperOptionsInternal::parseDbFormat(value, options);
+        }
+        else if (key == "db_table_format")
+        {
+            DBParser::ParseTableFormat(value, options.dbFormat);
         }
         else if (key == "enable_open_folder")
         {
             options.enableOpenFolder = RipperOptionsInternal::parseBool(value, options.enableOpenFolder);
         }
+        else if (key == "export_as_tar")
+        {
+            options.exportAsTar = RipperOptionsInternal::parseBool(value, options.exportAsTar);
+        }
+        else if (key == "deduplicate")
+        {
+            options.deduplicate = RipperOptionsInternal::parseBool(value, options.deduplicate);
+        }
+        else if (key == "verbose_logging")
+        {
+            options.verboseLogging = RipperOptionsInternal::parseBool(value, options.verboseLogging);
+        }
     }
 
     return options;
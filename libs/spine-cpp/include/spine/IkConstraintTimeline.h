@@ -52,6 +52,9 @@ namespace spine {
 		/// Sets the time, mix and bend direction of the specified keyframe.
 		void setFrame (int frameIndex, float time, float mix, float softness, int bendDirection, bool compress, bool stretch);
 
+		int getIkConstraintIndex();
+		void setIkConstraintIndex(int inValue);
+
 	private:
 		static const int PREV_TIME;
 		static const int PREV_MIX;
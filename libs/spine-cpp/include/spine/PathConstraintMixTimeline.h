@@ -50,6 +50,12 @@ namespace spine {
 
 		virtual int getPropertyId();
 
+		/// Sets the time and mixes of the specified keyframe.
+		void setFrame(int frameIndex, float time, float rotateMix, float translateMix);
+
+		int getPathConstraintIndex();
+		void setPathConstraintIndex(int inValue);
+
 	private:
 		static const int PREV_TIME;
 		static const int PREV_ROTATE;
@@ -59,9 +65,6 @@ namespace spine {
 
 		Vector<float> _frames;
 		int _pathConstraintIndex;
-
-		/// Sets the time and mixes of the specified keyframe.
-		void setFrame(int frameIndex, float time, float rotateMix, float translateMix);
 	};
 }
 
@@ -54,6 +54,9 @@ namespace spine {
 		/// Sets the time and value of the specified keyframe.
 		void setFrame(int frameIndex, float time, float value);
 
+		int getPathConstraintIndex();
+		void setPathConstraintIndex(int inValue);
+
 	protected:
 		static const int PREV_TIME;
 		static const int PREV_VALUE;
@@ -51,20 +51,33 @@ namespace spine {
 
 		Vector<BoneData*>& getBones();
 		BoneData* getTarget();
+		void setTarget(BoneData* inValue);
 		float getRotateMix();
+		void setRotateMix(float inValue);
 		float getTranslateMix();
+		void setTranslateMix(float inValue);
 		float getScaleMix();
+		void setScaleMix(float inValue);
 		float getShearMix();
+		void setShearMix(float inValue);
 
 		float getOffsetRotation();
+		void setOffsetRotation(float inValue);
 		float getOffsetX();
+		void setOffsetX(float inValue);
 		float getOffsetY();
+		void setOffsetY(float inValue);
 		float getOffsetScaleX();
+		void setOffsetScaleX(float inValue);
 		float getOffsetScaleY();
+		void setOffsetScaleY(float inValue);
 		float getOffsetShearY();
+		void setOffsetShearY(float inValue);
 
 		bool isRelative();
+		void setRelative(bool inValue);
 		bool isLocal();
+		void setLocal(bool inValue);
 
 	private:
 		Vector<BoneData*> _bones;
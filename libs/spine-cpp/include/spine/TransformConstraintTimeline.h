@@ -51,6 +51,9 @@ namespace spine {
 
 		void setFrame(size_t frameIndex, float time, float rotateMix, float translateMix, float scaleMix, float shearMix);
 
+		int getTransformConstraintIndex();
+		void setTransformConstraintIndex(int inValue);
+
 	private:
 		static const int PREV_TIME;
 		static const int PREV_ROTATE;
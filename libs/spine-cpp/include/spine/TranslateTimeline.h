@@ -57,6 +57,9 @@ namespace spine {
 		/// Sets the time and value of the specified keyframe.
 		void setFrame(int frameIndex, float time, float x, float y);
 
+		int getBoneIndex();
+		void setBoneIndex(int inValue);
+
 	protected:
 		static const int PREV_TIME;
 		static const int PREV_X;
@@ -168,3 +168,11 @@ void IkConstraintTimeline::setFrame(int frameIndex, float time, float mix, float
 	_frames[frameIndex + COMPRESS] = compress ? 1 : 0;
 	_frames[frameIndex + STRETCH] = stretch ? 1 : 0;
 }
+
+int IkConstraintTimeline::getIkConstraintIndex() {
+	return _ikConstraintIndex;
+}
+
+void IkConstraintTimeline::setIkConstraintIndex(int inValue) {
+	_ikConstraintIndex = inValue;
+}
@@ -124,3 +124,11 @@ void PathConstraintMixTimeline::setFrame(int frameIndex, float time, float rotat
 	_frames[frameIndex + ROTATE] = rotateMix;
 	_frames[frameIndex + TRANSLATE] = translateMix;
 }
+
+int PathConstraintMixTimeline::getPathConstraintIndex() {
+	return _pathConstraintIndex;
+}
+
+void PathConstraintMixTimeline::setPathConstraintIndex(int inValue) {
+	_pathConstraintIndex = inValue;
+}
@@ -114,3 +114,11 @@ void PathConstraintPositionTimeline::setFrame(int frameIndex, float time, float
 	_frames[frameIndex] = time;
 	_frames[frameIndex + VALUE] = value;
 }
+
+int PathConstraintPositionTimeline::getPathConstraintIndex() {
+	return _pathConstraintIndex;
+}
+
+void PathConstraintPositionTimeline::setPathConstraintIndex(int inValue) {
+	_pathConstraintIndex = inValue;
+}
@@ -110,3 +110,55 @@ bool TransformConstraintData::isRelative() {
 bool TransformConstraintData::isLocal() {
 	return _local;
 }
+
+void TransformConstraintData::setTarget(BoneData* inValue) {
+	_target = inValue;
+}
+
+void TransformConstraintData::setRotateMix(float inValue) {
+	_rotateMix = inValue;
+}
+
+void TransformConstraintData::setTranslateMix(float inValue) {
+	_translateMix = inValue;
+}
+
+void TransformConstraintData::setScaleMix(float inValue) {
+	_scaleMix = inValue;
+}
+
+void TransformConstraintData::setShearMix(float inValue) {
+	_shearMix = inValue;
+}
+
+void TransformConstraintData::setOffsetRotation(float inValue) {
+	_offsetRotation = inValue;
+}
+
+void TransformConstraintData::setOffsetX(float inValue) {
+	_offsetX = inValue;
+}
+
+void TransformConstraintData::setOffsetY(float inValue) {
+	_offsetY = inValue;
+}
+
+void TransformConstraintData::setOffsetScaleX(float inValue) {
+	_offsetScaleX = inValue;
+}
+
+void TransformConstraintData::setOffsetScaleY(float inValue) {
+	_offsetScaleY = inValue;
+}
+
+void TransformConstraintData::setOffsetShearY(float inValue) {
+	_offsetShearY = inValue;
+}
+
+void TransformConstraintData::setRelative(bool inValue) {
+	_relative = inValue;
+}
+
+void TransformConstraintData::setLocal(bool inValue) {
+	_local = inValue;
+}
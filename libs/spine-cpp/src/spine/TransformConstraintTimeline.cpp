@@ -146,3 +146,11 @@ void TransformConstraintTimeline::setFrame(size_t frameIndex, float time, float
 	_frames[frameIndex + SCALE] = scaleMix;
 	_frames[frameIndex + SHEAR] = shearMix;
 }
+
+int TransformConstraintTimeline::getTransformConstraintIndex() {
+	return _transformConstraintIndex;
+}
+
+void TransformConstraintTimeline::setTransformConstraintIndex(int inValue) {
+	_transformConstraintIndex = inValue;
+}
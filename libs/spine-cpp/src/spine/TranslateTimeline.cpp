@@ -129,3 +129,11 @@ void TranslateTimeline::setFrame(int frameIndex, float time, float x, float y) {
 	_frames[frameIndex + X] = x;
 	_frames[frameIndex + Y] = y;
 }
+
+int TranslateTimeline::getBoneIndex() {
+	return _boneIndex;
+}
+
+void TranslateTimeline::setBoneIndex(int inValue) {
+	_boneIndex = inValue;
+}
@@ -4,11 +4,14 @@
 #include <future>
 #include <atomic>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <list>
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <cstring>
 
 #include <GL/glew.h>
 #include <SDL.h>
@@ -33,6 +36,9 @@
 #include "archive/IArchive.h"
 #include "archive/CompositeArchive.h"
 #include "archive/SSRArchive.h"
+#include "archive/ArchiveFactory.h"
+#include "archive/OutputSink.h"
+#include "archive/ThumbnailCache.h"
 #include "parsers/SCTParser.h"
 #include "parsers/DBParser.h"
 #include "parsers/SCSPParser.h"
@@ -48,32 +54,6 @@
 
 using json = nlohmann::ordered_json;
 
-std::unique_ptr<IArchive> CreateArchive(const std::wstring& wpath) {
-    std::filesystem::path p(wpath);
-    if (p.filename() == L"manifest.ssra" || p.extension() == L".ssra") {
-        return std::make_unique<SSRArchive>(wpath);
-    }
-    std::filesystem::path dir = std::filesystem::is_directory(p) ? p : p.parent_path();
-    std::filesystem::path gameres_path = dir / L"gameres";
-    
-    if (std::filesystem::exists(gameres_path) && std::filesystem::is_directory(gameres_path)) {
-        auto composite = std::make_unique<CompositeArchive>(wpath);
-        composite->AddArchive(std::make_unique<DataPack>(wpath));
-        
-        try {
-            for (const auto& entry : std::filesystem::recursive_directory_iterator(gameres_path)) {
-                if (entry.is_regular_file() && entry.path().filename() == L"manifest.ssra") {
-                    composite->AddArchive(std::make_unique<SSRArchive>(entry.path().wstring()));
-                }
-            }
-        } catch (const std::exception& e) {
-            LogError("Error scanning gameres directory: " + std::string(e.what()));
-        }
-        return composite;
-    }
-    return std::make_unique<DataPack>(wpath);
-}
-
 struct FileBrowserState
 {
     std::unique_ptr<IArchive> data_pack;
@@ -109,6 +89,8 @@ struct PreviewState
 {
     GLuint texture = 0;
     int width = 0, height = 0;
+    // SCT previews are thumbnails; this is the size of the texture itself.
+    int source_width = 0, source_height = 0;
     bool has_preview = false;
     std::string error, atlas_preview, atlas_full, json_preview;
     PreviewMode mode = PreviewMode::None;
@@ -123,14 +105,25 @@ struct AtlasViewerState
     std::vector<char> text_buffer;
 };
 
+// Rows are decoded from the table only when they are drawn. The most recently
+// drawn ones are kept in a small LRU, already cut to their column widths.
 struct DatabaseViewerState
 {
-    json json_data;
-    std::vector<std::string> column_names;
-    std::vector<std::vector<std::string>> rows;
+    DBParser::Table table;
+    std::vector<float> column_widths;
+    uint32_t row_total = 0;
+    // Rows matching filter, in table order.
+    std::vector<uint32_t> visible_rows;
+    std::string filter;
+    bool filter_valid = false;
+    nk_uint scroll_x = 0, scroll_y = 0;
+    std::list<std::pair<uint32_t, std::vector<std::string>>> row_cache;
+    std::unordered_map<uint32_t, std::list<std::pair<uint32_t, std::vector<std::string>>>::iterator> row_cache_index;
     std::string filename;
 };
 
+static constexpr size_t DB_ROW_CACHE_SIZE = 512;
+
 struct ImageWindowState
 {
     SDL_Window *window = nullptr;
@@ -151,9 +144,14 @@ struct CommonState
 {
     bool show_options = false;
     nk_bool export_sct_as_png = nk_true;
+    PngWriter::Level png_level = PngWriter::Level::Default;
+    DBParser::TableFormat db_format = DBParser::TableFormat::Json;
     bool convert_all_sct = false;
     nk_bool export_db_as_json = nk_true;
     nk_bool enable_open_folder = nk_false;
+    nk_bool export_as_tar = nk_false;
+    nk_bool deduplicate = nk_false;
+    bool verbose_logging = false;
     bool show_success_popup = false;
     std::string success_message;
 };
@@ -242,8 +240,13 @@ static void save_options_to_ini()
 {
     RipperOptions options;
     options.exportSctAsPng = (g_state.common.export_sct_as_png != nk_false);
+    options.sctPngLevel = g_state.common.png_level;
     options.exportDbAsJson = (g_state.common.export_db_as_json != nk_false);
+    options.dbFormat = g_state.common.db_format;
     options.enableOpenFolder = (g_state.common.enable_open_folder != nk_false);
+    options.exportAsTar = (g_state.common.export_as_tar != nk_false);
+    options.deduplicate = (g_state.common.deduplicate != nk_false);
+    options.verboseLogging = g_state.common.verbose_logging;
     SaveRipperOptions(options);
 }
 
@@ -251,8 +254,14 @@ static void load_options_from_ini()
 {
     const RipperOptions options = LoadRipperOptions();
     g_state.common.export_sct_as_png = options.exportSctAsPng ? nk_true : nk_false;
+    g_state.common.png_level = options.sctPngLevel;
     g_state.common.export_db_as_json = options.exportDbAsJson ? nk_true : nk_false;
+    g_state.common.db_format = options.dbFormat;
     g_state.common.enable_open_folder = options.enableOpenFolder ? nk_true : nk_false;
+    g_state.common.export_as_tar = options.exportAsTar ? nk_true : nk_false;
+    g_state.common.deduplicate = options.deduplicate ? nk_true : nk_false;
+    g_state.common.verbose_logging = options.verboseLogging;
+    SetLogLevel(options.verboseLogging ? LogLevel::Debug : LogLevel::Info);
 }
 
 int get_file_count(const Core::FileNode &node)
@@ -438,13 +447,69 @@ void load_json_preview(const Core::FileNode &node, const std::string &content =
     }
 }
 
+// Cells of a table row cut to the column widths, decoded on a cache miss.
+const std::vector<std::string> &db_viewer_row(uint32_t row)
+{
+    DatabaseViewerState &db = g_state.database;
+    auto cached = db.row_cache_index.find(row);
+    if (cached != db.row_cache_index.end())
+    {
+        db.row_cache.splice(db.row_cache.begin(), db.row_cache, cached->second);
+        return cached->second->second;
+    }
+
+    std::vector<std::string_view> values;
+    db.table.GetRow(row, values);
+    std::vector<std::string> cells(db.column_widths.size());
+    for (size_t j = 0; j < cells.size() && j < values.size(); j++)
+    {
+        cells[j] = std::string(values[j]);
+        size_t max_chars = (size_t)(db.column_widths[j] / 7);
+        if (cells[j].length() > max_chars)
+            cells[j] = cells[j].substr(0, max_chars - 3) + "...";
+    }
+
+    db.row_cache.emplace_front(row, std::move(cells));
+    db.row_cache_index[row] = db.row_cache.begin();
+    if (db.row_cache.size() > DB_ROW_CACHE_SIZE)
+    {
+        db.row_cache_index.erase(db.row_cache.back().first);
+        db.row_cache.pop_back();
+    }
+    return db.row_cache.front().second;
+}
+
+// Rebuilds the list of rows to show when the search text changes. Matching
+// scans the values in place, so nothing is copied.
+void update_db_viewer_filter(const char *query)
+{
+    DatabaseViewerState &db = g_state.database;
+    if (db.filter_valid && db.filter == query)
+        return;
+    db.filter = query;
+    db.filter_valid = true;
+    db.visible_rows.clear();
+    db.scroll_y = 0;
+
+    size_t columns = db.table.ColumnNames().size();
+    std::vector<std::string_view> values;
+    for (uint32_t row = 0; row < db.table.RowCount(); row++)
+    {
+        if (!db.table.GetRow(row, values))
+            continue;
+        bool match = db.filter.empty();
+        for (size_t j = 0; !match && j < values.size() && j < columns; j++)
+            match = values[j].find(db.filter) != std::string_view::npos;
+        if (match)
+            db.visible_rows.push_back(row);
+    }
+}
+
 void load_db_preview(const Core::FileNode &node)
 {
     try
     {
-        g_state.database.column_names.clear();
-        g_state.database.rows.clear();
-        g_state.database.json_data.clear();
+        g_state.database = DatabaseViewerState();
         g_state.preview.json_preview = "";
         g_state.preview.mode = PreviewMode::None;
 
@@ -455,81 +520,44 @@ void load_db_preview(const Core::FileNode &node)
             return;
         }
 
-        std::string json_str = DBParser::ConvertToJson(file_data);
-        if (json_str.empty() || json_str == "{}")
+        DatabaseViewerState &db = g_state.database;
+        std::string error;
+        if (!db.table.Load(file_data, error))
         {
-            g_state.preview.json_preview = json_str;
+            g_state.preview.json_preview = "{}";
             g_state.preview.mode = PreviewMode::JSON;
             return;
         }
 
-        try
-        {
-            g_state.database.json_data = json::parse(json_str);
-        }
-        catch (const json::parse_error &e)
-        {
-            g_state.preview.json_preview = json_str;
-            g_state.preview.mode = PreviewMode::JSON;
-            return;
-        }
+        db.filename = node.name;
+        update_db_viewer_filter("");
+        db.row_total = (uint32_t)db.visible_rows.size();
 
-        g_state.database.filename = node.name;
-
-        if (!g_state.database.json_data.is_array() || g_state.database.json_data.empty())
+        const std::vector<std::string> &column_names = db.table.ColumnNames();
+        if (db.visible_rows.empty() || column_names.empty())
         {
-            g_state.preview.json_preview = g_state.database.json_data.dump(2);
+            // Nothing to lay out as a table; show what the JSON export writes.
+            g_state.preview.json_preview = DBParser::ConvertToJson(file_data);
             g_state.preview.mode = PreviewMode::JSON;
             return;
         }
 
-        // Check if it looks like a table (elements are objects)
-        if (g_state.database.json_data[0].is_object())
+        // Widths come from the header and the first rows, so opening a large
+        // table does not decode all of it.
+        std::vector<size_t> max_len(column_names.size());
+        for (size_t j = 0; j < column_names.size(); j++)
+            max_len[j] = column_names[j].length();
+        std::vector<std::string_view> values;
+        for (size_t i = 0; i < db.visible_rows.size() && i < 200; i++)
         {
-            for (auto &el : g_state.database.json_data[0].items())
-            {
-                g_state.database.column_names.push_back(el.key());
-            }
-
-            for (auto &row : g_state.database.json_data)
-            {
-                if (row.is_object())
-                {
-                    std::vector<std::string> row_data;
-                    for (const auto &col : g_state.database.column_names)
-                    {
-                        if (row.contains(col))
-                        {
-                            if (row[col].is_null())
-                            {
-                                row_data.push_back("");
-                            }
-                            else if (row[col].is_string())
-                            {
-                                row_data.push_back(row[col].get<std::string>());
-                            }
-                            else
-                            {
-                                row_data.push_back(row[col].dump());
-                            }
-                        }
-                        else
-                        {
-                            row_data.push_back("");
-                        }
-                    }
-                    g_state.database.rows.push_back(row_data);
-                }
-            }
-            g_state.preview.mode = PreviewMode::DB;
-        }
-        else
-        {
-            // Array of non-objects? Show as JSON
-            g_state.preview.json_preview = g_state.database.json_data.dump(2);
-            g_state.preview.mode = PreviewMode::JSON;
+            db.table.GetRow(db.visible_rows[i], values);
+            for (size_t j = 0; j < values.size() && j < max_len.size(); j++)
+                max_len[j] = std::max(max_len[j], values[j].length());
         }
+        for (size_t len : max_len)
+            db.column_widths.push_back(std::min(std::max(7.5f * len, 120.0f), 400.0f));
 
+        g_state.preview.mode = PreviewMode::DB;
         g_state.preview.error = "";
     }
     catch (const std::exception &e)
@@ -611,6 +639,16 @@ void load_text_preview(const Core::FileNode &node)
     }
 }
 
+// The preview pane shows SCT textures as thumbnails no larger than this,
+// decoded once and then read back from thumbnails.cache.
+constexpr int PREVIEW_THUMBNAIL_SIZE = 512;
+
+ThumbnailCache &preview_thumbnails()
+{
+    static ThumbnailCache cache(L"thumbnails.cache");
+    return cache;
+}
+
 void load_image_preview(const Core::FileNode &node)
 {
     if (g_state.preview.texture != 0)
@@ -621,12 +659,13 @@ void load_image_preview(const Core::FileNode &node)
     g_state.preview.has_preview = false;
     g_state.preview.width = 0;
     g_state.preview.height = 0;
+    g_state.preview.source_width = 0;
+    g_state.preview.source_height = 0;
     g_state.preview.error = "";
     g_state.preview.atlas_preview = "";
     g_state.preview.atlas_full = "";
     g_state.preview.json_preview = "";
-    g_state.database.column_names.clear();
-    g_state.database.rows.clear();
+    g_state.database = DatabaseViewerState();
     g_state.preview.mode = PreviewMode::None;
     g_state.preview.preview_node = &node;
 
@@ -691,33 +730,31 @@ void load_image_preview(const Core::FileNode &node)
         {
             try
             {
-                std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(file_data, false);
-
-                if (png_data.empty())
+                SCTParser::RGBAImage thumbnail = preview_thumbnails().Get(file_data, PREVIEW_THUMBNAIL_SIZE);
+                if (thumbnail.data.empty())
                 {
                     g_state.preview.error = "Failed to convert SCT/SCT2 file";
                     g_state.preview.mode = PreviewMode::None;
                     return;
                 }
 
-                SDL_RWops *rw = SDL_RWFromMem(png_data.data(), (int)png_data.size());
-                if (!rw)
+                rgba_surface = SDL_CreateRGBSurfaceWithFormat(0, thumbnail.width, thumbnail.height, 32, SDL_PIXELFORMAT_ABGR8888);
+                if (!rgba_surface)
                 {
-                    g_state.preview.error = "Failed to create memory stream for SCT";
+                    g_state.preview.error = "Failed to create surface for SCT: " + std::string(SDL_GetError());
                     g_state.preview.mode = PreviewMode::None;
                     return;
                 }
+                for (int y = 0; y < thumbnail.height; ++y)
+                    std::memcpy((uint8_t *)rgba_surface->pixels + (size_t)y * rgba_surface->pitch,
+                           thumbnail.data.data() + (size_t)y * thumbnail.width * 4, (size_t)thumbnail.width * 4);
 
-                SDL_Surface *surface = IMG_Load_RW(rw, 1);
-                if (!surface)
+                SCTParser::ProbeInfo probe;
+                if (SCTParser::Probe(file_data.data(), file_data.size(), probe))
                 {
-                    g_state.preview.error = "Failed to decode converted SCT image: " + std::string(IMG_GetError());
-                    g_state.preview.mode = PreviewMode::None;
-                    return;
+                    g_state.preview.source_width = probe.width;
+                    g_state.preview.source_height = probe.height;
                 }
-
-                rgba_surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ABGR8888, 0);
-                SDL_FreeSurface(surface);
             }
             catch (const std::exception &e)
             {
@@ -757,6 +794,11 @@ void load_image_preview(const Core::FileNode &node)
 
         g_state.preview.width = rgba_surface->w;
         g_state.preview.height = rgba_surface->h;
+        if (g_state.preview.source_width == 0)
+        {
+            g_state.preview.source_width = rgba_surface->w;
+            g_state.preview.source_height = rgba_surface->h;
+        }
 
         glGenTextures(1, &g_state.preview.texture);
         glBindTexture(GL_TEXTURE_2D, g_state.preview.texture);
@@ -800,29 +842,15 @@ void export_db_as_json_file(const Core::FileNode &node)
         if (!f.result().empty())
         {
             std::vector<uint8_t> file_data = g_state.browser.data_pack->GetFileData(node);
-            std::string json_str = DBParser::ConvertToJson(file_data);
-
-            if (!json_str.empty() && json_str != "{}")
+            bool exported = false;
             {
-                try
-                {
-                    // Formatta il JSON con indentazione
-                    json parsed = json::parse(json_str);
-                    std::string formatted_json = parsed.dump(2);
+                std::ofstream out(f.result(), std::ios::binary);
+                exported = out && DBParser::ConvertToJsonToStream(file_data, out);
+            }
 
-                    std::ofstream out(f.result());
-                    out << formatted_json;
-                    out.close();
-                    g_state.tasks.status = "Exported DB to JSON: " + f.result();
-                }
-                catch (const json::parse_error &e)
-                {
-                    // Se il parsing fallisce, scrivi il JSON raw
-                    std::ofstream out(f.result());
-                    out << json_str;
-                    out.close();
-                    g_state.tasks.status = "Exported DB to JSON (unformatted): " + f.result();
-                }
+            if (exported)
+            {
+                g_state.tasks.status = "Exported DB to JSON: " + f.result();
             }
             else
             {
@@ -888,6 +916,38 @@ void export_scsp_as_json_file(const Core::FileNode &node)
     }
 }
 
+void export_scsp_as_skel_file(const Core::FileNode &node)
+{
+    try
+    {
+        std::string default_name = node.name;
+        size_t dot_pos = default_name.find_last_of('.');
+        if (dot_pos != std::string::npos)
+        {
+            default_name = default_name.substr(0, dot_pos);
+        }
+        default_name += ".skel";
+
+        auto f = pfd::save_file("Export SCSP as Spine binary", default_name,
+                                {"Spine Binary Files", "*.skel", "All Files", "*.*"});
+
+        if (!f.result().empty())
+        {
+            std::vector<uint8_t> file_data = g_state.browser.data_pack->GetFileData(node);
+            std::vector<uint8_t> skel = SCSPParser::ConvertSCSP(file_data, SCSPParser::SkeletonFormat::Skel);
+
+            std::ofstream out(f.result(), std::ios::binary);
+            out.write(reinterpret_cast<const char *>(skel.data()), skel.size());
+            out.close();
+            g_state.tasks.status = "Exported SCSP to SKEL: " + f.result();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        g_state.tasks.status = "Export error: " + std::string(e.what());
+    }
+}
+
 void export_json_file(const Core::FileNode &node)
 {
     try
@@ -951,7 +1011,7 @@ void open_image_preview_window(const Core::FileNode &node)
 
         if (is_sct_format(info.format))
         {
-            std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(file_data, false);
+            std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(file_data, false, PngWriter::Level::Fast);
             if (png_data.empty())
             {
                 g_state.tasks.status = "Failed to convert SCT for preview window";
@@ -1076,7 +1136,7 @@ void export_file_as_png(const Core::FileNode &node)
 
             if (is_sct_format(info.format))
             {
-                png_data = SCTParser::ConvertToPNG(file_data, false);
+                png_data = SCTParser::ConvertToPNG(file_data, false, g_state.common.png_level);
             }
             else
             {
@@ -1157,8 +1217,7 @@ void handle_node_click(const Core::FileNode *node, bool is_folder)
             g_state.preview.atlas_preview = "";
             g_state.preview.json_preview = "";
             g_state.preview.atlas_full = "";
-            g_state.database.column_names.clear();
-            g_state.database.rows.clear();
+            g_state.database = DatabaseViewerState();
             g_state.preview.mode = PreviewMode::None;
             g_state.preview.preview_node = nullptr;
         }
@@ -1180,8 +1239,7 @@ void handle_node_click(const Core::FileNode *node, bool is_folder)
             g_state.preview.atlas_preview = "";
             g_state.preview.json_preview = "";
             g_state.preview.atlas_full = "";
-            g_state.database.column_names.clear();
-            g_state.database.rows.clear();
+            g_state.database = DatabaseViewerState();
             g_state.preview.mode = PreviewMode::None;
             g_state.preview.preview_node = nullptr;
         }
@@ -1198,6 +1256,30 @@ void handle_node_right_click(const Core::FileNode *node, struct nk_vec2 pos)
     g_state.context_menu.visible = true;
 }
 
+// Asks for the extraction destination and builds the matching output sink.
+std::shared_ptr<IOutputSink> select_extraction_sink()
+{
+    if (g_state.common.export_as_tar)
+    {
+        auto f = pfd::save_file("Select destination archive", "extracted.tar",
+                                {"Tar Archives", "*.tar", "All Files", "*.*"});
+        if (f.result().empty())
+            return nullptr;
+        auto sink = std::make_shared<TarSink>(Core::Utf8ToWString(f.result()));
+        if (!sink->IsOpen())
+        {
+            g_state.tasks.status = "Failed to create archive: " + f.result();
+            return nullptr;
+        }
+        return sink;
+    }
+
+    auto d = pfd::select_folder("Select destination folder", ".");
+    if (d.result().empty())
+        return nullptr;
+    return std::make_shared<DirectorySink>(Core::Utf8ToWString(d.result()));
+}
+
 nlohmann::ordered_json build_file_tree_json(const Core::FileNode &node)
 {
     nlohmann::ordered_json j;
@@ -1567,8 +1649,7 @@ void handle_diff_node_click(const DiffNode *node, bool is_folder)
                 g_state.preview.atlas_preview = "";
                 g_state.preview.json_preview = "";
                 g_state.preview.atlas_full = "";
-                g_state.database.column_names.clear();
-                g_state.database.rows.clear();
+                g_state.database = DatabaseViewerState();
                 g_state.preview.mode = PreviewMode::None;
                 g_state.preview.preview_node = nullptr;
             }
@@ -1580,8 +1661,7 @@ void handle_diff_node_click(const DiffNode *node, bool is_folder)
             g_state.preview.atlas_preview = "";
             g_state.preview.json_preview = "";
             g_state.preview.atlas_full = "";
-            g_state.database.column_names.clear();
-            g_state.database.rows.clear();
+            g_state.database = DatabaseViewerState();
             g_state.preview.mode = PreviewMode::None;
             g_state.preview.preview_node = nullptr;
         }
@@ -1606,8 +1686,7 @@ void handle_diff_node_click(const DiffNode *node, bool is_folder)
                 g_state.preview.atlas_preview = "";
                 g_state.preview.json_preview = "";
                 g_state.preview.atlas_full = "";
-                g_state.database.column_names.clear();
-                g_state.database.rows.clear();
+                g_state.database = DatabaseViewerState();
                 g_state.preview.mode = PreviewMode::None;
                 g_state.preview.preview_node = nullptr;
             }
@@ -1619,8 +1698,7 @@ void handle_diff_node_click(const DiffNode *node, bool is_folder)
             g_state.preview.atlas_preview = "";
             g_state.preview.json_preview = "";
             g_state.preview.atlas_full = "";
-            g_state.database.column_names.clear();
-            g_state.database.rows.clear();
+            g_state.database = DatabaseViewerState();
             g_state.preview.mode = PreviewMode::None;
             g_state.preview.preview_node = nullptr;
         }
@@ -2472,6 +2550,11 @@ int main(int argc, char *argv[])
                             export_scsp_as_json_file(*g_state.context_menu.node);
                             g_state.context_menu.visible = false;
                         }
+                        if (nk_button_label(ctx, "Export as SKEL"))
+                        {
+                            export_scsp_as_skel_file(*g_state.context_menu.node);
+                            g_state.context_menu.visible = false;
+                        }
                     }
                     else if (is_sct_format(info.format))
                     {
@@ -2541,7 +2624,7 @@ int main(int argc, char *argv[])
         if (g_state.common.show_options)
         {
             const float export_options_width = 530.0f;
-            const float export_options_height = 460.0f;
+            const float export_options_height = 620.0f;
             const float export_options_x = (window_width - export_options_width) * 0.5f;
             const float export_options_y = (window_height - export_options_height) * 0.5f;
             if (nk_begin(ctx, "Export Options", nk_rect(export_options_x, export_options_y, export_options_width, export_options_height),
@@ -2656,6 +2739,78 @@ int main(int argc, char *argv[])
                 nk_label(ctx, "When enabled, open folder button show up", NK_TEXT_LEFT);
                 nk_label(ctx, "letting user choose a folder to scan instead of only data.pack", NK_TEXT_LEFT);
 
+                nk_layout_row_dynamic(ctx, 10, 1);
+                nk_spacing(ctx, 1);
+
+                nk_layout_row_begin(ctx, NK_STATIC, 32, 2);
+                nk_layout_row_push(ctx, 380);
+                nk_label(ctx, "Extract into a single .tar archive", NK_TEXT_LEFT);
+                nk_layout_row_push(ctx, 120);
+                {
+                    struct nk_style_button toggle_style = ctx->style.button;
+                    if (g_state.common.export_as_tar)
+                    {
+                        toggle_style.normal = nk_style_item_color(nk_rgb(56, 120, 74));
+                        toggle_style.hover = nk_style_item_color(nk_rgb(66, 138, 86));
+                        toggle_style.active = nk_style_item_color(nk_rgb(50, 108, 66));
+                    }
+                    else
+                    {
+                        toggle_style.normal = nk_style_item_color(nk_rgb(100, 64, 64));
+                        toggle_style.hover = nk_style_item_color(nk_rgb(120, 74, 74));
+                        toggle_style.active = nk_style_item_color(nk_rgb(88, 56, 56));
+                    }
+                    toggle_style.text_normal = nk_rgb(240, 240, 240);
+                    toggle_style.text_hover = nk_rgb(255, 255, 255);
+                    toggle_style.text_active = nk_rgb(255, 255, 255);
+                    if (nk_button_label_styled(ctx, &toggle_style, g_state.common.export_as_tar ? "ON" : "OFF"))
+                    {
+                        g_state.common.export_as_tar = g_state.common.export_as_tar ? nk_false : nk_true;
+                        save_options_to_ini();
+                    }
+                }
+                nk_layout_row_end(ctx);
+
+                nk_layout_row_dynamic(ctx, 20, 1);
+                nk_label(ctx, "When enabled, Extract All/Selected write one .tar file", NK_TEXT_LEFT);
+                nk_label(ctx, "instead of a folder tree.", NK_TEXT_LEFT);
+
+                nk_layout_row_dynamic(ctx, 10, 1);
+                nk_spacing(ctx, 1);
+
+                nk_layout_row_begin(ctx, NK_STATIC, 32, 2);
+                nk_layout_row_push(ctx, 380);
+                nk_label(ctx, "Deduplicate identical files", NK_TEXT_LEFT);
+                nk_layout_row_push(ctx, 120);
+                {
+                    struct nk_style_button toggle_style = ctx->style.button;
+                    if (g_state.common.deduplicate)
+                    {
+                        toggle_style.normal = nk_style_item_color(nk_rgb(56, 120, 74));
+                        toggle_style.hover = nk_style_item_color(nk_rgb(66, 138, 86));
+                        toggle_style.active = nk_style_item_color(nk_rgb(50, 108, 66));
+                    }
+                    else
+                    {
+                        toggle_style.normal = nk_style_item_color(nk_rgb(100, 64, 64));
+                        toggle_style.hover = nk_style_item_color(nk_rgb(120, 74, 74));
+                        toggle_style.active = nk_style_item_color(nk_rgb(88, 56, 56));
+                    }
+                    toggle_style.text_normal = nk_rgb(240, 240, 240);
+                    toggle_style.text_hover = nk_rgb(255, 255, 255);
+                    toggle_style.text_active = nk_rgb(255, 255, 255);
+                    if (nk_button_label_styled(ctx, &toggle_style, g_state.common.deduplicate ? "ON" : "OFF"))
+                    {
+                        g_state.common.deduplicate = g_state.common.deduplicate ? nk_false : nk_true;
+                        save_options_to_ini();
+                    }
+                }
+                nk_layout_row_end(ctx);
+
+                nk_layout_row_dynamic(ctx, 20, 1);
+                nk_label(ctx, "When enabled, byte-identical files are converted once", NK_TEXT_LEFT);
+                nk_label(ctx, "and written as hard links (tar link entries).", NK_TEXT_LEFT);
+
                 nk_layout_row_dynamic(ctx, 25, 1);
 
                 nk_layout_row_dynamic(ctx, 30, 2);
@@ -2829,8 +2984,7 @@ int main(int argc, char *argv[])
                         g_state.preview.atlas_preview = "";
                         g_state.preview.json_preview = "";
                         g_state.preview.atlas_full = "";
-                        g_state.database.column_names.clear();
-                        g_state.database.rows.clear();
+                        g_state.database = DatabaseViewerState();
                         g_state.browser.search_query = "";
                         memset(g_state.browser.search_buffer, 0, sizeof(g_state.browser.search_buffer));
                         g_state.preview.mode = PreviewMode::None;
@@ -2902,8 +3056,7 @@ int main(int argc, char *argv[])
                             g_state.preview.atlas_preview = "";
                             g_state.preview.json_preview = "";
                             g_state.preview.atlas_full = "";
-                            g_state.database.column_names.clear();
-                            g_state.database.rows.clear();
+                            g_state.database = DatabaseViewerState();
                             g_state.browser.search_query = "";
                             memset(g_state.browser.search_buffer, 0, sizeof(g_state.browser.search_buffer));
                             g_state.preview.mode = PreviewMode::None;
@@ -2968,8 +3121,7 @@ int main(int argc, char *argv[])
                     g_state.preview.atlas_preview = "";
                     g_state.preview.json_preview = "";
                     g_state.preview.atlas_full = "";
-                    g_state.database.column_names.clear();
-                    g_state.database.rows.clear();
+                    g_state.database = DatabaseViewerState();
                     g_state.preview.mode = PreviewMode::None;
 
                     if (g_state.preview.texture)
@@ -3045,20 +3197,24 @@ int main(int argc, char *argv[])
             {
                 try
                 {
-                    auto d = pfd::select_folder("Select destination folder", ".");
-                    if (!d.result().empty())
+                    std::shared_ptr<IOutputSink> sink = select_extraction_sink();
+                    if (sink)
                     {
-                        std::string dest_str = d.result();
-                        std::wstring dest_path = Core::Utf8ToWString(dest_str);
                         g_state.tasks.running = true;
                         g_state.tasks.status = "Extracting all files...";
                         g_state.tasks.progress = 0.0f;
-                        bool convert_sct = (g_state.common.export_sct_as_png != 0);
-                        bool convert_db = (g_state.common.export_db_as_json != 0);
-                        g_state.tasks.future = std::async(std::launch::async, [dest_path, convert_sct, convert_db]()
+                        ExtractOptions options;
+                        options.convert_sct_to_png = (g_state.common.export_sct_as_png != 0);
+                        options.png_level = g_state.common.png_level;
+                        options.convert_db_to_json = (g_state.common.export_db_as_json != 0);
+                        options.db_format = g_state.common.db_format;
+                        options.deduplicate = (g_state.common.deduplicate != 0);
+                        options.threads = 0;
+                        g_state.tasks.future = std::async(std::launch::async, [sink, options]()
                                                  {
                             try {
-                                g_state.browser.data_pack->Extract(g_state.browser.data_pack->GetFileTree(), dest_path, g_state.tasks.progress, convert_sct, convert_db);
+                                g_state.browser.data_pack->Extract(g_state.browser.data_pack->GetFileTree(), *sink, g_state.tasks.progress, options);
+                                sink->Finish();
                             }
                             catch (...) {} });
                     }
@@ -3081,11 +3237,9 @@ int main(int argc, char *argv[])
 
                 try
                 {
-                    auto d = pfd::select_folder("Select destination folder", ".");
-                    if (!d.result().empty())
+                    std::shared_ptr<IOutputSink> sink = select_extraction_sink();
+                    if (sink)
                     {
-                        std::string dest_str = d.result();
-                        std::wstring dest_path = Core::Utf8ToWString(dest_str);
                         g_state.tasks.running = true;
                         std::vector<const Core::FileNode *> nodes_to_extract;
                         if (g_state.diff.show_tree)
@@ -3121,18 +3275,24 @@ int main(int argc, char *argv[])
 
                         g_state.tasks.status = "Extracting " + std::to_string(nodes_to_extract.size()) + " item(s)...";
                         g_state.tasks.progress = 0.0f;
-                        bool convert_sct = (g_state.common.export_sct_as_png != 0);
-                        bool convert_db = (g_state.common.export_db_as_json != 0);
-                        g_state.tasks.future = std::async(std::launch::async, [dest_path, nodes_to_extract, convert_sct, convert_db]()
+                        ExtractOptions options;
+                        options.convert_sct_to_png = (g_state.common.export_sct_as_png != 0);
+                        options.png_level = g_state.common.png_level;
+                        options.convert_db_to_json = (g_state.common.export_db_as_json != 0);
+                        options.db_format = g_state.common.db_format;
+                        options.deduplicate = (g_state.common.deduplicate != 0);
+                        options.threads = 0;
+                        g_state.tasks.future = std::async(std::launch::async, [sink, nodes_to_extract, options]()
                                                  {
                             try {
                                 const float total = nodes_to_extract.empty() ? 1.0f : (float)nodes_to_extract.size();
                                 for (size_t i = 0; i < nodes_to_extract.size(); i++)
                                 {
                                     std::atomic<float> local_progress = 0.0f;
-                                    g_state.browser.data_pack->Extract(*nodes_to_extract[i], dest_path, local_progress, convert_sct, convert_db);
+                                    g_state.browser.data_pack->Extract(*nodes_to_extract[i], *sink, local_progress, options);
                                     g_state.tasks.progress = (float)(i + 1) / total;
                                 }
+                                sink->Finish();
                             }
                             catch (...) {} });
                     }
@@ -3390,7 +3550,7 @@ int main(int argc, char *argv[])
                             }
 
                             nk_layout_row_dynamic(ctx, 25, 1);
-                            std::string dims = std::to_string(g_state.preview.width) + " x " + std::to_string(g_state.preview.height);
+                            std::string dims = std::to_string(g_state.preview.source_width) + " x " + std::to_string(g_state.preview.source_height);
                             nk_label_colored(ctx, dims.c_str(), NK_TEXT_CENTERED, nk_rgb(180, 180, 180));
 
                             if (g_state.preview.preview_node && std::holds_alternative<Core::FileInfo>(g_state.preview.preview_node->data))
@@ -3417,6 +3577,7 @@ int main(int argc, char *argv[])
                             float max_preview_width = right_width - 40.0f;
                             float max_preview_height = content_height - 180.0f;
 
+                            // Never upscaled, so a thumbnail is drawn at most at its own size.
                             float scale_w = max_preview_width / g_state.preview.width;
                             float scale_h = max_preview_height / g_state.preview.height;
                             float scale = (scale_w < scale_h) ? scale_w : scale_h;
@@ -3444,7 +3605,7 @@ int main(int argc, char *argv[])
                             }
 
                             nk_layout_row_dynamic(ctx, 25, 1);
-                            std::string stats = std::to_string(g_state.database.rows.size()) + " rows x " + std::to_string(g_state.database.column_names.size()) + " columns";
+                            std::string stats = std::to_string(g_state.database.row_total) + " rows x " + std::to_string(g_state.database.table.ColumnNames().size()) + " columns";
                             nk_label_colored(ctx, stats.c_str(), NK_TEXT_CENTERED, nk_rgb(180, 180, 180));
 
                             nk_layout_row_dynamic(ctx, 30, 1);
@@ -3464,102 +3625,78 @@ int main(int argc, char *argv[])
                             nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD, db_search_buffer, sizeof(db_search_buffer), nk_filter_default);
                             nk_layout_row_end(ctx);
 
+                            update_db_viewer_filter(db_search_buffer);
+
                             float preview_table_height = content_height - 230;
                             nk_layout_row_dynamic(ctx, preview_table_height, 1);
 
-                            if (nk_group_begin(ctx, (std::string("DBPreviewTable_") + g_state.database.filename).c_str(), NK_WINDOW_BORDER))
+                            DatabaseViewerState &db = g_state.database;
+                            if (nk_group_scrolled_offset_begin(ctx, &db.scroll_x, &db.scroll_y, (std::string("DBPreviewTable_") + db.filename).c_str(), NK_WINDOW_BORDER))
                             {
-                                float base_width = 100.0f;
-                                std::vector<float> col_widths(g_state.database.column_names.size(), base_width);
-                                for (size_t j = 0; j < g_state.database.column_names.size(); j++)
-                                {
-                                    size_t max_len = g_state.database.column_names[j].length();
-                                    for (const auto &row : g_state.database.rows)
-                                    {
-                                        if (j < row.size() && row[j].length() > max_len)
-                                            max_len = row[j].length();
-                                    }
-                                    col_widths[j] = std::min(std::max(7.5f * max_len, 120.0f), 400.0f);
-                                }
-
+                                const std::vector<std::string> &column_names = db.table.ColumnNames();
+                                const std::vector<float> &col_widths = db.column_widths;
                                 float index_col_width = 60.0f;
+                                const float header_height = 40.0f;
+                                const float row_height = 38.0f;
+                                const float spacing = ctx->style.window.spacing.y;
 
-                                nk_layout_row_begin(ctx, NK_STATIC, 40, (int)g_state.database.column_names.size() + 1);
+                                nk_layout_row_begin(ctx, NK_STATIC, header_height, (int)column_names.size() + 1);
 
                                 nk_layout_row_push(ctx, index_col_width);
                                 struct nk_rect bounds = nk_widget_bounds(ctx);
                                 nk_fill_rect(&ctx->current->buffer, bounds, 0, nk_rgb(60, 70, 90));
                                 nk_label_colored(ctx, "#", NK_TEXT_CENTERED, nk_rgb(220, 230, 255));
 
-                                for (size_t j = 0; j < g_state.database.column_names.size(); j++)
+                                for (size_t j = 0; j < column_names.size(); j++)
                                 {
                                     nk_layout_row_push(ctx, col_widths[j]);
                                     struct nk_rect col_bounds = nk_widget_bounds(ctx);
                                     nk_fill_rect(&ctx->current->buffer, col_bounds, 0, nk_rgb(60, 70, 90));
-                                    nk_label_colored(ctx, g_state.database.column_names[j].c_str(), NK_TEXT_CENTERED, nk_rgb(220, 230, 255));
+                                    nk_label_colored(ctx, column_names[j].c_str(), NK_TEXT_CENTERED, nk_rgb(220, 230, 255));
                                 }
                                 nk_layout_row_end(ctx);
 
-                                size_t preview_rows = g_state.database.rows.size();
-                                int visible_index = 1;
-                                int rows_shown = 0;
-                                for (size_t i = 0; i < preview_rows; i++)
-                                {
-                                    if (rows_shown > 200)
-                                        break; // rows limit for performance
-
-                                    bool match = false;
-                                    if (strlen(g_state.browser.search_buffer) == 0)
-                                    {
-                                        match = true;
-                                    }
-                                    else
-                                    {
-                                        std::string q = g_state.browser.search_buffer;
-                                        for (const auto &cell : g_state.database.rows[i])
-                                        {
-                                            if (cell.find(q) != std::string::npos)
-                                            {
-                                                match = true;
-                                                break;
-                                            }
-                                        }
-                                    }
+                                // Only the rows inside the scrolled view are laid out; spacers
+                                // stand in for the others so the scrollbar keeps its range.
+                                size_t row_count = db.visible_rows.size();
+                                float row_pitch = row_height + spacing;
+                                float offset = std::max(0.0f, (float)db.scroll_y - (header_height + spacing));
+                                size_t first = std::min(row_count, (size_t)(offset / row_pitch));
+                                size_t last = std::min(row_count, first + (size_t)(preview_table_height / row_pitch) + 2);
 
-                                    if (!match)
-                                        continue;
-                                    rows_shown++;
+                                if (first > 0)
+                                {
+                                    nk_layout_row_dynamic(ctx, first * row_pitch - spacing, 1);
+                                    nk_spacing(ctx, 1);
+                                }
 
-                                    struct nk_color row_color = (visible_index % 2 == 0) ? nk_rgb(45, 45, 50) : nk_rgb(40, 40, 45);
-                                    nk_layout_row_begin(ctx, NK_STATIC, 38, (int)g_state.database.column_names.size() + 1);
+                                for (size_t i = first; i < last; i++)
+                                {
+                                    const std::vector<std::string> &cells = db_viewer_row(db.visible_rows[i]);
+                                    struct nk_color row_color = ((i + 1) % 2 == 0) ? nk_rgb(45, 45, 50) : nk_rgb(40, 40, 45);
+                                    nk_layout_row_begin(ctx, NK_STATIC, row_height, (int)column_names.size() + 1);
 
                                     nk_layout_row_push(ctx, index_col_width);
                                     struct nk_rect index_bounds = nk_widget_bounds(ctx);
                                     nk_fill_rect(&ctx->current->buffer, index_bounds, 0, row_color);
 
-                                    std::string row_index = std::to_string(visible_index++);
+                                    std::string row_index = std::to_string(i + 1);
                                     nk_label_colored(ctx, row_index.c_str(), NK_TEXT_CENTERED, nk_rgb(180, 200, 255));
 
-                                    for (size_t j = 0; j < g_state.database.rows[i].size(); j++)
+                                    for (size_t j = 0; j < cells.size(); j++)
                                     {
                                         nk_layout_row_push(ctx, col_widths[j]);
                                         struct nk_rect cell_bounds = nk_widget_bounds(ctx);
                                         nk_fill_rect(&ctx->current->buffer, cell_bounds, 0, row_color);
-
-                                        std::string cell_text = g_state.database.rows[i][j];
-                                        int max_chars = (int)(col_widths[j] / 7);
-                                        if (cell_text.length() > max_chars)
-                                            cell_text = cell_text.substr(0, max_chars - 3) + "...";
-
-                                        nk_label_colored(ctx, cell_text.c_str(), NK_TEXT_LEFT, nk_rgb(200, 200, 200));
+                                        nk_label_colored(ctx, cells[j].c_str(), NK_TEXT_LEFT, nk_rgb(200, 200, 200));
                                     }
                                     nk_layout_row_end(ctx);
                                 }
 
-                                if (g_state.database.rows.size() > 200)
+                                if (last < row_count)
                                 {
-                                    nk_layout_row_dynamic(ctx, 20, 1);
-                                    nk_label_colored(ctx, "... (preview limit reached)", NK_TEXT_LEFT, nk_rgb(255, 100, 100));
+                                    nk_layout_row_dynamic(ctx, (row_count - last) * row_pitch - spacing, 1);
+                                    nk_spacing(ctx, 1);
                                 }
 
                                 nk_group_end(ctx);
@@ -3865,8 +4002,9 @@ int main(int argc, char *argv[])
                                         {
                                             if (a != g_state.spine.selected_animation)
                                             {
-                                                g_state.spine.selected_animation = a;
                                                 g_state.spine.viewer->setAnimation(anim_names[a], true);
+                                                // Stays on the previous animation if this one fails to build.
+                                                g_state.spine.selected_animation = g_state.spine.viewer->getCurrentAnimIndex();
                                             }
                                         }
                                     }
@@ -4064,7 +4202,7 @@ int main(int argc, char *argv[])
                                                 std::transform(el.begin(), el.end(), el.begin(), ::tolower);
                                                 if (el == ".sct" || el == ".sct2")
                                                 {
-                                                    std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(data, false);
+                                                    std::vector<uint8_t> png_data = SCTParser::ConvertToPNG(data, false, g_state.common.png_level);
                                                     if (!png_data.empty())
                                                     {
                                                         size_t dp = out_name.find_last_of('.');
@@ -4375,7 +4513,7 @@ int main(int argc, char *argv[])
                                             std::transform(el.begin(), el.end(), el.begin(), ::tolower);
                                             if (el == ".sct" || el == ".sct2")
                                             {
-                                                auto png = SCTParser::ConvertToPNG(fd, false);
+                                                auto png = SCTParser::ConvertToPNG(fd, false, g_state.common.png_level);
                                                 if (!png.empty())
                                                 {
                                                     size_t dp = on.find_last_of('.');
@@ -1,22 +1,34 @@
 #include "DBParser.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <map>
+#include <string_view>
+#include <unordered_map>
+#include "core/JsonString.h"
 #include "core/Logger.h"
-#include "json.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DBPARSER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define DBPARSER_NEON
+#include <arm_neon.h>
+#endif
 
 namespace DBParser
 {
-    using json = nlohmann::json;
-
     namespace
     {
         struct Header
         {
-            std::vector<uint8_t> magic; // 5 bytes
+            // magic (5 bytes)
             uint8_t version;
             uint16_t headerSize;
             uint8_t unk;
@@ -27,11 +39,6 @@ namespace DBParser
             uint64_t unk5;
         };
 
-        struct HashTableEntry
-        {
-            uint64_t entryOffset; // UInt40
-        };
-
         struct FileChunkHeader
         {
             uint32_t entrySize;
@@ -43,229 +50,550 @@ namespace DBParser
 
         static constexpr const char *KEY_HEX = "91AE4ED4644F585162EC1BD5EF24ADDBAF838242AEF51E97804B134FFD8CE5BB4F6E3E6451147CDF56C318E5E964C999C0D95CC860822E6B418BE465D79A036DBF67AB3DA72AB1023A4561F444E5CE858D23EA10FEB4899151AD7E43FF3E2419A97B4DD3AF4EF5C829E5AF4ACE9436F6B6B6382E9DFD26642099011A4899089C9D4B9F80BBB00A4CC73255CE1F78646E91C9C12313F5D840DC51457010D37D19615BB69888B42B19E749F993C00337E9332F89B320C173A5653848788798A771739E72DBC84C7946597149BDDAE4E3BD1A17856C85A555CFA24F6352D005933B50042BE0BA4C708DE8EBB52059B2059C9BFE90D8923DF74B43911BBC00BB6BFA";
 
-        std::vector<uint8_t> DecryptDB(const std::vector<uint8_t> &data)
-    {
-        std::vector<uint8_t> key;
-        key.reserve(256);
-        for (size_t i = 0; i < 256; ++i)
+        static constexpr size_t KEY_LENGTH = 256;
+        static constexpr const char *MAGIC = "PLPcK";
+
+        constexpr uint8_t HexValue(char c)
         {
-            std::string byteStr(KEY_HEX + i * 2, 2);
-            key.push_back(static_cast<uint8_t>(std::stoi(byteStr, nullptr, 16)));
+            return static_cast<uint8_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
         }
 
-        for (int i = 0; i < 256; ++i)
+        constexpr std::array<uint8_t, KEY_LENGTH> DecodeKey(const char *hex)
         {
-            std::vector<uint8_t> cur_k(key.begin() + i, key.end());
-            cur_k.insert(cur_k.end(), key.begin(), key.begin() + i);
-            bool found = true;
-            for (size_t j = 0; j < 5; ++j)
+            std::array<uint8_t, KEY_LENGTH> key{};
+            for (size_t i = 0; i < KEY_LENGTH; ++i)
+                key[i] = static_cast<uint8_t>((HexValue(hex[i * 2]) << 4) | HexValue(hex[i * 2 + 1]));
+            return key;
+        }
+
+        static constexpr std::array<uint8_t, KEY_LENGTH> KEY = DecodeKey(KEY_HEX);
+
+        // Rotations grouped by the key byte they start with: first[b] is the lowest
+        // rotation whose stream begins with b, next[r] the following one, -1 ends.
+        struct RotationIndex
+        {
+            std::array<int16_t, 256> first{};
+            std::array<int16_t, KEY_LENGTH> next{};
+        };
+
+        constexpr RotationIndex BuildRotationIndex()
+        {
+            RotationIndex index{};
+            for (size_t b = 0; b < 256; ++b)
+                index.first[b] = -1;
+            for (size_t r = KEY_LENGTH; r-- > 0;)
             {
-                if ((data[j] ^ cur_k[j % cur_k.size()]) != (uint8_t)"PLPcK"[j])
-                {
-                    found = false;
-                    break;
-                }
+                index.next[r] = index.first[KEY[r]];
+                index.first[KEY[r]] = static_cast<int16_t>(r);
+            }
+            return index;
+        }
+
+        static constexpr RotationIndex ROTATIONS = BuildRotationIndex();
+
+        // The file starts with the known magic, so its first byte names the key
+        // bytes the stream can start with; the other four settle ties.
+        int FindRotation(const uint8_t *data, size_t size)
+        {
+            if (size < 5)
+                return -1;
+            for (int r = ROTATIONS.first[data[0] ^ static_cast<uint8_t>(MAGIC[0])]; r >= 0; r = ROTATIONS.next[r])
+            {
+                size_t j = 1;
+                while (j < 5 && (data[j] ^ KEY[(r + j) % KEY_LENGTH]) == static_cast<uint8_t>(MAGIC[j]))
+                    ++j;
+                if (j == 5)
+                    return r;
             }
-            if (found)
+            return -1;
+        }
+
+        // XORs src with the key stream starting at rotation. The stream repeats
+        // every 256 bytes, so one rotated period is XORed in 16-byte lanes.
+        void ApplyKeyStream(const uint8_t *src, uint8_t *dst, size_t size, size_t rotation)
+        {
+            alignas(16) uint8_t stream[KEY_LENGTH];
+            for (size_t k = 0; k < KEY_LENGTH; ++k)
+                stream[k] = KEY[(rotation + k) % KEY_LENGTH];
+
+            size_t j = 0;
+            for (; j + KEY_LENGTH <= size; j += KEY_LENGTH)
             {
-                std::vector<uint8_t> result(data.size());
-                for (size_t j = 0; j < data.size(); ++j)
+                for (size_t k = 0; k < KEY_LENGTH; k += 16)
                 {
-                    result[j] = data[j] ^ cur_k[j % cur_k.size()];
+#if defined(DBPARSER_SSE2)
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + j + k));
+                    v = _mm_xor_si128(v, _mm_load_si128(reinterpret_cast<const __m128i *>(stream + k)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + j + k), v);
+#elif defined(DBPARSER_NEON)
+                    vst1q_u8(dst + j + k, veorq_u8(vld1q_u8(src + j + k), vld1q_u8(stream + k)));
+#else
+                    uint64_t a[2], b[2];
+                    std::memcpy(a, src + j + k, 16);
+                    std::memcpy(b, stream + k, 16);
+                    a[0] ^= b[0];
+                    a[1] ^= b[1];
+                    std::memcpy(dst + j + k, a, 16);
+#endif
                 }
-                return result;
             }
+            for (size_t k = 0; j < size; ++j, ++k)
+                dst[j] = src[j] ^ stream[k];
         }
-        return {};
-    }
-}
-
-    std::string ConvertToJson(const std::vector<uint8_t> &data)
-    {
-        try {
-            std::vector<uint8_t> decrypted = DecryptDB(data);
-            std::stringstream ss;
-            size_t pos = 0;
-            std::map<std::string, std::vector<uint8_t>> entries;
-            Header header;
 
-            // Read header
-            if (decrypted.size() < 0x26)
-                return "{}"; // Minimum header size
-
-            // Magic (5 bytes)
-            header.magic.assign(decrypted.begin() + pos, decrypted.begin() + pos + 5);
-            pos += 5;
+        std::vector<uint8_t> DecryptDB(const std::vector<uint8_t> &data)
+        {
+            int rotation = FindRotation(data.data(), data.size());
+            if (rotation < 0)
+                return {};
+            std::vector<uint8_t> result(data.size());
+            ApplyKeyStream(data.data(), result.data(), data.size(), static_cast<size_t>(rotation));
+            return result;
+        }
 
-            // Version (u8)
-            header.version = decrypted[pos++];
+        template <typename T>
+        T ReadValue(const uint8_t *data, size_t pos)
+        {
+            T value;
+            std::memcpy(&value, data + pos, sizeof(T));
+            return value;
+        }
 
-            // Header size (u16)
-            header.headerSize = *reinterpret_cast<const uint16_t *>(&decrypted[pos]);
-            pos += 2;
+        // UInt40 is stored as the high byte followed by the low 32 bits.
+        uint64_t ReadUInt40(const uint8_t *data, size_t pos)
+        {
+            return ReadValue<uint32_t>(data, pos + 1) + (static_cast<uint64_t>(data[pos]) << 32);
+        }
 
-            if (header.headerSize != 0x26)
-                return "{}";
+        // Where the table writers put their text. With a stream attached the
+        // buffer is written out whenever it fills, so memory stays bounded.
+        template <typename Buffer>
+        class TextOutput
+        {
+        public:
+            explicit TextOutput(Buffer &buffer, std::ostream *stream = nullptr)
+                : buffer(buffer), stream(stream)
+            {
+            }
 
-            // unk (u8)
-            header.unk = decrypted[pos++];
+            void Put(char c)
+            {
+                buffer.push_back(static_cast<typename Buffer::value_type>(c));
+            }
 
-            // unk1 (u64)
-            header.unk1 = *reinterpret_cast<const uint64_t *>(&decrypted[pos]);
-            pos += 8;
+            void Put(std::string_view text)
+            {
+                if (text.empty())
+                    return;
+                size_t used = buffer.size();
+                buffer.resize(used + text.size());
+                std::memcpy(&buffer[used], text.data(), text.size());
+            }
 
-            // default_file_count (u32)
-            header.defaultFileCount = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-            pos += 4;
+            bool Flush(bool force)
+            {
+                if (!stream || (!force && buffer.size() < FLUSH_BYTES))
+                    return true;
+                stream->write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+                return static_cast<bool>(*stream);
+            }
 
-            // hash_table_count (u32)
-            header.hashTableCount = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-            pos += 4;
+        private:
+            static constexpr size_t FLUSH_BYTES = 1 << 16;
 
-            // hash_table_offset (UInt40)
-            uint8_t offsetHi = decrypted[pos++];
-            uint32_t offsetLo = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-            pos += 4;
-            header.hashTableOffset = offsetLo + (static_cast<uint64_t>(offsetHi) << 32);
+            Buffer &buffer;
+            std::ostream *stream;
+        };
 
-            // unk5 (u64)
-            header.unk5 = *reinterpret_cast<const uint64_t *>(&decrypted[pos]);
-            pos += 8;
+        // Writes text as a quoted JSON string. Bytes that are not valid UTF-8
+        // become U+FFFD rather than failing the whole table.
+        template <typename Buffer>
+        void PutString(TextOutput<Buffer> &out, std::string_view text)
+        {
+            Core::PutJsonString(text, Core::InvalidUtf8::Replace, [&](std::string_view piece) { out.Put(piece); });
+        }
 
-            // go to hash table offset
-            pos = header.hashTableOffset;
+        // One key of the row objects. Keys come out sorted and unique, as
+        // nlohmann::json objects do, so columns sharing a name share a key that
+        // holds the value of the last such column present in the row.
+        struct Field
+        {
+            std::string key; // quoted and escaped, followed by the separator
+            std::vector<size_t> columns; // ascending
+        };
 
-            // Root entry (5 bytes)
-            std::vector<uint8_t> rootEntry(decrypted.begin() + pos, decrypted.begin() + pos + 5);
-            pos += 5;
+        std::vector<Field> MakeFields(const Table &table, bool pretty)
+        {
+            std::map<std::string_view, std::vector<size_t>> names;
+            const std::vector<std::string> &columns = table.ColumnNames();
+            for (size_t col = 0; col < columns.size(); col++)
+                names[columns[col]].push_back(col);
+
+            std::vector<Field> fields;
+            fields.reserve(names.size());
+            for (auto &[name, indices] : names)
+            {
+                Field field;
+                TextOutput<std::string> key(field.key);
+                PutString(key, name);
+                field.key += pretty ? ": " : ":";
+                field.columns = std::move(indices);
+                fields.push_back(std::move(field));
+            }
+            return fields;
+        }
 
-            if (rootEntry[4] != 1)
-                return "{}";
-            uint32_t rootSize = *reinterpret_cast<const uint32_t *>(&rootEntry[0]);
-            if (rootSize != 5 * (header.hashTableCount + 1))
-                return "{}";
+        // One row as a JSON object; pretty objects sit at the second level of
+        // the array.
+        template <typename Buffer>
+        void PutObject(TextOutput<Buffer> &out, const std::vector<Field> &fields, const std::vector<std::string_view> &values, bool pretty)
+        {
+            const std::string_view separator = pretty ? ",\n    " : ",";
+            bool first_field = true;
+            out.Put('{');
+            for (const Field &field : fields)
+            {
+                auto column = std::find_if(field.columns.rbegin(), field.columns.rend(),
+                                           [&](size_t c) { return c < values.size(); });
+                if (column == field.columns.rend())
+                    continue;
+                out.Put(first_field ? separator.substr(1) : separator);
+                first_field = false;
+                out.Put(field.key);
+                PutString(out, values[*column]);
+            }
+            if (pretty && !first_field)
+                out.Put("\n  ");
+            out.Put('}');
+        }
 
-            // Hash table entries
-            std::vector<HashTableEntry> hashTableEntries;
-            // Process each entry in the hash table
-            for (uint32_t i = 0; i < header.hashTableCount; i++)
+        // RFC 4180: fields holding the delimiter, quotes or line breaks are
+        // quoted, with quotes doubled.
+        template <typename Buffer>
+        void PutCsvField(TextOutput<Buffer> &out, std::string_view text, char delimiter)
+        {
+            bool quote = false;
+            for (char c : text)
             {
-                uint8_t entryHi = decrypted[pos++];
-                uint32_t entryLo = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-                pos += 4;
-                HashTableEntry entry;
-                entry.entryOffset = entryLo + (static_cast<uint64_t>(entryHi) << 32);
-                hashTableEntries.push_back(entry);
-
-                if (entry.entryOffset != 0)
+                if (c == delimiter || c == '"' || c == '\r' || c == '\n')
                 {
-                    size_t currentPos = entry.entryOffset;
-
-                    while (true)
-                    {
-                        // Read FileChunkHeader
-                        FileChunkHeader chunk;
-                        chunk.entrySize = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-
-                        chunk.entryType = decrypted[currentPos++];
-                        chunk.fileNameLength = decrypted[currentPos++];
-
-                        chunk.fileSize = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-
-                        uint8_t nextEntryHi = decrypted[currentPos++];
-                        uint32_t nextEntryLo = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-                        chunk.nextEntry = nextEntryLo + (static_cast<uint64_t>(nextEntryHi) << 32);
-
-                        // Read file name
-                        std::string fileName(reinterpret_cast<const char *>(&decrypted[currentPos]), chunk.fileNameLength);
-                        currentPos += chunk.fileNameLength;
-
-                        // Read file data
-                        std::vector<uint8_t> fileData(decrypted.begin() + currentPos,
-                                                      decrypted.begin() + currentPos + chunk.fileSize);
-                        currentPos += chunk.fileSize;
-
-                        // Save entry
-                        entries[fileName] = fileData;
-
-                        if (chunk.nextEntry == 0)
-                            break;
-                        currentPos = chunk.nextEntry;
-                    }
+                    quote = true;
+                    break;
                 }
             }
+            if (!quote)
+            {
+                out.Put(text);
+                return;
+            }
+            out.Put('"');
+            size_t run = 0;
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                if (text[i] == '"')
+                {
+                    out.Put(text.substr(run, i + 1 - run));
+                    run = i;
+                }
+            }
+            out.Put(text.substr(run));
+            out.Put('"');
+        }
 
-            // Process the database data
-            uint32_t rows = 0;
-            uint32_t cols = 0;
-            std::vector<std::string> colNames;
-
-            // Get rows and cols
-            auto rowsIt = entries.find("\trows");
-            if (rowsIt != entries.end() && !rowsIt->second.empty())
+        template <typename Buffer>
+        void PutDelimitedLine(TextOutput<Buffer> &out, const std::vector<std::string_view> &fields, size_t count, TableFormat format)
+        {
+            for (size_t i = 0; i < count; i++)
             {
-                rows = *reinterpret_cast<const uint32_t *>(rowsIt->second.data());
+                if (i > 0)
+                    out.Put(format == TableFormat::Tsv ? '\t' : ',');
+                std::string_view field = i < fields.size() ? fields[i] : std::string_view();
+                if (format == TableFormat::Tsv)
+                    PutTsvField(field, [&](std::string_view piece) { out.Put(piece); });
+                else if (count == 1 && field.empty())
+                    out.Put("\"\""); // a blank line would read as no fields at all
+                else
+                    PutCsvField(out, field, ',');
             }
+            out.Put('\n');
+        }
 
-            auto colsIt = entries.find("\tcols");
-            if (colsIt != entries.end() && !colsIt->second.empty())
+        // Writes every row of the table in the given format, streaming values
+        // straight from the decrypted buffer.
+        template <typename Buffer>
+        bool WriteTable(const Table &table, TableFormat format, JsonStyle style, TextOutput<Buffer> &out, std::string &error)
+        {
+            const bool pretty = format == TableFormat::Json && style == JsonStyle::Pretty;
+            const bool delimited = format == TableFormat::Csv || format == TableFormat::Tsv;
+            std::vector<Field> fields;
+            if (!delimited)
+                fields = MakeFields(table, pretty);
+
+            const size_t columns = table.ColumnNames().size();
+            std::vector<std::string_view> values;
+            if (delimited)
             {
-                cols = *reinterpret_cast<const uint32_t *>(colsIt->second.data());
+                values.assign(table.ColumnNames().begin(), table.ColumnNames().end());
+                PutDelimitedLine(out, values, columns, format);
             }
 
-            // Get column names
-            for (uint32_t col = 0; col < cols; col++)
+            const std::string_view row_separator = pretty ? ",\n  " : ",";
+            bool first_row = true;
+            if (format == TableFormat::Json)
+                out.Put('[');
+            for (uint32_t row = 0; row < table.RowCount(); row++)
             {
-                std::string key = "\t" + std::to_string(col);
-                auto it = entries.find(key);
-                if (it != entries.end())
+                if ((row % 1000) == 0 && LogEnabled(LogLevel::Debug)) LogDebug(std::string("DB rows written: ") + std::to_string(row));
+
+                if (!table.GetRow(row, values))
+                    continue;
+
+                switch (format)
                 {
-                    colNames.push_back(std::string(it->second.begin(), it->second.end()));
+                case TableFormat::Json:
+                    out.Put(first_row ? row_separator.substr(1) : row_separator);
+                    PutObject(out, fields, values, pretty);
+                    break;
+                case TableFormat::Ndjson:
+                    PutObject(out, fields, values, false);
+                    out.Put('\n');
+                    break;
+                default:
+                    PutDelimitedLine(out, values, columns, format);
+                    break;
+                }
+                first_row = false;
+
+                if (!out.Flush(false))
+                {
+                    error = "write failed";
+                    return false;
                 }
             }
+            if (format == TableFormat::Json)
+            {
+                if (pretty && !first_row)
+                    out.Put('\n');
+                out.Put(']');
+            }
 
-            // Build final JSON
-            json root_json = json::array();
+            if (!out.Flush(true))
+            {
+                error = "write failed";
+                return false;
+            }
+            return true;
+        }
 
-            for (uint32_t row = 0; row < rows; row++)
+        template <typename Buffer>
+        bool WriteTable(const std::vector<uint8_t> &data, TableFormat format, JsonStyle style, TextOutput<Buffer> &out, std::string &error)
+        {
+            Table table;
+            return table.Load(data, error) && WriteTable(table, format, style, out, error);
+        }
+    }
+
+    bool Table::Load(const std::vector<uint8_t> &data, std::string &error)
+    {
+        decrypted = DecryptDB(data);
+        entries.clear();
+        column_names.clear();
+        row_count = 0;
+
+        const uint8_t *bytes = decrypted.data();
+        const uint64_t size = decrypted.size();
+        Header header;
+
+        if (size < 0x26) { error = "decrypted too small"; return false; }
+
+        header.version = bytes[5];
+        header.headerSize = ReadValue<uint16_t>(bytes, 6);
+        if (header.headerSize != 0x26) { error = "invalid header size"; return false; }
+        header.unk = bytes[8];
+        header.unk1 = ReadValue<uint64_t>(bytes, 9);
+        header.defaultFileCount = ReadValue<uint32_t>(bytes, 17);
+        header.hashTableCount = ReadValue<uint32_t>(bytes, 21);
+        header.hashTableOffset = ReadUInt40(bytes, 25);
+        header.unk5 = ReadValue<uint64_t>(bytes, 30);
+
+        // Root entry (5 bytes) followed by one UInt40 per bucket
+        uint64_t pos = header.hashTableOffset;
+        if (pos > size || size - pos < 5) { error = "hash table out of bounds"; return false; }
+        if (bytes[pos + 4] != 1) { error = "rootEntry invalid"; return false; }
+        uint32_t rootSize = ReadValue<uint32_t>(bytes, pos);
+        if (rootSize != 5 * (header.hashTableCount + 1)) { error = "rootSize mismatch"; return false; }
+        pos += 5;
+        if (size - pos < 5ull * header.hashTableCount) { error = "hash table out of bounds"; return false; }
+
+        // The game's bucket hash is unknown, so the chains are walked once and
+        // lookups go through our own table. Every chunk takes at least a
+        // header, which bounds the chunks a well-formed file can hold and
+        // stops looping chains.
+        constexpr uint64_t CHUNK_HEADER_SIZE = 15;
+        uint64_t budget = size / CHUNK_HEADER_SIZE;
+        entries.reserve(static_cast<size_t>(std::min<uint64_t>(header.defaultFileCount, budget)));
+
+        for (uint32_t i = 0; i < header.hashTableCount; i++, pos += 5)
+        {
+            uint64_t current = ReadUInt40(bytes, pos);
+            while (current != 0)
             {
-                std::string entryKey = "\t\t" + std::to_string(row);
-                auto entryIt = entries.find(entryKey);
+                if (budget-- == 0) { error = "entry chain does not end"; return false; }
+                if (current > size || size - current < CHUNK_HEADER_SIZE) { error = "entry out of bounds"; return false; }
+
+                FileChunkHeader chunk;
+                chunk.entrySize = ReadValue<uint32_t>(bytes, current);
+                chunk.entryType = bytes[current + 4];
+                chunk.fileNameLength = bytes[current + 5];
+                chunk.fileSize = ReadValue<uint32_t>(bytes, current + 6);
+                chunk.nextEntry = ReadUInt40(bytes, current + 10);
+
+                uint64_t name_pos = current + CHUNK_HEADER_SIZE;
+                if (size - name_pos < static_cast<uint64_t>(chunk.fileNameLength) + chunk.fileSize) { error = "entry data out of bounds"; return false; }
+
+                // Later entries with the same name replace earlier ones.
+                std::string_view name(reinterpret_cast<const char *>(bytes + name_pos), chunk.fileNameLength);
+                entries[name] = std::string_view(reinterpret_cast<const char *>(bytes + name_pos + chunk.fileNameLength), chunk.fileSize);
+                current = chunk.nextEntry;
+            }
+        }
 
-                if (entryIt != entries.end())
-                {
-                    auto actualEntryIt = entries.find(std::string(entryIt->second.begin(), entryIt->second.end()));
-                    if (actualEntryIt != entries.end())
-                    {
-                        // Split data by column
-                        std::vector<std::string> values;
-                        size_t start = 0;
-                        for (size_t i = 0; i < actualEntryIt->second.size(); i++)
-                        {
-                            if (actualEntryIt->second[i] == 0)
-                            {
-                                values.push_back(std::string(
-                                    actualEntryIt->second.begin() + start,
-                                    actualEntryIt->second.begin() + i));
-                                start = i + 1;
-                            }
-                        }
-
-                        // Generate JSON for the row
-                        json row_obj = json::object();
-                        for (size_t i = 0; i < colNames.size() && i < values.size(); i++)
-                        {
-                            row_obj[colNames[i]] = values[i];
-                        }
-                        root_json.push_back(row_obj);
-                    }
-                }
+        row_count = ReadCount("\trows");
+        uint32_t cols = ReadCount("\tcols");
+        for (uint32_t col = 0; col < cols; col++)
+        {
+            if (const std::string_view *name = Find(1, col))
+                column_names.emplace_back(*name);
+        }
+        return true;
+    }
+
+    bool Table::GetRow(uint32_t row, std::vector<std::string_view> &values) const
+    {
+        values.clear();
+        // The row key names the entry that holds the row's values.
+        const std::string_view *key = Find(2, row);
+        const std::string_view *entry = key ? Find(*key) : nullptr;
+        if (!entry)
+            return false;
+
+        // Split data by column; every value is NUL-terminated
+        size_t start = 0;
+        for (size_t i = 0; i < entry->size(); i++)
+        {
+            if ((*entry)[i] == 0)
+            {
+                values.push_back(entry->substr(start, i - start));
+                start = i + 1;
             }
+        }
+        return true;
+    }
+
+    const std::string_view *Table::Find(std::string_view name) const
+    {
+        auto it = entries.find(name);
+        return it != entries.end() ? &it->second : nullptr;
+    }
+
+    // Looks up the entry named by a run of tabs followed by a number, such as
+    // "\t3" for a column name or "\t\t3" for a row key.
+    const std::string_view *Table::Find(size_t tabs, uint32_t number) const
+    {
+        char name[2 + 10];
+        std::memset(name, '\t', tabs);
+        auto result = std::to_chars(name + tabs, name + sizeof(name), number);
+        return Find(std::string_view(name, static_cast<size_t>(result.ptr - name)));
+    }
+
+    uint32_t Table::ReadCount(std::string_view name) const
+    {
+        uint32_t value = 0;
+        if (const std::string_view *entry = Find(name))
+            std::memcpy(&value, entry->data(), std::min<size_t>(entry->size(), sizeof(value)));
+        return value;
+    }
+
+    bool ParseTableFormat(const std::string &name, TableFormat &format)
+    {
+        std::string lower = LowerAscii(name);
+        if (lower == "json") format = TableFormat::Json;
+        else if (lower == "csv") format = TableFormat::Csv;
+        else if (lower == "tsv") format = TableFormat::Tsv;
+        else if (lower == "ndjson") format = TableFormat::Ndjson;
+        else return false;
+        return true;
+    }
+
+    const char *TableFormatName(TableFormat format)
+    {
+        switch (format)
+        {
+        case TableFormat::Csv: return "csv";
+        case TableFormat::Tsv: return "tsv";
+        case TableFormat::Ndjson: return "ndjson";
+        default: return "json";
+        }
+    }
 
-            return root_json.dump(2, ' ', false);
+    std::string LowerAscii(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    bool IsDBPath(std::string_view path)
+    {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of('/');
+        bool has_extension = dot != std::string_view::npos && (slash == std::string_view::npos || dot > slash);
+        return has_extension && LowerAscii(std::string(path.substr(dot))) == ".db";
+    }
+
+    bool ParseInteger(std::string_view text, int64_t &value)
+    {
+        if (text.empty() || text.size() > 20)
+            return false;
+        size_t digits = text[0] == '-' ? 1 : 0;
+        if (digits == text.size() || (text[digits] == '0' && text.size() > digits + 1) || text == "-0")
+            return false;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    std::vector<uint8_t> EncryptDB(const std::vector<uint8_t> &plain, uint8_t key_rotation)
+    {
+        std::vector<uint8_t> result(plain.size());
+        ApplyKeyStream(plain.data(), result.data(), plain.size(), key_rotation);
+        return result;
+    }
+
+    bool ConvertTable(const std::vector<uint8_t> &data, std::vector<uint8_t> &out, TableFormat format, JsonStyle style)
+    {
+        try {
+            TextOutput<std::vector<uint8_t>> output(out);
+            std::string error;
+            return WriteTable(data, format, style, output, error);
+        } catch (...) {
+            return false;
+        }
+    }
+
+    bool ConvertToJson(const std::vector<uint8_t> &data, std::vector<uint8_t> &out, JsonStyle style)
+    {
+        return ConvertTable(data, out, TableFormat::Json, style);
+    }
+
+    std::string ConvertToJson(const std::vector<uint8_t> &data, JsonStyle style)
+    {
+        try {
+            std::string text;
+            TextOutput<std::string> output(text);
+            std::string error;
+            if (!WriteTable(data, TableFormat::Json, style, output, error))
+                return "{}";
+            return text;
 
         } catch (const std::exception&) {
             return "{}";
@@ -274,122 +602,16 @@ namespace DBParser
         }
     }
 
-    bool ConvertToJsonToStream(const std::vector<uint8_t>& data, std::ostream& out) noexcept
+    bool ConvertToJsonToStream(const std::vector<uint8_t>& data, std::ostream& out, JsonStyle style) noexcept
     {
         try {
-            LogInfo("DB ConvertToJsonToStream begin");
-            std::vector<uint8_t> decrypted = DecryptDB(data);
-            size_t pos = 0;
-            std::map<std::string, std::vector<uint8_t>> entries;
-            Header header;
-
-            if (decrypted.size() < 0x26) { LogError("DB decrypted too small"); return false; }
-
-            header.magic.assign(decrypted.begin() + pos, decrypted.begin() + pos + 5);
-            pos += 5;
-            header.version = decrypted[pos++];
-            header.headerSize = *reinterpret_cast<const uint16_t *>(&decrypted[pos]);
-            pos += 2;
-            if (header.headerSize != 0x26) { LogError("DB invalid header size"); return false; }
-            header.unk = decrypted[pos++];
-            header.unk1 = *reinterpret_cast<const uint64_t *>(&decrypted[pos]);
-            pos += 8;
-            header.defaultFileCount = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-            pos += 4;
-            header.hashTableCount = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-            pos += 4;
-            {
-                uint8_t offsetHi = decrypted[pos++];
-                uint32_t offsetLo = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-                pos += 4;
-                header.hashTableOffset = offsetLo + (static_cast<uint64_t>(offsetHi) << 32);
-            }
-            header.unk5 = *reinterpret_cast<const uint64_t *>(&decrypted[pos]);
-            pos += 8;
-            pos = header.hashTableOffset;
-
-            std::vector<uint8_t> rootEntry(decrypted.begin() + pos, decrypted.begin() + pos + 5);
-            pos += 5;
-            if (rootEntry[4] != 1) { LogError("DB rootEntry invalid"); return false; }
-            uint32_t rootSize = *reinterpret_cast<const uint32_t *>(&rootEntry[0]);
-            if (rootSize != 5 * (header.hashTableCount + 1)) { LogError("DB rootSize mismatch"); return false; }
-
-            std::vector<HashTableEntry> hashTableEntries;
-            for (uint32_t i = 0; i < header.hashTableCount; i++) {
-                uint8_t entryHi = decrypted[pos++];
-                uint32_t entryLo = *reinterpret_cast<const uint32_t *>(&decrypted[pos]);
-                pos += 4;
-                HashTableEntry entry;
-                entry.entryOffset = entryLo + (static_cast<uint64_t>(entryHi) << 32);
-                hashTableEntries.push_back(entry);
-
-                if (entry.entryOffset != 0) {
-                    size_t currentPos = entry.entryOffset;
-                    while (true) {
-                        FileChunkHeader chunk;
-                        chunk.entrySize = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-                        chunk.entryType = decrypted[currentPos++];
-                        chunk.fileNameLength = decrypted[currentPos++];
-                        chunk.fileSize = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-                        uint8_t nextEntryHi = decrypted[currentPos++];
-                        uint32_t nextEntryLo = *reinterpret_cast<const uint32_t *>(&decrypted[currentPos]);
-                        currentPos += 4;
-                        chunk.nextEntry = nextEntryLo + (static_cast<uint64_t>(nextEntryHi) << 32);
-                        std::string fileName(reinterpret_cast<const char *>(&decrypted[currentPos]), chunk.fileNameLength);
-                        currentPos += chunk.fileNameLength;
-                        std::vector<uint8_t> fileData(decrypted.begin() + currentPos, decrypted.begin() + currentPos + chunk.fileSize);
-                        currentPos += chunk.fileSize;
-                        entries[fileName] = std::move(fileData);
-                        if (chunk.nextEntry == 0) break;
-                        currentPos = chunk.nextEntry;
-                    }
-                }
-            }
-
-            uint32_t rows = 0, cols = 0;
-            std::vector<std::string> colNames;
-            auto rowsIt = entries.find("\trows");
-            if (rowsIt != entries.end() && !rowsIt->second.empty()) rows = *reinterpret_cast<const uint32_t *>(rowsIt->second.data());
-            auto colsIt = entries.find("\tcols");
-            if (colsIt != entries.end() && !colsIt->second.empty()) cols = *reinterpret_cast<const uint32_t *>(colsIt->second.data());
-            for (uint32_t col = 0; col < cols; col++) {
-                std::string key = "\t" + std::to_string(col);
-                auto it = entries.find(key);
-                if (it != entries.end()) colNames.push_back(std::string(it->second.begin(), it->second.end()));
-            }
+            LogDebug("DB ConvertToJsonToStream begin");
+            std::vector<uint8_t> buffer;
+            TextOutput<std::vector<uint8_t>> output(buffer, &out);
+            std::string error;
+            if (!WriteTable(data, TableFormat::Json, style, output, error)) { LogError("DB " + error); return false; }
 
-            // Build final JSON
-            json root_json = json::array();
-
-            for (uint32_t row = 0; row < rows; row++) {
-                if ((row % 1000) == 0) LogInfo(std::string("DB JSON rows written: ") + std::to_string(row));
-                std::string entryKey = "\t\t" + std::to_string(row);
-                auto entryIt = entries.find(entryKey);
-                if (entryIt != entries.end()) {
-                    auto actualEntryIt = entries.find(std::string(entryIt->second.begin(), entryIt->second.end()));
-                    if (actualEntryIt != entries.end()) {
-                        std::vector<std::string> values;
-                        size_t start = 0;
-                        for (size_t i = 0; i < actualEntryIt->second.size(); i++) {
-                            if (actualEntryIt->second[i] == 0) {
-                                values.push_back(std::string(actualEntryIt->second.begin() + start, actualEntryIt->second.begin() + i));
-                                start = i + 1;
-                            }
-                        }
-                        
-                        json row_obj = json::object();
-                        for (size_t i = 0; i < colNames.size() && i < values.size(); i++) {
-                            row_obj[colNames[i]] = values[i];
-                        }
-                        root_json.push_back(row_obj);
-                    }
-                }
-            }
-            
-            out << root_json.dump(2, ' ', false);
-            LogInfo("DB ConvertToJsonToStream end");
+            LogDebug("DB ConvertToJsonToStream end");
             return true;
         } catch (...) {
             LogError("DB ConvertToJsonToStream exception");
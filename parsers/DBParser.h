@@ -1,12 +1,99 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <cstdint>
+#include <ostream>
 
 namespace DBParser
 {
-	std::string ConvertToJson(const std::vector<uint8_t> &data);
-	bool ConvertToJsonToStream(const std::vector<uint8_t>& data, std::ostream& out) noexcept;
-	std::string ConvertToJson(const std::vector<uint8_t> &decrypted);
-	bool ConvertToJsonToStream(const std::vector<uint8_t>& data, std::ostream& out) noexcept;
+	enum class JsonStyle { Pretty, Compact };
+
+	// Formats a DB table can be converted to. Json is an array of row objects,
+	// Ndjson one object per line; Csv and Tsv start with a header of column names.
+	enum class TableFormat { Json, Csv, Tsv, Ndjson };
+
+	bool ParseTableFormat(const std::string &name, TableFormat &format);
+	const char *TableFormatName(TableFormat format);
+
+	std::string LowerAscii(std::string text);
+	// True if the file name ends in ".db", in any case.
+	bool IsDBPath(std::string_view path);
+	// Only text that prints back exactly as stored is an integer, so nothing
+	// like "007", "+1" or "-0" changes type when it is typed on load.
+	bool ParseInteger(std::string_view text, int64_t &value);
+
+	// TSV has no quoting, so tabs, line breaks and backslashes are written as
+	// backslash escapes. put receives the escaped text in pieces.
+	template <typename Put>
+	void PutTsvField(std::string_view text, Put &&put)
+	{
+		size_t run = 0;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			const char *escape = nullptr;
+			switch (text[i])
+			{
+			case '\t': escape = "\\t"; break;
+			case '\n': escape = "\\n"; break;
+			case '\r': escape = "\\r"; break;
+			case '\\': escape = "\\\\"; break;
+			default: continue;
+			}
+			put(text.substr(run, i - run));
+			put(std::string_view(escape));
+			run = i + 1;
+		}
+		put(text.substr(run));
+	}
+
+	// A decrypted DB with its entries indexed in place. Rows are split on
+	// demand into views of the table's own buffer, so they stay valid while
+	// the table lives, including after it is moved.
+	class Table
+	{
+	public:
+		Table() = default;
+		Table(const Table &) = delete;
+		Table &operator=(const Table &) = delete;
+		Table(Table &&) = default;
+		Table &operator=(Table &&) = default;
+
+		// Decrypts and indexes data; on failure error says why.
+		bool Load(const std::vector<uint8_t> &data, std::string &error);
+
+		uint32_t RowCount() const { return row_count; }
+		// Names of the columns that have one, in column order; row values
+		// line up with these.
+		const std::vector<std::string> &ColumnNames() const { return column_names; }
+		// Splits a row into its NUL-terminated values. Returns false if the
+		// row has no entry; converters skip those rows.
+		bool GetRow(uint32_t row, std::vector<std::string_view> &values) const;
+
+		const std::string_view *Find(std::string_view name) const;
+
+	private:
+		const std::string_view *Find(size_t tabs, uint32_t number) const;
+		uint32_t ReadCount(std::string_view name) const;
+
+		std::vector<uint8_t> decrypted;
+		std::unordered_map<std::string_view, std::string_view> entries;
+		std::vector<std::string> column_names;
+		uint32_t row_count = 0;
+	};
+
+	// Rows are written as a JSON array of objects, escaped straight from the
+	// decrypted file. Pretty output matches nlohmann::json's dump(2).
+	std::string ConvertToJson(const std::vector<uint8_t> &data, JsonStyle style = JsonStyle::Pretty);
+	// Appends to out; returns false and leaves out untouched if data is not a DB.
+	bool ConvertToJson(const std::vector<uint8_t> &data, std::vector<uint8_t> &out, JsonStyle style = JsonStyle::Pretty);
+	// Writes in blocks as rows are produced, so memory stays bounded.
+	bool ConvertToJsonToStream(const std::vector<uint8_t>& data, std::ostream& out, JsonStyle style = JsonStyle::Pretty) noexcept;
+	// Same as ConvertToJson for any TableFormat; style only affects Json.
+	bool ConvertTable(const std::vector<uint8_t> &data, std::vector<uint8_t> &out, TableFormat format, JsonStyle style = JsonStyle::Pretty);
+
+	// Applies the on-disk key stream starting at key_rotation; the inverse of the
+	// decryption done on load. Used to build synthetic databases.
+	std::vector<uint8_t> EncryptDB(const std::vector<uint8_t> &plain, uint8_t key_rotation);
 }
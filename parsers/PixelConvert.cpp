@@ -0,0 +1,97 @@
+#include "PixelConvert.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELCONVERT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PIXELCONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace PixelConvert {
+    namespace {
+        void RGB565ToRGBAScalar(const uint8_t* src, size_t pixel_count, uint8_t* dst) {
+            for (size_t i = 0; i < pixel_count; ++i) {
+                uint16_t pixel = static_cast<uint16_t>(src[i * 2] | (src[i * 2 + 1] << 8));
+                dst[i * 4 + 0] = static_cast<uint8_t>(((pixel >> 11) & 0x1F) << 3);
+                dst[i * 4 + 1] = static_cast<uint8_t>(((pixel >> 5) & 0x3F) << 2);
+                dst[i * 4 + 2] = static_cast<uint8_t>((pixel & 0x1F) << 3);
+                dst[i * 4 + 3] = 255;
+            }
+        }
+
+        void L8ToRGBAScalar(const uint8_t* src, size_t pixel_count, uint8_t* dst) {
+            for (size_t i = 0; i < pixel_count; ++i) {
+                uint8_t gray = src[i];
+                dst[i * 4 + 0] = gray;
+                dst[i * 4 + 1] = gray;
+                dst[i * 4 + 2] = gray;
+                dst[i * 4 + 3] = 255;
+            }
+        }
+    }
+
+    void RGB565ToRGBA(const uint8_t* src, size_t pixel_count, uint8_t* dst) {
+        size_t i = 0;
+#if defined(PIXELCONVERT_SSE2)
+        const __m128i mask5 = _mm_set1_epi16(0x1F);
+        const __m128i mask6 = _mm_set1_epi16(0x3F);
+        const __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+        for (; i + 8 <= pixel_count; i += 8) {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            __m128i r = _mm_slli_epi16(_mm_srli_epi16(p, 11), 3);
+            __m128i g = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(p, 5), mask6), 2);
+            __m128i b = _mm_slli_epi16(_mm_and_si128(p, mask5), 3);
+            // 16-bit lanes holding R|G<<8 and B|A<<8 interleave into RGBA pixels.
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+            __m128i ba = _mm_or_si128(b, alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+        }
+#elif defined(PIXELCONVERT_NEON)
+        const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+        const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+        for (; i + 8 <= pixel_count; i += 8) {
+            uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+            uint8x8x4_t rgba;
+            rgba.val[0] = vshl_n_u8(vmovn_u16(vshrq_n_u16(p, 11)), 3);
+            rgba.val[1] = vshl_n_u8(vmovn_u16(vandq_u16(vshrq_n_u16(p, 5), mask6)), 2);
+            rgba.val[2] = vshl_n_u8(vmovn_u16(vandq_u16(p, mask5)), 3);
+            rgba.val[3] = vdup_n_u8(255);
+            vst4_u8(dst + i * 4, rgba);
+        }
+#endif
+        RGB565ToRGBAScalar(src + i * 2, pixel_count - i, dst + i * 4);
+    }
+
+    void L8ToRGBA(const uint8_t* src, size_t pixel_count, uint8_t* dst) {
+        size_t i = 0;
+#if defined(PIXELCONVERT_SSE2)
+        const __m128i opaque = _mm_set1_epi8(static_cast<char>(0xFF));
+        for (; i + 16 <= pixel_count; i += 16) {
+            __m128i gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i gg_lo = _mm_unpacklo_epi8(gray, gray);
+            __m128i ga_lo = _mm_unpacklo_epi8(gray, opaque);
+            __m128i gg_hi = _mm_unpackhi_epi8(gray, gray);
+            __m128i ga_hi = _mm_unpackhi_epi8(gray, opaque);
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i * 4);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(gg_lo, ga_lo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg_lo, ga_lo));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(gg_hi, ga_hi));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(gg_hi, ga_hi));
+        }
+#elif defined(PIXELCONVERT_NEON)
+        for (; i + 16 <= pixel_count; i += 16) {
+            uint8x16_t gray = vld1q_u8(src + i);
+            uint8x16x4_t rgba;
+            rgba.val[0] = gray;
+            rgba.val[1] = gray;
+            rgba.val[2] = gray;
+            rgba.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst + i * 4, rgba);
+        }
+#endif
+        L8ToRGBAScalar(src + i, pixel_count - i, dst + i * 4);
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Single-pass conversions from SCT pixel formats into 8-bit RGBA. Each writes
+// pixel_count * 4 bytes to dst. SSE2 on x86-64, NEON on ARM64, scalar elsewhere.
+namespace PixelConvert {
+    // Little-endian RGB565, channels widened by shifting (no bit replication).
+    void RGB565ToRGBA(const uint8_t* src, size_t pixel_count, uint8_t* dst);
+
+    void L8ToRGBA(const uint8_t* src, size_t pixel_count, uint8_t* dst);
+}
@@ -0,0 +1,916 @@
+#include "PngWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace PngWriter {
+    namespace {
+        static constexpr int BYTES_PER_PIXEL = 4;
+
+        // Filtered bytes per strip. Each strip becomes a run of deflate blocks
+        // ending in a sync flush, so strips can be compressed independently and
+        // concatenated; matches may still reach back into the previous strip.
+        static constexpr size_t STRIP_BYTES = 512 * 1024;
+
+        // Same threshold the SCT decoders use for spreading one image over all cores.
+        static constexpr size_t COOPERATIVE_MIN_PIXELS = 1024 * 1024;
+
+        static constexpr int WINDOW_SIZE = 32768;
+        static constexpr int WINDOW_MASK = WINDOW_SIZE - 1;
+        static constexpr int HASH_BITS = 15;
+        static constexpr int MIN_MATCH = 4;
+        static constexpr int MAX_MATCH = 258;
+
+        struct LevelParams {
+            bool adaptive_filter;
+            int max_chain;
+            int good_length;        // chain is cut to a quarter once a match this long is in hand
+            int nice_length;
+            bool lazy;
+            bool insert_all;        // hash every position inside a match
+            size_t block_symbols;   // symbols per Huffman block
+        };
+
+        LevelParams GetParams(Level level) {
+            switch (level) {
+            case Level::Fast:    return { false, 1, MAX_MATCH, 32, false, false, 1 << 15 };
+            case Level::Best:    return { true, 64, 32, MAX_MATCH, true, true, 1 << 14 };
+            case Level::Default:
+            default:             return { true, 16, 8, 128, true, true, 1 << 15 };
+            }
+        }
+
+        // ---- Checksums ----
+
+        struct Crc32Table {
+            uint32_t t[4][256];
+            Crc32Table() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    t[0][i] = c;
+                }
+                for (uint32_t i = 0; i < 256; ++i)
+                    for (int k = 1; k < 4; ++k)
+                        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        };
+
+        uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n) {
+            static const Crc32Table table;
+            const auto& t = table.t;
+            uint32_t c = ~crc;
+            for (; n >= 4; p += 4, n -= 4) {
+                c ^= static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                    (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+                c = t[3][c & 0xFF] ^ t[2][(c >> 8) & 0xFF] ^ t[1][(c >> 16) & 0xFF] ^ t[0][c >> 24];
+            }
+            for (; n > 0; ++p, --n)
+                c = t[0][(c ^ *p) & 0xFF] ^ (c >> 8);
+            return ~c;
+        }
+
+        static constexpr uint32_t ADLER_BASE = 65521;
+
+        uint32_t Adler32(uint32_t adler, const uint8_t* p, size_t n) {
+            uint32_t a = adler & 0xFFFF;
+            uint32_t b = adler >> 16;
+            while (n > 0) {
+                // Largest run before b can overflow 32 bits.
+                size_t run = std::min<size_t>(n, 5552);
+                n -= run;
+                for (; run > 0; --run) {
+                    a += *p++;
+                    b += a;
+                }
+                a %= ADLER_BASE;
+                b %= ADLER_BASE;
+            }
+            return a | (b << 16);
+        }
+
+        // Adler-32 of A followed by B, given the checksums of each and B's length.
+        uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+            uint32_t rem = static_cast<uint32_t>(length2 % ADLER_BASE);
+            uint32_t sum1 = adler1 & 0xFFFF;
+            uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % ADLER_BASE);
+            sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+            sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+            if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+            if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+            if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+            if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+            return sum1 | (sum2 << 16);
+        }
+
+        // ---- Filtering ----
+
+        inline uint8_t Paeth(int a, int b, int c) {
+            int p = a + b - c;
+            int pa = std::abs(p - a);
+            int pb = std::abs(p - b);
+            int pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+            if (pb <= pc) return static_cast<uint8_t>(b);
+            return static_cast<uint8_t>(c);
+        }
+
+        // prev is the unfiltered row above, or nullptr for the first row.
+        void FilterRow(int type, const uint8_t* row, const uint8_t* prev, size_t n, uint8_t* out) {
+            const size_t bpp = BYTES_PER_PIXEL;
+            switch (type) {
+            case 0:
+                std::memcpy(out, row, n);
+                break;
+            case 1:
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = static_cast<uint8_t>(row[i] - (i >= bpp ? row[i - bpp] : 0));
+                break;
+            case 2:
+                if (!prev) { std::memcpy(out, row, n); break; }
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = static_cast<uint8_t>(row[i] - prev[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < n; ++i) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    int up = prev ? prev[i] : 0;
+                    out[i] = static_cast<uint8_t>(row[i] - ((left + up) >> 1));
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < n; ++i) {
+                    int left = i >= bpp ? row[i - bpp] : 0;
+                    int up = prev ? prev[i] : 0;
+                    int up_left = (prev && i >= bpp) ? prev[i - bpp] : 0;
+                    out[i] = static_cast<uint8_t>(row[i] - Paeth(left, up, up_left));
+                }
+                break;
+            }
+        }
+
+        // Picks the filter whose output has the smallest sum of absolute signed
+        // bytes (the usual libpng heuristic) and writes the type byte plus row.
+        void FilterRowAdaptive(const uint8_t* row, const uint8_t* prev, size_t n, uint8_t* out, std::vector<uint8_t>& scratch) {
+            scratch.resize(n * 2);
+            uint8_t* candidate = scratch.data();
+            uint8_t* best = scratch.data() + n;
+            uint64_t best_cost = UINT64_MAX;
+            int best_type = 0;
+            for (int type = 0; type < 5; ++type) {
+                FilterRow(type, row, prev, n, candidate);
+                uint64_t cost = 0;
+                for (size_t i = 0; i < n; ++i)
+                    cost += static_cast<uint64_t>(std::abs(static_cast<int8_t>(candidate[i])));
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_type = type;
+                    std::swap(candidate, best);
+                }
+            }
+            out[0] = static_cast<uint8_t>(best_type);
+            std::memcpy(out + 1, best, n);
+        }
+
+        // ---- Deflate ----
+
+        static constexpr int LITLEN_CODES = 286;
+        static constexpr int DIST_CODES = 30;
+        static constexpr int CODELEN_CODES = 19;
+        static constexpr int END_OF_BLOCK = 256;
+
+        static const uint16_t LENGTH_BASE[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t LENGTH_EXTRA[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t DIST_BASE[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const uint8_t DIST_EXTRA[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        static const uint8_t CODELEN_ORDER[CODELEN_CODES] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        struct Tables {
+            uint8_t length_code[MAX_MATCH + 1];     // match length -> index into LENGTH_BASE
+            uint8_t dist_code[512];                 // see DistCode
+            uint8_t fixed_litlen_lengths[288];
+            uint8_t fixed_dist_lengths[DIST_CODES];
+            uint16_t fixed_litlen_codes[288];
+            uint16_t fixed_dist_codes[DIST_CODES];
+            Tables();
+        };
+
+        const Tables& GetTables() {
+            static const Tables tables;
+            return tables;
+        }
+
+        inline int DistCode(const Tables& tables, int distance) {
+            int d = distance - 1;
+            return d < 256 ? tables.dist_code[d] : tables.dist_code[256 + (d >> 7)];
+        }
+
+        void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+            int bl_count[16] = {};
+            for (int i = 0; i < count; ++i)
+                bl_count[lengths[i]]++;
+            bl_count[0] = 0;
+            int next_code[16] = {};
+            int code = 0;
+            for (int bits = 1; bits < 16; ++bits) {
+                code = (code + bl_count[bits - 1]) << 1;
+                next_code[bits] = code;
+            }
+            for (int i = 0; i < count; ++i) {
+                int len = lengths[i];
+                if (len == 0) {
+                    codes[i] = 0;
+                    continue;
+                }
+                // Deflate sends Huffman codes MSB first into an LSB-first stream.
+                int c = next_code[len]++;
+                int reversed = 0;
+                for (int b = 0; b < len; ++b)
+                    reversed |= ((c >> b) & 1) << (len - 1 - b);
+                codes[i] = static_cast<uint16_t>(reversed);
+            }
+        }
+
+        Tables::Tables() {
+            for (int code = 0; code < 29; ++code) {
+                int end = code == 28 ? MAX_MATCH : LENGTH_BASE[code] + (1 << LENGTH_EXTRA[code]) - 1;
+                for (int len = LENGTH_BASE[code]; len <= end; ++len)
+                    length_code[len] = static_cast<uint8_t>(code);
+            }
+            // Distances up to 256 index directly; longer ones by (distance - 1) >> 7.
+            for (int code = 0; code < DIST_CODES; ++code) {
+                for (int d = DIST_BASE[code] - 1; d < DIST_BASE[code] - 1 + (1 << DIST_EXTRA[code]); ++d) {
+                    if (d < 256)
+                        dist_code[d] = static_cast<uint8_t>(code);
+                    else
+                        dist_code[256 + (d >> 7)] = static_cast<uint8_t>(code);
+                }
+            }
+            for (int i = 0; i < 288; ++i)
+                fixed_litlen_lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+            for (int i = 0; i < DIST_CODES; ++i)
+                fixed_dist_lengths[i] = 5;
+            BuildCodes(fixed_litlen_lengths, 288, fixed_litlen_codes);
+            BuildCodes(fixed_dist_lengths, DIST_CODES, fixed_dist_codes);
+        }
+
+        // Length-limited Huffman code lengths: an optimal tree from the
+        // frequencies, then over-long codes are folded back under max_bits.
+        void BuildLengths(const uint32_t* freq, int count, int max_bits, uint8_t* lengths) {
+            struct Leaf { uint32_t freq; int symbol; };
+            Leaf leaves[LITLEN_CODES];
+            int used = 0;
+            for (int i = 0; i < count; ++i) {
+                lengths[i] = 0;
+                if (freq[i])
+                    leaves[used++] = { freq[i], i };
+            }
+            if (used == 0)
+                return;
+            if (used == 1) {
+                lengths[leaves[0].symbol] = 1;
+                return;
+            }
+            std::sort(leaves, leaves + used, [](const Leaf& a, const Leaf& b) {
+                return a.freq != b.freq ? a.freq < b.freq : a.symbol < b.symbol;
+            });
+
+            // Two-queue construction: leaves in order, internal nodes as created.
+            uint64_t weight[2 * LITLEN_CODES];
+            int parent[2 * LITLEN_CODES];
+            for (int i = 0; i < used; ++i)
+                weight[i] = leaves[i].freq;
+            int next_leaf = 0;
+            int next_node = used;
+            auto pick = [&](int created) {
+                if (next_leaf < used && (next_node >= created || weight[next_leaf] <= weight[next_node]))
+                    return next_leaf++;
+                return next_node++;
+            };
+            const int nodes = 2 * used - 1;
+            for (int created = used; created < nodes; ++created) {
+                int a = pick(created);
+                int b = pick(created);
+                weight[created] = weight[a] + weight[b];
+                parent[a] = created;
+                parent[b] = created;
+            }
+
+            int depth[2 * LITLEN_CODES];
+            depth[nodes - 1] = 0;
+            int length_count[64] = {};
+            for (int i = nodes - 2; i >= 0; --i) {
+                depth[i] = depth[parent[i]] + 1;
+                if (i < used)
+                    length_count[std::min(depth[i], 63)]++;
+            }
+
+            for (int bits = max_bits + 1; bits < 64; ++bits) {
+                length_count[max_bits] += length_count[bits];
+                length_count[bits] = 0;
+            }
+            uint32_t kraft = 0;
+            for (int bits = max_bits; bits > 0; --bits)
+                kraft += static_cast<uint32_t>(length_count[bits]) << (max_bits - bits);
+            while (kraft > (1u << max_bits)) {
+                length_count[max_bits]--;
+                for (int bits = max_bits - 1; bits > 0; --bits) {
+                    if (length_count[bits]) {
+                        length_count[bits]--;
+                        length_count[bits + 1] += 2;
+                        break;
+                    }
+                }
+                kraft--;
+            }
+
+            // Most frequent symbols take the shortest codes.
+            int j = used;
+            for (int bits = 1; bits <= max_bits; ++bits)
+                for (int n = length_count[bits]; n > 0; --n)
+                    lengths[leaves[--j].symbol] = static_cast<uint8_t>(bits);
+        }
+
+        class BitWriter {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+            void Put(uint32_t value, int count) {
+                bits_ |= static_cast<uint64_t>(value) << count_;
+                count_ += count;
+                if (count_ >= 32) {
+                    uint8_t bytes[4] = {
+                        static_cast<uint8_t>(bits_), static_cast<uint8_t>(bits_ >> 8),
+                        static_cast<uint8_t>(bits_ >> 16), static_cast<uint8_t>(bits_ >> 24) };
+                    out_.insert(out_.end(), bytes, bytes + 4);
+                    bits_ >>= 32;
+                    count_ -= 32;
+                }
+            }
+
+            void AlignToByte() {
+                while (count_ > 0) {
+                    out_.push_back(static_cast<uint8_t>(bits_));
+                    bits_ >>= 8;
+                    count_ = count_ > 8 ? count_ - 8 : 0;
+                }
+                bits_ = 0;
+            }
+
+            void PutBytes(const uint8_t* data, size_t size) {
+                out_.insert(out_.end(), data, data + size);
+            }
+
+        private:
+            std::vector<uint8_t>& out_;
+            uint64_t bits_ = 0;
+            int count_ = 0;
+        };
+
+        // A literal (distance == 0, value in length) or a match.
+        struct Symbol {
+            uint16_t length;
+            uint16_t distance;
+        };
+
+        class BlockWriter {
+        public:
+            explicit BlockWriter(BitWriter& writer) : writer_(writer), tables_(GetTables()) {}
+
+            // Emits syms, which encode raw[0, raw_size), as the cheapest of a
+            // dynamic, fixed or stored block.
+            void Write(const std::vector<Symbol>& syms, const uint8_t* raw, size_t raw_size) {
+                uint32_t litlen_freq[LITLEN_CODES] = {};
+                uint32_t dist_freq[DIST_CODES] = {};
+                uint64_t extra_bits = 0;
+                for (const Symbol& s : syms) {
+                    if (s.distance == 0) {
+                        litlen_freq[s.length]++;
+                    }
+                    else {
+                        int lc = tables_.length_code[s.length];
+                        int dc = DistCode(tables_, s.distance);
+                        litlen_freq[257 + lc]++;
+                        dist_freq[dc]++;
+                        extra_bits += LENGTH_EXTRA[lc] + DIST_EXTRA[dc];
+                    }
+                }
+                litlen_freq[END_OF_BLOCK] = 1;
+
+                bool any_distance = false;
+                for (uint32_t f : dist_freq)
+                    any_distance |= f != 0;
+                if (!any_distance)
+                    dist_freq[0] = 1;     // some decoders reject an empty distance tree
+
+                BuildLengths(litlen_freq, LITLEN_CODES, 15, litlen_lengths_);
+                BuildLengths(dist_freq, DIST_CODES, 15, dist_lengths_);
+                uint64_t dynamic_bits = 3 + BuildHeader() + extra_bits;
+                uint64_t fixed_bits = 3 + extra_bits;
+                for (int i = 0; i < LITLEN_CODES; ++i) {
+                    dynamic_bits += static_cast<uint64_t>(litlen_freq[i]) * litlen_lengths_[i];
+                    fixed_bits += static_cast<uint64_t>(litlen_freq[i]) * tables_.fixed_litlen_lengths[i];
+                }
+                for (int i = 0; i < DIST_CODES; ++i) {
+                    dynamic_bits += static_cast<uint64_t>(dist_freq[i]) * dist_lengths_[i];
+                    fixed_bits += static_cast<uint64_t>(dist_freq[i]) * tables_.fixed_dist_lengths[i];
+                }
+                uint64_t stored_blocks = std::max<uint64_t>(1, (raw_size + 65534) / 65535);
+                uint64_t stored_bits = (raw_size + stored_blocks * 5) * 8 + 7;
+
+                if (stored_bits <= dynamic_bits && stored_bits <= fixed_bits) {
+                    WriteStored(raw, raw_size);
+                }
+                else if (fixed_bits <= dynamic_bits) {
+                    writer_.Put(0, 1);
+                    writer_.Put(1, 2);
+                    WriteSymbols(syms, tables_.fixed_litlen_codes, tables_.fixed_litlen_lengths,
+                        tables_.fixed_dist_codes, tables_.fixed_dist_lengths);
+                }
+                else {
+                    writer_.Put(0, 1);
+                    writer_.Put(2, 2);
+                    WriteHeader();
+                    uint16_t litlen_codes[LITLEN_CODES];
+                    uint16_t dist_codes[DIST_CODES];
+                    BuildCodes(litlen_lengths_, LITLEN_CODES, litlen_codes);
+                    BuildCodes(dist_lengths_, DIST_CODES, dist_codes);
+                    WriteSymbols(syms, litlen_codes, litlen_lengths_, dist_codes, dist_lengths_);
+                }
+            }
+
+            // Empty stored block: leaves the stream byte aligned without ending it.
+            void SyncFlush() {
+                writer_.Put(0, 3);
+                writer_.AlignToByte();
+                static const uint8_t marker[4] = { 0x00, 0x00, 0xFF, 0xFF };
+                writer_.PutBytes(marker, 4);
+            }
+
+        private:
+            void WriteStored(const uint8_t* raw, size_t raw_size) {
+                do {
+                    size_t chunk = std::min<size_t>(raw_size, 65535);
+                    writer_.Put(0, 3);
+                    writer_.AlignToByte();
+                    uint8_t header[4] = {
+                        static_cast<uint8_t>(chunk), static_cast<uint8_t>(chunk >> 8),
+                        static_cast<uint8_t>(~chunk), static_cast<uint8_t>(~chunk >> 8) };
+                    writer_.PutBytes(header, 4);
+                    writer_.PutBytes(raw, chunk);
+                    raw += chunk;
+                    raw_size -= chunk;
+                } while (raw_size > 0);
+            }
+
+            void WriteSymbols(const std::vector<Symbol>& syms,
+                const uint16_t* litlen_codes, const uint8_t* litlen_lengths,
+                const uint16_t* dist_codes, const uint8_t* dist_lengths) {
+                for (const Symbol& s : syms) {
+                    if (s.distance == 0) {
+                        writer_.Put(litlen_codes[s.length], litlen_lengths[s.length]);
+                        continue;
+                    }
+                    int lc = tables_.length_code[s.length];
+                    writer_.Put(litlen_codes[257 + lc], litlen_lengths[257 + lc]);
+                    if (LENGTH_EXTRA[lc])
+                        writer_.Put(s.length - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+                    int dc = DistCode(tables_, s.distance);
+                    writer_.Put(dist_codes[dc], dist_lengths[dc]);
+                    if (DIST_EXTRA[dc])
+                        writer_.Put(s.distance - DIST_BASE[dc], DIST_EXTRA[dc]);
+                }
+                writer_.Put(litlen_codes[END_OF_BLOCK], litlen_lengths[END_OF_BLOCK]);
+            }
+
+            // Run-length codes the two code length tables and builds the code
+            // length alphabet. Returns the header size in bits.
+            uint64_t BuildHeader() {
+                hlit_ = LITLEN_CODES;
+                while (hlit_ > 257 && litlen_lengths_[hlit_ - 1] == 0)
+                    --hlit_;
+                hdist_ = DIST_CODES;
+                while (hdist_ > 1 && dist_lengths_[hdist_ - 1] == 0)
+                    --hdist_;
+
+                uint8_t all[LITLEN_CODES + DIST_CODES];
+                std::memcpy(all, litlen_lengths_, hlit_);
+                std::memcpy(all + hlit_, dist_lengths_, hdist_);
+                const int total = hlit_ + hdist_;
+
+                runs_.clear();
+                uint32_t codelen_freq[CODELEN_CODES] = {};
+                for (int i = 0; i < total;) {
+                    uint8_t value = all[i];
+                    int run = 1;
+                    while (i + run < total && all[i + run] == value)
+                        ++run;
+                    i += run;
+                    if (value == 0) {
+                        while (run >= 11) {
+                            int n = std::min(run, 138);
+                            runs_.push_back({ 18, static_cast<uint8_t>(n - 11) });
+                            run -= n;
+                        }
+                        if (run >= 3) {
+                            runs_.push_back({ 17, static_cast<uint8_t>(run - 3) });
+                            run = 0;
+                        }
+                    }
+                    else {
+                        runs_.push_back({ value, 0 });
+                        --run;
+                        while (run >= 3) {
+                            int n = std::min(run, 6);
+                            runs_.push_back({ 16, static_cast<uint8_t>(n - 3) });
+                            run -= n;
+                        }
+                    }
+                    for (; run > 0; --run)
+                        runs_.push_back({ value, 0 });
+                }
+
+                uint64_t bits = 5 + 5 + 4;
+                for (const CodeLengthRun& r : runs_)
+                    codelen_freq[r.code]++;
+                BuildLengths(codelen_freq, CODELEN_CODES, 7, codelen_lengths_);
+                hclen_ = CODELEN_CODES;
+                while (hclen_ > 4 && codelen_lengths_[CODELEN_ORDER[hclen_ - 1]] == 0)
+                    --hclen_;
+                bits += 3 * hclen_;
+                for (const CodeLengthRun& r : runs_)
+                    bits += codelen_lengths_[r.code] + ExtraBits(r.code);
+                return bits;
+            }
+
+            void WriteHeader() {
+                uint16_t codelen_codes[CODELEN_CODES];
+                BuildCodes(codelen_lengths_, CODELEN_CODES, codelen_codes);
+                writer_.Put(hlit_ - 257, 5);
+                writer_.Put(hdist_ - 1, 5);
+                writer_.Put(hclen_ - 4, 4);
+                for (int i = 0; i < hclen_; ++i)
+                    writer_.Put(codelen_lengths_[CODELEN_ORDER[i]], 3);
+                for (const CodeLengthRun& r : runs_) {
+                    writer_.Put(codelen_codes[r.code], codelen_lengths_[r.code]);
+                    if (int extra = ExtraBits(r.code))
+                        writer_.Put(r.extra, extra);
+                }
+            }
+
+            static int ExtraBits(uint8_t code) {
+                return code == 16 ? 2 : code == 17 ? 3 : code == 18 ? 7 : 0;
+            }
+
+            struct CodeLengthRun {
+                uint8_t code;
+                uint8_t extra;
+            };
+
+            BitWriter& writer_;
+            const Tables& tables_;
+            uint8_t litlen_lengths_[LITLEN_CODES];
+            uint8_t dist_lengths_[DIST_CODES];
+            uint8_t codelen_lengths_[CODELEN_CODES];
+            int hlit_ = 0;
+            int hdist_ = 0;
+            int hclen_ = 0;
+            std::vector<CodeLengthRun> runs_;
+        };
+
+        inline uint32_t Hash4(const uint8_t* p) {
+            uint32_t v = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            return (v * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        inline int MatchLength(const uint8_t* a, const uint8_t* b, int limit) {
+            int len = 0;
+            while (len + 8 <= limit) {
+                uint64_t x, y;
+                std::memcpy(&x, a + len, 8);
+                std::memcpy(&y, b + len, 8);
+                if (x != y)
+                    break;
+                len += 8;
+            }
+            while (len < limit && a[len] == b[len])
+                ++len;
+            return len;
+        }
+
+        // Compresses data[begin, end) as non-final deflate blocks followed by a
+        // sync flush. Matches may refer back to the 32 KiB before begin.
+        class StripCompressor {
+        public:
+            explicit StripCompressor(const LevelParams& params)
+                : params_(params), head_(size_t(1) << HASH_BITS), prev_(WINDOW_SIZE) {}
+
+            void Compress(const uint8_t* data, size_t begin, size_t end, std::vector<uint8_t>& out) {
+                BitWriter bits(out);
+                BlockWriter blocks(bits);
+
+                // Positions are kept relative to the start of the preset window so
+                // they fit in int32 and -1 can mark an empty slot.
+                base_ = data + (begin > WINDOW_SIZE ? begin - WINDOW_SIZE : 0);
+                const int start = static_cast<int>(data + begin - base_);
+                const int limit = static_cast<int>(data + end - base_);
+                std::fill(head_.begin(), head_.end(), -1);
+                for (int p = 0; p < start; ++p)
+                    Insert(p, limit);
+
+                syms_.clear();
+                syms_.reserve(params_.block_symbols + 2);
+                int block_start = start;
+                auto flush_if_full = [&](int pos) {
+                    if (syms_.size() >= params_.block_symbols) {
+                        blocks.Write(syms_, base_ + block_start, pos - block_start);
+                        syms_.clear();
+                        block_start = pos;
+                    }
+                };
+
+                int p = start;
+                if (params_.lazy) {
+                    int prev_length = 0;
+                    int prev_distance = 0;
+                    bool pending_literal = false;
+                    while (p < limit) {
+                        int length = 0;
+                        int distance = 0;
+                        if (prev_length < params_.nice_length)
+                            length = FindMatch(p, limit, std::max(prev_length, MIN_MATCH - 1), distance);
+                        Insert(p, limit);
+
+                        if (prev_length >= MIN_MATCH && length <= prev_length) {
+                            // The match found one byte earlier wins.
+                            syms_.push_back({ static_cast<uint16_t>(prev_length), static_cast<uint16_t>(prev_distance) });
+                            int match_end = p - 1 + prev_length;
+                            for (++p; p < match_end; ++p)
+                                Insert(p, limit);
+                            prev_length = 0;
+                            pending_literal = false;
+                            flush_if_full(p);
+                            continue;
+                        }
+                        if (pending_literal) {
+                            syms_.push_back({ base_[p - 1], 0 });
+                            flush_if_full(p);
+                        }
+                        pending_literal = true;
+                        prev_length = length;
+                        prev_distance = distance;
+                        ++p;
+                    }
+                    if (pending_literal)
+                        syms_.push_back({ base_[p - 1], 0 });
+                }
+                else {
+                    // Long literal runs are searched more sparsely, as LZ4 does, so
+                    // incompressible rows do not cost a probe per byte.
+                    int misses = 0;
+                    while (p < limit) {
+                        int distance = 0;
+                        int length = FindMatch(p, limit, MIN_MATCH - 1, distance);
+                        Insert(p, limit);
+                        if (length >= MIN_MATCH) {
+                            syms_.push_back({ static_cast<uint16_t>(length), static_cast<uint16_t>(distance) });
+                            int match_end = p + length;
+                            if (params_.insert_all) {
+                                for (++p; p < match_end; ++p)
+                                    Insert(p, limit);
+                            }
+                            p = match_end;
+                            misses = 0;
+                        }
+                        else {
+                            int run_end = std::min(limit, p + 1 + (misses++ >> 6));
+                            for (; p < run_end; ++p)
+                                syms_.push_back({ base_[p], 0 });
+                        }
+                        flush_if_full(p);
+                    }
+                }
+
+                if (!syms_.empty() || block_start == start)
+                    blocks.Write(syms_, base_ + block_start, limit - block_start);
+                blocks.SyncFlush();
+            }
+
+        private:
+            void Insert(int p, int limit) {
+                if (p + MIN_MATCH > limit)
+                    return;
+                uint32_t h = Hash4(base_ + p);
+                prev_[p & WINDOW_MASK] = head_[h];
+                head_[h] = p;
+            }
+
+            // Longest match at p that beats best_length, searching at most
+            // max_chain candidates. Returns 0 if none does.
+            int FindMatch(int p, int limit, int best_length, int& distance) {
+                if (p + MIN_MATCH > limit)
+                    return 0;
+                const int max_length = std::min(MAX_MATCH, limit - p);
+                if (best_length >= max_length)
+                    return 0;
+                const int window_start = p > WINDOW_SIZE ? p - WINDOW_SIZE : 0;
+                const uint8_t* cur = base_ + p;
+                int candidate = head_[Hash4(cur)];
+                int found = 0;
+                int chain = best_length >= params_.good_length ? std::max(1, params_.max_chain >> 2) : params_.max_chain;
+                for (; chain > 0 && candidate >= window_start && candidate < p; --chain) {
+                    const uint8_t* match = base_ + candidate;
+                    if (match[best_length] == cur[best_length] && std::memcmp(match, cur, MIN_MATCH) == 0) {
+                        int length = MatchLength(match, cur, max_length);
+                        if (length > best_length) {
+                            best_length = length;
+                            distance = p - candidate;
+                            found = length;
+                            if (length >= params_.nice_length || length == max_length)
+                                break;
+                        }
+                    }
+                    candidate = prev_[candidate & WINDOW_MASK];
+                }
+                return found;
+            }
+
+            LevelParams params_;
+            const uint8_t* base_ = nullptr;
+            std::vector<int32_t> head_;
+            std::vector<int32_t> prev_;
+            std::vector<Symbol> syms_;
+        };
+
+        // ---- Strip scheduling ----
+
+        // Runs fn(index) for every index in [0, count), spread over all cores
+        // when cooperative is set.
+        template <typename Fn>
+        void ForEachStrip(size_t count, bool cooperative, Fn&& fn) {
+            std::atomic<size_t> next{ 0 };
+            auto run = [&]() {
+                for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+                    fn(i);
+            };
+            if (!cooperative || count < 2) {
+                run();
+                return;
+            }
+            unsigned int thread_count = static_cast<unsigned int>(
+                std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count));
+            std::vector<std::thread> helpers;
+            helpers.reserve(thread_count - 1);
+            for (unsigned int i = 1; i < thread_count; ++i)
+                helpers.emplace_back(run);
+            run();
+            for (auto& helper : helpers)
+                helper.join();
+        }
+
+        void PutU32BE(std::vector<uint8_t>& out, uint32_t v) {
+            uint8_t bytes[4] = {
+                static_cast<uint8_t>(v >> 24), static_cast<uint8_t>(v >> 16),
+                static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v) };
+            out.insert(out.end(), bytes, bytes + 4);
+        }
+
+        // Writes a chunk whose CRC is already known (computed over type + data).
+        void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size, uint32_t crc) {
+            PutU32BE(out, static_cast<uint32_t>(size));
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data, data + size);
+            PutU32BE(out, crc);
+        }
+
+        void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+            uint32_t crc = Crc32(Crc32(0, reinterpret_cast<const uint8_t*>(type), 4), data, size);
+            PutChunk(out, type, data, size, crc);
+        }
+    }
+
+    bool ParseLevel(const std::string& name, Level& level) {
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower == "fast") level = Level::Fast;
+        else if (lower == "default") level = Level::Default;
+        else if (lower == "best") level = Level::Best;
+        else return false;
+        return true;
+    }
+
+    const char* LevelName(Level level) {
+        switch (level) {
+        case Level::Fast: return "fast";
+        case Level::Best: return "best";
+        default: return "default";
+        }
+    }
+
+    bool EncodeRGBA(const uint8_t* rgba, int width, int height, Level level, std::vector<uint8_t>& out) {
+        if (!rgba || width <= 0 || height <= 0)
+            return false;
+
+        const LevelParams params = GetParams(level);
+        const size_t row_bytes = static_cast<size_t>(width) * BYTES_PER_PIXEL;
+        const size_t filtered_row = row_bytes + 1;
+        const size_t rows_per_strip = std::max<size_t>(1, STRIP_BYTES / filtered_row);
+        const size_t strip_count = (static_cast<size_t>(height) + rows_per_strip - 1) / rows_per_strip;
+
+        // Only one large image fans out at a time so concurrent extraction
+        // workers do not multiply the thread count.
+        static std::mutex wide_mutex;
+        std::unique_lock<std::mutex> wide_lock(wide_mutex, std::defer_lock);
+        bool cooperative = static_cast<size_t>(width) * height >= COOPERATIVE_MIN_PIXELS &&
+            std::thread::hardware_concurrency() > 1 && wide_lock.try_lock();
+
+        std::vector<uint8_t> filtered(filtered_row * height);
+        ForEachStrip(strip_count, cooperative, [&](size_t strip) {
+            std::vector<uint8_t> scratch;
+            size_t first = strip * rows_per_strip;
+            size_t last = std::min<size_t>(first + rows_per_strip, height);
+            for (size_t y = first; y < last; ++y) {
+                const uint8_t* row = rgba + y * row_bytes;
+                const uint8_t* prev = y > 0 ? row - row_bytes : nullptr;
+                uint8_t* dst = filtered.data() + y * filtered_row;
+                if (params.adaptive_filter) {
+                    FilterRowAdaptive(row, prev, row_bytes, dst, scratch);
+                }
+                else {
+                    dst[0] = prev ? 2 : 0;
+                    FilterRow(dst[0], row, prev, row_bytes, dst + 1);
+                }
+            }
+        });
+
+        // FLEVEL in the zlib header is informational; it mirrors zlib's levels.
+        const uint8_t zlib_header[2] = { 0x78, static_cast<uint8_t>(level == Level::Fast ? 0x01 : level == Level::Best ? 0xDA : 0x9C) };
+        static const uint8_t idat[4] = { 'I', 'D', 'A', 'T' };
+
+        struct Strip {
+            std::vector<uint8_t> data;
+            uint32_t crc = 0;
+            uint32_t adler = 1;
+            size_t raw_size = 0;
+        };
+        std::vector<Strip> strips(strip_count);
+        ForEachStrip(strip_count, cooperative, [&](size_t index) {
+            Strip& strip = strips[index];
+            size_t begin = index * rows_per_strip * filtered_row;
+            size_t end = std::min(begin + rows_per_strip * filtered_row, filtered.size());
+            strip.raw_size = end - begin;
+            strip.adler = Adler32(1, filtered.data() + begin, strip.raw_size);
+            strip.data.reserve(strip.raw_size + strip.raw_size / 64 + 256);
+            if (index == 0)
+                strip.data.assign(zlib_header, zlib_header + 2);
+            StripCompressor compressor(params);
+            compressor.Compress(filtered.data(), begin, end, strip.data);
+            strip.crc = Crc32(Crc32(0, idat, 4), strip.data.data(), strip.data.size());
+        });
+
+        uint32_t adler = 1;
+        size_t total = 8 + 25 + 12 + 6 + 12;
+        for (const Strip& strip : strips) {
+            adler = Adler32Combine(adler, strip.adler, strip.raw_size);
+            total += strip.data.size() + 12;
+        }
+        out.reserve(out.size() + total);
+
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        out.insert(out.end(), signature, signature + 8);
+
+        uint8_t ihdr[13] = {
+            static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16),
+            static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+            static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16),
+            static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+            8, 6, 0, 0, 0 };   // 8-bit RGBA, deflate, adaptive filtering, no interlace
+        PutChunk(out, "IHDR", ihdr, sizeof(ihdr));
+
+        for (const Strip& strip : strips)
+            PutChunk(out, "IDAT", strip.data.data(), strip.data.size(), strip.crc);
+
+        // Empty final fixed-Huffman block, then the Adler-32 of all filtered rows.
+        const uint8_t tail[6] = { 0x03, 0x00,
+            static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+            static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler) };
+        PutChunk(out, "IDAT", tail, sizeof(tail));
+        PutChunk(out, "IEND", nullptr, 0);
+        return true;
+    }
+}
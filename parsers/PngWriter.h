@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// PNG encoder for 8-bit RGBA images. Rows are filtered and deflated in fixed
+// strips that are joined into a single zlib stream, one IDAT chunk per strip.
+// Large images compress their strips in parallel; the strip layout depends only
+// on the image size, so the output is identical on any number of cores.
+namespace PngWriter {
+    enum class Level {
+        Fast,       // Up filter, single-probe greedy matching
+        Default,    // adaptive filters, short hash chains with lazy matching
+        Best        // adaptive filters, long hash chains, smaller Huffman blocks
+    };
+
+    // Accepts "fast", "default" and "best", case-insensitive.
+    bool ParseLevel(const std::string& name, Level& level);
+    const char* LevelName(Level level);
+
+    // Appends the encoded file to out, reserving the space up front.
+    // Returns false if the dimensions are invalid.
+    bool EncodeRGBA(const uint8_t* rgba, int width, int height, Level level, std::vector<uint8_t>& out);
+}
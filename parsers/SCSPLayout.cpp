@@ -0,0 +1,104 @@
+#include "SCSPLayout.h"
+
+namespace SCSPParser
+{
+    size_t FrameEntries(TimelineType type)
+    {
+        switch (type)
+        {
+        case TimelineType::Rotate:
+        case TimelineType::PathConstraintPosition:
+        case TimelineType::PathConstraintSpacing:
+            return 2;
+        case TimelineType::Translate:
+        case TimelineType::Scale:
+        case TimelineType::Shear:
+        case TimelineType::PathConstraintMix:
+            return 3;
+        case TimelineType::Color:
+        case TimelineType::TransformConstraint:
+            return 5;
+        case TimelineType::IkConstraint:
+            return 6;
+        case TimelineType::TwoColor:
+            return 8;
+        default:
+            return 1;
+        }
+    }
+
+    size_t CountFrames(const TimelineParts &parts)
+    {
+        size_t count = 0;
+        for (const Timeline *part : parts)
+            count += part->frames.size() / FrameEntries(part->type);
+        return count;
+    }
+
+    AnimationLayout LayoutAnimation(const Animation &animation)
+    {
+        AnimationLayout layout;
+        for (const Timeline &t : animation.timelines)
+        {
+            switch (t.type)
+            {
+            case TimelineType::Rotate:
+            case TimelineType::Translate:
+            case TimelineType::Scale:
+            case TimelineType::Shear:
+                layout.bones[t.target][t.type].push_back(&t);
+                break;
+            case TimelineType::Attachment:
+            case TimelineType::Color:
+            case TimelineType::TwoColor:
+                layout.slots[t.target][t.type].push_back(&t);
+                break;
+            case TimelineType::IkConstraint:
+                layout.ik[t.target].push_back(&t);
+                break;
+            case TimelineType::TransformConstraint:
+                layout.transform[t.target].push_back(&t);
+                break;
+            case TimelineType::PathConstraintPosition:
+            case TimelineType::PathConstraintSpacing:
+            case TimelineType::PathConstraintMix:
+                layout.paths[t.target][t.type].assign(1, &t);
+                break;
+            case TimelineType::Deform:
+                layout.deform[t.skin][t.target][t.attachment].push_back(&t);
+                break;
+            case TimelineType::DrawOrder:
+                if (!t.draw_order.empty())
+                    layout.draw_order = &t;
+                break;
+            case TimelineType::Event:
+                break;
+            }
+        }
+        return layout;
+    }
+
+    SkinLayout LayoutSkin(const Skin &skin)
+    {
+        SkinLayout layout;
+        for (const Attachment &a : skin.attachments)
+            layout[a.slot][a.name] = &a;
+        return layout;
+    }
+
+    OrderedGroups<const Event *> LayoutEvents(const std::vector<Event> &events)
+    {
+        OrderedGroups<const Event *> layout;
+        for (const Event &e : events)
+            layout[e.name] = &e;
+        return layout;
+    }
+
+    OrderedGroups<const Animation *> LayoutAnimations(const std::vector<Animation> &animations)
+    {
+        OrderedGroups<const Animation *> layout;
+        for (const Animation &a : animations)
+            layout[a.name] = &a;
+        return layout;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "SCSPParser.h"
+#include <stdexcept>
+#include <unordered_map>
+
+// How the Spine 3.8 loaders see a decoded skeleton: sections keyed and merged
+// the way the JSON export keys them, so every writer and builder resolves the
+// same names to the same entries.
+namespace SCSPParser {
+    // Name to index, first entry wins like SkeletonData::find*.
+    class NameIndex {
+    public:
+        void add(const std::string& name, int index) { names.emplace(name, index); }
+
+        int find(const std::string& name) const
+        {
+            auto it = names.find(name);
+            return it == names.end() ? -1 : it->second;
+        }
+
+        int require(const std::string& name, const char* what) const
+        {
+            int index = find(name);
+            if (index < 0)
+                throw std::runtime_error(std::string(what) + " not found: " + name);
+            return index;
+        }
+
+    private:
+        std::unordered_map<std::string, int> names;
+    };
+
+    // Values keyed in order of first appearance, the way assigning into the
+    // export's ordered JSON objects keys them.
+    template <typename T, typename Key = std::string>
+    class OrderedGroups {
+    public:
+        T& operator[](const Key& key)
+        {
+            auto [it, inserted] = index.emplace(key, groups.size());
+            if (inserted)
+                groups.emplace_back(key, T());
+            return groups[it->second].second;
+        }
+
+        const T* find(const Key& key) const
+        {
+            auto it = index.find(key);
+            return it == index.end() ? nullptr : &groups[it->second].second;
+        }
+
+        size_t size() const { return groups.size(); }
+        auto begin() const { return groups.begin(); }
+        auto end() const { return groups.end(); }
+
+    private:
+        std::vector<std::pair<Key, T>> groups;
+        std::unordered_map<Key, size_t> index;
+    };
+
+    // SCSP timelines that together animate one property; their frames are
+    // concatenated, as the export does.
+    using TimelineParts = std::vector<const Timeline*>;
+    using TypedTimelines = OrderedGroups<TimelineParts, TimelineType>;
+
+    // Values per keyframe in Timeline::frames, the time included.
+    size_t FrameEntries(TimelineType type);
+    size_t CountFrames(const TimelineParts& parts);
+
+    // Calls visit(frame, values, part, i, curve) for every keyframe in order.
+    // curve is the curve to the next keyframe, or null where the runtime keeps
+    // it linear: past the part's curves and after the last frame.
+    template <typename Visit>
+    void ForEachFrame(const TimelineParts& parts, Visit visit)
+    {
+        size_t count = CountFrames(parts);
+        size_t frame = 0;
+        for (const Timeline* part : parts)
+        {
+            size_t entries = FrameEntries(part->type);
+            for (size_t i = 0; i < part->frames.size() / entries; i++, frame++)
+            {
+                const Curve* curve = frame + 1 < count && i < part->curves.size() ? &part->curves[i] : nullptr;
+                visit(frame, part->frames.data() + i * entries, *part, i, curve);
+            }
+        }
+    }
+
+    struct AnimationLayout {
+        // Slot name, then attachment, color or twoColor.
+        OrderedGroups<TypedTimelines> slots;
+        // Bone name, then rotate, translate, scale or shear.
+        OrderedGroups<TypedTimelines> bones;
+        OrderedGroups<TimelineParts> ik;
+        OrderedGroups<TimelineParts> transform;
+        // Constraint name, then position, spacing or mix; the last one wins.
+        OrderedGroups<TypedTimelines> paths;
+        // Skin, slot, then attachment name.
+        OrderedGroups<OrderedGroups<OrderedGroups<TimelineParts>>> deform;
+        // The last draw order timeline with keys.
+        const Timeline* draw_order = nullptr;
+    };
+
+    AnimationLayout LayoutAnimation(const Animation& animation);
+
+    // Attachments by slot, then by name; a later attachment with the same name
+    // replaces the earlier one.
+    using SkinLayout = OrderedGroups<OrderedGroups<const Attachment*>>;
+    SkinLayout LayoutSkin(const Skin& skin);
+
+    // Events and animations by name; a later one replaces the earlier in place.
+    OrderedGroups<const Event*> LayoutEvents(const std::vector<Event>& events);
+    OrderedGroups<const Animation*> LayoutAnimations(const std::vector<Animation>& animations);
+}
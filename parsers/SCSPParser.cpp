@@ -1,10 +1,20 @@
 #include "SCSPParser.h"
+#include "SCSPLayout.h"
+#include "core/JsonString.h"
+#include "core/LZ4.h"
 #include "json.hpp"
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cmath>
+#include <deque>
 #include <map>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
 using json = nlohmann::ordered_json;
 
@@ -30,16 +40,21 @@ namespace
         return val;
     }
 
-    std::string read_cstr(const uint8_t *buf, size_t start, size_t end)
+    std::string_view read_cstr_view(const uint8_t *buf, size_t start, size_t end)
     {
         if (start >= end)
-            return "";
+            return {};
         size_t len = 0;
         while (start + len < end && buf[start + len] != 0)
         {
             len++;
         }
-        return std::string(reinterpret_cast<const char *>(buf + start), len);
+        return std::string_view(reinterpret_cast<const char *>(buf + start), len);
+    }
+
+    std::string read_cstr(const uint8_t *buf, size_t start, size_t end)
+    {
+        return std::string(read_cstr_view(buf, start, end));
     }
 
     std::string rgba_to_hex(float r, float g, float b, float a)
@@ -77,6 +92,60 @@ namespace
 
     using AttachmentMetaMap = std::map<std::tuple<std::string, int, std::string>, AttachmentMeta>;
 
+    // Names by the index the file refers to them with, in a flat array.
+    // Names read from the string table are views into the decompressed
+    // buffer, which must outlive the table; names made up for unnamed
+    // entries are copied into the table.
+    template <typename Index>
+    class NameTable
+    {
+    public:
+        NameTable() = default;
+        NameTable(const NameTable &) = delete;
+        NameTable &operator=(const NameTable &) = delete;
+
+        void set(Index index, std::string_view name)
+        {
+            size_t slot = to_slot(index);
+            if (slot >= names.size())
+                names.resize(slot + 1);
+            if (!names[slot])
+                ++count;
+            names[slot] = name;
+        }
+
+        void set_copy(Index index, std::string name)
+        {
+            set(index, made.emplace_back(std::move(name)));
+        }
+
+        // Null when nothing was set at index.
+        const std::string_view *find(Index index) const
+        {
+            size_t slot = to_slot(index);
+            return slot < names.size() && names[slot] ? &*names[slot] : nullptr;
+        }
+
+        // The name at index, or prefix followed by the index as given.
+        template <typename Number>
+        std::string name_or(Number index, const char *prefix) const
+        {
+            const std::string_view *name = find(static_cast<Index>(index));
+            return name ? std::string(*name) : prefix + std::to_string(index);
+        }
+
+        size_t size() const { return count; }
+
+    private:
+        // Negative indices land past the positive ones, as they would
+        // reinterpreted as unsigned.
+        static size_t to_slot(Index index) { return static_cast<std::make_unsigned_t<Index>>(index); }
+
+        std::vector<std::optional<std::string_view>> names;
+        std::deque<std::string> made; // never reallocates, so views stay valid
+        size_t count = 0;
+    };
+
     void ParseAssignVertexAttachment(const uint8_t *buf, size_t buf_size, size_t &pos,
                                      size_t strings_base, size_t strings_end,
                                      std::vector<int16_t> &out_bones,
@@ -142,12 +211,17 @@ namespace
         return arr;
     }
 
-    bool bezier_from_spine_block(const std::vector<float> &block,
-                                 float &cx1, float &cy1, float &cx2, float &cy2)
+    // Advances pos as read_f32_array would, stopping at the end of the buffer.
+    void skip_f32_array(size_t buf_size, size_t &pos, int count)
     {
-        if (block.size() < 19)
-            return false;
+        size_t available = pos < buf_size ? (buf_size - pos) / 4 : 0;
+        pos += 4 * std::min<size_t>(count, available);
+    }
 
+    // block holds the 19 floats of one curve: its type and nine sampled points.
+    bool bezier_from_spine_block(const float *block,
+                                 float &cx1, float &cy1, float &cx2, float &cy2)
+    {
         float x0 = block[1], y0 = block[2];
         float x1 = block[3], y1 = block[4];
         float x2 = block[5], y2 = block[6];
@@ -194,97 +268,273 @@ namespace
         return std::round(value * multiplier) / multiplier;
     }
 
-    void maybe_add_curve(int i, const std::vector<float> &curves, json &frame)
+    std::vector<SCSPParser::Curve> read_curves(const std::vector<float> &blocks, int frame_count)
     {
-        size_t start = i * 19;
-        size_t end = start + 19;
-        if (end <= curves.size())
+        std::vector<SCSPParser::Curve> curves;
+        for (size_t i = 0; i < (size_t)frame_count && (i + 1) * 19 <= blocks.size(); i++)
         {
-            std::vector<float> b(curves.begin() + start, curves.begin() + end);
+            const float *b = blocks.data() + i * 19;
+            SCSPParser::Curve curve;
             if (b[0] == 1.0f)
             {
-                frame["curve"] = "stepped";
+                curve.type = SCSPParser::Curve::Stepped;
             }
             else if (b[0] == 2.0f)
             {
                 float cx1, cy1, cx2, cy2;
                 if (bezier_from_spine_block(b, cx1, cy1, cx2, cy2))
                 {
-                    frame["curve"] = round_float(cx1);
-                    frame["c2"] = round_float(cy1);
-                    frame["c3"] = round_float(cx2);
-                    frame["c4"] = round_float(cy2);
+                    curve.type = SCSPParser::Curve::Bezier;
+                    curve.cx1 = round_float(cx1);
+                    curve.cy1 = round_float(cy1);
+                    curve.cx2 = round_float(cx2);
+                    curve.cy2 = round_float(cy2);
                 }
             }
+            curves.push_back(curve);
         }
+        return curves;
     }
-}
-
-namespace SCSPParser
-{
 
-    // LZ4 Decompression (block format)
-    std::vector<uint8_t> LZ4DecompressBlock(const uint8_t *src, size_t src_size, size_t uncompressed_size)
+    // Streams JSON laid out byte for byte as nlohmann::json's dump(4) prints
+    // it, so the export never builds a document: keys and values go straight
+    // into the output in the order they are written.
+    class JsonWriter
     {
-        std::vector<uint8_t> out;
-        out.reserve(uncompressed_size);
+    public:
+        explicit JsonWriter(std::string &out) : out(out) {}
+
+        // Appends what is still buffered to the output.
+        void flush()
+        {
+            out.append(buffer, used);
+            used = 0;
+        }
+
+        void begin_object() { open('{'); }
+        void end_object() { close('}'); }
+        void begin_array() { open('['); }
+        void end_array() { close(']'); }
+
+        void key(std::string_view name)
+        {
+            next();
+            put_string(name);
+            put(": ");
+            after_key = true;
+        }
+
+        void value(std::string_view text)
+        {
+            next();
+            put_string(text);
+        }
+
+        void value(const char *text) { value(std::string_view(text)); }
+
+        void value(bool b)
+        {
+            next();
+            put(b ? "true" : "false");
+        }
 
-        size_t i = 0;
-        while (i < src_size)
+        void value(std::nullptr_t)
         {
-            uint8_t token = src[i++];
+            next();
+            put("null");
+        }
 
-            size_t lit_len = token >> 4;
-            if (lit_len == 15)
+        // Floats are widened to double first, as assigning them to a json does.
+        void value(float f) { value(static_cast<double>(f)); }
+
+        void value(double d)
+        {
+            next();
+            if (!std::isfinite(d))
             {
-                uint8_t b = 255;
-                while (i < src_size && b == 255)
-                {
-                    b = src[i++];
-                    lit_len += b;
-                }
+                put("null");
+                return;
+            }
+            char buf[64];
+            char *end;
+            // Whole numbers, common in setup poses and keys, skip the shortest
+            // digit search; dump() prints them the same way, as n.0.
+            long long whole = std::abs(d) < 1e15 ? static_cast<long long>(d) : 0;
+            if (static_cast<double>(whole) == d)
+            {
+                end = buf;
+                if (whole == 0 && std::signbit(d))
+                    *end++ = '-';
+                end = std::to_chars(end, buf + sizeof(buf), whole).ptr;
+                *end++ = '.';
+                *end++ = '0';
             }
+            else
+                end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), d);
+            put(std::string_view(buf, static_cast<size_t>(end - buf)));
+        }
+
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+        void value(T n)
+        {
+            next();
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), n);
+            put(std::string_view(buf, static_cast<size_t>(result.ptr - buf)));
+        }
+
+        template <typename T>
+        void value(const std::vector<T> &values)
+        {
+            begin_array();
+            for (const T &v : values)
+                value(v);
+            end_array();
+        }
+
+        template <typename T>
+        void field(std::string_view name, const T &v)
+        {
+            key(name);
+            value(v);
+        }
 
-            if (lit_len > 0)
+    private:
+        // Separates a value from the one before it, unless it follows its key.
+        void next()
+        {
+            if (after_key)
             {
-                if (i + lit_len > src_size)
-                    break;
-                out.insert(out.end(), src + i, src + i + lit_len);
-                i += lit_len;
-                if (i >= src_size)
-                    break;
+                after_key = false;
+                return;
             }
+            if (open_items.empty())
+                return;
+            if (open_items.back())
+                put(',');
+            open_items.back() = true;
+            new_line();
+        }
 
-            if (i + 2 > src_size)
-                break;
-            uint16_t offset = src[i] | (src[i + 1] << 8);
-            i += 2;
-            if (offset == 0)
-                break;
+        void open(char bracket)
+        {
+            next();
+            put(bracket);
+            open_items.push_back(false);
+        }
+
+        void close(char bracket)
+        {
+            bool items = open_items.back();
+            open_items.pop_back();
+            if (items)
+                new_line();
+            put(bracket);
+        }
+
+        // A line break indented to the open containers, four spaces each.
+        void new_line()
+        {
+            static constexpr std::string_view LINE = "\n                                                                ";
+            size_t indent = open_items.size() * 4;
+            put(LINE.substr(0, 1 + std::min(indent, LINE.size() - 1)));
+            for (size_t written = LINE.size() - 1; written < indent; written += LINE.size() - 1)
+                put(LINE.substr(1, std::min(indent - written, LINE.size() - 1)));
+        }
 
-            size_t match_len = (token & 0x0F) + 4;
-            if ((token & 0x0F) == 15)
+        // Invalid UTF-8 is left to nlohmann::json to reject, so it fails the
+        // export with the same error.
+        void put_string(std::string_view text)
+        {
+            if (!Core::PutJsonString(text, Core::InvalidUtf8::Reject, [this](std::string_view piece) { put(piece); }))
+                json(std::string(text)).dump();
+        }
+
+        // Small writes gather here and reach the output in large appends.
+        void put(std::string_view text)
+        {
+            if (text.size() > sizeof(buffer) - used)
             {
-                uint8_t b = 255;
-                while (i < src_size && b == 255)
+                flush();
+                if (text.size() > sizeof(buffer))
                 {
-                    b = src[i++];
-                    match_len += b;
+                    out.append(text);
+                    return;
                 }
             }
+            std::memcpy(buffer + used, text.data(), text.size());
+            used += text.size();
+        }
 
-            size_t start = out.size() - offset;
-            for (size_t j = 0; j < match_len; j++)
-            {
-                out.push_back(out[start + j]);
-            }
+        void put(char c)
+        {
+            if (used == sizeof(buffer))
+                flush();
+            buffer[used++] = c;
+        }
+
+        std::string &out;
+        char buffer[1 << 16];
+        size_t used = 0;
+        // Whether each open object or array has a value yet.
+        std::vector<bool> open_items;
+        bool after_key = false;
+    };
+
+    void write_curve(JsonWriter &out, const std::vector<SCSPParser::Curve> &curves, size_t i)
+    {
+        if (i >= curves.size())
+            return;
+        const SCSPParser::Curve &curve = curves[i];
+        if (curve.type == SCSPParser::Curve::Stepped)
+        {
+            out.field("curve", "stepped");
+        }
+        else if (curve.type == SCSPParser::Curve::Bezier)
+        {
+            out.field("curve", curve.cx1);
+            out.field("c2", curve.cy1);
+            out.field("c3", curve.cx2);
+            out.field("c4", curve.cy2);
+        }
+    }
+
+    // Weighted vertices are written as Spine JSON lists them: per vertex its
+    // bone count, then bone index, x, y and weight for each bone.
+    void write_vertices(JsonWriter &out, const std::vector<int16_t> &bones, const std::vector<float> &verts)
+    {
+        if (bones.empty())
+        {
+            out.value(verts);
+            return;
         }
 
-        if (out.size() > uncompressed_size)
+        out.begin_array();
+        size_t i = 0, vf = 0;
+        while (i < bones.size())
         {
-            out.resize(uncompressed_size);
+            int c = bones[i++];
+            out.value(c);
+            for (int k = 0; k < c && i < bones.size() && vf + 3 <= verts.size(); k++)
+            {
+                out.value(bones[i++]);
+                out.value(verts[vf++]);
+                out.value(verts[vf++]);
+                out.value(verts[vf++]);
+            }
         }
+        out.end_array();
+    }
+}
+
+namespace SCSPParser
+{
 
+    // LZ4 Decompression (block format)
+    std::vector<uint8_t> LZ4DecompressBlock(const uint8_t *src, size_t src_size, size_t uncompressed_size)
+    {
+        std::vector<uint8_t> out(uncompressed_size);
+        out.resize(Core::LZ4DecodeBlock(src, src_size, out.data(), out.size()));
         return out;
     }
 
@@ -308,6 +558,11 @@ namespace SCSPParser
             throw std::runtime_error("Compressed block exceeds file size");
         }
 
+        if (static_cast<uint64_t>(dec_len) > static_cast<uint64_t>(comp_len) * 255 + 16)
+        {
+            throw std::runtime_error("Invalid SCSP decompressed size");
+        }
+
         return LZ4DecompressBlock(data.data() + 8, comp_len, dec_len);
     }
 
@@ -365,21 +620,17 @@ namespace SCSPParser
         return hdr;
     }
 
-    json ParseBones(const uint8_t *buf, size_t buf_size, size_t &pos,
-                    size_t strings_base, size_t strings_end,
-                    std::map<int16_t, std::string> &bone_names)
+    std::vector<Bone> ParseBones(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                 size_t strings_base, size_t strings_end,
+                                 NameTable<int16_t> &bone_names)
     {
-
+        std::vector<Bone> bones;
         if (pos + 2 > buf_size)
-            return json::array();
+            return bones;
 
         uint16_t count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json bones = json::array();
-        std::map<int16_t, std::string> transform_modes = {
-            {0, "normal"}, {1, "onlyTranslation"}, {2, "noRotationOrReflection"}, {3, "noScale"}, {4, "noScaleOrReflection"}};
-
         for (uint16_t i = 0; i < count; i++)
         {
             if (pos + 6 > buf_size)
@@ -414,71 +665,52 @@ namespace SCSPParser
             bool skin = buf[pos] != 0;
             pos += 1;
 
-            std::string name;
+            std::string_view name;
             if (name_rel != 0xFFFFFFFF && strings_base + name_rel < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_rel, strings_end);
+                name = read_cstr_view(buf, strings_base + name_rel, strings_end);
             }
 
             if (name.empty())
                 continue;
 
-            bone_names[index] = name;
-
-            json bone;
-            bone["name"] = name;
-
-            if (parent >= 0 && bone_names.count(parent))
-            {
-                bone["parent"] = bone_names[parent];
-            }
+            bone_names.set(index, name);
 
-            if (length != 0.0f)
-                bone["length"] = length;
-            if (x != 0.0f)
-                bone["x"] = x;
-            if (y != 0.0f)
-                bone["y"] = y;
-            if (rot != 0.0f)
-                bone["rotation"] = rot;
-            if (sx != 1.0f)
-                bone["scaleX"] = sx;
-            if (sy != 1.0f)
-                bone["scaleY"] = sy;
-            if (shx != 0.0f)
-                bone["shearX"] = shx;
-            if (shy != 0.0f)
-                bone["shearY"] = shy;
-
-            if (transform_modes.count(tmode))
+            Bone bone;
+            bone.name = name;
+            if (parent >= 0 && bone_names.find(parent))
             {
-                bone["transform"] = transform_modes[tmode];
+                bone.parent = *bone_names.find(parent);
             }
-            if (skin)
-                bone["skin"] = true;
-
-            bones.push_back(bone);
+            bone.length = length;
+            bone.x = x;
+            bone.y = y;
+            bone.rotation = rot;
+            bone.scale_x = sx;
+            bone.scale_y = sy;
+            bone.shear_x = shx;
+            bone.shear_y = shy;
+            bone.transform_mode = tmode;
+            bone.skin_required = skin;
+
+            bones.push_back(std::move(bone));
         }
 
         return bones;
     }
 
-    json ParseSlots(const uint8_t *buf, size_t buf_size, size_t &pos,
-                    size_t strings_base, size_t strings_end,
-                    const std::map<int16_t, std::string> &bone_names,
-                    std::map<int16_t, std::string> &slot_names)
+    std::vector<Slot> ParseSlots(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                 size_t strings_base, size_t strings_end,
+                                 const NameTable<int16_t> &bone_names,
+                                 NameTable<int16_t> &slot_names)
     {
-
+        std::vector<Slot> slots;
         if (pos + 2 > buf_size)
-            return json::array();
+            return slots;
 
         uint16_t count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json slots = json::array();
-        std::map<uint16_t, std::string> blend_modes = {
-            {0, "normal"}, {1, "additive"}, {2, "multiply"}, {3, "screen"}};
-
         for (uint16_t i = 0; i < count; i++)
         {
             if (pos + 2 > buf_size)
@@ -492,10 +724,10 @@ namespace SCSPParser
             uint32_t name_rel = read_le<uint32_t>(buf, pos);
             pos += 4;
 
-            std::string name;
+            std::string_view name;
             if (name_rel != 0xFFFFFFFF && strings_base + name_rel < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_rel, strings_end);
+                name = read_cstr_view(buf, strings_base + name_rel, strings_end);
             }
 
             if (pos + 2 > buf_size)
@@ -503,29 +735,26 @@ namespace SCSPParser
             int16_t bone_idx = read_le<int16_t>(buf, pos);
             pos += 2;
 
-            std::string bone_name;
-            if (bone_names.count(bone_idx))
+            std::string_view bone_name;
+            if (const std::string_view *found = bone_names.find(bone_idx))
             {
-                bone_name = bone_names.at(bone_idx);
+                bone_name = *found;
             }
 
             if (pos + 32 > buf_size)
                 break;
-            float cr = read_le<float>(buf, pos + 0);
-            float cg = read_le<float>(buf, pos + 4);
-            float cb = read_le<float>(buf, pos + 8);
-            float ca = read_le<float>(buf, pos + 12);
+            Slot slot;
+            for (int c = 0; c < 4; c++)
+                slot.color[c] = read_le<float>(buf, pos + c * 4);
             pos += 16;
 
-            float dr = read_le<float>(buf, pos + 0);
-            float dg = read_le<float>(buf, pos + 4);
-            float db = read_le<float>(buf, pos + 8);
-            float da = read_le<float>(buf, pos + 12);
+            for (int c = 0; c < 3; c++)
+                slot.dark[c] = read_le<float>(buf, pos + c * 4);
             pos += 16;
 
             if (pos + 1 > buf_size)
                 break;
-            bool hasDark = buf[pos] != 0;
+            slot.has_dark = buf[pos] != 0;
             pos += 1;
 
             if (pos + 4 > buf_size)
@@ -535,72 +764,43 @@ namespace SCSPParser
 
             if (pos + 2 > buf_size)
                 break;
-            uint16_t blend_raw = read_le<uint16_t>(buf, pos);
+            slot.blend_mode = read_le<uint16_t>(buf, pos);
             pos += 2;
 
-            std::string attachment;
             if (attach_rel != 0xFFFFFFFF && strings_base + attach_rel < strings_end)
             {
-                attachment = read_cstr(buf, strings_base + attach_rel, strings_end);
+                slot.attachment = read_cstr(buf, strings_base + attach_rel, strings_end);
             }
 
             if (name.empty())
             {
-                name = "slot" + std::to_string(slot_index);
-            }
-
-            slot_names[slot_index] = name;
-
-            json slot;
-            slot["name"] = name;
-            slot["bone"] = bone_name;
-
-            std::string col_hex = rgba_to_hex(cr, cg, cb, ca);
-            if (col_hex != "FFFFFFFF")
-            {
-                slot["color"] = col_hex;
-            }
-
-            if (hasDark)
-            {
-                slot["dark"] = rgb_to_hex(dr, dg, db);
-            }
-
-            if (!attachment.empty())
-            {
-                slot["attachment"] = attachment;
-            }
-
-            std::string blend = "normal";
-            if (blend_modes.count(blend_raw))
-            {
-                blend = blend_modes[blend_raw];
+                slot.name = "slot" + std::to_string(slot_index);
+                slot_names.set_copy(slot_index, slot.name);
             }
-            if (blend != "normal")
+            else
             {
-                slot["blend"] = blend;
+                slot.name = name;
+                slot_names.set(slot_index, name);
             }
-
-            slots.push_back(slot);
+            slot.bone = bone_name;
+            slots.push_back(std::move(slot));
         }
 
         return slots;
     }
 
-    json ParseIKConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
-                            size_t strings_base, size_t strings_end,
-                            const std::map<int16_t, std::string> &bone_names,
-                            std::map<int, std::string> &ik_names)
+    std::vector<IkConstraint> ParseIKConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                                 size_t strings_base, size_t strings_end,
+                                                 const NameTable<int16_t> &bone_names,
+                                                 NameTable<int> &ik_names)
     {
-
+        std::vector<IkConstraint> iks;
         if (pos + 2 > buf_size)
-            return json::array();
+            return iks;
 
         uint16_t count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json iks = json::array();
-
         for (int i = 0; i < count; i++)
         {
             if (pos + 4 > buf_size)
@@ -608,59 +808,60 @@ namespace SCSPParser
 
             uint32_t name_rel = read_le<uint32_t>(buf, pos);
             pos += 4;
-            std::string name;
+            std::string_view name;
             if (name_rel != 0xFFFFFFFF && strings_base + name_rel < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_rel, strings_end);
+                name = read_cstr_view(buf, strings_base + name_rel, strings_end);
             }
-            if (name.empty())
-                name = "ik" + std::to_string(i);
+
+            IkConstraint ik;
+            ik.name = name.empty() ? "ik" + std::to_string(i) : std::string(name);
 
             if (pos + 4 > buf_size)
                 break;
-            uint32_t order = read_le<uint32_t>(buf, pos);
+            ik.order = (int)read_le<uint32_t>(buf, pos);
             pos += 4;
 
             if (pos + 1 > buf_size)
                 break;
-            bool skinRequired = buf[pos] != 0;
+            ik.skin_required = buf[pos] != 0;
             pos += 1;
 
             if (pos + 4 > buf_size)
                 break;
             int32_t bendDirection = read_le<int32_t>(buf, pos);
             pos += 4;
+            ik.bend_positive = bendDirection >= 0;
 
             if (pos + 1 > buf_size)
                 break;
-            bool compress = buf[pos] != 0;
+            ik.compress = buf[pos] != 0;
             pos += 1;
 
             if (pos + 8 > buf_size)
                 break;
-            float mix = read_le<float>(buf, pos);
+            ik.mix = read_le<float>(buf, pos);
             pos += 4;
-            float softness = read_le<float>(buf, pos);
+            ik.softness = read_le<float>(buf, pos);
             pos += 4;
 
             if (pos + 1 > buf_size)
                 break;
-            bool stretch = buf[pos] != 0;
+            ik.stretch = buf[pos] != 0;
             pos += 1;
 
             if (pos + 1 > buf_size)
                 break;
-            bool uniform = buf[pos] != 0;
+            ik.uniform = buf[pos] != 0;
             pos += 1;
 
             if (pos + 2 > buf_size)
                 break;
             int16_t t_idx = read_le<int16_t>(buf, pos);
             pos += 2;
-            std::string target_name;
-            if (t_idx >= 0 && bone_names.count(t_idx))
+            if (t_idx >= 0 && bone_names.find(t_idx))
             {
-                target_name = bone_names.at(t_idx);
+                ik.target = *bone_names.find(t_idx);
             }
 
             if (pos + 2 > buf_size)
@@ -668,56 +869,40 @@ namespace SCSPParser
             uint16_t nb = read_le<uint16_t>(buf, pos);
             pos += 2;
 
-            json bnames = json::array();
             for (uint16_t j = 0; j < nb; j++)
             {
                 if (pos + 2 > buf_size)
                     break;
                 int16_t bidx = read_le<int16_t>(buf, pos);
                 pos += 2;
-                if (bidx >= 0 && bone_names.count(bidx))
+                if (bidx >= 0 && bone_names.find(bidx))
                 {
-                    bnames.push_back(bone_names.at(bidx));
+                    ik.bones.emplace_back(*bone_names.find(bidx));
                 }
             }
 
-            json ik;
-            ik["name"] = name;
-            ik["order"] = (int)order;
-            ik["skin"] = skinRequired;
-            ik["bones"] = bnames;
-            ik["target"] = target_name;
-            ik["mix"] = mix;
-            ik["softness"] = softness;
-            ik["bendPositive"] = (bendDirection >= 0);
-            if (compress)
-                ik["compress"] = true;
-            if (stretch)
-                ik["stretch"] = true;
-            if (uniform)
-                ik["uniform"] = true;
-
-            ik_names[i] = name;
-            iks.push_back(ik);
+            if (name.empty())
+                ik_names.set_copy(i, ik.name);
+            else
+                ik_names.set(i, name);
+            iks.push_back(std::move(ik));
         }
 
         return iks;
     }
 
-    json ParseTransformConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
-                                   size_t strings_base, size_t strings_end,
-                                   const std::map<int16_t, std::string> &bone_names,
-                                   std::map<int, std::string> &transform_names)
+    std::vector<TransformConstraint> ParseTransformConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                                               size_t strings_base, size_t strings_end,
+                                                               const NameTable<int16_t> &bone_names,
+                                                               NameTable<int> &transform_names)
     {
-
+        std::vector<TransformConstraint> transforms;
         if (pos + 2 > buf_size)
-            return json::array();
+            return transforms;
 
         uint16_t count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json transforms = json::array();
-
         for (int i = 0; i < count; i++)
         {
             if (pos + 4 > buf_size)
@@ -725,65 +910,57 @@ namespace SCSPParser
 
             uint32_t name_off = read_le<uint32_t>(buf, pos);
             pos += 4;
-            std::string name;
+            std::string_view name;
             if (name_off != 0xFFFFFFFF && strings_base + name_off < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_off, strings_end);
+                name = read_cstr_view(buf, strings_base + name_off, strings_end);
             }
-            if (name.empty())
-                name = "transform" + std::to_string(i);
+
+            TransformConstraint tr;
+            tr.name = name.empty() ? "transform" + std::to_string(i) : std::string(name);
 
             if (pos + 4 > buf_size)
                 break;
-            uint32_t order = read_le<uint32_t>(buf, pos);
+            tr.order = (int)read_le<uint32_t>(buf, pos);
             pos += 4;
 
             if (pos + 1 > buf_size)
                 break;
-            bool skin_req = buf[pos] != 0;
+            tr.skin_required = buf[pos] != 0;
             pos += 1;
 
             if (pos + 44 > buf_size)
                 break;
-            float rotateMix = read_le<float>(buf, pos);
-            pos += 4;
-            float translateMix = read_le<float>(buf, pos);
-            pos += 4;
-            float scaleMix = read_le<float>(buf, pos);
-            pos += 4;
-            float shearMix = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetRotation = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetX = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetY = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetScaleX = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetScaleY = read_le<float>(buf, pos);
-            pos += 4;
-            float offsetShearY = read_le<float>(buf, pos);
-            pos += 4;
+            tr.rotate_mix = read_le<float>(buf, pos);
+            tr.translate_mix = read_le<float>(buf, pos + 4);
+            tr.scale_mix = read_le<float>(buf, pos + 8);
+            tr.shear_mix = read_le<float>(buf, pos + 12);
+            tr.rotation = read_le<float>(buf, pos + 16);
+            tr.x = read_le<float>(buf, pos + 20);
+            tr.y = read_le<float>(buf, pos + 24);
+            tr.scale_x = read_le<float>(buf, pos + 28);
+            tr.scale_y = read_le<float>(buf, pos + 32);
+            tr.shear_y = read_le<float>(buf, pos + 36);
+            pos += 40;
 
             if (pos + 1 > buf_size)
                 break;
-            bool isRelative = buf[pos] != 0;
+            tr.relative = buf[pos] != 0;
             pos += 1;
 
             if (pos + 1 > buf_size)
                 break;
-            bool isLocal = buf[pos] != 0;
+            tr.local = buf[pos] != 0;
             pos += 1;
 
             if (pos + 2 > buf_size)
                 break;
             int16_t tgt = read_le<int16_t>(buf, pos);
             pos += 2;
-            std::string tgt_name = "root";
-            if (tgt >= 0 && bone_names.count(tgt))
+            tr.target = "root";
+            if (tgt >= 0 && bone_names.find(tgt))
             {
-                tgt_name = bone_names.at(tgt);
+                tr.target = *bone_names.find(tgt);
             }
 
             if (pos + 2 > buf_size)
@@ -791,67 +968,45 @@ namespace SCSPParser
             uint16_t bc = read_le<uint16_t>(buf, pos);
             pos += 2;
 
-            json blist = json::array();
             for (uint16_t j = 0; j < bc; j++)
             {
                 if (pos + 2 > buf_size)
                     break;
                 int16_t bi = read_le<int16_t>(buf, pos);
                 pos += 2;
-                if (bi >= 0 && bone_names.count(bi))
+                if (bi >= 0 && bone_names.find(bi))
                 {
-                    blist.push_back(bone_names.at(bi));
+                    tr.bones.emplace_back(*bone_names.find(bi));
                 }
                 else
                 {
-                    blist.push_back("root");
+                    tr.bones.push_back("root");
                 }
             }
 
-            json tr;
-            tr["name"] = name;
-            tr["order"] = (int)order;
-            tr["skin"] = skin_req;
-            tr["target"] = tgt_name;
-            tr["bones"] = blist;
-            tr["rotateMix"] = rotateMix;
-            tr["translateMix"] = translateMix;
-            tr["scaleMix"] = scaleMix;
-            tr["shearMix"] = shearMix;
-            tr["rotation"] = offsetRotation;
-            tr["x"] = offsetX;
-            tr["y"] = offsetY;
-            tr["scaleX"] = offsetScaleX;
-            tr["scaleY"] = offsetScaleY;
-            tr["shearY"] = offsetShearY;
-            tr["relative"] = isRelative;
-            tr["local"] = isLocal;
-
-            transform_names[i] = name;
-            transforms.push_back(tr);
+            if (name.empty())
+                transform_names.set_copy(i, tr.name);
+            else
+                transform_names.set(i, name);
+            transforms.push_back(std::move(tr));
         }
 
         return transforms;
     }
 
-    json ParsePathConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
-                              size_t strings_base, size_t strings_end,
-                              const std::map<int16_t, std::string> &bone_names,
-                              const std::map<int16_t, std::string> &slot_names,
-                              std::map<int, std::string> &path_names)
+    std::vector<PathConstraint> ParsePathConstraints(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                                     size_t strings_base, size_t strings_end,
+                                                     const NameTable<int16_t> &bone_names,
+                                                     const NameTable<int16_t> &slot_names,
+                                                     NameTable<int> &path_names)
     {
-
+        std::vector<PathConstraint> paths;
         if (pos + 2 > buf_size)
-            return json::array();
+            return paths;
 
         uint16_t count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json paths = json::array();
-        std::map<uint16_t, std::string> pos_modes = {{0, "fixed"}, {1, "percent"}};
-        std::map<uint16_t, std::string> spacing_modes = {{0, "length"}, {1, "fixed"}, {2, "percent"}};
-        std::map<uint16_t, std::string> rotate_modes = {{0, "tangent"}, {1, "chain"}, {2, "chainScale"}};
-
         for (int i = 0; i < count; i++)
         {
             if (pos + 4 > buf_size)
@@ -859,22 +1014,23 @@ namespace SCSPParser
 
             uint32_t name_off = read_le<uint32_t>(buf, pos);
             pos += 4;
-            std::string name;
+            std::string_view name;
             if (name_off != 0xFFFFFFFF && strings_base + name_off < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_off, strings_end);
+                name = read_cstr_view(buf, strings_base + name_off, strings_end);
             }
-            if (name.empty())
-                name = "path" + std::to_string(i);
+
+            PathConstraint pc;
+            pc.name = name.empty() ? "path" + std::to_string(i) : std::string(name);
 
             if (pos + 4 > buf_size)
                 break;
-            uint32_t order = read_le<uint32_t>(buf, pos);
+            pc.order = (int)read_le<uint32_t>(buf, pos);
             pos += 4;
 
             if (pos + 1 > buf_size)
                 break;
-            bool skin_req = buf[pos] != 0;
+            pc.skin_required = buf[pos] != 0;
             pos += 1;
 
             if (pos + 6 > buf_size)
@@ -885,28 +1041,27 @@ namespace SCSPParser
             pos += 2;
             uint16_t rotateMode = read_le<uint16_t>(buf, pos);
             pos += 2;
+            pc.position_mode = positionMode <= 1 ? positionMode : 1;
+            pc.spacing_mode = spacingMode <= 2 ? spacingMode : 0;
+            pc.rotate_mode = rotateMode <= 2 ? rotateMode : 0;
 
             if (pos + 20 > buf_size)
                 break;
-            float offsetRotation = read_le<float>(buf, pos);
-            pos += 4;
-            float position = read_le<float>(buf, pos);
-            pos += 4;
-            float spacing = read_le<float>(buf, pos);
-            pos += 4;
-            float rotateMix = read_le<float>(buf, pos);
-            pos += 4;
-            float translateMix = read_le<float>(buf, pos);
-            pos += 4;
+            pc.rotation = read_le<float>(buf, pos);
+            pc.position = read_le<float>(buf, pos + 4);
+            pc.spacing = read_le<float>(buf, pos + 8);
+            pc.rotate_mix = read_le<float>(buf, pos + 12);
+            pc.translate_mix = read_le<float>(buf, pos + 16);
+            pos += 20;
 
             if (pos + 2 > buf_size)
                 break;
             int16_t tgt = read_le<int16_t>(buf, pos);
             pos += 2;
-            std::string tgt_name = "slot0";
-            if (tgt >= 0 && slot_names.count(tgt))
+            pc.target = "slot0";
+            if (tgt >= 0 && slot_names.find(tgt))
             {
-                tgt_name = slot_names.at(tgt);
+                pc.target = *slot_names.find(tgt);
             }
 
             if (pos + 2 > buf_size)
@@ -914,54 +1069,44 @@ namespace SCSPParser
             uint16_t bc = read_le<uint16_t>(buf, pos);
             pos += 2;
 
-            json blist = json::array();
             for (uint16_t j = 0; j < bc; j++)
             {
                 if (pos + 2 > buf_size)
                     break;
                 int16_t bi = read_le<int16_t>(buf, pos);
                 pos += 2;
-                if (bi >= 0 && bone_names.count(bi))
+                if (bi >= 0 && bone_names.find(bi))
                 {
-                    blist.push_back(bone_names.at(bi));
+                    pc.bones.emplace_back(*bone_names.find(bi));
                 }
                 else
                 {
-                    blist.push_back("root");
+                    pc.bones.push_back("root");
                 }
             }
 
-            json pc;
-            pc["name"] = name;
-            pc["order"] = (int)order;
-            pc["skin"] = skin_req;
-            pc["positionMode"] = pos_modes.count(positionMode) ? pos_modes[positionMode] : "percent";
-            pc["spacingMode"] = spacing_modes.count(spacingMode) ? spacing_modes[spacingMode] : "length";
-            pc["rotateMode"] = rotate_modes.count(rotateMode) ? rotate_modes[rotateMode] : "tangent";
-            pc["rotation"] = offsetRotation;
-            pc["position"] = position;
-            pc["spacing"] = spacing;
-            pc["rotateMix"] = rotateMix;
-            pc["translateMix"] = translateMix;
-            pc["target"] = tgt_name;
-            pc["bones"] = blist;
-
-            path_names[i] = name;
-            paths.push_back(pc);
+            if (name.empty())
+                path_names.set_copy(i, pc.name);
+            else
+                path_names.set(i, name);
+            paths.push_back(std::move(pc));
         }
 
         return paths;
     }
 
-    json ParseSkins(const uint8_t *buf, size_t buf_size, size_t &pos,
-                    size_t strings_base, size_t strings_end,
-                    const std::map<int16_t, std::string> &slot_names,
-                    AttachmentMetaMap &attachment_meta,
-                    int hdr_version,
-                    std::map<int, std::string> &skin_names)
+    std::vector<Skin> ParseSkins(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                 size_t strings_base, size_t strings_end,
+                                 const NameTable<int16_t> &slot_names,
+                                 AttachmentMetaMap &attachment_meta,
+                                 int hdr_version,
+                                 NameTable<int> &skin_names)
     {
+        std::vector<Skin> skins;
 
-        json skins = json::array();
+        // Linked meshes in newer files name their skin by index, which may
+        // refer to a skin further on: (skin, attachment, skin index).
+        std::vector<std::tuple<size_t, size_t, int16_t>> linked_skins;
 
         if (pos + 2 > buf_size)
             return skins;
@@ -970,18 +1115,18 @@ namespace SCSPParser
 
         for (int sidx = 0; sidx < skin_count; sidx++)
         {
-            std::string name = "default";
+            std::string_view name = "default";
             if (pos + 4 > buf_size)
                 break;
             uint32_t off = read_le<uint32_t>(buf, pos);
             pos += 4;
             if (off != 0xFFFFFFFF && strings_base + off < strings_end)
             {
-                std::string s = read_cstr(buf, strings_base + off, strings_end);
+                std::string_view s = read_cstr_view(buf, strings_base + off, strings_end);
                 if (!s.empty())
                     name = s;
             }
-            skin_names[sidx] = name;
+            skin_names.set(sidx, name);
 
             if (pos + 2 > buf_size)
                 break;
@@ -1000,7 +1145,8 @@ namespace SCSPParser
                 pos += 4;
             }
 
-            json attachments_json = json::object();
+            Skin skin;
+            skin.name = name;
 
             if (pos + 2 > buf_size)
                 break;
@@ -1014,8 +1160,8 @@ namespace SCSPParser
                 uint16_t slot_idx = read_le<uint16_t>(buf, pos);
                 pos += 2;
                 std::string slot_name = "slot" + std::to_string(slot_idx);
-                if (slot_names.count(slot_idx))
-                    slot_name = slot_names.at(slot_idx);
+                if (const std::string_view *found = slot_names.find(slot_idx))
+                    slot_name = *found;
 
                 if (pos + 4 > buf_size)
                     break;
@@ -1039,26 +1185,29 @@ namespace SCSPParser
                 read_le<uint32_t>(buf, pos);
                 pos += 4; // ctor_name unused
 
-                json att;
+                Attachment att;
+                att.slot = slot_name;
+                att.name = att_name;
 
                 if (atype == 0)
                 {
                     // Region
                     if (pos + 24 > buf_size)
                         break;
-                    float x = read_le<float>(buf, pos);
+                    att.type = AttachmentType::Region;
+                    att.x = read_le<float>(buf, pos);
                     pos += 4;
-                    float y = read_le<float>(buf, pos);
+                    att.y = read_le<float>(buf, pos);
                     pos += 4;
-                    float rot = read_le<float>(buf, pos);
+                    att.rotation = read_le<float>(buf, pos);
                     pos += 4;
-                    float sx = read_le<float>(buf, pos);
+                    att.scale_x = read_le<float>(buf, pos);
                     pos += 4;
-                    float sy = read_le<float>(buf, pos);
+                    att.scale_y = read_le<float>(buf, pos);
                     pos += 4;
-                    float w = read_le<float>(buf, pos);
+                    att.width = read_le<float>(buf, pos);
                     pos += 4;
-                    float h = read_le<float>(buf, pos);
+                    att.height = read_le<float>(buf, pos);
                     pos += 4;
 
                     // Skip 6 floats (24 bytes) before vc/uc
@@ -1081,92 +1230,40 @@ namespace SCSPParser
                         break;
                     uint32_t poff = read_le<uint32_t>(buf, pos);
                     pos += 4;
-                    std::string path;
                     if (poff != 0xFFFFFFFF && strings_base + poff < strings_end)
                     {
-                        path = read_cstr(buf, strings_base + poff, strings_end);
+                        att.path = read_cstr(buf, strings_base + poff, strings_end);
                     }
 
                     // color
                     if (pos + 16 > buf_size)
                         break;
-                    float cr = read_le<float>(buf, pos);
-                    pos += 4;
-                    float cg = read_le<float>(buf, pos);
-                    pos += 4;
-                    float cb = read_le<float>(buf, pos);
-                    pos += 4;
-                    float ca = read_le<float>(buf, pos);
-                    pos += 4;
-
-                    att["type"] = "region";
-                    att["x"] = x;
-                    att["y"] = y;
-                    att["rotation"] = rot;
-                    att["scaleX"] = sx;
-                    att["scaleY"] = sy;
-                    att["width"] = w;
-                    att["height"] = h;
-                    if (!path.empty())
-                        att["path"] = path;
-                    std::string color = rgba_to_hex(cr, cg, cb, ca);
-                    if (color != "FFFFFFFF")
-                        att["color"] = color;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        att.color[c] = read_le<float>(buf, pos);
+                        pos += 4;
+                    }
                 }
                 else if (atype == 1)
                 {
                     // Bounding Box
-                    std::vector<int16_t> bones;
-                    std::vector<float> verts;
                     uint16_t vcount = 0;
-                    uint32_t world_vertices_len = 0;
-                    std::string vpath;
-                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, bones, verts, vcount, world_vertices_len, vpath);
+                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, att.bones, att.vertices, vcount, att.world_vertices_length, att.path);
 
-                    bool is_weighted = !bones.empty();
-                    attachment_meta[{name, slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : verts};
-
-                    att["type"] = "boundingbox";
-                    att["vertexCount"] = (int)world_vertices_len >> 1;
-
-                    if (!bones.empty())
-                    {
-                        json jv = json::array();
-                        int i = 0, vf = 0;
-                        while (i < (int)bones.size())
-                        {
-                            int c = bones[i++];
-                            jv.push_back(c);
-                            for (int k = 0; k < c; k++)
-                            {
-                                jv.push_back(bones[i++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                            }
-                        }
-                        att["vertices"] = jv;
-                    }
-                    else
-                    {
-                        att["vertices"] = verts;
-                    }
+                    bool is_weighted = !att.bones.empty();
+                    attachment_meta[{std::string(name), slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : att.vertices};
 
-                    if (!vpath.empty())
-                        att["path"] = vpath;
+                    att.type = AttachmentType::BoundingBox;
                 }
                 else if (atype == 2 || atype == 3)
                 {
                     // Mesh or Linked Mesh
-                    std::vector<int16_t> bones;
-                    std::vector<float> verts;
                     uint16_t vcount_dummy;
-                    uint32_t world_vertices_len_dummy = 0;
                     std::string vpath;
-                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, bones, verts, vcount_dummy, world_vertices_len_dummy, vpath);
+                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, att.bones, att.vertices, vcount_dummy, att.world_vertices_length, vpath);
 
-                    bool is_weighted = !bones.empty();
-                    attachment_meta[{name, slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : verts};
+                    bool is_weighted = !att.bones.empty();
+                    attachment_meta[{std::string(name), slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : att.vertices};
 
                     pos += 4 * 6; // Skip 24 bytes
 
@@ -1176,62 +1273,46 @@ namespace SCSPParser
 
                     uint16_t ruvc = read_le<uint16_t>(buf, pos);
                     pos += 2;
-                    std::vector<float> regionUVs = read_f32_array(buf, buf_size, pos, ruvc);
+                    att.uvs = read_f32_array(buf, buf_size, pos, ruvc);
 
                     uint16_t tc = read_le<uint16_t>(buf, pos);
                     pos += 2;
-                    std::vector<uint16_t> triangles;
                     for (int i = 0; i < tc; i++)
                     {
-                        triangles.push_back(read_le<uint16_t>(buf, pos));
+                        att.triangles.push_back(read_le<uint16_t>(buf, pos));
                         pos += 2;
                     }
 
                     uint16_t ec = read_le<uint16_t>(buf, pos);
                     pos += 2;
-                    std::vector<uint16_t> edges;
                     for (int i = 0; i < ec; i++)
                     {
-                        edges.push_back(read_le<uint16_t>(buf, pos));
+                        att.edges.push_back(read_le<uint16_t>(buf, pos));
                         pos += 2;
                     }
 
-                    std::string mpath = vpath;
+                    att.path = vpath;
                     uint32_t moff = read_le<uint32_t>(buf, pos);
                     pos += 4;
                     if (moff != 0xFFFFFFFF && strings_base + moff < strings_end)
                     {
                         std::string s = read_cstr(buf, strings_base + moff, strings_end);
                         if (!s.empty())
-                            mpath = s;
+                            att.path = s;
                     }
 
-                    float regionU = read_le<float>(buf, pos);
-                    pos += 4;
-                    float regionV = read_le<float>(buf, pos);
+                    pos += 4 * 4; // region u, v, u2, v2
+                    att.width = read_le<float>(buf, pos);
                     pos += 4;
-                    float regionU2 = read_le<float>(buf, pos);
-                    pos += 4;
-                    float regionV2 = read_le<float>(buf, pos);
-                    pos += 4;
-                    float width = read_le<float>(buf, pos);
-                    pos += 4;
-                    float height = read_le<float>(buf, pos);
+                    att.height = read_le<float>(buf, pos);
                     pos += 4;
 
-                    float cr = read_le<float>(buf, pos);
-                    pos += 4;
-                    float cg = read_le<float>(buf, pos);
-                    pos += 4;
-                    float cb = read_le<float>(buf, pos);
-                    pos += 4;
-                    float ca = read_le<float>(buf, pos);
-                    pos += 4;
+                    // Mesh colors are not exported.
+                    pos += 4 * 4;
 
-                    uint32_t hull = read_le<uint32_t>(buf, pos);
+                    att.hull = read_le<uint32_t>(buf, pos);
                     pos += 4;
-                    bool regionRotate = buf[pos] != 0;
-                    pos += 1;
+                    pos += 1; // region rotate
                     pos += 4; // _deg
 
                     uint32_t parent_off = read_le<uint32_t>(buf, pos);
@@ -1242,34 +1323,9 @@ namespace SCSPParser
                         parent_name = read_cstr(buf, strings_base + parent_off, strings_end);
                     }
 
-                    json out_verts_json;
-                    if (!bones.empty())
-                    {
-                        json jv = json::array();
-                        int i = 0, vf = 0;
-                        while (i < (int)bones.size())
-                        {
-                            int c = bones[i++];
-                            jv.push_back(c);
-                            for (int k = 0; k < c; k++)
-                            {
-                                jv.push_back(bones[i++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                            }
-                        }
-                        out_verts_json = jv;
-                    }
-                    else
-                    {
-                        out_verts_json = verts;
-                    }
-
                     if (atype == 3)
                     {
                         // Linked Mesh
-                        int16_t temp_skin_idx = 0;
                         std::string temp_skin_name = "";
                         if (hdr_version > 0x7530)
                         {
@@ -1277,8 +1333,7 @@ namespace SCSPParser
                         }
                         else
                         {
-                            temp_skin_idx = read_le<int16_t>(buf, pos);
-                            pos += 2;
+                            pos += 2; // skin index
                             uint32_t soff = read_le<uint32_t>(buf, pos);
                             pos += 4;
                             if (soff != 0xFFFFFFFF && strings_base + soff < strings_end)
@@ -1289,223 +1344,105 @@ namespace SCSPParser
 
                         int16_t skin_idx = read_le<int16_t>(buf, pos);
                         pos += 2;
-                        bool deform_flag = buf[pos] != 0;
+                        att.deform = buf[pos] != 0;
                         pos += 1;
 
-                        att["type"] = "linkedmesh";
-                        att["parent"] = (!parent_name.empty()) ? parent_name : att_name;
-                        att["deform"] = deform_flag;
-                        att["uvs"] = regionUVs;
-                        att["triangles"] = triangles;
-                        att["vertices"] = out_verts_json;
-                        att["hull"] = hull;
-                        att["edges"] = edges;
-                        att["width"] = width;
-                        att["height"] = height;
+                        att.type = AttachmentType::LinkedMesh;
+                        att.parent = (!parent_name.empty()) ? parent_name : att_name;
 
                         if (hdr_version > 0x7530)
                         {
-                            att["skinIndex"] = skin_idx;
+                            linked_skins.emplace_back(skins.size(), skin.attachments.size(), skin_idx);
                         }
                         else
                         {
-                            att["skin"] = temp_skin_name.empty() ? "default" : temp_skin_name;
+                            att.skin = temp_skin_name.empty() ? "default" : temp_skin_name;
                         }
-                        if (!mpath.empty())
-                            att["path"] = mpath;
-                        // att["color"] = rgba_to_hex(cr, cg, cb, ca);
                     }
                     else
                     {
                         // Mesh
                         pos += 5; // skip 5 bytes
-                        att["type"] = "mesh";
-                        att["uvs"] = regionUVs;
-                        att["triangles"] = triangles;
-                        att["vertices"] = out_verts_json;
-                        att["hull"] = hull;
-                        att["edges"] = edges;
-                        att["width"] = width;
-                        att["height"] = height;
-                        if (!mpath.empty())
-                            att["path"] = mpath;
-                        // att["color"] = rgba_to_hex(cr, cg, cb, ca);
+                        att.type = AttachmentType::Mesh;
                     }
                 }
                 else if (atype == 4)
                 {
                     // Path
-                    std::vector<int16_t> bones;
-                    std::vector<float> verts;
                     uint16_t vcount = 0;
-                    uint32_t world_vertices_len = 0;
-                    std::string vpath;
-                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, bones, verts, vcount, world_vertices_len, vpath);
+                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, att.bones, att.vertices, vcount, att.world_vertices_length, att.path);
 
-                    bool is_weighted = !bones.empty();
-                    attachment_meta[{name, slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : verts};
+                    bool is_weighted = !att.bones.empty();
+                    attachment_meta[{std::string(name), slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : att.vertices};
 
                     uint16_t cnt = read_le<uint16_t>(buf, pos);
                     pos += 2;
-                    std::vector<float> lengths = read_f32_array(buf, buf_size, pos, cnt);
-                    bool closed = buf[pos] != 0;
+                    att.lengths = read_f32_array(buf, buf_size, pos, cnt);
+                    att.closed = buf[pos] != 0;
                     pos += 1;
-                    bool constantSpeed = buf[pos] != 0;
+                    att.constant_speed = buf[pos] != 0;
                     pos += 1;
 
-                    att["type"] = "path";
-                    att["closed"] = closed;
-                    att["constantSpeed"] = constantSpeed;
-                    att["lengths"] = lengths;
-                    att["vertexCount"] = (int)world_vertices_len >> 1;
-
-                    if (!bones.empty())
-                    {
-                        json jv = json::array();
-                        int i = 0, vf = 0;
-                        while (i < (int)bones.size())
-                        {
-                            int c = bones[i++];
-                            jv.push_back(c);
-                            for (int k = 0; k < c; k++)
-                            {
-                                jv.push_back(bones[i++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                            }
-                        }
-                        att["vertices"] = jv;
-                    }
-                    else
-                    {
-                        att["vertices"] = verts;
-                    }
-                    if (!vpath.empty())
-                        att["path"] = vpath;
+                    att.type = AttachmentType::Path;
                 }
                 else if (atype == 5)
                 {
                     // Point
-                    float x = read_le<float>(buf, pos);
+                    att.x = read_le<float>(buf, pos);
                     pos += 4;
-                    float y = read_le<float>(buf, pos);
+                    att.y = read_le<float>(buf, pos);
                     pos += 4;
-                    float rotation = read_le<float>(buf, pos);
+                    att.rotation = read_le<float>(buf, pos);
                     pos += 4;
                     pos += 4;
 
-                    att["type"] = "point";
-                    att["x"] = x;
-                    att["y"] = y;
-                    att["rotation"] = rotation;
+                    att.type = AttachmentType::Point;
                 }
                 else if (atype == 6)
                 {
                     // Clipping
-                    std::vector<int16_t> bones;
-                    std::vector<float> verts;
                     uint16_t vcount = 0;
-                    uint32_t world_vertices_len = 0;
-                    std::string vpath;
-                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, bones, verts, vcount, world_vertices_len, vpath);
+                    ParseAssignVertexAttachment(buf, buf_size, pos, strings_base, strings_end, att.bones, att.vertices, vcount, att.world_vertices_length, att.path);
 
-                    bool is_weighted = !bones.empty();
-                    attachment_meta[{name, slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : verts};
+                    bool is_weighted = !att.bones.empty();
+                    attachment_meta[{std::string(name), slot_idx, att_name}] = {is_weighted, is_weighted ? std::vector<float>() : att.vertices};
 
                     int16_t end_slot_idx = read_le<int16_t>(buf, pos);
                     pos += 2;
-                    std::string end_slot_name = "slot" + std::to_string(end_slot_idx);
-                    if (slot_names.count(end_slot_idx))
-                        end_slot_name = slot_names.at(end_slot_idx);
-
-                    att["type"] = "clipping";
-                    att["end"] = end_slot_name;
-                    att["vertexCount"] = (int)world_vertices_len >> 1;
+                    att.end_slot = slot_names.name_or(end_slot_idx, "slot");
 
-                    if (!bones.empty())
-                    {
-                        json jv = json::array();
-                        int i = 0, vf = 0;
-                        while (i < (int)bones.size())
-                        {
-                            int c = bones[i++];
-                            jv.push_back(c);
-                            for (int k = 0; k < c; k++)
-                            {
-                                jv.push_back(bones[i++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                                jv.push_back(verts[vf++]);
-                            }
-                        }
-                        att["vertices"] = jv;
-                    }
-                    else
-                    {
-                        att["vertices"] = verts;
-                    }
-                    if (!vpath.empty())
-                        att["path"] = vpath;
+                    att.type = AttachmentType::Clipping;
                 }
-
-                if (!att.empty())
+                else
                 {
-                    if (!attachments_json.contains(slot_name))
-                        attachments_json[slot_name] = json::object();
-                    attachments_json[slot_name][att_name] = att;
+                    continue;
                 }
+
+                skin.attachments.push_back(std::move(att));
             }
 
-            json skin_obj;
-            skin_obj["name"] = name;
-            skin_obj["attachments"] = attachments_json;
-            skins.push_back(skin_obj);
+            skins.push_back(std::move(skin));
         }
 
-        // Post-process linked mesh skin indices
-        for (auto &skin : skins)
+        for (const auto &[skin, attachment, skin_idx] : linked_skins)
         {
-            if (skin.contains("attachments"))
-            {
-                for (auto &[slot, slots] : skin["attachments"].items())
-                {
-                    for (auto &[att_name, att] : slots.items())
-                    {
-                        if (att.contains("type") && att["type"] == "linkedmesh" && att.contains("skinIndex"))
-                        {
-                            int idx = att["skinIndex"];
-                            if (skin_names.count(idx))
-                            {
-                                att["skin"] = skin_names[idx];
-                            }
-                            else
-                            {
-                                att["skin"] = "default";
-                            }
-                            att.erase("skinIndex");
-                        }
-                    }
-                }
-            }
+            const std::string_view *name = skin_names.find(skin_idx);
+            skins[skin].attachments[attachment].skin = name ? *name : "default";
         }
 
         return skins;
     }
 
-    json ParseEvents(const uint8_t *buf, size_t buf_size, size_t &pos,
-                     size_t strings_base, size_t strings_end,
-                     std::map<int, std::string> &event_names)
+    std::vector<Event> ParseEvents(const uint8_t *buf, size_t buf_size, size_t &pos,
+                                   size_t strings_base, size_t strings_end)
     {
-
+        std::vector<Event> events;
         if (pos + 2 > buf_size)
-            return json::object();
+            return events;
 
         uint16_t event_count = read_le<uint16_t>(buf, pos);
         pos += 2;
 
-        json events = json::object();
-
         for (uint16_t e = 0; e < event_count; e++)
         {
             if (pos + 4 > buf_size)
@@ -1513,25 +1450,24 @@ namespace SCSPParser
 
             uint32_t name_off = read_le<uint32_t>(buf, pos);
             pos += 4;
-            std::string name;
+            Event evt;
             if (name_off != 0xFFFFFFFF && strings_base + name_off < strings_end)
             {
-                name = read_cstr(buf, strings_base + name_off, strings_end);
+                evt.name = read_cstr(buf, strings_base + name_off, strings_end);
             }
 
             if (pos + 12 > buf_size)
                 break;
-            uint32_t intData = read_le<uint32_t>(buf, pos);
+            evt.int_value = read_le<uint32_t>(buf, pos);
             pos += 4;
-            float floatData = read_le<float>(buf, pos);
+            evt.float_value = read_le<float>(buf, pos);
             pos += 4;
             uint32_t stringOff = read_le<uint32_t>(buf, pos);
             pos += 4;
 
-            std::string stringData;
             if (stringOff != 0xFFFFFFFF && strings_base + stringOff < strings_end)
             {
-                stringData = read_cstr(buf, strings_base + stringOff, strings_end);
+                evt.string_value = read_cstr(buf, strings_base + stringOff, strings_end);
             }
 
             if (pos + 12 > buf_size)
@@ -1539,629 +1475,1158 @@ namespace SCSPParser
             uint32_t audioOff = read_le<uint32_t>(buf, pos);
             pos += 4;
 
-            std::string audioData;
             if (audioOff != 0xFFFFFFFF && strings_base + audioOff < strings_end)
             {
-                audioData = read_cstr(buf, strings_base + audioOff, strings_end);
+                evt.audio_path = read_cstr(buf, strings_base + audioOff, strings_end);
             }
 
-            float volume = read_le<float>(buf, pos);
+            evt.volume = read_le<float>(buf, pos);
             pos += 4;
-            float balance = read_le<float>(buf, pos);
+            evt.balance = read_le<float>(buf, pos);
             pos += 4;
 
-            json evt;
-            evt["int"] = intData;
-            evt["float"] = floatData;
-            evt["string"] = stringData;
-            evt["audio"] = audioData;
-            evt["volume"] = volume;
-            evt["balance"] = balance;
-
-            if (!name.empty())
+            if (!evt.name.empty())
             {
-                events[name] = evt;
-                event_names[e] = name;
+                events.push_back(std::move(evt));
             }
         }
 
         return events;
     }
 
-    json ParseAnimations(const uint8_t *buf, size_t buf_size, size_t &pos,
-                         size_t strings_base, size_t strings_end,
-                         const std::map<int16_t, std::string> &bone_names,
-                         const std::map<int16_t, std::string> &slot_names,
-                         const std::map<int, std::string> &skin_names,
-                         const std::map<int, std::string> &ik_names,
-                         const std::map<int, std::string> &transform_names,
-                         const std::map<int, std::string> &path_names,
-                         const std::map<int, std::string> &event_names,
-                         const AttachmentMetaMap &attachment_meta,
-                         int hdr_version)
+    // What the animation section refers to by index, kept from the first pass
+    // so that an animation can also be decoded on its own later.
+    struct AnimationContext
     {
+        size_t strings_base = 0, strings_end = 0;
+        int hdr_version = 0;
+        NameTable<int16_t> bone_names, slot_names;
+        NameTable<int> skin_names, ik_names, transform_names, path_names;
+        AttachmentMetaMap attachment_meta;
+    };
 
-        json animations = json::object();
-        if (pos + 2 > buf_size)
-            return animations;
-
-        uint16_t anim_count = read_le<uint16_t>(buf, pos);
-        pos += 2;
+    // Reads an animation's name, duration and timeline count; false where the
+    // section ends before them.
+    bool ParseAnimationHeader(const uint8_t *buf, size_t buf_size, size_t &pos, const AnimationContext &ctx,
+                              uint16_t index, std::string &name, float &duration, uint16_t &timeline_count)
+    {
+        if (pos + 8 > buf_size)
+            return false;
+        uint32_t name_off = read_le<uint32_t>(buf, pos);
+        pos += 4;
+        duration = read_le<float>(buf, pos);
+        pos += 4;
 
-        for (uint16_t ai = 0; ai < anim_count; ai++)
+        name = "anim" + std::to_string(index);
+        if (name_off != 0xFFFFFFFF && ctx.strings_base + name_off < ctx.strings_end)
         {
-            if (pos + 8 > buf_size)
-                break;
-            uint32_t name_off = read_le<uint32_t>(buf, pos);
-            pos += 4;
-            float duration = read_le<float>(buf, pos);
-            pos += 4;
-
-            std::string name = "anim" + std::to_string(ai);
-            if (name_off != 0xFFFFFFFF && strings_base + name_off < strings_end)
-            {
-                name = read_cstr(buf, strings_base + name_off, strings_end);
-            }
+            name = read_cstr(buf, ctx.strings_base + name_off, ctx.strings_end);
+        }
 
-            json anim;
-            anim["bones"] = json::object();
-            anim["slots"] = json::object();
-            anim["ik"] = json::object();
-            anim["transform"] = json::object();
-            anim["path"] = json::object();
-            anim["deform"] = json::object();
-            anim["events"] = json::array();
+        if (pos + 2 > buf_size)
+            return false;
+        timeline_count = read_le<uint16_t>(buf, pos);
+        pos += 2;
+        return true;
+    }
 
+    void ParseTimelines(const uint8_t *buf, size_t buf_size, size_t &pos, const AnimationContext &ctx,
+                        uint16_t timeline_count, Animation &anim)
+    {
+        for (int k = 0; k < timeline_count; k++)
+        {
             if (pos + 2 > buf_size)
                 break;
-            uint16_t timeline_count = read_le<uint16_t>(buf, pos);
+            uint16_t ttype = read_le<uint16_t>(buf, pos);
             pos += 2;
 
-            for (int k = 0; k < timeline_count; k++)
+            Timeline timeline;
+            timeline.type = static_cast<TimelineType>(ttype);
+
+            if (ttype <= 3)
             {
-                if (pos + 2 > buf_size)
-                    break;
-                uint16_t ttype = read_le<uint16_t>(buf, pos);
+                // Rotate, Translate, Scale, Shear
+                uint16_t bone_idx = read_le<uint16_t>(buf, pos);
                 pos += 2;
 
-                if (ttype <= 3)
-                {
-                    // Rotate, Translate, Scale, Shear
-                    uint16_t bone_idx = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-
-                    // Read frames
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t cc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
-
-                    std::string bkey = std::to_string(bone_idx);
-                    if (bone_names.count(bone_idx))
-                        bkey = bone_names.at(bone_idx);
-
-                    std::string tname_str;
-                    if (ttype == 0)
-                        tname_str = "rotate";
-                    else if (ttype == 1)
-                        tname_str = "translate";
-                    else if (ttype == 2)
-                        tname_str = "scale";
-                    else
-                        tname_str = "shear";
-
-                    if (!anim["bones"].contains(bkey))
-                        anim["bones"][bkey] = json::object();
-                    if (!anim["bones"][bkey].contains(tname_str))
-                        anim["bones"][bkey][tname_str] = json::array();
+                // Read frames
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
+                uint16_t cc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
 
-                    int valCount = (ttype == 0) ? 2 : 3;
-                    int frameCount = fc / valCount;
+                timeline.target = ctx.bone_names.name_or(bone_idx, "");
 
-                    for (int i = 0; i < frameCount; i++)
+                int valCount = (ttype == 0) ? 2 : 3;
+                int frameCount = (int)values.size() / valCount;
+                values.resize(frameCount * valCount);
+                timeline.frames = std::move(values);
+                timeline.curves = read_curves(curves, frameCount);
+            }
+            else if (ttype == 4)
+            {
+                // Attachment
+                uint16_t slot_idx = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> times = read_f32_array(buf, buf_size, pos, fc);
+                uint16_t name_cnt = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                for (int i = 0; i < name_cnt; i++)
+                {
+                    uint32_t soff = read_le<uint32_t>(buf, pos);
+                    pos += 4;
+                    if (soff != 0xFFFFFFFF && ctx.strings_base + soff < ctx.strings_end)
                     {
-                        json fr;
-                        if (ttype == 0)
-                        {
-                            fr["time"] = values[i * 2];
-                            fr["angle"] = values[i * 2 + 1];
-                        }
-                        else
-                        {
-                            fr["time"] = values[i * 3];
-                            fr["x"] = values[i * 3 + 1];
-                            fr["y"] = values[i * 3 + 2];
-                        }
-                        maybe_add_curve(i, curves, fr);
-                        anim["bones"][bkey][tname_str].push_back(fr);
+                        timeline.attachment_names.push_back(read_cstr(buf, ctx.strings_base + soff, ctx.strings_end));
                     }
-                }
-                else if (ttype == 4)
-                {
-                    // Attachment
-                    uint16_t slot_idx = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> times = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t name_cnt = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<std::string> names;
-                    for (int i = 0; i < name_cnt; i++)
+                    else
                     {
-                        uint32_t soff = read_le<uint32_t>(buf, pos);
-                        pos += 4;
-                        if (soff != 0xFFFFFFFF && strings_base + soff < strings_end)
-                        {
-                            names.push_back(read_cstr(buf, strings_base + soff, strings_end));
-                        }
-                        else
-                        {
-                            names.push_back("");
-                        }
+                        timeline.attachment_names.push_back("");
                     }
+                }
 
-                    std::string sname = std::to_string(slot_idx);
-                    if (slot_names.count(slot_idx))
-                        sname = slot_names.at(slot_idx);
+                timeline.target = ctx.slot_names.name_or(slot_idx, "");
 
-                    if (!anim["slots"].contains(sname))
-                        anim["slots"][sname] = json::object();
-                    if (!anim["slots"][sname].contains("attachment"))
-                        anim["slots"][sname]["attachment"] = json::array();
+                size_t count = std::min(times.size(), timeline.attachment_names.size());
+                times.resize(count);
+                timeline.attachment_names.resize(count);
+                timeline.frames = std::move(times);
+            }
+            else if (ttype == 6)
+            {
+                // Deform
+                uint16_t slot_idx = read_le<uint16_t>(buf, pos);
+                pos += 2;
 
-                    int count = std::min((int)fc, (int)names.size());
-                    for (int i = 0; i < count; i++)
-                    {
-                        json fr;
-                        fr["time"] = times[i];
-                        if (!names[i].empty())
-                            fr["name"] = names[i];
-                        else
-                            fr["name"] = nullptr;
-                        anim["slots"][sname]["attachment"].push_back(fr);
-                    }
-                }
-                else if (ttype == 6)
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
+                uint16_t cc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
+
+                uint16_t fv_frames = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<std::vector<float>> frame_vertices;
+                for (int i = 0; i < fv_frames; i++)
                 {
-                    // Deform
-                    uint16_t slot_idx = read_le<uint16_t>(buf, pos);
+                    uint16_t cnt = read_le<uint16_t>(buf, pos);
                     pos += 2;
+                    frame_vertices.push_back(read_f32_array(buf, buf_size, pos, cnt));
+                }
 
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t cc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
+                uint32_t att_off = read_le<uint32_t>(buf, pos);
+                pos += 4;
+                if (att_off != 0xFFFFFFFF && ctx.strings_base + att_off < ctx.strings_end)
+                    timeline.attachment = read_cstr(buf, ctx.strings_base + att_off, ctx.strings_end);
 
-                    uint16_t fv_frames = read_le<uint16_t>(buf, pos);
+                timeline.skin = "default";
+                if (ctx.hdr_version > 0x7530 && pos + 2 <= buf_size)
+                {
+                    uint16_t sidx = read_le<uint16_t>(buf, pos);
                     pos += 2;
-                    std::vector<std::vector<float>> frame_vertices;
-                    for (int i = 0; i < fv_frames; i++)
-                    {
-                        uint16_t cnt = read_le<uint16_t>(buf, pos);
-                        pos += 2;
-                        frame_vertices.push_back(read_f32_array(buf, buf_size, pos, cnt));
-                    }
+                    if (const std::string_view *name = ctx.skin_names.find(sidx))
+                        timeline.skin = *name;
+                }
 
-                    uint32_t att_off = read_le<uint32_t>(buf, pos);
-                    pos += 4;
-                    std::string att_name = "";
-                    if (att_off != 0xFFFFFFFF && strings_base + att_off < strings_end)
-                        att_name = read_cstr(buf, strings_base + att_off, strings_end);
+                // Process Deform
+                bool is_unweighted = true;
+                std::vector<float> setup;
+                auto key = std::make_tuple(timeline.skin, (int)slot_idx, timeline.attachment);
+                if (ctx.attachment_meta.count(key))
+                {
+                    is_unweighted = !ctx.attachment_meta.at(key).weighted;
+                    setup = ctx.attachment_meta.at(key).setup;
+                }
 
-                    std::string skinname = "default";
-                    if (hdr_version > 0x7530 && pos + 2 <= buf_size)
-                    {
-                        uint16_t sidx = read_le<uint16_t>(buf, pos);
-                        pos += 2;
-                        if (skin_names.count(sidx))
-                            skinname = skin_names.at(sidx);
-                    }
+                timeline.target = ctx.slot_names.name_or(slot_idx, "");
 
-                    // Process Deform
-                    bool is_unweighted = true;
-                    std::vector<float> setup;
-                    auto key = std::make_tuple(skinname, (int)slot_idx, att_name);
-                    if (attachment_meta.count(key))
+                size_t n = std::min(values.size(), frame_vertices.size());
+                values.resize(n);
+                timeline.frames = std::move(values);
+                timeline.curves = read_curves(curves, (int)n);
+                timeline.deform.resize(n);
+                for (size_t i = 0; i < n; i++)
+                {
+                    std::vector<float> &diffs = frame_vertices[i];
+                    if (is_unweighted && setup.size() == diffs.size())
                     {
-                        is_unweighted = !attachment_meta.at(key).weighted;
-                        setup = attachment_meta.at(key).setup;
+                        for (size_t v = 0; v < diffs.size(); v++)
+                            diffs[v] -= setup[v];
                     }
 
-                    std::string sname = std::to_string(slot_idx);
-                    if (slot_names.count(slot_idx))
-                        sname = slot_names.at(slot_idx);
-
-                    if (!anim["deform"].contains(skinname))
-                        anim["deform"][skinname] = json::object();
-                    if (!anim["deform"][skinname].contains(sname))
-                        anim["deform"][skinname][sname] = json::object();
-                    if (!anim["deform"][skinname][sname].contains(att_name))
-                        anim["deform"][skinname][sname][att_name] = json::array();
-
-                    int n = std::min((int)fc, (int)fv_frames);
-                    for (int i = 0; i < n; i++)
+                    int start = 0;
+                    while (start < (int)diffs.size() && std::abs(diffs[start]) < 1e-6)
+                        start++;
+                    if (start < (int)diffs.size())
                     {
-                        json fr;
-                        fr["time"] = values[i];
-                        const auto &verts = frame_vertices[i];
-                        if (!verts.empty())
-                        {
-                            std::vector<float> diffs;
-                            if (is_unweighted && setup.size() == verts.size())
-                            {
-                                for (size_t k = 0; k < verts.size(); k++)
-                                    diffs.push_back(verts[k] - setup[k]);
-                            }
-                            else
-                            {
-                                diffs = verts;
-                            }
+                        int end = (int)diffs.size() - 1;
+                        while (end >= 0 && std::abs(diffs[end]) < 1e-6)
+                            end--;
 
-                            int start = 0;
-                            while (start < (int)diffs.size() && std::abs(diffs[start]) < 1e-6)
-                                start++;
-                            if (start < (int)diffs.size())
-                            {
-                                int end = (int)diffs.size() - 1;
-                                while (end >= 0 && std::abs(diffs[end]) < 1e-6)
-                                    end--;
-
-                                json v = json::array();
-                                for (int k = start; k <= end; k++)
-                                    v.push_back(diffs[k]);
-                                fr["vertices"] = v;
-                                if (start > 0)
-                                    fr["offset"] = start;
-                            }
-                        }
-                        maybe_add_curve(i, curves, fr);
-                        anim["deform"][skinname][sname][att_name].push_back(fr);
-                    }
-                }
-                else if (ttype == 7)
-                {
-                    // Events timeline (consume only)
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> times = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t evc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    for (int i = 0; i < evc; i++)
-                    {
-                        (void)read_le<uint32_t>(buf, pos);
-                        pos += 4;
+                        DeformKey &deform = timeline.deform[i];
+                        deform.offset = start;
+                        deform.vertices.assign(diffs.begin() + start, diffs.begin() + end + 1);
                     }
                 }
-                else if (ttype == 8)
+            }
+            else if (ttype == 7)
+            {
+                // Events timeline (consume only)
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                read_f32_array(buf, buf_size, pos, fc);
+                uint16_t evc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                pos += 4 * evc;
+                continue;
+            }
+            else if (ttype == 8)
+            {
+                // DrawOrder
+                int slot_count = (int)ctx.slot_names.size();
+
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> times = read_f32_array(buf, buf_size, pos, fc);
+                uint16_t groups = read_le<uint16_t>(buf, pos);
+                pos += 2;
+
+                auto slot_name = [&](int index)
                 {
-                    // DrawOrder
-                    int slot_count = (int)slot_names.size();
+                    return ctx.slot_names.name_or(index, "");
+                };
 
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> times = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t groups = read_le<uint16_t>(buf, pos);
+                for (int i = 0; i < groups; i++)
+                {
+                    uint16_t c = read_le<uint16_t>(buf, pos);
                     pos += 2;
+                    DrawOrderKey fr;
+                    fr.time = (i < (int)times.size()) ? times[i] : 0.0f;
 
-                    json drawOrder = json::array();
-                    for (int i = 0; i < groups; i++)
+                    if (c == slot_count)
                     {
-                        uint16_t c = read_le<uint16_t>(buf, pos);
-                        pos += 2;
-                        json fr;
-                        fr["time"] = (i < (int)times.size()) ? times[i] : 0.0f;
-
-                        json offsets = json::array();
-                        if (c == slot_count)
+                        std::vector<int> new_order;
+                        for (int j = 0; j < c; j++)
                         {
-                            std::vector<int> new_order;
-                            for (int j = 0; j < c; j++)
-                            {
-                                new_order.push_back((int)read_le<uint32_t>(buf, pos));
-                                pos += 4;
-                            }
-                            // Map new positions
-                            for (int orig = 0; orig < slot_count; orig++)
-                            {
-                                int new_pos = -1;
-                                for (int p = 0; p < slot_count; p++)
-                                    if (new_order[p] == orig)
-                                    {
-                                        new_pos = p;
-                                        break;
-                                    }
-                                if (new_pos != -1 && new_pos != orig)
-                                {
-                                    json off;
-                                    off["slot"] = slot_names.count(orig) ? slot_names.at(orig) : std::to_string(orig);
-                                    off["offset"] = new_pos - orig;
-                                    offsets.push_back(off);
-                                }
-                            }
+                            new_order.push_back((int)read_le<uint32_t>(buf, pos));
+                            pos += 4;
                         }
-                        else
+                        // Map new positions
+                        for (int orig = 0; orig < slot_count; orig++)
                         {
-                            for (int j = 0; j < c; j++)
-                            {
-                                int sidx = read_le<uint32_t>(buf, pos);
-                                pos += 4;
-                                int offset = read_le<int32_t>(buf, pos);
-                                pos += 4;
-                                if (offset != 0)
+                            int new_pos = -1;
+                            for (int p = 0; p < slot_count; p++)
+                                if (new_order[p] == orig)
                                 {
-                                    json off;
-                                    off["slot"] = slot_names.count(sidx) ? slot_names.at(sidx) : std::to_string(sidx);
-                                    off["offset"] = offset;
-                                    offsets.push_back(off);
+                                    new_pos = p;
+                                    break;
                                 }
+                            if (new_pos != -1 && new_pos != orig)
+                            {
+                                fr.offsets.emplace_back(slot_name(orig), new_pos - orig);
                             }
                         }
-                        if (!offsets.empty())
+                    }
+                    else
+                    {
+                        for (int j = 0; j < c; j++)
                         {
-                            fr["offsets"] = offsets;
-                            drawOrder.push_back(fr);
+                            int sidx = read_le<uint32_t>(buf, pos);
+                            pos += 4;
+                            int offset = read_le<int32_t>(buf, pos);
+                            pos += 4;
+                            if (offset != 0)
+                            {
+                                fr.offsets.emplace_back(slot_name(sidx), offset);
+                            }
                         }
                     }
-                    if (!drawOrder.empty())
-                        anim["drawOrder"] = drawOrder;
+                    if (!fr.offsets.empty())
+                    {
+                        timeline.draw_order.push_back(std::move(fr));
+                    }
                 }
-                else if (ttype == 5 || ttype == 9 || ttype == 10 || ttype >= 11)
+            }
+            else
+            {
+                uint16_t idx = read_le<uint16_t>(buf, pos);
+                pos += 2;
+
+                uint16_t fc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
+                uint16_t cc = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
+
+                int entries;
+                if (ttype == 5)
                 {
-                    uint16_t idx = read_le<uint16_t>(buf, pos);
-                    pos += 2;
+                    // Color
+                    timeline.target = ctx.slot_names.name_or(idx, "");
+                    entries = 5;
+                }
+                else if (ttype == 9)
+                {
+                    // IK
+                    timeline.target = ctx.ik_names.name_or(idx, "ik");
+                    entries = 6;
+                }
+                else if (ttype == 10)
+                {
+                    // Transform
+                    timeline.target = ctx.transform_names.name_or(idx, "transform");
+                    entries = 5;
+                }
+                else if (ttype == 11 || ttype == 12 || ttype == 13)
+                {
+                    // Path position, spacing or mix
+                    timeline.target = ctx.path_names.name_or(idx, "path");
+                    entries = ttype == 13 ? 3 : 2;
+                }
+                else if (ttype == 14)
+                {
+                    // TwoColor
+                    timeline.target = ctx.slot_names.name_or(idx, "");
+                    entries = 8;
+                }
+                else
+                {
+                    continue;
+                }
 
-                    uint16_t fc = read_le<uint16_t>(buf, pos);
-                    pos += 2;
-                    std::vector<float> values = read_f32_array(buf, buf_size, pos, fc);
-                    uint16_t cc = read_le<uint16_t>(buf, pos);
+                int frames = (int)values.size() / entries;
+                values.resize(frames * entries);
+                timeline.frames = std::move(values);
+                timeline.curves = read_curves(curves, frames);
+            }
+
+            anim.timelines.push_back(std::move(timeline));
+        }
+    }
+
+    // Moves pos past the timelines the way ParseTimelines reads them, without
+    // decoding any.
+    void SkipTimelines(const uint8_t *buf, size_t buf_size, size_t &pos, const AnimationContext &ctx,
+                       uint16_t timeline_count)
+    {
+        auto skip_count = [&](size_t element_size)
+        {
+            uint16_t count = read_le<uint16_t>(buf, pos);
+            pos += 2 + count * element_size;
+        };
+        auto skip_floats = [&]()
+        {
+            uint16_t count = read_le<uint16_t>(buf, pos);
+            pos += 2;
+            skip_f32_array(buf_size, pos, count);
+        };
+
+        for (int k = 0; k < timeline_count; k++)
+        {
+            if (pos + 2 > buf_size)
+                break;
+            uint16_t ttype = read_le<uint16_t>(buf, pos);
+            pos += 2;
+
+            if (ttype == 4)
+            {
+                // Attachment: slot, times, names
+                pos += 2;
+                skip_floats();
+                skip_count(4);
+            }
+            else if (ttype == 6)
+            {
+                // Deform: slot, times, curves, vertices per frame, attachment, skin
+                pos += 2;
+                skip_floats();
+                skip_floats();
+                uint16_t fv_frames = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                for (int i = 0; i < fv_frames; i++)
+                    skip_floats();
+                pos += 4;
+                if (ctx.hdr_version > 0x7530 && pos + 2 <= buf_size)
                     pos += 2;
-                    std::vector<float> curves = read_f32_array(buf, buf_size, pos, cc);
+            }
+            else if (ttype == 7)
+            {
+                // Events: times, event indices
+                skip_floats();
+                skip_count(4);
+            }
+            else if (ttype == 8)
+            {
+                // DrawOrder: times, then each key as a full order or as offsets
+                skip_floats();
+                uint16_t groups = read_le<uint16_t>(buf, pos);
+                pos += 2;
+                for (int i = 0; i < groups; i++)
+                {
+                    uint16_t c = read_le<uint16_t>(buf, pos);
+                    pos += 2 + (c == ctx.slot_names.size() ? 4 : 8) * (size_t)c;
+                }
+            }
+            else
+            {
+                // Target index, values and curves
+                pos += 2;
+                skip_floats();
+                skip_floats();
+            }
+        }
+    }
 
-                    if (ttype == 5)
-                    {
-                        // Color
-                        std::string sname = slot_names.count(idx) ? slot_names.at(idx) : std::to_string(idx);
-                        int ENTRIES = 5;
-                        int frames = fc / ENTRIES;
+    std::vector<Animation> ParseAnimations(const uint8_t *buf, size_t buf_size, size_t &pos, const AnimationContext &ctx)
+    {
+        std::vector<Animation> animations;
+        if (pos + 2 > buf_size)
+            return animations;
 
-                        if (!anim["slots"].contains(sname))
-                            anim["slots"][sname] = json::object();
-                        if (!anim["slots"][sname].contains("color"))
-                            anim["slots"][sname]["color"] = json::array();
+        uint16_t anim_count = read_le<uint16_t>(buf, pos);
+        pos += 2;
 
-                        for (int i = 0; i < frames; i++)
-                        {
-                            int b = i * ENTRIES;
-                            json fr;
-                            fr["time"] = values[b];
-                            fr["color"] = rgba_to_hex(values[b + 1], values[b + 2], values[b + 3], values[b + 4]);
-                            maybe_add_curve(i, curves, fr);
-                            anim["slots"][sname]["color"].push_back(fr);
-                        }
-                    }
-                    else if (ttype == 9)
-                    {
-                        // IK
-                        std::string cname = ik_names.count(idx) ? ik_names.at(idx) : "ik" + std::to_string(idx);
-                        int ENTRIES = 6;
-                        int frames = fc / ENTRIES;
+        for (uint16_t ai = 0; ai < anim_count; ai++)
+        {
+            Animation anim;
+            uint16_t timeline_count;
+            if (!ParseAnimationHeader(buf, buf_size, pos, ctx, ai, anim.name, anim.duration, timeline_count))
+                break;
+            ParseTimelines(buf, buf_size, pos, ctx, timeline_count, anim);
+            animations.push_back(std::move(anim));
+        }
+        return animations;
+    }
 
-                        if (!anim["ik"].contains(cname))
-                            anim["ik"][cname] = json::array();
+    // The first pass over the animation section: where each animation starts
+    // and ends, found by skipping its timelines.
+    std::vector<AnimationEntry> IndexAnimations(const uint8_t *buf, size_t buf_size, size_t &pos, const AnimationContext &ctx)
+    {
+        std::vector<AnimationEntry> entries;
+        if (pos + 2 > buf_size)
+            return entries;
 
-                        for (int i = 0; i < frames; i++)
-                        {
-                            int b = i * ENTRIES;
-                            json fr;
-                            fr["time"] = values[b];
-                            fr["mix"] = values[b + 1];
-                            fr["softness"] = values[b + 2];
-                            fr["bendPositive"] = (values[b + 3] >= 0.0f);
-                            if (values[b + 4] != 0)
-                                fr["compress"] = true;
-                            if (values[b + 5] != 0)
-                                fr["stretch"] = true;
-                            maybe_add_curve(i, curves, fr);
-                            anim["ik"][cname].push_back(fr);
-                        }
-                    }
-                    else if (ttype == 10)
-                    {
-                        // Transform
-                        std::string cname = transform_names.count(idx) ? transform_names.at(idx) : "transform" + std::to_string(idx);
-                        int ENTRIES = 5;
-                        int frames = fc / ENTRIES;
+        uint16_t anim_count = read_le<uint16_t>(buf, pos);
+        pos += 2;
 
-                        if (!anim["transform"].contains(cname))
-                            anim["transform"][cname] = json::array();
+        for (uint16_t ai = 0; ai < anim_count; ai++)
+        {
+            AnimationEntry entry;
+            entry.index = ai;
+            entry.begin = pos;
+            uint16_t timeline_count;
+            if (!ParseAnimationHeader(buf, buf_size, pos, ctx, ai, entry.name, entry.duration, timeline_count))
+                break;
+            SkipTimelines(buf, buf_size, pos, ctx, timeline_count);
+            entry.end = pos;
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
 
-                        for (int i = 0; i < frames; i++)
-                        {
-                            int b = i * ENTRIES;
-                            json fr;
-                            fr["time"] = values[b];
-                            fr["rotateMix"] = values[b + 1];
-                            fr["translateMix"] = values[b + 2];
-                            fr["scaleMix"] = values[b + 3];
-                            fr["shearMix"] = values[b + 4];
-                            maybe_add_curve(i, curves, fr);
-                            anim["transform"][cname].push_back(fr);
-                        }
-                    }
-                    else if (ttype == 11 || ttype == 12 || ttype == 13)
-                    {
-                        // Path
-                        std::string cname = path_names.count(idx) ? path_names.at(idx) : "path" + std::to_string(idx);
+    Animation ParseAnimation(const uint8_t *buf, size_t buf_size, const AnimationEntry &entry, const AnimationContext &ctx)
+    {
+        Animation anim;
+        size_t pos = entry.begin;
+        uint16_t timeline_count;
+        if (ParseAnimationHeader(buf, buf_size, pos, ctx, entry.index, anim.name, anim.duration, timeline_count))
+            ParseTimelines(buf, buf_size, pos, ctx, timeline_count, anim);
+        return anim;
+    }
 
-                        if (!anim["path"].contains(cname))
-                            anim["path"][cname] = json::object();
+    // Everything before the animation section, which starts at pos on return.
+    Skeleton ParseSetup(const uint8_t *buf, size_t buf_size, size_t &pos, AnimationContext &ctx)
+    {
+        // Parse header
+        Header hdr = ParseHeader(buf, buf_size);
 
-                        if (ttype == 13)
-                        {
-                            // Path Mix
-                            int ENTRIES = 3;
-                            int frames = fc / ENTRIES;
-                            anim["path"][cname]["mix"] = json::array();
-                            for (int i = 0; i < frames; i++)
-                            {
-                                int b = i * ENTRIES;
-                                json fr;
-                                fr["time"] = values[b];
-                                fr["rotateMix"] = values[b + 1];
-                                fr["translateMix"] = values[b + 2];
-                                maybe_add_curve(i, curves, fr);
-                                anim["path"][cname]["mix"].push_back(fr);
-                            }
-                        }
-                        else
-                        {
-                            // Position or Spacing
-                            int ENTRIES = 2;
-                            int frames = fc / ENTRIES;
-                            std::string key = (ttype == 11) ? "position" : "spacing";
-                            anim["path"][cname][key] = json::array();
-                            for (int i = 0; i < frames; i++)
-                            {
-                                int b = i * ENTRIES;
-                                json fr;
-                                fr["time"] = values[b];
-                                fr[key] = values[b + 1];
-                                maybe_add_curve(i, curves, fr);
-                                anim["path"][cname][key].push_back(fr);
-                            }
-                        }
-                    }
-                    else if (ttype == 14)
-                    {
-                        // TwoColor
-                        std::string sname = slot_names.count(idx) ? slot_names.at(idx) : std::to_string(idx);
-                        int ENTRIES = 8;
-                        int frames = fc / ENTRIES;
+        ctx.strings_base = hdr.string_offset + 8;
+        ctx.strings_end = ctx.strings_base + hdr.string_length;
+        ctx.hdr_version = hdr.hdr_version;
+        size_t strings_base = ctx.strings_base;
+        size_t strings_end = ctx.strings_end;
+
+        Skeleton skeleton;
+        skeleton.header.width = hdr.width;
+        skeleton.header.height = hdr.height;
+        skeleton.header.version = hdr.version;
+        skeleton.header.images_path = hdr.images_path;
+        skeleton.header.audio_path = hdr.audio_path;
+        skeleton.header.hash = hdr.hash;
+        skeleton.format_version = hdr.hdr_version;
 
-                        if (!anim["slots"].contains(sname))
-                            anim["slots"][sname] = json::object();
-                        if (!anim["slots"][sname].contains("twoColor"))
-                            anim["slots"][sname]["twoColor"] = json::array();
+        // Parse bones
+        pos = 0x08 + 0x62; // Start of bones section
+        skeleton.bones = ParseBones(buf, buf_size, pos, strings_base, strings_end, ctx.bone_names);
 
-                        for (int i = 0; i < frames; i++)
-                        {
-                            int b = i * ENTRIES;
-                            json fr;
-                            fr["time"] = values[b];
-                            fr["light"] = rgba_to_hex(values[b + 1], values[b + 2], values[b + 3], values[b + 4]);
-                            fr["dark"] = rgb_to_hex(values[b + 5], values[b + 6], values[b + 7]);
-                            maybe_add_curve(i, curves, fr);
-                            anim["slots"][sname]["twoColor"].push_back(fr);
-                        }
-                    }
+        // Parse IK constraints
+        skeleton.ik_constraints = ParseIKConstraints(buf, buf_size, pos, strings_base, strings_end, ctx.bone_names, ctx.ik_names);
+
+        // Parse slots
+        skeleton.slots = ParseSlots(buf, buf_size, pos, strings_base, strings_end, ctx.bone_names, ctx.slot_names);
+
+        // Parse transform constraints
+        skeleton.transform_constraints = ParseTransformConstraints(buf, buf_size, pos, strings_base, strings_end, ctx.bone_names, ctx.transform_names);
+
+        // Parse path constraints
+        skeleton.path_constraints = ParsePathConstraints(buf, buf_size, pos, strings_base, strings_end, ctx.bone_names, ctx.slot_names, ctx.path_names);
+
+        // Parse skins (Full)
+        skeleton.skins = ParseSkins(buf, buf_size, pos, strings_base, strings_end, ctx.slot_names, ctx.attachment_meta, hdr.hdr_version, ctx.skin_names);
+
+        // Parse events
+        skeleton.events = ParseEvents(buf, buf_size, pos, strings_base, strings_end);
+
+        return skeleton;
+    }
+
+    Skeleton ParseSkeleton(const std::vector<uint8_t> &decompressed_data)
+    {
+        const uint8_t *buf = decompressed_data.data();
+        size_t buf_size = decompressed_data.size();
+
+        AnimationContext ctx;
+        size_t pos;
+        Skeleton skeleton = ParseSetup(buf, buf_size, pos, ctx);
+
+        // Parse animations
+        skeleton.animations = ParseAnimations(buf, buf_size, pos, ctx);
+
+        return skeleton;
+    }
+
+    void WriteBones(JsonWriter &out, const std::vector<Bone> &bones)
+    {
+        static const char *const transform_modes[] = {"normal", "onlyTranslation", "noRotationOrReflection", "noScale", "noScaleOrReflection"};
+
+        out.begin_array();
+        for (const Bone &b : bones)
+        {
+            out.begin_object();
+            out.field("name", b.name);
+
+            if (!b.parent.empty())
+                out.field("parent", b.parent);
+
+            if (b.length != 0.0f)
+                out.field("length", b.length);
+            if (b.x != 0.0f)
+                out.field("x", b.x);
+            if (b.y != 0.0f)
+                out.field("y", b.y);
+            if (b.rotation != 0.0f)
+                out.field("rotation", b.rotation);
+            if (b.scale_x != 1.0f)
+                out.field("scaleX", b.scale_x);
+            if (b.scale_y != 1.0f)
+                out.field("scaleY", b.scale_y);
+            if (b.shear_x != 0.0f)
+                out.field("shearX", b.shear_x);
+            if (b.shear_y != 0.0f)
+                out.field("shearY", b.shear_y);
+
+            if (b.transform_mode >= 0 && b.transform_mode < 5)
+                out.field("transform", transform_modes[b.transform_mode]);
+            if (b.skin_required)
+                out.field("skin", true);
+
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WriteSlots(JsonWriter &out, const std::vector<Slot> &slots)
+    {
+        static const char *const blend_modes[] = {"normal", "additive", "multiply", "screen"};
+
+        out.begin_array();
+        for (const Slot &s : slots)
+        {
+            out.begin_object();
+            out.field("name", s.name);
+            out.field("bone", s.bone);
+
+            std::string col_hex = rgba_to_hex(s.color[0], s.color[1], s.color[2], s.color[3]);
+            if (col_hex != "FFFFFFFF")
+                out.field("color", col_hex);
+            if (s.has_dark)
+                out.field("dark", rgb_to_hex(s.dark[0], s.dark[1], s.dark[2]));
+            if (!s.attachment.empty())
+                out.field("attachment", s.attachment);
+            if (s.blend_mode > 0 && s.blend_mode < 4)
+                out.field("blend", blend_modes[s.blend_mode]);
+
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WriteIkConstraints(JsonWriter &out, const std::vector<IkConstraint> &iks)
+    {
+        out.begin_array();
+        for (const IkConstraint &c : iks)
+        {
+            out.begin_object();
+            out.field("name", c.name);
+            out.field("order", c.order);
+            out.field("skin", c.skin_required);
+            out.field("bones", c.bones);
+            out.field("target", c.target);
+            out.field("mix", c.mix);
+            out.field("softness", c.softness);
+            out.field("bendPositive", c.bend_positive);
+            if (c.compress)
+                out.field("compress", true);
+            if (c.stretch)
+                out.field("stretch", true);
+            if (c.uniform)
+                out.field("uniform", true);
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WriteTransformConstraints(JsonWriter &out, const std::vector<TransformConstraint> &transforms)
+    {
+        out.begin_array();
+        for (const TransformConstraint &c : transforms)
+        {
+            out.begin_object();
+            out.field("name", c.name);
+            out.field("order", c.order);
+            out.field("skin", c.skin_required);
+            out.field("target", c.target);
+            out.field("bones", c.bones);
+            out.field("rotateMix", c.rotate_mix);
+            out.field("translateMix", c.translate_mix);
+            out.field("scaleMix", c.scale_mix);
+            out.field("shearMix", c.shear_mix);
+            out.field("rotation", c.rotation);
+            out.field("x", c.x);
+            out.field("y", c.y);
+            out.field("scaleX", c.scale_x);
+            out.field("scaleY", c.scale_y);
+            out.field("shearY", c.shear_y);
+            out.field("relative", c.relative);
+            out.field("local", c.local);
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WritePathConstraints(JsonWriter &out, const std::vector<PathConstraint> &paths)
+    {
+        static const char *const pos_modes[] = {"fixed", "percent"};
+        static const char *const spacing_modes[] = {"length", "fixed", "percent"};
+        static const char *const rotate_modes[] = {"tangent", "chain", "chainScale"};
+
+        out.begin_array();
+        for (const PathConstraint &c : paths)
+        {
+            out.begin_object();
+            out.field("name", c.name);
+            out.field("order", c.order);
+            out.field("skin", c.skin_required);
+            out.field("positionMode", pos_modes[c.position_mode]);
+            out.field("spacingMode", spacing_modes[c.spacing_mode]);
+            out.field("rotateMode", rotate_modes[c.rotate_mode]);
+            out.field("rotation", c.rotation);
+            out.field("position", c.position);
+            out.field("spacing", c.spacing);
+            out.field("rotateMix", c.rotate_mix);
+            out.field("translateMix", c.translate_mix);
+            out.field("target", c.target);
+            out.field("bones", c.bones);
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WriteAttachment(JsonWriter &out, const Attachment &a, uint32_t format_version)
+    {
+        out.begin_object();
+        switch (a.type)
+        {
+        case AttachmentType::Region:
+        {
+            out.field("type", "region");
+            out.field("x", a.x);
+            out.field("y", a.y);
+            out.field("rotation", a.rotation);
+            out.field("scaleX", a.scale_x);
+            out.field("scaleY", a.scale_y);
+            out.field("width", a.width);
+            out.field("height", a.height);
+            if (!a.path.empty())
+                out.field("path", a.path);
+            std::string color = rgba_to_hex(a.color[0], a.color[1], a.color[2], a.color[3]);
+            if (color != "FFFFFFFF")
+                out.field("color", color);
+            break;
+        }
+        case AttachmentType::BoundingBox:
+            out.field("type", "boundingbox");
+            out.field("vertexCount", (int)a.world_vertices_length >> 1);
+            out.key("vertices");
+            write_vertices(out, a.bones, a.vertices);
+            if (!a.path.empty())
+                out.field("path", a.path);
+            break;
+        case AttachmentType::Mesh:
+        case AttachmentType::LinkedMesh:
+        {
+            bool linked = a.type == AttachmentType::LinkedMesh;
+            out.field("type", linked ? "linkedmesh" : "mesh");
+            if (linked)
+            {
+                out.field("parent", a.parent);
+                out.field("deform", a.deform);
+            }
+            out.field("uvs", a.uvs);
+            out.field("triangles", a.triangles);
+            out.key("vertices");
+            write_vertices(out, a.bones, a.vertices);
+            out.field("hull", a.hull);
+            out.field("edges", a.edges);
+            out.field("width", a.width);
+            out.field("height", a.height);
+            // Older files name the skin inline; newer ones resolve its index
+            // once every skin is known, so it comes last.
+            bool skin_last = format_version > 0x7530;
+            if (linked && !skin_last)
+                out.field("skin", a.skin);
+            if (!a.path.empty())
+                out.field("path", a.path);
+            if (linked && skin_last)
+                out.field("skin", a.skin);
+            break;
+        }
+        case AttachmentType::Path:
+            out.field("type", "path");
+            out.field("closed", a.closed);
+            out.field("constantSpeed", a.constant_speed);
+            out.field("lengths", a.lengths);
+            out.field("vertexCount", (int)a.world_vertices_length >> 1);
+            out.key("vertices");
+            write_vertices(out, a.bones, a.vertices);
+            if (!a.path.empty())
+                out.field("path", a.path);
+            break;
+        case AttachmentType::Point:
+            out.field("type", "point");
+            out.field("x", a.x);
+            out.field("y", a.y);
+            out.field("rotation", a.rotation);
+            break;
+        case AttachmentType::Clipping:
+            out.field("type", "clipping");
+            out.field("end", a.end_slot);
+            out.field("vertexCount", (int)a.world_vertices_length >> 1);
+            out.key("vertices");
+            write_vertices(out, a.bones, a.vertices);
+            if (!a.path.empty())
+                out.field("path", a.path);
+            break;
+        }
+        out.end_object();
+    }
+
+    void WriteSkins(JsonWriter &out, const std::vector<Skin> &skins, uint32_t format_version)
+    {
+        out.begin_array();
+        for (const Skin &skin : skins)
+        {
+            out.begin_object();
+            out.field("name", skin.name);
+            out.key("attachments");
+            out.begin_object();
+            for (const auto &[slot, attachments] : LayoutSkin(skin))
+            {
+                out.key(slot);
+                out.begin_object();
+                for (const auto &[name, a] : attachments)
+                {
+                    out.key(name);
+                    WriteAttachment(out, *a, format_version);
                 }
-                else
+                out.end_object();
+            }
+            out.end_object();
+            out.end_object();
+        }
+        out.end_array();
+    }
+
+    void WriteEvents(JsonWriter &out, const std::vector<Event> &events)
+    {
+        out.begin_object();
+        for (const auto &[name, e] : LayoutEvents(events))
+        {
+            out.key(name);
+            out.begin_object();
+            out.field("int", e->int_value);
+            out.field("float", e->float_value);
+            out.field("string", e->string_value);
+            out.field("audio", e->audio_path);
+            out.field("volume", e->volume);
+            out.field("balance", e->balance);
+            out.end_object();
+        }
+        out.end_object();
+    }
+
+    const char *TimelineName(TimelineType type)
+    {
+        switch (type)
+        {
+        case TimelineType::Rotate: return "rotate";
+        case TimelineType::Translate: return "translate";
+        case TimelineType::Scale: return "scale";
+        case TimelineType::Shear: return "shear";
+        case TimelineType::Attachment: return "attachment";
+        case TimelineType::Color: return "color";
+        case TimelineType::TwoColor: return "twoColor";
+        case TimelineType::PathConstraintPosition: return "position";
+        case TimelineType::PathConstraintSpacing: return "spacing";
+        case TimelineType::PathConstraintMix: return "mix";
+        default: return "";
+        }
+    }
+
+    // The frames of every part in turn; curves are looked up per part.
+    void WriteFrames(JsonWriter &out, const TimelineParts &parts)
+    {
+        out.begin_array();
+        for (const Timeline *part : parts)
+        {
+            size_t entries = FrameEntries(part->type);
+            for (size_t i = 0; i < part->frames.size() / entries; i++)
+            {
+                const float *v = part->frames.data() + i * entries;
+                out.begin_object();
+                out.field("time", v[0]);
+                switch (part->type)
                 {
+                case TimelineType::Rotate:
+                    out.field("angle", v[1]);
+                    break;
+                case TimelineType::Translate:
+                case TimelineType::Scale:
+                case TimelineType::Shear:
+                    out.field("x", v[1]);
+                    out.field("y", v[2]);
+                    break;
+                case TimelineType::Attachment:
+                    if (!part->attachment_names[i].empty())
+                        out.field("name", part->attachment_names[i]);
+                    else
+                        out.field("name", nullptr);
+                    break;
+                case TimelineType::Color:
+                    out.field("color", rgba_to_hex(v[1], v[2], v[3], v[4]));
+                    break;
+                case TimelineType::TwoColor:
+                    out.field("light", rgba_to_hex(v[1], v[2], v[3], v[4]));
+                    out.field("dark", rgb_to_hex(v[5], v[6], v[7]));
+                    break;
+                case TimelineType::Deform:
+                {
+                    const DeformKey &key = part->deform[i];
+                    if (!key.vertices.empty())
+                    {
+                        out.field("vertices", key.vertices);
+                        if (key.offset > 0)
+                            out.field("offset", key.offset);
+                    }
+                    break;
+                }
+                case TimelineType::IkConstraint:
+                    out.field("mix", v[1]);
+                    out.field("softness", v[2]);
+                    out.field("bendPositive", v[3] >= 0.0f);
+                    if (v[4] != 0)
+                        out.field("compress", true);
+                    if (v[5] != 0)
+                        out.field("stretch", true);
+                    break;
+                case TimelineType::TransformConstraint:
+                    out.field("rotateMix", v[1]);
+                    out.field("translateMix", v[2]);
+                    out.field("scaleMix", v[3]);
+                    out.field("shearMix", v[4]);
+                    break;
+                case TimelineType::PathConstraintPosition:
+                case TimelineType::PathConstraintSpacing:
+                    out.field(TimelineName(part->type), v[1]);
+                    break;
+                case TimelineType::PathConstraintMix:
+                    out.field("rotateMix", v[1]);
+                    out.field("translateMix", v[2]);
+                    break;
+                default:
                     break;
                 }
+                if (part->type != TimelineType::Attachment)
+                    write_curve(out, part->curves, i);
+                out.end_object();
             }
+        }
+        out.end_array();
+    }
 
-            if (anim["events"].empty())
+    void WriteTypedTimelines(JsonWriter &out, const OrderedGroups<TypedTimelines> &groups)
+    {
+        out.begin_object();
+        for (const auto &[target, timelines] : groups)
+        {
+            out.key(target);
+            out.begin_object();
+            for (const auto &[type, parts] : timelines)
             {
-                anim.erase("events");
+                out.key(TimelineName(type));
+                WriteFrames(out, parts);
             }
-
-            anim["duration"] = duration;
-            animations[name] = anim;
+            out.end_object();
         }
-        return animations;
+        out.end_object();
     }
 
-    std::string ParseSCSPToJson(const std::vector<uint8_t> &decompressed_data)
+    void WriteTimelines(JsonWriter &out, const OrderedGroups<TimelineParts> &groups)
     {
-        if (decompressed_data.empty())
-            return "{}";
+        out.begin_object();
+        for (const auto &[target, parts] : groups)
+        {
+            out.key(target);
+            WriteFrames(out, parts);
+        }
+        out.end_object();
+    }
 
-        const uint8_t *buf = decompressed_data.data();
-        size_t buf_size = decompressed_data.size();
+    // Timelines are grouped by target first, so every section comes out in
+    // one pass with the keys in the order the SCSP first names them.
+    void WriteAnimation(JsonWriter &out, const Animation &animation)
+    {
+        AnimationLayout layout = LayoutAnimation(animation);
+
+        out.begin_object();
+        out.key("bones");
+        WriteTypedTimelines(out, layout.bones);
+        out.key("slots");
+        WriteTypedTimelines(out, layout.slots);
+        out.key("ik");
+        WriteTimelines(out, layout.ik);
+        out.key("transform");
+        WriteTimelines(out, layout.transform);
+        out.key("path");
+        WriteTypedTimelines(out, layout.paths);
+
+        out.key("deform");
+        out.begin_object();
+        for (const auto &[skin, slots] : layout.deform)
+        {
+            out.key(skin);
+            out.begin_object();
+            for (const auto &[slot, attachments] : slots)
+            {
+                out.key(slot);
+                WriteTimelines(out, attachments);
+            }
+            out.end_object();
+        }
+        out.end_object();
 
-        // Parse header
-        Header hdr = ParseHeader(buf, buf_size);
+        if (layout.draw_order)
+        {
+            out.key("drawOrder");
+            out.begin_array();
+            for (const DrawOrderKey &key : layout.draw_order->draw_order)
+            {
+                out.begin_object();
+                out.field("time", key.time);
+                out.key("offsets");
+                out.begin_array();
+                for (const auto &[slot, offset] : key.offsets)
+                {
+                    out.begin_object();
+                    out.field("slot", slot);
+                    out.field("offset", offset);
+                    out.end_object();
+                }
+                out.end_array();
+                out.end_object();
+            }
+            out.end_array();
+        }
 
-        size_t strings_base = hdr.string_offset + 8;
-        size_t strings_end = strings_base + hdr.string_length;
+        out.field("duration", animation.duration);
+        out.end_object();
+    }
 
-        // Build skeleton section
-        json skeleton;
-        skeleton["spine"] = hdr.version.empty() ? "3.8.79" : hdr.version;
-        skeleton["x"] = 0.0f;
-        skeleton["y"] = 0.0f;
+    // Rough size of the JSON: keyframe values come out as indented fields with
+    // their curves, array values one per indented line.
+    size_t EstimateJsonSize(const Skeleton &skeleton)
+    {
+        size_t fields = 0, elements = 0;
+        for (const Skin &skin : skeleton.skins)
+        {
+            for (const Attachment &a : skin.attachments)
+            {
+                fields += 16;
+                elements += a.bones.size() + a.vertices.size() + a.uvs.size() + a.triangles.size() + a.edges.size() + a.lengths.size();
+            }
+        }
+        for (const Animation &animation : skeleton.animations)
+        {
+            for (const Timeline &t : animation.timelines)
+            {
+                fields += t.frames.size() * 2;
+                for (const DeformKey &key : t.deform)
+                    elements += key.vertices.size();
+                for (const DrawOrderKey &key : t.draw_order)
+                    fields += key.offsets.size() * 2;
+            }
+        }
+        return 4096 + fields * 64 + elements * 32;
+    }
 
+    std::string ToJson(const Skeleton &skeleton)
+    {
+        const HeaderInfo &hdr = skeleton.header;
+
+        // Reserved up front so the text is not copied each time it outgrows
+        // its buffer; pages past the end are never touched.
+        std::string result;
+        result.reserve(EstimateJsonSize(skeleton));
+        JsonWriter out(result);
+        out.begin_object();
+
+        out.key("skeleton");
+        out.begin_object();
+        out.field("spine", hdr.version.empty() ? "3.8.79" : hdr.version);
+        out.field("x", 0.0f);
+        out.field("y", 0.0f);
         if (hdr.width != 0.0f)
-            skeleton["width"] = hdr.width;
+            out.field("width", hdr.width);
         if (hdr.height != 0.0f)
-            skeleton["height"] = hdr.height;
+            out.field("height", hdr.height);
         if (!hdr.hash.empty())
-            skeleton["hash"] = hdr.hash;
+            out.field("hash", hdr.hash);
         if (!hdr.images_path.empty())
-            skeleton["images"] = hdr.images_path;
+            out.field("images", hdr.images_path);
         if (!hdr.audio_path.empty())
-            skeleton["audio"] = hdr.audio_path;
-
-        // Parse bones
-        size_t pos = 0x08 + 0x62; // Start of bones section
-        std::map<int16_t, std::string> bone_names;
-        json bones = ParseBones(buf, buf_size, pos, strings_base, strings_end, bone_names);
+            out.field("audio", hdr.audio_path);
+        out.end_object();
+
+        out.key("bones");
+        WriteBones(out, skeleton.bones);
+        out.key("ik");
+        WriteIkConstraints(out, skeleton.ik_constraints);
+        out.key("slots");
+        WriteSlots(out, skeleton.slots);
+        out.key("transform");
+        WriteTransformConstraints(out, skeleton.transform_constraints);
+        out.key("path");
+        WritePathConstraints(out, skeleton.path_constraints);
+        out.key("skins");
+        WriteSkins(out, skeleton.skins, skeleton.format_version);
+        out.key("events");
+        WriteEvents(out, skeleton.events);
+
+        out.key("animations");
+        out.begin_object();
+        for (const auto &[name, animation] : LayoutAnimations(skeleton.animations))
+        {
+            out.key(name);
+            WriteAnimation(out, *animation);
+        }
+        out.end_object();
 
-        // Parse IK constraints
-        std::map<int, std::string> ik_names;
-        json iks = ParseIKConstraints(buf, buf_size, pos, strings_base, strings_end, bone_names, ik_names);
+        out.end_object();
+        out.flush();
+        return result;
+    }
 
-        // Parse slots
-        std::map<int16_t, std::string> slot_names;
-        json slots = ParseSlots(buf, buf_size, pos, strings_base, strings_end, bone_names, slot_names);
+    Skeleton ReadSkeleton(const std::vector<uint8_t> &scsp_data)
+    {
+        return ParseSkeleton(DecompressSCSP(scsp_data));
+    }
 
-        // Parse transform constraints
-        std::map<int, std::string> transform_names;
-        json transforms = ParseTransformConstraints(buf, buf_size, pos, strings_base, strings_end, bone_names, transform_names);
+    struct SkeletonReader::Context
+    {
+        std::vector<uint8_t> data;
+        AnimationContext names;
+        // Start of the animation section.
+        size_t section = 0;
+    };
 
-        // Parse path constraints
-        std::map<int, std::string> path_names;
-        json paths = ParsePathConstraints(buf, buf_size, pos, strings_base, strings_end, bone_names, slot_names, path_names);
+    SkeletonReader::SkeletonReader(const std::vector<uint8_t> &scsp_data)
+        : context(std::make_unique<Context>())
+    {
+        context->data = DecompressSCSP(scsp_data);
+        const uint8_t *buf = context->data.data();
+        size_t buf_size = context->data.size();
+
+        skeleton = ParseSetup(buf, buf_size, context->section, context->names);
+
+        size_t pos = context->section;
+        OrderedGroups<AnimationEntry> by_name;
+        for (AnimationEntry &entry : IndexAnimations(buf, buf_size, pos, context->names))
+            by_name[entry.name] = std::move(entry);
+        animations.reserve(by_name.size());
+        for (const auto &[name, entry] : by_name)
+            animations.push_back(entry);
+    }
 
-        // Parse skins (Full)
-        AttachmentMetaMap attachment_meta;
-        std::map<int, std::string> skin_names;
-        json skins = ParseSkins(buf, buf_size, pos, strings_base, strings_end, slot_names, attachment_meta, hdr.hdr_version, skin_names);
+    SkeletonReader::~SkeletonReader() = default;
 
-        // Parse events
-        std::map<int, std::string> event_names;
-        json events = ParseEvents(buf, buf_size, pos, strings_base, strings_end, event_names);
+    Animation SkeletonReader::ReadAnimation(size_t index) const
+    {
+        return ParseAnimation(context->data.data(), context->data.size(), animations.at(index), context->names);
+    }
 
-        // Parse animations
-        json animations = ParseAnimations(buf, buf_size, pos, strings_base, strings_end,
-                                          bone_names, slot_names, skin_names, ik_names, transform_names, path_names, event_names,
-                                          attachment_meta, hdr.hdr_version);
-
-        // Build final JSON
-        json result;
-        result["skeleton"] = skeleton;
-        result["bones"] = bones;
-        result["ik"] = iks;
-        result["slots"] = slots;
-        result["transform"] = transforms;
-        result["path"] = paths;
-        result["skins"] = skins;
-        result["events"] = events;
-        result["animations"] = animations;
-
-        return result.dump(4);
+    Skeleton SkeletonReader::ReadAll() const
+    {
+        Skeleton all = skeleton;
+        size_t pos = context->section;
+        all.animations = ParseAnimations(context->data.data(), context->data.size(), pos, context->names);
+        return all;
     }
 
     std::string ConvertSCSPToJson(const std::vector<uint8_t> &scsp_data)
     {
         auto decompressed = DecompressSCSP(scsp_data);
-        return ParseSCSPToJson(decompressed);
+        if (decompressed.empty())
+            return "{}";
+        return ToJson(ParseSkeleton(decompressed));
+    }
+
+    bool ParseSkeletonFormat(const std::string &name, SkeletonFormat &format)
+    {
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower == "json") format = SkeletonFormat::Json;
+        else if (lower == "skel") format = SkeletonFormat::Skel;
+        else return false;
+        return true;
+    }
+
+    const char *SkeletonFormatName(SkeletonFormat format)
+    {
+        return format == SkeletonFormat::Skel ? "skel" : "json";
+    }
+
+    std::vector<uint8_t> ConvertSCSP(const std::vector<uint8_t> &scsp_data, SkeletonFormat format)
+    {
+        if (format == SkeletonFormat::Skel)
+            return ToBinary(ReadSkeleton(scsp_data));
+        std::string json_str = ConvertSCSPToJson(scsp_data);
+        return std::vector<uint8_t>(json_str.begin(), json_str.end());
     }
 
     HeaderInfo ExtractHeader(const std::vector<uint8_t> &scsp_data)
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <memory>
 
 namespace SCSPParser {
     std::string ConvertSCSPToJson(const std::vector<uint8_t>& scsp_data);
@@ -18,4 +19,237 @@ namespace SCSPParser {
 
     // Lightweight: decompresses and reads only the SCSP header fields.
     HeaderInfo ExtractHeader(const std::vector<uint8_t>& scsp_data);
+
+    // Decoded SCSP skeleton. Bones, slots, constraints and skins are referred to
+    // by the names the JSON export writes for them, including its fallbacks for
+    // unnamed or unknown entries, so every consumer resolves them the same way.
+    struct Bone {
+        std::string name;
+        std::string parent;
+        float length = 0, x = 0, y = 0, rotation = 0;
+        float scale_x = 1, scale_y = 1, shear_x = 0, shear_y = 0;
+        // 0 normal, 1 onlyTranslation, 2 noRotationOrReflection, 3 noScale,
+        // 4 noScaleOrReflection; anything else is written as the default.
+        int transform_mode = 0;
+        bool skin_required = false;
+    };
+
+    struct Slot {
+        std::string name;
+        std::string bone;
+        float color[4] = { 1, 1, 1, 1 };
+        float dark[3] = { 0, 0, 0 };
+        bool has_dark = false;
+        std::string attachment;
+        // 0 normal, 1 additive, 2 multiply, 3 screen.
+        int blend_mode = 0;
+    };
+
+    struct IkConstraint {
+        std::string name;
+        int order = 0;
+        bool skin_required = false;
+        std::vector<std::string> bones;
+        std::string target;
+        float mix = 1, softness = 0;
+        bool bend_positive = true, compress = false, stretch = false, uniform = false;
+    };
+
+    struct TransformConstraint {
+        std::string name;
+        int order = 0;
+        bool skin_required = false;
+        std::vector<std::string> bones;
+        std::string target;
+        float rotate_mix = 1, translate_mix = 1, scale_mix = 1, shear_mix = 1;
+        float rotation = 0, x = 0, y = 0, scale_x = 0, scale_y = 0, shear_y = 0;
+        bool relative = false, local = false;
+    };
+
+    struct PathConstraint {
+        std::string name;
+        int order = 0;
+        bool skin_required = false;
+        std::vector<std::string> bones;
+        std::string target;
+        // Position 0 fixed, 1 percent; spacing 0 length, 1 fixed, 2 percent;
+        // rotate 0 tangent, 1 chain, 2 chainScale.
+        int position_mode = 1, spacing_mode = 0, rotate_mode = 0;
+        float rotation = 0, position = 0, spacing = 0;
+        float rotate_mix = 1, translate_mix = 1;
+    };
+
+    enum class AttachmentType { Region, BoundingBox, Mesh, LinkedMesh, Path, Point, Clipping };
+
+    struct Attachment {
+        AttachmentType type = AttachmentType::Region;
+        std::string slot;
+        std::string name;
+        // Atlas region for regions and meshes; for the other vertex attachments
+        // only carried through to the JSON.
+        std::string path;
+
+        // Region and point; regions also use width, height and color.
+        float x = 0, y = 0, rotation = 0, scale_x = 1, scale_y = 1;
+        float width = 0, height = 0;
+        float color[4] = { 1, 1, 1, 1 };
+
+        // Vertex attachments. Unweighted vertices are x, y pairs; weighted ones
+        // list each vertex's bone count followed by its bone indices in bones and
+        // hold x, y, weight per bone in vertices, as the Spine runtime does.
+        std::vector<int16_t> bones;
+        std::vector<float> vertices;
+        uint32_t world_vertices_length = 0;
+
+        // Meshes and linked meshes.
+        std::vector<float> uvs;
+        std::vector<uint16_t> triangles;
+        std::vector<uint16_t> edges;
+        uint32_t hull = 0;
+        std::string parent;
+        std::string skin;
+        bool deform = false;
+
+        // Paths.
+        std::vector<float> lengths;
+        bool closed = false, constant_speed = false;
+
+        // Clipping.
+        std::string end_slot;
+    };
+
+    struct Skin {
+        std::string name;
+        std::vector<Attachment> attachments;
+    };
+
+    struct Event {
+        std::string name;
+        uint32_t int_value = 0;
+        float float_value = 0;
+        std::string string_value;
+        std::string audio_path;
+        float volume = 1, balance = 0;
+    };
+
+    struct Curve {
+        enum Type : uint8_t { Linear, Stepped, Bezier } type = Linear;
+        // Bezier control points, rounded as the JSON writes them.
+        double cx1 = 0, cy1 = 0, cx2 = 1, cy2 = 1;
+    };
+
+    // Timeline types as numbered in the SCSP animation section.
+    enum class TimelineType : uint16_t {
+        Rotate, Translate, Scale, Shear, Attachment, Color, Deform, Event, DrawOrder,
+        IkConstraint, TransformConstraint, PathConstraintPosition, PathConstraintSpacing,
+        PathConstraintMix, TwoColor
+    };
+
+    // Vertices relative to the attachment's setup pose for unweighted
+    // attachments, with leading and trailing zeros trimmed: the first value
+    // belongs at offset. Empty when the key equals the setup pose.
+    struct DeformKey {
+        int offset = 0;
+        std::vector<float> vertices;
+    };
+
+    struct DrawOrderKey {
+        float time = 0;
+        // Slots that moved and by how many places, in slot order.
+        std::vector<std::pair<std::string, int>> offsets;
+    };
+
+    struct Timeline {
+        TimelineType type = TimelineType::Rotate;
+        // Bone, slot or constraint the timeline animates.
+        std::string target;
+        // Keyframes as the Spine runtime lays them out: the time followed by
+        // the frame's values (angle; x, y; r, g, b, a; mix, softness, bend,
+        // compress, stretch; ...). Attachment, deform and draw order timelines
+        // hold only the times.
+        std::vector<float> frames;
+        // Curve to the next keyframe; frames past the end are linear.
+        std::vector<Curve> curves;
+
+        std::vector<std::string> attachment_names;
+
+        std::string skin;
+        std::string attachment;
+        std::vector<DeformKey> deform;
+
+        std::vector<DrawOrderKey> draw_order;
+    };
+
+    struct Animation {
+        std::string name;
+        float duration = 0;
+        // In file order; event timelines are skipped.
+        std::vector<Timeline> timelines;
+    };
+
+    struct Skeleton {
+        HeaderInfo header;
+        // Layout version from the SCSP header; newer files refer to skins by index.
+        uint32_t format_version = 0;
+        std::vector<Bone> bones;
+        std::vector<IkConstraint> ik_constraints;
+        std::vector<Slot> slots;
+        std::vector<TransformConstraint> transform_constraints;
+        std::vector<PathConstraint> path_constraints;
+        std::vector<Skin> skins;
+        std::vector<Event> events;
+        std::vector<Animation> animations;
+    };
+
+    // Decompresses and decodes a whole SCSP file; throws on a malformed header.
+    Skeleton ReadSkeleton(const std::vector<uint8_t>& scsp_data);
+
+    // Where one animation sits in the decompressed SCSP data.
+    struct AnimationEntry {
+        std::string name;
+        float duration = 0;
+        // Position in the file's animation list, which names its fallbacks.
+        uint16_t index = 0;
+        size_t begin = 0, end = 0;
+    };
+
+    // Reads the setup pose of an SCSP file and indexes its animations, leaving
+    // their timelines to be decoded one at a time; for callers that only look
+    // at a few animations of a large skeleton.
+    class SkeletonReader {
+    public:
+        // Throws on a malformed header, as ReadSkeleton does.
+        explicit SkeletonReader(const std::vector<uint8_t>& scsp_data);
+        ~SkeletonReader();
+
+        // Everything but the animations.
+        const Skeleton& GetSkeleton() const { return skeleton; }
+        // One entry per name, as the JSON export keeps them: the last animation
+        // with a name, at the position of the first.
+        const std::vector<AnimationEntry>& GetAnimations() const { return animations; }
+
+        Animation ReadAnimation(size_t index) const;
+        // The whole skeleton, as ReadSkeleton returns it.
+        Skeleton ReadAll() const;
+
+    private:
+        struct Context;
+        std::unique_ptr<Context> context;
+        Skeleton skeleton;
+        std::vector<AnimationEntry> animations;
+    };
+
+    // Spine 3.8 JSON, as written on export.
+    std::string ToJson(const Skeleton& skeleton);
+    // Spine 3.8 binary (.skel) with nonessential data, loading into the same
+    // skeleton as the JSON. Throws where a name does not resolve or the layout
+    // cannot hold the skeleton, such as a second root bone.
+    std::vector<uint8_t> ToBinary(const Skeleton& skeleton);
+
+    enum class SkeletonFormat { Json, Skel };
+    bool ParseSkeletonFormat(const std::string& name, SkeletonFormat& format);
+    // Also the file extension, without the dot.
+    const char* SkeletonFormatName(SkeletonFormat format);
+    // ConvertSCSPToJson or ToBinary; throws on a malformed file.
+    std::vector<uint8_t> ConvertSCSP(const std::vector<uint8_t>& scsp_data, SkeletonFormat format);
 }
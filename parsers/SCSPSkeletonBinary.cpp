@@ -0,0 +1,799 @@
+#include "SCSPParser.h"
+#include "SCSPLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace SCSPParser;
+
+namespace
+{
+    // Colors the Spine editor gives bones and unrendered attachments. The
+    // binary only carries them as nonessential data, which it needs for mesh
+    // edges and sizes.
+    const uint32_t bone_color = 0x989898FF;
+    const uint32_t bounding_box_color = 0x60F000FF;
+    const uint32_t path_color = 0xFF7F00FF;
+    const uint32_t point_color = 0xF1F100FF;
+    const uint32_t clipping_color = 0xCE3A3AFF;
+
+    // Numbering of SkeletonBinary.
+    enum SlotTimelineType : uint8_t { SlotAttachment, SlotColor, SlotTwoColor };
+    enum BoneTimelineType : uint8_t { BoneRotate, BoneTranslate, BoneScale, BoneShear };
+    enum PathTimelineType : uint8_t { PathPosition, PathSpacing, PathMix };
+    enum CurveType : uint8_t { CurveLinear, CurveStepped, CurveBezier };
+
+    // Quantized like the JSON export's hex colors.
+    uint32_t color_byte(float v)
+    {
+        return (uint32_t)std::round((v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f) * 255.0f);
+    }
+
+    uint32_t rgba8888(float r, float g, float b, float a)
+    {
+        return color_byte(r) << 24 | color_byte(g) << 16 | color_byte(b) << 8 | color_byte(a);
+    }
+
+    // Big-endian fixed-size values and 7-bit varints, as DataInput reads them.
+    class Output
+    {
+    public:
+        std::vector<uint8_t> bytes;
+
+        void Byte(uint8_t v) { bytes.push_back(v); }
+        void Bool(bool v) { Byte(v ? 1 : 0); }
+
+        void Int(uint32_t v)
+        {
+            Byte((uint8_t)(v >> 24));
+            Byte((uint8_t)(v >> 16));
+            Byte((uint8_t)(v >> 8));
+            Byte((uint8_t)v);
+        }
+
+        void Float(float v)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            Int(bits);
+        }
+
+        // Negative values take all five bytes and read back as themselves.
+        void Varint(uint32_t v)
+        {
+            while (v >= 0x80)
+            {
+                Byte((uint8_t)(v | 0x80));
+                v >>= 7;
+            }
+            Byte((uint8_t)v);
+        }
+
+        void SignedVarint(int32_t v) { Varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+
+        void String(const std::string &s)
+        {
+            Varint((uint32_t)s.size() + 1);
+            bytes.insert(bytes.end(), s.begin(), s.end());
+        }
+
+        void Shorts(const std::vector<uint16_t> &values)
+        {
+            Varint((uint32_t)values.size());
+            for (uint16_t v : values)
+            {
+                Byte((uint8_t)(v >> 8));
+                Byte((uint8_t)v);
+            }
+        }
+
+        void Append(const Output &other) { bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end()); }
+    };
+
+    class SkelWriter
+    {
+    public:
+        explicit SkelWriter(const Skeleton &skeleton) : skeleton(skeleton) {}
+
+        std::vector<uint8_t> Write()
+        {
+            WriteBones();
+            WriteSlots();
+            WriteIkConstraints();
+            WriteTransformConstraints();
+            WritePathConstraints();
+            WriteSkins();
+            WriteEvents();
+            WriteAnimations();
+
+            // The string table sits between the header and the data that refers
+            // to it, so it is only known once everything else is written.
+            Output head;
+            WriteHeader(head);
+            head.Varint((uint32_t)strings.size());
+            for (const std::string &s : strings)
+                head.String(s);
+            head.Append(out);
+            return std::move(head.bytes);
+        }
+
+    private:
+        const Skeleton &skeleton;
+        Output out;
+
+        std::vector<std::string> strings;
+        std::unordered_map<std::string, uint32_t> string_refs;
+
+        NameIndex bones, slots, ik_constraints, transform_constraints, path_constraints, skins;
+        // Decoded skin indices by name in binary order, as the runtime finds
+        // the skins of linked meshes.
+        NameIndex binary_skins;
+        std::vector<SkinLayout> skin_layouts;
+        // Index each decoded skin gets in the binary, where the default skin comes first.
+        std::vector<uint32_t> skin_indices;
+        int default_skin = -1;
+
+        // Empty names are written as null, which the runtime reads as empty.
+        void StringRef(Output &o, const std::string &s)
+        {
+            if (s.empty())
+            {
+                o.Varint(0);
+                return;
+            }
+            auto [it, inserted] = string_refs.emplace(s, (uint32_t)strings.size());
+            if (inserted)
+                strings.push_back(s);
+            o.Varint(it->second + 1);
+        }
+
+        void WriteHeader(Output &o) const
+        {
+            const HeaderInfo &hdr = skeleton.header;
+            std::string version = hdr.version.empty() ? "3.8.79" : hdr.version;
+            if (version == "3.8.75")
+                throw std::runtime_error("Unsupported skeleton data, please export with a newer version of Spine.");
+
+            o.String(hdr.hash);
+            o.String(version);
+            o.Float(0.0f);
+            o.Float(0.0f);
+            o.Float(hdr.width);
+            o.Float(hdr.height);
+            o.Bool(true);
+            o.Float(30.0f);
+            o.String(hdr.images_path);
+            o.String(hdr.audio_path);
+        }
+
+        void WriteBones()
+        {
+            out.Varint((uint32_t)skeleton.bones.size());
+            for (size_t i = 0; i < skeleton.bones.size(); i++)
+            {
+                const Bone &b = skeleton.bones[i];
+                int parent = b.parent.empty() ? -1 : bones.require(b.parent, "Parent bone");
+                // Every bone but the first names its parent.
+                if (i > 0 && parent < 0)
+                    throw std::runtime_error("Bone has no parent: " + b.name);
+                bones.add(b.name, (int)i);
+
+                out.String(b.name);
+                if (i > 0)
+                    out.Varint((uint32_t)parent);
+                out.Float(b.rotation);
+                out.Float(b.x);
+                out.Float(b.y);
+                out.Float(b.scale_x);
+                out.Float(b.scale_y);
+                out.Float(b.shear_x);
+                out.Float(b.shear_y);
+                out.Float(b.length);
+                out.Varint(b.transform_mode >= 0 && b.transform_mode < 5 ? (uint32_t)b.transform_mode : 0);
+                out.Bool(b.skin_required);
+                out.Int(bone_color);
+            }
+        }
+
+        void WriteSlots()
+        {
+            out.Varint((uint32_t)skeleton.slots.size());
+            for (size_t i = 0; i < skeleton.slots.size(); i++)
+            {
+                const Slot &s = skeleton.slots[i];
+                int bone = bones.require(s.bone, "Slot bone");
+                slots.add(s.name, (int)i);
+
+                out.String(s.name);
+                out.Varint((uint32_t)bone);
+                out.Int(rgba8888(s.color[0], s.color[1], s.color[2], s.color[3]));
+                // All ones means no dark color, so the unused alpha keeps a
+                // white one apart.
+                if (s.has_dark)
+                    out.Int(rgba8888(s.dark[0], s.dark[1], s.dark[2], 0.0f));
+                else
+                    out.Int(0xFFFFFFFF);
+                StringRef(out, s.attachment);
+                out.Varint(s.blend_mode > 0 && s.blend_mode < 4 ? (uint32_t)s.blend_mode : 0);
+            }
+        }
+
+        void WriteBoneList(const std::vector<std::string> &names, const char *what)
+        {
+            out.Varint((uint32_t)names.size());
+            for (const std::string &name : names)
+                out.Varint((uint32_t)bones.require(name, what));
+        }
+
+        void WriteIkConstraints()
+        {
+            out.Varint((uint32_t)skeleton.ik_constraints.size());
+            for (size_t i = 0; i < skeleton.ik_constraints.size(); i++)
+            {
+                const IkConstraint &c = skeleton.ik_constraints[i];
+                ik_constraints.add(c.name, (int)i);
+
+                out.String(c.name);
+                out.Varint((uint32_t)c.order);
+                out.Bool(c.skin_required);
+                WriteBoneList(c.bones, "IK bone");
+                out.Varint((uint32_t)bones.require(c.target, "Target bone"));
+                out.Float(c.mix);
+                out.Float(c.softness);
+                out.Byte(c.bend_positive ? 1 : 0xFF);
+                out.Bool(c.compress);
+                out.Bool(c.stretch);
+                out.Bool(c.uniform);
+            }
+        }
+
+        void WriteTransformConstraints()
+        {
+            out.Varint((uint32_t)skeleton.transform_constraints.size());
+            for (size_t i = 0; i < skeleton.transform_constraints.size(); i++)
+            {
+                const TransformConstraint &c = skeleton.transform_constraints[i];
+                transform_constraints.add(c.name, (int)i);
+
+                out.String(c.name);
+                out.Varint((uint32_t)c.order);
+                out.Bool(c.skin_required);
+                WriteBoneList(c.bones, "Transform bone");
+                out.Varint((uint32_t)bones.require(c.target, "Target bone"));
+                out.Bool(c.local);
+                out.Bool(c.relative);
+                out.Float(c.rotation);
+                out.Float(c.x);
+                out.Float(c.y);
+                out.Float(c.scale_x);
+                out.Float(c.scale_y);
+                out.Float(c.shear_y);
+                out.Float(c.rotate_mix);
+                out.Float(c.translate_mix);
+                out.Float(c.scale_mix);
+                out.Float(c.shear_mix);
+            }
+        }
+
+        void WritePathConstraints()
+        {
+            out.Varint((uint32_t)skeleton.path_constraints.size());
+            for (size_t i = 0; i < skeleton.path_constraints.size(); i++)
+            {
+                const PathConstraint &c = skeleton.path_constraints[i];
+                path_constraints.add(c.name, (int)i);
+
+                out.String(c.name);
+                out.Varint((uint32_t)c.order);
+                out.Bool(c.skin_required);
+                WriteBoneList(c.bones, "Path bone");
+                out.Varint((uint32_t)slots.require(c.target, "Target slot"));
+                out.Varint((uint32_t)c.position_mode);
+                out.Varint((uint32_t)c.spacing_mode);
+                out.Varint((uint32_t)c.rotate_mode);
+                out.Float(c.rotation);
+                out.Float(c.position);
+                out.Float(c.spacing);
+                out.Float(c.rotate_mix);
+                out.Float(c.translate_mix);
+            }
+        }
+
+        static uint32_t VertexCount(const Attachment &a)
+        {
+            return a.type == AttachmentType::Mesh ? (uint32_t)(a.uvs.size() / 2) : a.world_vertices_length >> 1;
+        }
+
+        // Writes vertex_count vertices when o is set and returns the length of
+        // a deform key for them. The reader takes exactly vertex_count entries,
+        // so missing bones and values are written as zero.
+        static size_t WriteVertices(Output *o, const Attachment &a, uint32_t vertex_count)
+        {
+            if (a.bones.empty())
+            {
+                if (o)
+                {
+                    o->Bool(false);
+                    for (size_t i = 0; i < (size_t)vertex_count * 2; i++)
+                        o->Float(i < a.vertices.size() ? a.vertices[i] : 0.0f);
+                }
+                return (size_t)vertex_count * 2;
+            }
+
+            if (o)
+                o->Bool(true);
+            size_t b = 0, v = 0, weights = 0;
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                int count = b < a.bones.size() ? std::max<int>(a.bones[b++], 0) : 0;
+                if (o)
+                    o->Varint((uint32_t)count);
+                for (int k = 0; k < count; k++, weights++)
+                {
+                    int16_t bone = b < a.bones.size() ? a.bones[b++] : 0;
+                    if (!o)
+                        continue;
+                    o->Varint((uint32_t)bone);
+                    for (int c = 0; c < 3; c++, v++)
+                        o->Float(v < a.vertices.size() ? a.vertices[v] : 0.0f);
+                }
+            }
+            return weights * 2;
+        }
+
+        void WriteAttachment(const Attachment &a)
+        {
+            // The key is the name; no separate name follows.
+            StringRef(out, a.name);
+            StringRef(out, "");
+            out.Byte((uint8_t)a.type);
+
+            uint32_t vertex_count = VertexCount(a);
+            switch (a.type)
+            {
+            case AttachmentType::Region:
+                StringRef(out, a.path);
+                out.Float(a.rotation);
+                out.Float(a.x);
+                out.Float(a.y);
+                out.Float(a.scale_x);
+                out.Float(a.scale_y);
+                out.Float(a.width);
+                out.Float(a.height);
+                out.Int(rgba8888(a.color[0], a.color[1], a.color[2], a.color[3]));
+                break;
+            case AttachmentType::BoundingBox:
+                out.Varint(vertex_count);
+                WriteVertices(&out, a, vertex_count);
+                out.Int(bounding_box_color);
+                break;
+            case AttachmentType::Mesh:
+                StringRef(out, a.path);
+                out.Int(0xFFFFFFFF);
+                out.Varint(vertex_count);
+                for (size_t i = 0; i < (size_t)vertex_count * 2; i++)
+                    out.Float(a.uvs[i]);
+                out.Shorts(a.triangles);
+                WriteVertices(&out, a, vertex_count);
+                // Counted in vertices here, in floats everywhere else.
+                out.Varint(a.hull >> 1);
+                out.Shorts(a.edges);
+                out.Float(a.width);
+                out.Float(a.height);
+                break;
+            case AttachmentType::LinkedMesh:
+                StringRef(out, a.path);
+                out.Int(0xFFFFFFFF);
+                StringRef(out, a.skin);
+                StringRef(out, a.parent);
+                out.Bool(a.deform);
+                out.Float(a.width);
+                out.Float(a.height);
+                break;
+            case AttachmentType::Path:
+                out.Bool(a.closed);
+                out.Bool(a.constant_speed);
+                out.Varint(vertex_count);
+                WriteVertices(&out, a, vertex_count);
+                for (size_t i = 0; i < vertex_count / 3; i++)
+                    out.Float(i < a.lengths.size() ? a.lengths[i] : 0.0f);
+                out.Int(path_color);
+                break;
+            case AttachmentType::Point:
+                out.Float(a.rotation);
+                out.Float(a.x);
+                out.Float(a.y);
+                out.Int(point_color);
+                break;
+            case AttachmentType::Clipping:
+            {
+                // Without an end slot clipping runs to the end of the draw
+                // order, which is what ending at the last slot does too.
+                int end_slot = slots.find(a.end_slot);
+                out.Varint(end_slot >= 0 ? (uint32_t)end_slot : (uint32_t)skeleton.slots.size() - 1);
+                out.Varint(vertex_count);
+                WriteVertices(&out, a, vertex_count);
+                out.Int(clipping_color);
+                break;
+            }
+            }
+        }
+
+        void WriteSkinAttachments(const SkinLayout &layout)
+        {
+            out.Varint((uint32_t)layout.size());
+            for (const auto &[slot_name, attachments] : layout)
+            {
+                out.Varint((uint32_t)slots.require(slot_name, "Slot"));
+                out.Varint((uint32_t)attachments.size());
+                for (const auto &[name, attachment] : attachments)
+                    WriteAttachment(*attachment);
+            }
+        }
+
+        const Attachment *FindAttachment(int skin, const std::string &slot, const std::string &name) const
+        {
+            const auto *attachments = skin_layouts[skin].find(slot);
+            const Attachment *const *attachment = attachments ? attachments->find(name) : nullptr;
+            return attachment ? *attachment : nullptr;
+        }
+
+        // The mesh a linked mesh takes its vertices from, checked like the
+        // runtime checks it once every skin is read.
+        const Attachment &ParentMesh(const Attachment &linked) const
+        {
+            int skin = linked.skin.empty() ? default_skin : binary_skins.find(linked.skin);
+            if (skin < 0)
+                throw std::runtime_error("Skin not found: " + linked.skin);
+            const Attachment *parent = FindAttachment(skin, linked.slot, linked.parent);
+            if (!parent || (parent->type != AttachmentType::Mesh && parent->type != AttachmentType::LinkedMesh))
+                throw std::runtime_error("Parent mesh not found: " + linked.parent);
+            return *parent;
+        }
+
+        void WriteSkins()
+        {
+            for (size_t i = 0; i < skeleton.skins.size(); i++)
+            {
+                const Skin &s = skeleton.skins[i];
+                skins.add(s.name, (int)i);
+                skin_layouts.push_back(LayoutSkin(s));
+                if (s.name == "default")
+                    default_skin = (int)i;
+            }
+
+            // The format has a single unnamed default skin up front and leaves
+            // it out when it has no attachments; an empty one is then kept as
+            // an ordinary skin so lookups by name still find it.
+            bool leading_default = default_skin >= 0 && skin_layouts[default_skin].size() > 0;
+            skin_indices.assign(skeleton.skins.size(), 0);
+            uint32_t next = leading_default ? 1 : 0;
+            for (size_t i = 0; i < skeleton.skins.size(); i++)
+                skin_indices[i] = leading_default && (int)i == default_skin ? 0 : next++;
+
+            if (leading_default)
+            {
+                binary_skins.add(skeleton.skins[default_skin].name, default_skin);
+                WriteSkinAttachments(skin_layouts[default_skin]);
+            }
+            else
+            {
+                out.Varint(0);
+            }
+
+            out.Varint((uint32_t)(skeleton.skins.size() - (leading_default ? 1 : 0)));
+            for (size_t i = 0; i < skeleton.skins.size(); i++)
+            {
+                if (leading_default && (int)i == default_skin)
+                    continue;
+                binary_skins.add(skeleton.skins[i].name, (int)i);
+                StringRef(out, skeleton.skins[i].name);
+                // Skin bones and constraints are not in SCSP.
+                for (int list = 0; list < 4; list++)
+                    out.Varint(0);
+                WriteSkinAttachments(skin_layouts[i]);
+            }
+
+            for (const SkinLayout &layout : skin_layouts)
+            {
+                for (const auto &[slot_name, attachments] : layout)
+                {
+                    for (const auto &[name, attachment] : attachments)
+                    {
+                        if (attachment->type == AttachmentType::LinkedMesh)
+                            ParentMesh(*attachment);
+                    }
+                }
+            }
+        }
+
+        void WriteEvents()
+        {
+            auto events = LayoutEvents(skeleton.events);
+            out.Varint((uint32_t)events.size());
+            for (const auto &[name, event_ptr] : events)
+            {
+                const Event &e = *event_ptr;
+                StringRef(out, name);
+                out.SignedVarint((int32_t)e.int_value);
+                out.Float(e.float_value);
+                out.String(e.string_value);
+                out.String(e.audio_path);
+                // Volume and balance only go with a sound.
+                if (!e.audio_path.empty())
+                {
+                    out.Float(e.volume);
+                    out.Float(e.balance);
+                }
+            }
+        }
+
+        static void WriteCurve(Output &o, const Curve *curve)
+        {
+            if (!curve || curve->type == Curve::Linear)
+            {
+                o.Byte(CurveLinear);
+            }
+            else if (curve->type == Curve::Stepped)
+            {
+                o.Byte(CurveStepped);
+            }
+            else
+            {
+                o.Byte(CurveBezier);
+                o.Float((float)curve->cx1);
+                o.Float((float)curve->cy1);
+                o.Float((float)curve->cx2);
+                o.Float((float)curve->cy2);
+            }
+        }
+
+        // Writes the frame count and frames of one timeline: the time, then
+        // values() for the frame's values, then the curve to the next frame.
+        template <typename Values>
+        static void WriteFrames(Output &o, const TimelineParts &parts, Values values)
+        {
+            size_t count = CountFrames(parts);
+            o.Varint((uint32_t)count);
+            ForEachFrame(parts, [&](size_t frame, const float *v, const Timeline &part, size_t i, const Curve *curve)
+                         {
+                             o.Float(v[0]);
+                             values(v, part, i);
+                             if (frame + 1 < count)
+                                 WriteCurve(o, curve); });
+        }
+
+        void WriteSlotTimelines(Output &o, TimelineType type, const TimelineParts &parts)
+        {
+            if (type == TimelineType::Attachment)
+            {
+                // Attachment keys have no curves.
+                o.Byte(SlotAttachment);
+                o.Varint((uint32_t)CountFrames(parts));
+                ForEachFrame(parts, [&](size_t, const float *v, const Timeline &part, size_t i, const Curve *)
+                             {
+                                 o.Float(v[0]);
+                                 StringRef(o, part.attachment_names[i]); });
+            }
+            else if (type == TimelineType::Color)
+            {
+                o.Byte(SlotColor);
+                WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                            { o.Int(rgba8888(v[1], v[2], v[3], v[4])); });
+            }
+            else
+            {
+                o.Byte(SlotTwoColor);
+                WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                            {
+                                o.Int(rgba8888(v[1], v[2], v[3], v[4]));
+                                o.Int(rgba8888(0.0f, v[5], v[6], v[7])); });
+            }
+        }
+
+        static void WriteBoneTimelines(Output &o, TimelineType type, const TimelineParts &parts)
+        {
+            static const BoneTimelineType bone_types[] = {BoneRotate, BoneTranslate, BoneScale, BoneShear};
+            o.Byte(bone_types[(int)type]);
+            if (type == TimelineType::Rotate)
+                WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                            { o.Float(v[1]); });
+            else
+                WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                            {
+                                o.Float(v[1]);
+                                o.Float(v[2]); });
+        }
+
+        // Section of timelines keyed by bone, slot or constraint, each with its
+        // non-empty timelines by type.
+        template <typename Write>
+        void WriteTyped(Output &o, const OrderedGroups<TypedTimelines> &groups, const NameIndex &names, const char *what, Write write)
+        {
+            o.Varint((uint32_t)groups.size());
+            for (const auto &[target, types] : groups)
+            {
+                o.Varint((uint32_t)names.require(target, what));
+                uint32_t count = 0;
+                for (const auto &[type, parts] : types)
+                    count += CountFrames(parts) ? 1 : 0;
+                o.Varint(count);
+                for (const auto &[type, parts] : types)
+                {
+                    if (CountFrames(parts))
+                        write(type, parts);
+                }
+            }
+        }
+
+        // Section of constraint timelines; like SkeletonJson only constraints
+        // with keys need to exist.
+        template <typename Write>
+        static void WriteConstraintTimelines(Output &o, const OrderedGroups<TimelineParts> &groups, const NameIndex &names,
+                                             const char *what, Write write)
+        {
+            Output section;
+            uint32_t count = 0;
+            for (const auto &[constraint, parts] : groups)
+            {
+                if (!CountFrames(parts))
+                    continue;
+                section.Varint((uint32_t)names.require(constraint, what));
+                WriteFrames(section, parts, [&](const float *v, const Timeline &, size_t)
+                            { write(section, v); });
+                count++;
+            }
+            o.Varint(count);
+            o.Append(section);
+        }
+
+        void WriteDeformTimelines(Output &o, const AnimationLayout &layout)
+        {
+            o.Varint((uint32_t)layout.deform.size());
+            for (const auto &[skin_name, skin_slots] : layout.deform)
+            {
+                int skin = skins.require(skin_name, "Skin");
+                o.Varint(skin_indices[skin]);
+                o.Varint((uint32_t)skin_slots.size());
+                for (const auto &[slot_name, attachments] : skin_slots)
+                {
+                    int slot_index = slots.find(slot_name);
+                    Output section;
+                    uint32_t count = 0;
+                    for (const auto &[name, parts] : attachments)
+                    {
+                        const Attachment *attachment = slot_index < 0 ? nullptr : FindAttachment(skin, slot_name, name);
+                        if (!attachment || attachment->type == AttachmentType::Region || attachment->type == AttachmentType::Point)
+                            throw std::runtime_error("Attachment not found: " + name);
+                        if (!CountFrames(parts))
+                            continue;
+
+                        // Linked meshes take their vertices from the parent.
+                        const Attachment *source = attachment;
+                        for (size_t depth = 0; source->type == AttachmentType::LinkedMesh && depth < 16; depth++)
+                            source = &ParentMesh(*source);
+                        size_t deform_length = source->type == AttachmentType::LinkedMesh
+                                                   ? 0
+                                                   : WriteVertices(nullptr, *source, VertexCount(*source));
+
+                        StringRef(section, name);
+                        WriteFrames(section, parts, [&](const float *, const Timeline &part, size_t i)
+                                    { WriteDeformKey(section, part.deform[i], deform_length); });
+                        count++;
+                    }
+                    o.Varint(slot_index < 0 ? 0 : (uint32_t)slot_index);
+                    o.Varint(count);
+                    o.Append(section);
+                }
+            }
+        }
+
+        // The runtime writes a key into a buffer of the attachment's deform
+        // length without checking, so keys are clipped to it. Leading values
+        // before the first vertex and trailing ones past the end go.
+        static void WriteDeformKey(Output &o, const DeformKey &key, size_t deform_length)
+        {
+            size_t skip = key.offset < 0 ? (size_t)-(long)key.offset : 0;
+            size_t start = key.offset < 0 ? 0 : (size_t)key.offset;
+            size_t count = 0;
+            if (skip < key.vertices.size() && start < deform_length)
+                count = std::min(key.vertices.size() - skip, deform_length - start);
+
+            // A zero length key is the setup pose.
+            o.Varint((uint32_t)count);
+            if (count == 0)
+                return;
+            o.Varint((uint32_t)start);
+            for (size_t k = 0; k < count; k++)
+                o.Float(key.vertices[skip + k]);
+        }
+
+        void WriteDrawOrder(Output &o, const Timeline *draw_order)
+        {
+            if (!draw_order)
+            {
+                o.Varint(0);
+                return;
+            }
+
+            size_t slot_count = skeleton.slots.size();
+            o.Varint((uint32_t)draw_order->draw_order.size());
+            for (const DrawOrderKey &key : draw_order->draw_order)
+            {
+                o.Float(key.time);
+                o.Varint((uint32_t)key.offsets.size());
+                std::vector<bool> taken(slot_count);
+                size_t original = 0;
+                for (const auto &[slot_name, offset] : key.offsets)
+                {
+                    size_t slot_index = (size_t)slots.require(slot_name, "Slot");
+                    long target = (long)slot_index + offset;
+                    if (slot_index < original || target < 0 || (size_t)target >= slot_count || taken[target])
+                        throw std::runtime_error("Invalid draw order offset for slot: " + slot_name);
+                    taken[target] = true;
+                    original = slot_index + 1;
+                    o.Varint((uint32_t)slot_index);
+                    o.Varint((uint32_t)offset);
+                }
+            }
+        }
+
+        void WriteAnimations()
+        {
+            auto animations = LayoutAnimations(skeleton.animations);
+            out.Varint((uint32_t)animations.size());
+            for (const auto &[name, animation] : animations)
+            {
+                AnimationLayout layout = LayoutAnimation(*animation);
+                Output &o = out;
+                o.String(name);
+
+                WriteTyped(o, layout.slots, slots, "Slot", [&](TimelineType type, const TimelineParts &parts)
+                           { WriteSlotTimelines(o, type, parts); });
+                WriteTyped(o, layout.bones, bones, "Bone", [&](TimelineType type, const TimelineParts &parts)
+                           { WriteBoneTimelines(o, type, parts); });
+
+                WriteConstraintTimelines(o, layout.ik, ik_constraints, "IK constraint", [](Output &s, const float *v)
+                                         {
+                                             s.Float(v[1]);
+                                             s.Float(v[2]);
+                                             s.Byte(v[3] >= 0.0f ? 1 : 0xFF);
+                                             s.Bool(v[4] != 0);
+                                             s.Bool(v[5] != 0); });
+                WriteConstraintTimelines(o, layout.transform, transform_constraints, "Transform constraint", [](Output &s, const float *v)
+                                         {
+                                             for (int k = 1; k <= 4; k++)
+                                                 s.Float(v[k]); });
+
+                WriteTyped(o, layout.paths, path_constraints, "Path constraint", [&](TimelineType type, const TimelineParts &parts)
+                           {
+                               if (type == TimelineType::PathConstraintMix)
+                               {
+                                   o.Byte(PathMix);
+                                   WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                                               {
+                                                   o.Float(v[1]);
+                                                   o.Float(v[2]); });
+                                   return;
+                               }
+                               o.Byte(type == TimelineType::PathConstraintSpacing ? PathSpacing : PathPosition);
+                               WriteFrames(o, parts, [&](const float *v, const Timeline &, size_t)
+                                           { o.Float(v[1]); }); });
+
+                WriteDeformTimelines(o, layout);
+                WriteDrawOrder(o, layout.draw_order);
+                // Event timelines are not decoded.
+                o.Varint(0);
+            }
+        }
+    };
+}
+
+namespace SCSPParser
+{
+    std::vector<uint8_t> ToBinary(const Skeleton &skeleton)
+    {
+        return SkelWriter(skeleton).Write();
+    }
+}
@@ -0,0 +1,727 @@
+#include "SCSPSkeletonData.h"
+#include "SCSPLayout.h"
+#include <spine/spine.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+using namespace SCSPParser;
+
+namespace
+{
+    spine::String to_spine(const std::string &s)
+    {
+        return spine::String(s.c_str());
+    }
+
+    float clamp01(float v)
+    {
+        return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    }
+
+    struct LinkedMesh
+    {
+        spine::MeshAttachment *mesh;
+        std::string skin;
+        int slot_index;
+        std::string parent;
+        bool inherit_deform;
+    };
+
+    // Builds animations against skeleton data that already holds everything
+    // they refer to, resolving names as SkeletonJson does.
+    class AnimationReader
+    {
+    public:
+        explicit AnimationReader(spine::SkeletonData &data)
+            : data(data)
+        {
+            Index(bones, data.getBones());
+            Index(slots, data.getSlots());
+            Index(ik_constraints, data.getIkConstraints());
+            Index(transform_constraints, data.getTransformConstraints());
+            Index(path_constraints, data.getPathConstraints());
+            Index(skins, data.getSkins());
+        }
+
+    private:
+        spine::SkeletonData &data;
+
+        NameIndex bones, slots, ik_constraints, transform_constraints, path_constraints, skins;
+
+        template <typename T>
+        static void Index(NameIndex &index, spine::Vector<T *> &items)
+        {
+            for (size_t i = 0; i < items.size(); i++)
+                index.add(items[i]->getName().buffer(), (int)i);
+        }
+
+        // Timelines of one animation.
+        struct AnimationBuilder
+        {
+            std::vector<std::unique_ptr<spine::Timeline>> timelines;
+            float duration = 0;
+
+            // Calls write(frame, values, part, i) for every keyframe in order and
+            // sets its curve.
+            template <typename Write>
+            void Fill(const TimelineParts &parts, spine::CurveTimeline *curves, Write write)
+            {
+                float last_time = 0;
+                ForEachFrame(parts, [&](size_t frame, const float *values, const SCSPParser::Timeline &part, size_t i, const Curve *curve)
+                             {
+                                 write((int)frame, values, part, i);
+                                 last_time = values[0];
+                                 if (!curves || !curve)
+                                     return;
+                                 if (curve->type == Curve::Stepped)
+                                     curves->setStepped(frame);
+                                 else if (curve->type == Curve::Bezier)
+                                     curves->setCurve(frame, (float)curve->cx1, (float)curve->cy1, (float)curve->cx2, (float)curve->cy2); });
+                // Like SkeletonJson, the duration goes by each timeline's last frame.
+                duration = std::max(duration, last_time);
+            }
+
+            template <typename T>
+            T *Add(T *timeline)
+            {
+                timelines.emplace_back(timeline);
+                return timeline;
+            }
+        };
+
+        void ReadSlotTimelines(AnimationBuilder &anim, int slot_index, TimelineType type, const TimelineParts &parts)
+        {
+            size_t count = CountFrames(parts);
+            if (count == 0)
+                return;
+
+            if (type == TimelineType::Attachment)
+            {
+                spine::AttachmentTimeline *timeline = anim.Add(new spine::AttachmentTimeline((int)count));
+                timeline->setSlotIndex(slot_index);
+                anim.Fill(parts, nullptr, [&](int frame, const float *v, const SCSPParser::Timeline &part, size_t i)
+                          { timeline->setFrame(frame, v[0], to_spine(part.attachment_names[i])); });
+            }
+            else if (type == TimelineType::Color)
+            {
+                spine::ColorTimeline *timeline = anim.Add(new spine::ColorTimeline((int)count));
+                timeline->setSlotIndex(slot_index);
+                anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                          { timeline->setFrame(frame, v[0], clamp01(v[1]), clamp01(v[2]), clamp01(v[3]), clamp01(v[4])); });
+            }
+            else
+            {
+                spine::TwoColorTimeline *timeline = anim.Add(new spine::TwoColorTimeline((int)count));
+                timeline->setSlotIndex(slot_index);
+                anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                          { timeline->setFrame(frame, v[0], clamp01(v[1]), clamp01(v[2]), clamp01(v[3]), clamp01(v[4]),
+                                               clamp01(v[5]), clamp01(v[6]), clamp01(v[7])); });
+            }
+        }
+
+        void ReadBoneTimelines(AnimationBuilder &anim, int bone_index, TimelineType type, const TimelineParts &parts)
+        {
+            size_t count = CountFrames(parts);
+            if (count == 0)
+                return;
+
+            if (type == TimelineType::Rotate)
+            {
+                spine::RotateTimeline *timeline = anim.Add(new spine::RotateTimeline((int)count));
+                timeline->setBoneIndex(bone_index);
+                anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                          { timeline->setFrame(frame, v[0], v[1]); });
+                return;
+            }
+
+            spine::TranslateTimeline *timeline;
+            if (type == TimelineType::Scale)
+                timeline = anim.Add(new spine::ScaleTimeline((int)count));
+            else if (type == TimelineType::Shear)
+                timeline = anim.Add(new spine::ShearTimeline((int)count));
+            else
+                timeline = anim.Add(new spine::TranslateTimeline((int)count));
+            timeline->setBoneIndex(bone_index);
+            anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                      { timeline->setFrame(frame, v[0], v[1], v[2]); });
+        }
+
+        void ReadDeformTimeline(AnimationBuilder &anim, spine::Skin &skin, int slot_index, const std::string &name,
+                                const TimelineParts &parts)
+        {
+            spine::Attachment *base = slot_index < 0 ? nullptr : skin.getAttachment(slot_index, to_spine(name));
+            if (!base || !base->getRTTI().instanceOf(spine::VertexAttachment::rtti))
+                throw std::runtime_error("Attachment not found: " + name);
+
+            size_t count = CountFrames(parts);
+            if (count == 0)
+                return;
+
+            spine::VertexAttachment *attachment = static_cast<spine::VertexAttachment *>(base);
+            spine::Vector<float> &setup = attachment->getVertices();
+            bool weighted = attachment->getBones().size() != 0;
+            size_t deform_length = weighted ? setup.size() / 3 * 2 : setup.size();
+
+            spine::DeformTimeline *timeline = anim.Add(new spine::DeformTimeline((int)count));
+            timeline->setSlotIndex(slot_index);
+            timeline->setAttachment(attachment);
+            anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &part, size_t i)
+                      {
+                          const DeformKey &key = part.deform[i];
+                          spine::Vector<float> deformed;
+                          if (key.vertices.empty() && !weighted)
+                          {
+                              deformed.clearAndAddAll(setup);
+                          }
+                          else
+                          {
+                              deformed.setSize(deform_length, 0);
+                              for (size_t k = 0; k < key.vertices.size() && key.offset + k < deform_length; k++)
+                                  deformed[key.offset + k] = key.vertices[k];
+                              if (!weighted)
+                              {
+                                  for (size_t k = 0; k < deform_length; k++)
+                                      deformed[k] += setup[k];
+                              }
+                          }
+                          timeline->setFrame(frame, v[0], deformed); });
+        }
+
+        void ReadDrawOrder(AnimationBuilder &anim, const SCSPParser::Timeline &draw_order)
+        {
+            size_t slot_count = data.getSlots().size();
+            spine::DrawOrderTimeline *timeline = anim.Add(new spine::DrawOrderTimeline((int)draw_order.draw_order.size()));
+
+            for (size_t frame = 0; frame < draw_order.draw_order.size(); frame++)
+            {
+                const DrawOrderKey &key = draw_order.draw_order[frame];
+                spine::Vector<int> order;
+                order.setSize(slot_count, -1);
+                std::vector<int> unchanged;
+                size_t original = 0;
+                for (const auto &[slot_name, offset] : key.offsets)
+                {
+                    size_t slot_index = (size_t)slots.require(slot_name, "Slot");
+                    long target = (long)slot_index + offset;
+                    if (slot_index < original || target < 0 || (size_t)target >= slot_count || order[target] != -1)
+                        throw std::runtime_error("Invalid draw order offset for slot: " + slot_name);
+                    while (original != slot_index)
+                        unchanged.push_back((int)original++);
+                    order[target] = (int)original++;
+                }
+                while (original < slot_count)
+                    unchanged.push_back((int)original++);
+                for (size_t i = slot_count; i-- > 0;)
+                {
+                    if (order[i] == -1)
+                    {
+                        order[i] = unchanged.back();
+                        unchanged.pop_back();
+                    }
+                }
+                timeline->setFrame(frame, key.time, order);
+            }
+            anim.duration = std::max(anim.duration, draw_order.draw_order.back().time);
+        }
+
+    public:
+        spine::Animation *Read(const std::string &name, const SCSPParser::Animation &animation)
+        {
+            AnimationLayout layout = LayoutAnimation(animation);
+            AnimationBuilder anim;
+
+            for (const auto &[slot_name, types] : layout.slots)
+            {
+                int slot_index = slots.require(slot_name, "Slot");
+                for (const auto &[type, parts] : types)
+                    ReadSlotTimelines(anim, slot_index, type, parts);
+            }
+
+            for (const auto &[bone_name, types] : layout.bones)
+            {
+                int bone_index = bones.require(bone_name, "Bone");
+                for (const auto &[type, parts] : types)
+                    ReadBoneTimelines(anim, bone_index, type, parts);
+            }
+
+            for (const auto &[constraint, parts] : layout.ik)
+            {
+                size_t count = CountFrames(parts);
+                if (count == 0)
+                    continue;
+                spine::IkConstraintTimeline *timeline = anim.Add(new spine::IkConstraintTimeline((int)count));
+                timeline->setIkConstraintIndex(ik_constraints.require(constraint, "IK constraint"));
+                anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                          { timeline->setFrame(frame, v[0], v[1], v[2], v[3] >= 0.0f ? 1 : -1, v[4] != 0, v[5] != 0); });
+            }
+
+            for (const auto &[constraint, parts] : layout.transform)
+            {
+                size_t count = CountFrames(parts);
+                if (count == 0)
+                    continue;
+                spine::TransformConstraintTimeline *timeline = anim.Add(new spine::TransformConstraintTimeline((int)count));
+                timeline->setTransformConstraintIndex(transform_constraints.require(constraint, "Transform constraint"));
+                anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                          { timeline->setFrame(frame, v[0], v[1], v[2], v[3], v[4]); });
+            }
+
+            for (const auto &[constraint, types] : layout.paths)
+            {
+                int index = path_constraints.require(constraint, "Path constraint");
+                for (const auto &[type, parts] : types)
+                {
+                    if (type == TimelineType::PathConstraintMix)
+                    {
+                        size_t count = CountFrames(parts);
+                        if (count == 0)
+                            continue;
+                        spine::PathConstraintMixTimeline *timeline = anim.Add(new spine::PathConstraintMixTimeline((int)count));
+                        timeline->setPathConstraintIndex(index);
+                        anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                                  { timeline->setFrame(frame, v[0], v[1], v[2]); });
+                        continue;
+                    }
+
+                    size_t count = CountFrames(parts);
+                    if (count == 0)
+                        continue;
+                    spine::PathConstraintPositionTimeline *timeline;
+                    if (type == TimelineType::PathConstraintSpacing)
+                        timeline = anim.Add(new spine::PathConstraintSpacingTimeline((int)count));
+                    else
+                        timeline = anim.Add(new spine::PathConstraintPositionTimeline((int)count));
+                    timeline->setPathConstraintIndex(index);
+                    anim.Fill(parts, timeline, [&](int frame, const float *v, const SCSPParser::Timeline &, size_t)
+                              { timeline->setFrame(frame, v[0], v[1]); });
+                }
+            }
+
+            for (const auto &[skin_name, skin_slots] : layout.deform)
+            {
+                int skin_index = skins.require(skin_name, "Skin");
+                spine::Skin &skin = *data.getSkins()[skin_index];
+                for (const auto &[slot_name, attachments] : skin_slots)
+                {
+                    int slot_index = slots.find(slot_name);
+                    for (const auto &[attachment, parts] : attachments)
+                        ReadDeformTimeline(anim, skin, slot_index, attachment, parts);
+                }
+            }
+
+            if (layout.draw_order)
+                ReadDrawOrder(anim, *layout.draw_order);
+
+            spine::Vector<spine::Timeline *> timelines;
+            for (auto &timeline : anim.timelines)
+                timelines.add(timeline.release());
+            return new spine::Animation(to_spine(name), timelines, anim.duration);
+        }
+
+    };
+
+    class Builder
+    {
+    public:
+        Builder(const Skeleton &skeleton, spine::AttachmentLoader &loader)
+            : skeleton(skeleton), loader(loader), data(new spine::SkeletonData())
+        {
+        }
+
+        spine::SkeletonData *Build()
+        {
+            ReadHeader();
+            ReadBones();
+            ReadSlots();
+            ReadIkConstraints();
+            ReadTransformConstraints();
+            ReadPathConstraints();
+            ReadSkins();
+            ReadEvents();
+            ReadAnimations();
+            return data.release();
+        }
+
+    private:
+        const Skeleton &skeleton;
+        spine::AttachmentLoader &loader;
+        std::unique_ptr<spine::SkeletonData> data;
+
+        NameIndex bones, slots, skins;
+
+        void ReadHeader()
+        {
+            const HeaderInfo &hdr = skeleton.header;
+            std::string version = hdr.version.empty() ? "3.8.79" : hdr.version;
+            if (version == "3.8.75")
+                throw std::runtime_error("Unsupported skeleton data, please export with a newer version of Spine.");
+
+            data->setHash(to_spine(hdr.hash));
+            data->setVersion(to_spine(version));
+            data->setX(0.0f);
+            data->setY(0.0f);
+            data->setWidth(hdr.width);
+            data->setHeight(hdr.height);
+            data->setFps(30.0f);
+            data->setAudioPath(to_spine(hdr.audio_path));
+            data->setImagesPath(to_spine(hdr.images_path));
+        }
+
+        spine::BoneData *Bone(const std::string &name, const char *what) const
+        {
+            return data->getBones()[bones.require(name, what)];
+        }
+
+        spine::SlotData *Slot(const std::string &name, const char *what) const
+        {
+            return data->getSlots()[slots.require(name, what)];
+        }
+
+        void ReadBones()
+        {
+            static const spine::TransformMode transform_modes[] = {
+                spine::TransformMode_Normal, spine::TransformMode_OnlyTranslation, spine::TransformMode_NoRotationOrReflection,
+                spine::TransformMode_NoScale, spine::TransformMode_NoScaleOrReflection};
+
+            for (const SCSPParser::Bone &b : skeleton.bones)
+            {
+                spine::BoneData *parent = b.parent.empty() ? nullptr : Bone(b.parent, "Parent bone");
+                int index = (int)data->getBones().size();
+                spine::BoneData *bone = new spine::BoneData(index, to_spine(b.name), parent);
+                data->getBones().add(bone);
+                bones.add(b.name, index);
+
+                bone->setLength(b.length);
+                bone->setX(b.x);
+                bone->setY(b.y);
+                bone->setRotation(b.rotation);
+                bone->setScaleX(b.scale_x);
+                bone->setScaleY(b.scale_y);
+                bone->setShearX(b.shear_x);
+                bone->setShearY(b.shear_y);
+                if (b.transform_mode >= 0 && b.transform_mode < 5)
+                    bone->setTransformMode(transform_modes[b.transform_mode]);
+                bone->setSkinRequired(b.skin_required);
+            }
+        }
+
+        void ReadSlots()
+        {
+            static const spine::BlendMode blend_modes[] = {
+                spine::BlendMode_Normal, spine::BlendMode_Additive, spine::BlendMode_Multiply, spine::BlendMode_Screen};
+
+            for (const SCSPParser::Slot &s : skeleton.slots)
+            {
+                spine::BoneData *bone = Bone(s.bone, "Slot bone");
+                int index = (int)data->getSlots().size();
+                spine::SlotData *slot = new spine::SlotData(index, to_spine(s.name), *bone);
+                data->getSlots().add(slot);
+                slots.add(s.name, index);
+
+                slot->getColor().set(clamp01(s.color[0]), clamp01(s.color[1]), clamp01(s.color[2]), clamp01(s.color[3]));
+                if (s.has_dark)
+                {
+                    slot->getDarkColor().set(clamp01(s.dark[0]), clamp01(s.dark[1]), clamp01(s.dark[2]), 1.0f);
+                    slot->setHasDarkColor(true);
+                }
+                if (!s.attachment.empty())
+                    slot->setAttachmentName(to_spine(s.attachment));
+                if (s.blend_mode > 0 && s.blend_mode < 4)
+                    slot->setBlendMode(blend_modes[s.blend_mode]);
+            }
+        }
+
+        void ReadIkConstraints()
+        {
+            for (const IkConstraint &c : skeleton.ik_constraints)
+            {
+                spine::IkConstraintData *ik = new spine::IkConstraintData(to_spine(c.name));
+                data->getIkConstraints().add(ik);
+
+                ik->setOrder(c.order);
+                ik->setSkinRequired(c.skin_required);
+                for (const std::string &name : c.bones)
+                    ik->getBones().add(Bone(name, "IK bone"));
+                ik->setTarget(Bone(c.target, "Target bone"));
+                ik->setMix(c.mix);
+                ik->setSoftness(c.softness);
+                ik->setBendDirection(c.bend_positive ? 1 : -1);
+                ik->setCompress(c.compress);
+                ik->setStretch(c.stretch);
+                ik->setUniform(c.uniform);
+            }
+        }
+
+        void ReadTransformConstraints()
+        {
+            for (const TransformConstraint &c : skeleton.transform_constraints)
+            {
+                spine::TransformConstraintData *tr = new spine::TransformConstraintData(to_spine(c.name));
+                data->getTransformConstraints().add(tr);
+
+                tr->setOrder(c.order);
+                tr->setSkinRequired(c.skin_required);
+                for (const std::string &name : c.bones)
+                    tr->getBones().add(Bone(name, "Transform bone"));
+                tr->setTarget(Bone(c.target, "Target bone"));
+                tr->setLocal(c.local);
+                tr->setRelative(c.relative);
+                tr->setOffsetRotation(c.rotation);
+                tr->setOffsetX(c.x);
+                tr->setOffsetY(c.y);
+                tr->setOffsetScaleX(c.scale_x);
+                tr->setOffsetScaleY(c.scale_y);
+                tr->setOffsetShearY(c.shear_y);
+                tr->setRotateMix(c.rotate_mix);
+                tr->setTranslateMix(c.translate_mix);
+                tr->setScaleMix(c.scale_mix);
+                tr->setShearMix(c.shear_mix);
+            }
+        }
+
+        void ReadPathConstraints()
+        {
+            static const spine::PositionMode position_modes[] = {spine::PositionMode_Fixed, spine::PositionMode_Percent};
+            static const spine::SpacingMode spacing_modes[] = {spine::SpacingMode_Length, spine::SpacingMode_Fixed, spine::SpacingMode_Percent};
+            static const spine::RotateMode rotate_modes[] = {spine::RotateMode_Tangent, spine::RotateMode_Chain, spine::RotateMode_ChainScale};
+
+            for (const PathConstraint &c : skeleton.path_constraints)
+            {
+                spine::PathConstraintData *path = new spine::PathConstraintData(to_spine(c.name));
+                data->getPathConstraints().add(path);
+
+                path->setOrder(c.order);
+                path->setSkinRequired(c.skin_required);
+                for (const std::string &name : c.bones)
+                    path->getBones().add(Bone(name, "Path bone"));
+                path->setTarget(Slot(c.target, "Target slot"));
+                path->setPositionMode(position_modes[c.position_mode]);
+                path->setSpacingMode(spacing_modes[c.spacing_mode]);
+                path->setRotateMode(rotate_modes[c.rotate_mode]);
+                path->setOffsetRotation(c.rotation);
+                path->setPosition(c.position);
+                path->setSpacing(c.spacing);
+                path->setRotateMix(c.rotate_mix);
+                path->setTranslateMix(c.translate_mix);
+            }
+        }
+
+        static void SetVertices(spine::VertexAttachment &attachment, const Attachment &a, size_t world_vertices_length)
+        {
+            attachment.setWorldVerticesLength(world_vertices_length);
+            spine::Vector<float> &vertices = attachment.getVertices();
+            vertices.clear();
+            for (float v : a.vertices)
+                vertices.add(v);
+            spine::Vector<size_t> &vertex_bones = attachment.getBones();
+            vertex_bones.clear();
+            for (int16_t b : a.bones)
+                vertex_bones.add((size_t)b);
+        }
+
+        template <typename T>
+        T *Require(T *attachment, const Attachment &a)
+        {
+            if (!attachment)
+                throw std::runtime_error("Error reading attachment: " + a.name);
+            return attachment;
+        }
+
+        spine::Attachment *ReadAttachment(spine::Skin &skin, const Attachment &a, int slot_index, std::vector<LinkedMesh> &linked_meshes)
+        {
+            spine::String name = to_spine(a.name);
+            spine::String path = to_spine(a.path.empty() ? a.name : a.path);
+            // Vertex counts as the JSON round-trips them: pairs of floats.
+            size_t vertex_pairs_length = (a.world_vertices_length >> 1) << 1;
+
+            switch (a.type)
+            {
+            case AttachmentType::Region:
+            {
+                spine::RegionAttachment *region = Require(loader.newRegionAttachment(skin, name, path), a);
+                region->setPath(path);
+                region->setX(a.x);
+                region->setY(a.y);
+                region->setScaleX(a.scale_x);
+                region->setScaleY(a.scale_y);
+                region->setRotation(a.rotation);
+                region->setWidth(a.width);
+                region->setHeight(a.height);
+                region->getColor().set(clamp01(a.color[0]), clamp01(a.color[1]), clamp01(a.color[2]), clamp01(a.color[3]));
+                region->updateOffset();
+                loader.configureAttachment(region);
+                return region;
+            }
+            case AttachmentType::Mesh:
+            case AttachmentType::LinkedMesh:
+            {
+                spine::MeshAttachment *mesh = Require(loader.newMeshAttachment(skin, name, path), a);
+                mesh->setPath(path);
+                mesh->setWidth(a.width);
+                mesh->setHeight(a.height);
+
+                if (a.type == AttachmentType::LinkedMesh)
+                {
+                    linked_meshes.push_back({mesh, a.skin, slot_index, a.parent, a.deform});
+                    return mesh;
+                }
+
+                for (uint16_t t : a.triangles)
+                    mesh->getTriangles().add(t);
+                for (float uv : a.uvs)
+                    mesh->getRegionUVs().add(uv);
+                SetVertices(*mesh, a, a.uvs.size());
+                mesh->updateUVs();
+                mesh->setHullLength((int)a.hull);
+                for (uint16_t e : a.edges)
+                    mesh->getEdges().add(e);
+                loader.configureAttachment(mesh);
+                return mesh;
+            }
+            case AttachmentType::BoundingBox:
+            {
+                spine::BoundingBoxAttachment *box = Require(loader.newBoundingBoxAttachment(skin, name), a);
+                SetVertices(*box, a, vertex_pairs_length);
+                loader.configureAttachment(box);
+                return box;
+            }
+            case AttachmentType::Path:
+            {
+                spine::PathAttachment *path_attachment = Require(loader.newPathAttachment(skin, name), a);
+                path_attachment->setClosed(a.closed);
+                path_attachment->setConstantSpeed(a.constant_speed);
+                size_t vertex_count = a.world_vertices_length >> 1;
+                SetVertices(*path_attachment, a, vertex_count << 1);
+                spine::Vector<float> &lengths = path_attachment->getLengths();
+                lengths.setSize(vertex_count / 3, 0);
+                for (size_t i = 0; i < lengths.size() && i < a.lengths.size(); i++)
+                    lengths[i] = a.lengths[i];
+                loader.configureAttachment(path_attachment);
+                return path_attachment;
+            }
+            case AttachmentType::Point:
+            {
+                spine::PointAttachment *point = Require(loader.newPointAttachment(skin, name), a);
+                point->setX(a.x);
+                point->setY(a.y);
+                point->setRotation(a.rotation);
+                loader.configureAttachment(point);
+                return point;
+            }
+            case AttachmentType::Clipping:
+            {
+                spine::ClippingAttachment *clip = Require(loader.newClippingAttachment(skin, name), a);
+                int end_slot = slots.find(a.end_slot);
+                if (end_slot >= 0)
+                    clip->setEndSlot(data->getSlots()[end_slot]);
+                SetVertices(*clip, a, vertex_pairs_length);
+                loader.configureAttachment(clip);
+                return clip;
+            }
+            }
+            return nullptr;
+        }
+
+        void ReadSkins()
+        {
+            std::vector<LinkedMesh> linked_meshes;
+
+            for (const SCSPParser::Skin &s : skeleton.skins)
+            {
+                spine::Skin *skin = new spine::Skin(to_spine(s.name));
+                skins.add(s.name, (int)data->getSkins().size());
+                data->getSkins().add(skin);
+                if (s.name == "default")
+                    data->setDefaultSkin(skin);
+
+                for (const auto &[slot_name, attachments] : LayoutSkin(s))
+                {
+                    int slot_index = slots.require(slot_name, "Slot");
+                    for (const auto &[name, attachment] : attachments)
+                    {
+                        spine::Attachment *built = ReadAttachment(*skin, *attachment, slot_index, linked_meshes);
+                        skin->setAttachment(slot_index, to_spine(name), built);
+                    }
+                }
+            }
+
+            for (const LinkedMesh &linked : linked_meshes)
+            {
+                spine::Skin *skin = linked.skin.empty() ? data->getDefaultSkin() : nullptr;
+                if (!linked.skin.empty())
+                {
+                    int index = skins.find(linked.skin);
+                    if (index >= 0)
+                        skin = data->getSkins()[index];
+                }
+                if (!skin)
+                    throw std::runtime_error("Skin not found: " + linked.skin);
+
+                spine::Attachment *parent = skin->getAttachment(linked.slot_index, to_spine(linked.parent));
+                if (!parent || !parent->getRTTI().instanceOf(spine::MeshAttachment::rtti))
+                    throw std::runtime_error("Parent mesh not found: " + linked.parent);
+
+                spine::MeshAttachment *parent_mesh = static_cast<spine::MeshAttachment *>(parent);
+                linked.mesh->setDeformAttachment(linked.inherit_deform ? static_cast<spine::VertexAttachment *>(parent_mesh) : linked.mesh);
+                linked.mesh->setParentMesh(parent_mesh);
+                linked.mesh->updateUVs();
+                loader.configureAttachment(linked.mesh);
+            }
+        }
+
+        void ReadEvents()
+        {
+            for (const auto &[name, event_ptr] : LayoutEvents(skeleton.events))
+            {
+                const Event &e = *event_ptr;
+                spine::EventData *event = new spine::EventData(to_spine(name));
+                data->getEvents().add(event);
+                event->setIntValue((int)e.int_value);
+                event->setFloatValue(e.float_value);
+                event->setStringValue(to_spine(e.string_value));
+                event->setAudioPath(to_spine(e.audio_path));
+                event->setVolume(e.volume);
+                event->setBalance(e.balance);
+            }
+        }
+
+        void ReadAnimations()
+        {
+            AnimationReader animations(*data);
+            for (const auto &[name, animation] : LayoutAnimations(skeleton.animations))
+                data->getAnimations().add(animations.Read(name, *animation));
+        }
+    };
+}
+
+namespace SCSPParser
+{
+    spine::SkeletonData *BuildSkeletonData(const Skeleton &skeleton, spine::AttachmentLoader &loader, std::string &error)
+    {
+        error.clear();
+        try
+        {
+            return Builder(skeleton, loader).Build();
+        }
+        catch (const std::exception &e)
+        {
+            error = e.what();
+            return nullptr;
+        }
+    }
+
+    spine::Animation *BuildAnimation(spine::SkeletonData &data, const std::string &name, const Animation &animation, std::string &error)
+    {
+        error.clear();
+        try
+        {
+            return AnimationReader(data).Read(name, animation);
+        }
+        catch (const std::exception &e)
+        {
+            error = e.what();
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "SCSPParser.h"
+#include <string>
+
+namespace spine {
+    class Animation;
+    class AttachmentLoader;
+    class SkeletonData;
+}
+
+namespace SCSPParser {
+    // Builds spine runtime data straight from a decoded skeleton, resolving
+    // names the way SkeletonJson resolves them in the exported JSON. Returns
+    // nullptr and sets error when a reference cannot be resolved or the loader
+    // has no region for an attachment.
+    spine::SkeletonData* BuildSkeletonData(const Skeleton& skeleton, spine::AttachmentLoader& loader, std::string& error);
+    // One animation for data built without it, resolved the same way. The
+    // caller owns the result, or adds it to data; nullptr and error as above.
+    spine::Animation* BuildAnimation(spine::SkeletonData& data, const std::string& name, const Animation& animation, std::string& error);
+}
@@ -3,10 +3,15 @@
 #include <cstring>
 #include <algorithm>
 #include <stdexcept>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "core/Logger.h"
+#include "core/LZ4.h"
+#include "PixelConvert.h"
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
 #define ETCDEC_IMPLEMENTATION
 #include "etcdec.h"
 #define ASTCENC_API
@@ -47,14 +52,14 @@ namespace SCTParser {
             std::string type;
         };
 
-        Format DetectFormat(const std::vector<uint8_t>& data, bool debug = false) {
-        if (data.size() < 4) {
-            if (debug) std::cout << "Data too short: " << data.size() << " bytes\n";
+        Format DetectFormat(const uint8_t* data, size_t size, bool debug = false) {
+        if (size < 4) {
+            if (debug) std::cout << "Data too short: " << size << " bytes\n";
             return Format::Unknown;
         }
 
 
-        int signature = *reinterpret_cast<const int*>(data.data());
+        int signature = *reinterpret_cast<const int*>(data);
         if (debug) std::cout << "4-byte signature: " << signature << " (0x" << std::hex << signature << std::dec << ")\n";
 
         if (signature == SCT2_SIGNATURE) {
@@ -63,8 +68,8 @@ namespace SCTParser {
         }
 
 
-        if (data.size() >= 3) {
-            uint16_t word = *reinterpret_cast<const uint16_t*>(data.data());
+        if (size >= 3) {
+            uint16_t word = *reinterpret_cast<const uint16_t*>(data);
             uint8_t b = data[2];
             if (debug) std::cout << "SCT check: word=" << word << ", byte=" << (int)b << "\n";
 
@@ -77,8 +82,8 @@ namespace SCTParser {
         return Format::Unknown;
     }
 
-    Header ParseSCTHeader(const std::vector<uint8_t>& data) {
-        if (data.size() < 9)
+    Header ParseSCTHeader(const uint8_t* data, size_t size) {
+        if (size < 9)
             throw std::runtime_error("File too small to contain a valid SCT header");
 
         Header header;
@@ -96,8 +101,8 @@ namespace SCTParser {
         return header;
     }
 
-    Header ParseSCT2Header(const std::vector<uint8_t>& data) {
-        if (data.size() < 34)
+    Header ParseSCT2Header(const uint8_t* data, size_t size) {
+        if (size < 34)
             throw std::runtime_error("File too small to contain a valid SCT2 header");
 
         Header header;
@@ -120,128 +125,37 @@ namespace SCTParser {
         return header;
     }
 
-    std::vector<uint8_t> LZ4Decompress(const std::vector<uint8_t>& compressed_data) {
-        if (compressed_data.size() < 8)
-            throw std::runtime_error("Compressed data too short");
-
-        int decompressed_size = *reinterpret_cast<const int*>(compressed_data.data());
-        int compressed_size = *reinterpret_cast<const int*>(compressed_data.data() + 4);
-
-        std::vector<uint8_t> dst(decompressed_size);
-        size_t src_pos = 8;
-        size_t dst_pos = 0;
-
-        while (src_pos < compressed_data.size() && dst_pos < (size_t)decompressed_size) {
-            if (src_pos >= compressed_data.size()) break;
-
-            uint8_t token = compressed_data[src_pos++];
-            int literal_length = (token >> 4) & 0x0F;
-            int match_length = token & 0x0F;
-
-            if (literal_length == 15) {
-                while (src_pos < compressed_data.size()) {
-                    uint8_t extra = compressed_data[src_pos++];
-                    literal_length += extra;
-                    if (extra != 255) break;
-                }
-            }
-
-            if (literal_length > 0) {
-                if (src_pos + literal_length > compressed_data.size())
-                    literal_length = compressed_data.size() - src_pos;
-                if (dst_pos + literal_length > dst.size())
-                    literal_length = dst.size() - dst_pos;
-
-                std::memcpy(dst.data() + dst_pos, compressed_data.data() + src_pos, literal_length);
-                src_pos += literal_length;
-                dst_pos += literal_length;
-            }
-
-            if (src_pos >= compressed_data.size() || dst_pos >= (size_t)decompressed_size)
-                break;
-
-            if (src_pos + 1 >= compressed_data.size()) break;
-
-            uint16_t offset = *reinterpret_cast<const uint16_t*>(compressed_data.data() + src_pos);
-            src_pos += 2;
-
-            if (match_length == 15) {
-                while (src_pos < compressed_data.size()) {
-                    uint8_t extra = compressed_data[src_pos++];
-                    match_length += extra;
-                    if (extra != 255) break;
-                }
-            }
-
-            match_length += 4;
-
-            int match_start = dst_pos - offset;
-            if (match_start < 0) break;
-
-            for (int i = 0; i < match_length && dst_pos < (size_t)decompressed_size && match_start + i < (int)dst_pos; i++) {
-                dst[dst_pos++] = dst[match_start + i];
-            }
-        }
-
-        if (dst_pos < (size_t)decompressed_size) {
-            dst.resize(dst_pos);
-        }
-
-        return dst;
+    // Reads the size stored in front of an LZ4 payload. Returns false if the
+    // payload is too short or the size is one LZ4 could not have produced.
+    bool PeekLZ4Size(const uint8_t* compressed_data, size_t compressed_size, uint64_t& decompressed_size) {
+        if (compressed_size < 8)
+            return false;
+        int declared;
+        std::memcpy(&declared, compressed_data, sizeof(declared));
+        // LZ4 cannot expand a block by more than 255x; anything larger is not LZ4.
+        if (declared < 0 || static_cast<uint64_t>(declared) > static_cast<uint64_t>(compressed_size - 8) * 255 + 16)
+            return false;
+        decompressed_size = static_cast<uint64_t>(declared);
+        return true;
     }
 
-    std::vector<uint8_t> RGB565LEToRGB(const std::vector<uint8_t>& data) {
-        std::vector<uint8_t> rgb_data;
-        rgb_data.reserve((data.size() / 2) * 3);
-
-        for (size_t i = 0; i + 1 < data.size(); i += 2) {
-            uint16_t pixel = *reinterpret_cast<const uint16_t*>(&data[i]);
-
-            uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-            uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-            uint8_t b = (pixel & 0x1F) << 3;
-
-            rgb_data.push_back(r);
-            rgb_data.push_back(g);
-            rgb_data.push_back(b);
-        }
-
-        return rgb_data;
-    }
-
-    std::vector<uint8_t> RGBToRGBA(const std::vector<uint8_t>& rgb_data) {
-        std::vector<uint8_t> rgba(rgb_data.size() / 3 * 4);
-
-        for (size_t i = 0, j = 0; i < rgb_data.size() - 2; i += 3, j += 4) {
-            rgba[j] = rgb_data[i];
-            rgba[j + 1] = rgb_data[i + 1];
-            rgba[j + 2] = rgb_data[i + 2];
-            rgba[j + 3] = 255;
-        }
+    // Decompresses into dst, reusing its capacity.
+    void LZ4Decompress(const uint8_t* compressed_data, size_t compressed_size, std::vector<uint8_t>& dst) {
+        if (compressed_size < 8)
+            throw std::runtime_error("Compressed data too short");
 
-        return rgba;
-    }
+        uint64_t decompressed_size = 0;
+        if (!PeekLZ4Size(compressed_data, compressed_size, decompressed_size))
+            throw std::runtime_error("Invalid LZ4 decompressed size");
 
-    void BGRASwapRB(std::vector<uint8_t>& buffer) {
-        for (size_t i = 0; i + 3 < buffer.size(); i += 4) {
-            std::swap(buffer[i], buffer[i + 2]);
-        }
+        dst.resize(static_cast<size_t>(decompressed_size));
+        bool ok = true;
+        size_t written = Core::LZ4DecodeBlock(compressed_data + 8, compressed_size - 8, dst.data(), dst.size(), &ok);
+        if (!ok)
+            throw std::runtime_error("Malformed LZ4 block");
+        dst.resize(written);
     }
 
-    std::vector<uint8_t> L8ToRGBA(const std::vector<uint8_t>& data) {
-    std::vector<uint8_t> rgba(data.size() * 4);
-    
-    for (size_t i = 0; i < data.size(); i++) {
-        uint8_t gray = data[i];
-        rgba[i * 4 + 0] = gray;  // R
-        rgba[i * 4 + 1] = gray;  // G
-        rgba[i * 4 + 2] = gray;  // B
-        rgba[i * 4 + 3] = 255;   // A 
-    }
-    
-    return rgba;
-}
-
     PixelFormatInfo GetPixelFormatInfo(int format_code) {
         static const std::map<int, PixelFormatInfo> format_map = {
             {4, {"RGB", 3, "RGB565_LE"}},
@@ -272,29 +186,40 @@ namespace SCTParser {
         return { "RGBA", 4, "UNKNOWN" };
     }
 
-    bool ShouldDecompressIntelligently(const std::vector<uint8_t>& image_data,
-        int width, int height, int pixel_format,
-        bool verbose) {
-        if (image_data.size() < 8) return false;
-
-        int expected_astc_size;
+    // Size an uncompressed raw/alpha flagged payload is expected to have.
+    int ExpectedRawSize(int width, int height, int pixel_format) {
         if (pixel_format == 40) {
             int blocks_w = (width + 3) / 4;
             int blocks_h = (height + 3) / 4;
-            expected_astc_size = blocks_w * blocks_h * 16;
-        }
-        else {
-            expected_astc_size = width * height * 2;
+            return blocks_w * blocks_h * 16;
         }
+        return width * height * 2;
+    }
 
-        double size_ratio = (double)image_data.size() / expected_astc_size;
+    // Raw/alpha flagged SCT2 payloads are sometimes LZ4 wrapped anyway. Decides by
+    // size and by whether the payload decodes; an accepted decode is handed back
+    // in decompressed so it is never decoded twice.
+    bool DecompressIfLZ4(const uint8_t* payload, size_t payload_size,
+        int width, int height, int pixel_format,
+        bool verbose, std::vector<uint8_t>& decompressed) {
+        if (payload_size < 8) return false;
+
+        int expected_astc_size = ExpectedRawSize(width, height, pixel_format);
+        double size_ratio = (double)payload_size / expected_astc_size;
+        if (size_ratio >= 0.95) {
+            // Already as large as the raw pixels would be; no need to try decoding.
+            if (verbose) {
+                std::cout << "Intelligent detection: data appears to be already decompressed\n";
+                std::cout << "   Size ratio: " << size_ratio << "\n";
+            }
+            return false;
+        }
 
-        std::vector<uint8_t> decompressed;
         double decomp_ratio = 0;
         bool lz4_works = false;
 
         try {
-            decompressed = LZ4Decompress(image_data);
+            LZ4Decompress(payload, payload_size, decompressed);
             decomp_ratio = (double)decompressed.size() / expected_astc_size;
             lz4_works = !decompressed.empty();
         }
@@ -303,7 +228,7 @@ namespace SCTParser {
             lz4_works = false;
         }
 
-        bool should_decompress = (size_ratio < 0.95 && lz4_works && decomp_ratio > size_ratio);
+        bool should_decompress = (lz4_works && decomp_ratio > size_ratio);
 
         if (verbose) {
             if (should_decompress) {
@@ -319,76 +244,140 @@ namespace SCTParser {
             }
         }
 
+        if (!should_decompress)
+            decompressed.clear();
         return should_decompress;
     }
 
 
-    void initialize_astc() {
-        static bool is_initialized = false;
-        if (!is_initialized) {
-            astcenc_config config;
-            astcenc_error status = astcenc_config_init(
-                ASTCENC_PRF_LDR,
-                4, 4, 1,
-                ASTCENC_PRE_FASTEST,
-                0,
-                &config
-            );
+    // Images at least this large are split across every core of one shared context;
+    // smaller ones are decoded whole on the calling thread, so concurrent
+    // extraction workers each get their own context instead.
+    static constexpr size_t COOPERATIVE_MIN_PIXELS = 1024 * 1024;
 
-            if (status == ASTCENC_SUCCESS) {
-                astcenc_context* context;
-                if (astcenc_context_alloc(&config, 1, &context) == ASTCENC_SUCCESS) {
-                    astcenc_context_free(context);
-                }
-            }
-            is_initialized = true;
-        }
-    }
+    // Context allocation builds the partition and block mode tables, which costs
+    // far more than decoding a typical texture, so contexts live for the whole
+    // process and are handed out per block size.
+    struct AstcContextSet {
+        int block_width = 0;
+        int block_height = 0;
 
-    std::vector<uint8_t> DecodeASTC(const std::vector<uint8_t>& compressed_data,
-        int width, int height, int block_width, int block_height) {
+        std::mutex idle_mutex;
+        std::vector<astcenc_context*> idle;     // thread_count = 1
 
+        std::mutex wide_mutex;                  // one cooperative decode at a time
+        astcenc_context* wide = nullptr;        // thread_count = wide_threads
+        unsigned int wide_threads = 0;
+    };
 
-        initialize_astc();
+    unsigned int CooperativeThreadCount() {
+        static const unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        return count;
+    }
 
+    AstcContextSet& GetContextSet(int block_width, int block_height) {
+        static std::mutex sets_mutex;
+        static std::map<std::pair<int, int>, std::unique_ptr<AstcContextSet>> sets;
 
-        if (width <= 0 || height <= 0 || width > 16384 || height > 16384) {
-            LogError("ASTC decode: invalid dimensions");
-            return std::vector<uint8_t>();
-        }
-        int blocks_x = (width + block_width - 1) / block_width;
-        int blocks_y = (height + block_height - 1) / block_height;
-        size_t expected_size = static_cast<size_t>(blocks_x) * static_cast<size_t>(blocks_y) * 16;
-        if (compressed_data.size() < expected_size) {
-            LogError(std::string("ASTC data too small: expected ") + std::to_string(expected_size) + ", got " + std::to_string(compressed_data.size()));
-            return std::vector<uint8_t>();
+        std::lock_guard<std::mutex> lock(sets_mutex);
+        auto& set = sets[{ block_width, block_height }];
+        if (!set) {
+            set = std::make_unique<AstcContextSet>();
+            set->block_width = block_width;
+            set->block_height = block_height;
         }
+        return *set;
+    }
 
+    astcenc_context* AllocContext(int block_width, int block_height, unsigned int thread_count) {
         astcenc_config config;
         astcenc_error status = astcenc_config_init(
             ASTCENC_PRF_LDR,
             block_width, block_height, 1,
             ASTCENC_PRE_FASTEST,
-            0,
+            ASTCENC_FLG_DECOMPRESS_ONLY,
             &config
         );
-
         if (status != ASTCENC_SUCCESS) {
             std::cerr << "Error: astcenc_config_init failed\n";
-            return std::vector<uint8_t>(width * height * 4, 128);
+            return nullptr;
         }
 
-
-        astcenc_context* context;
-        status = astcenc_context_alloc(&config, 1, &context);
+        astcenc_context* context = nullptr;
+        status = astcenc_context_alloc(&config, thread_count, &context);
         if (status != ASTCENC_SUCCESS) {
             std::cerr << "Error: astcenc_context_alloc failed\n";
-            return std::vector<uint8_t>(width * height * 4, 128);
+            return nullptr;
         }
+        return context;
+    }
 
+    astcenc_context* AcquireContext(AstcContextSet& set) {
+        {
+            std::lock_guard<std::mutex> lock(set.idle_mutex);
+            if (!set.idle.empty()) {
+                astcenc_context* context = set.idle.back();
+                set.idle.pop_back();
+                return context;
+            }
+        }
+        return AllocContext(set.block_width, set.block_height, 1);
+    }
+
+    void ReleaseContext(AstcContextSet& set, astcenc_context* context) {
+        std::lock_guard<std::mutex> lock(set.idle_mutex);
+        set.idle.push_back(context);
+    }
 
-        std::vector<uint8_t> rgba(width * height * 4);
+    // Runs astcenc's multi-thread protocol: every thread index calls decompress
+    // on the same image, then the context is reset for the next one.
+    astcenc_error DecompressCooperative(AstcContextSet& set, const uint8_t* compressed_data, size_t compressed_size,
+        astcenc_image& image, const astcenc_swizzle& swizzle) {
+        if (!set.wide) {
+            set.wide_threads = CooperativeThreadCount();
+            set.wide = AllocContext(set.block_width, set.block_height, set.wide_threads);
+            if (!set.wide)
+                return ASTCENC_ERR_OUT_OF_MEM;
+        }
+
+        std::atomic<int> first_error{ ASTCENC_SUCCESS };
+        auto run = [&](unsigned int thread_index) {
+            astcenc_error status = astcenc_decompress_image(set.wide, compressed_data, compressed_size,
+                &image, &swizzle, thread_index);
+            if (status != ASTCENC_SUCCESS) {
+                int expected = ASTCENC_SUCCESS;
+                first_error.compare_exchange_strong(expected, status);
+            }
+        };
 
+        std::vector<std::thread> helpers;
+        helpers.reserve(set.wide_threads - 1);
+        for (unsigned int i = 1; i < set.wide_threads; ++i)
+            helpers.emplace_back(run, i);
+        run(0);
+        for (auto& helper : helpers)
+            helper.join();
+
+        astcenc_decompress_reset(set.wide);
+        return static_cast<astcenc_error>(first_error.load());
+    }
+
+    // Decodes into rgba (width * height * 4 bytes). A failed decode leaves the
+    // image grey; false means the input was unusable and rgba is untouched.
+    bool DecodeASTC(const uint8_t* compressed_data, size_t compressed_size,
+        int width, int height, int block_width, int block_height, uint8_t* rgba) {
+        if (width <= 0 || height <= 0 || width > 16384 || height > 16384) {
+            LogError("ASTC decode: invalid dimensions");
+            return false;
+        }
+        int blocks_x = (width + block_width - 1) / block_width;
+        int blocks_y = (height + block_height - 1) / block_height;
+        size_t expected_size = static_cast<size_t>(blocks_x) * static_cast<size_t>(blocks_y) * 16;
+        if (compressed_size < expected_size) {
+            LogError(std::string("ASTC data too small: expected ") + std::to_string(expected_size) + ", got " + std::to_string(compressed_size));
+            return false;
+        }
+        const size_t rgba_size = static_cast<size_t>(width) * height * 4;
 
         astcenc_image image;
         image.dim_x = width;
@@ -396,242 +385,790 @@ namespace SCTParser {
         image.dim_z = 1;
         image.data_type = ASTCENC_TYPE_U8;
 
-        void* data_ptr = rgba.data();
+        void* data_ptr = rgba;
         image.data = &data_ptr;
 
+        astcenc_swizzle swizzle = { ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A };
 
-        astcenc_swizzle swizzle = { ASTCENC_SWZ_B, ASTCENC_SWZ_G, ASTCENC_SWZ_R, ASTCENC_SWZ_A };
+        AstcContextSet& set = GetContextSet(block_width, block_height);
+        astcenc_error status = ASTCENC_SUCCESS;
 
+        // If another worker already holds the wide context, decoding alone is
+        // faster than waiting for it.
+        std::unique_lock<std::mutex> wide_lock(set.wide_mutex, std::defer_lock);
+        bool cooperative = static_cast<size_t>(width) * height >= COOPERATIVE_MIN_PIXELS &&
+            CooperativeThreadCount() > 1 && wide_lock.try_lock();
 
-        status = astcenc_decompress_image(
-            context,
-            compressed_data.data(),
-            compressed_data.size(),
-            &image,
-            &swizzle,
-            0
-        );
+        if (cooperative) {
+            status = DecompressCooperative(set, compressed_data, compressed_size, image, swizzle);
+        }
+        else {
+            astcenc_context* context = AcquireContext(set);
+            if (!context) {
+                std::memset(rgba, 128, rgba_size);
+                return true;
+            }
+
+            status = astcenc_decompress_image(context, compressed_data, compressed_size,
+                &image, &swizzle, 0);
+            ReleaseContext(set, context);
+        }
 
         if (status != ASTCENC_SUCCESS) {
             std::cerr << "Error: astcenc_decompress_image failed (" << status << ")\n";
-            std::fill(rgba.begin(), rgba.end(), 128);
+            std::memset(rgba, 128, rgba_size);
         }
 
+        return true;
+    }
 
-        astcenc_context_free(context);
+    // Decodes ETC2 block rows [first_row, last_row). Interior blocks are written
+    // in place at the image stride; only blocks crossing the right or bottom
+    // edge go through a temporary to be clipped.
+    void DecodeETC2Rows(const uint8_t* compressed, uint8_t* rgba, int width, int height,
+        int first_row, int last_row) {
+        const int num_blocks_x = (width + 3) / 4;
+        const int full_blocks_x = width / 4;
+        const size_t pitch = static_cast<size_t>(width) * 4;
+
+        for (int by = first_row; by < last_row; ++by) {
+            const uint8_t* src = compressed + static_cast<size_t>(by) * num_blocks_x * 16;
+            uint8_t* dst_row = rgba + static_cast<size_t>(by) * 4 * pitch;
+            const int rows = std::min(4, height - by * 4);
+
+            if (rows == 4) {
+                for (int bx = 0; bx < full_blocks_x; ++bx)
+                    etcdec_eac_rgba(src + bx * 16, dst_row + bx * 16, static_cast<int>(pitch));
+            }
+            else {
+                for (int bx = 0; bx < full_blocks_x; ++bx) {
+                    uint8_t block_pixels[4 * 4 * 4];
+                    etcdec_eac_rgba(src + bx * 16, block_pixels, 16);
+                    for (int y = 0; y < rows; ++y)
+                        std::memcpy(dst_row + y * pitch + bx * 16, block_pixels + y * 16, 16);
+                }
+            }
 
-        return rgba;
+            if (full_blocks_x < num_blocks_x) {
+                const int columns = width - full_blocks_x * 4;
+                uint8_t block_pixels[4 * 4 * 4];
+                etcdec_eac_rgba(src + full_blocks_x * 16, block_pixels, 16);
+                for (int y = 0; y < rows; ++y)
+                    std::memcpy(dst_row + y * pitch + full_blocks_x * 16, block_pixels + y * 16, columns * 4);
+            }
+        }
     }
 
-    std::vector<uint8_t> DecodeETC2RGBA8(const std::vector<uint8_t>& compressed_data,
-        int width, int height, bool verbose) {
+    // Decodes into rgba (width * height * 4 bytes); short input leaves it grey.
+    void DecodeETC2RGBA8(const uint8_t* compressed_data, size_t compressed_size,
+        int width, int height, uint8_t* rgba, bool verbose) {
         if (verbose) std::cout << "Decoding ETC2 RGBA8 with etcdec.h...\n";
 
+        int num_blocks_x = (width + 3) / 4;
+        int num_blocks_y = (height + 3) / 4;
 
-        const int block_width = 4;
-        const int block_height = 4;
-        const int block_size = 16;
+        size_t expected_size = static_cast<size_t>(num_blocks_x) * num_blocks_y * 16;
+        if (compressed_size < expected_size) {
+            if (verbose) std::cerr << "Error: ETC2 data size mismatch. Expected " << expected_size << " bytes, got " << compressed_size << "\n";
 
+            std::memset(rgba, 128, static_cast<size_t>(width) * height * 4);
+            return;
+        }
 
-        int num_blocks_x = (width + block_width - 1) / block_width;
-        int num_blocks_y = (height + block_height - 1) / block_height;
+        const uint8_t* src = compressed_data;
 
+        // Same policy as ASTC: only large images fan out, and only one at a time,
+        // so concurrent extraction workers do not multiply the thread count.
+        static std::mutex wide_mutex;
+        std::unique_lock<std::mutex> wide_lock(wide_mutex, std::defer_lock);
+        bool cooperative = static_cast<size_t>(width) * height >= COOPERATIVE_MIN_PIXELS &&
+            CooperativeThreadCount() > 1 && wide_lock.try_lock();
 
-        size_t expected_size = num_blocks_x * num_blocks_y * block_size;
-        if (compressed_data.size() < expected_size) {
-            if (verbose) std::cerr << "Error: ETC2 data size mismatch. Expected " << expected_size << " bytes, got " << compressed_data.size() << "\n";
+        if (!cooperative) {
+            DecodeETC2Rows(src, rgba, width, height, 0, num_blocks_y);
+            return;
+        }
+
+        // Block rows are handed out in small batches so threads that finish
+        // early pick up the remaining work.
+        static constexpr int ROWS_PER_BATCH = 8;
+        std::atomic<int> next_row{ 0 };
+        auto run = [&]() {
+            for (;;) {
+                int first = next_row.fetch_add(ROWS_PER_BATCH);
+                if (first >= num_blocks_y)
+                    break;
+                DecodeETC2Rows(src, rgba, width, height, first, std::min(first + ROWS_PER_BATCH, num_blocks_y));
+            }
+        };
+
+        unsigned int thread_count = std::min<unsigned int>(CooperativeThreadCount(),
+            (num_blocks_y + ROWS_PER_BATCH - 1) / ROWS_PER_BATCH);
+        std::vector<std::thread> helpers;
+        helpers.reserve(thread_count - 1);
+        for (unsigned int i = 1; i < thread_count; ++i)
+            helpers.emplace_back(run);
+        run();
+        for (auto& helper : helpers)
+            helper.join();
+    }
+
+    // Parses the header and points payload at the pixel data: into data itself
+    // when it is stored plain, or into scratch after LZ4 decompression when the
+    // file says (or looks like) it is compressed. Returns false for data that is
+    // not SCT/SCT2.
+    bool ReadPayload(const uint8_t* data, size_t size, bool verbose, Header& header,
+        PixelFormatInfo& format_info, std::vector<uint8_t>& scratch,
+        const uint8_t*& payload, size_t& payload_size) {
+        Format format_type = DetectFormat(data, size);
+        if (format_type == Format::SCT2) {
+            header = ParseSCT2Header(data, size);
+            if (header.data_offset < 0 || static_cast<size_t>(header.data_offset) > size)
+                throw std::runtime_error("SCT2 data offset out of range");
+            const uint8_t* stored = data + header.data_offset;
+            size_t stored_size = size - header.data_offset;
+            payload = stored;
+            payload_size = stored_size;
+
+            if (header.raw_data || header.has_alpha) {
+                if (DecompressIfLZ4(stored, stored_size, header.width, header.height,
+                    header.pixel_format, verbose, scratch)) {
+                    if (verbose) std::cout << "LZ4 decompression applied: " << scratch.size() << " bytes\n";
+                    payload = scratch.data();
+                    payload_size = scratch.size();
+                }
+            }
+            else if (header.pixel_format == 40 || header.compressed) {
+                try {
+                    LZ4Decompress(stored, stored_size, scratch);
+                    if (verbose) std::cout << "Decompression successful: " << scratch.size() << " bytes\n";
+                    payload = scratch.data();
+                    payload_size = scratch.size();
+                }
+                catch (...) {
+                    if (verbose) std::cout << "Decompression failed\n";
+                }
+            }
+
+            format_info = GetPixelFormatInfo(header.pixel_format);
 
-            return std::vector<uint8_t>(width * height * 4, 128);
         }
+        else if (format_type == Format::SCT) {
+            header = ParseSCTHeader(data, size);
 
+            if (verbose) std::cout << "Decompressing data...\n";
+            try {
+                LZ4Decompress(data + header.data_offset, size - header.data_offset, scratch);
+                if (verbose) std::cout << "Decompressed: " << scratch.size() << " bytes\n";
+            }
+            catch (const std::exception& e) {
+                if (verbose) std::cout << "Error during decompression: " << e.what() << "\n";
+                throw;
+            }
+            payload = scratch.data();
+            payload_size = scratch.size();
 
-        std::vector<uint8_t> rgba(width * height * 4);
+            format_info = GetPixelFormatInfo(header.pixel_format);
 
-        uint8_t block_pixels[block_width * block_height * 4];
+        }
+        else {
+            if (verbose) std::cout << "Unsupported format\n";
+            return false;
+        }
+        return true;
+    }
 
-        const uint8_t* src_ptr = compressed_data.data();
+    // KTX2 description of one SCT pixel format: the Vulkan format plus the
+    // Khronos Data Format descriptor fields the container has to carry.
+    struct Ktx2Sample {
+        uint16_t bit_offset;
+        uint8_t bit_length;
+        uint8_t channel;        // channel id, with 0x10 for a linear sample in an sRGB format
+        uint32_t upper;
+    };
+
+    struct Ktx2Format {
+        uint32_t vk_format = 0;
+        uint32_t type_size = 1;
+        uint8_t color_model = 0;
+        uint8_t transfer = 0;
+        int block_width = 1;
+        int block_height = 1;
+        uint32_t block_bytes = 0;
+        std::vector<Ktx2Sample> samples;
+        const char* swizzle = nullptr;
+    };
+
+    static constexpr uint8_t KHR_DF_MODEL_RGBSDA = 1;
+    static constexpr uint8_t KHR_DF_MODEL_ETC2 = 161;
+    static constexpr uint8_t KHR_DF_MODEL_ASTC = 162;
+    static constexpr uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+    static constexpr uint8_t KHR_DF_TRANSFER_SRGB = 2;
+
+    // Colour data is stored as sRGB where Vulkan has such a format, matching how
+    // the PNG export presents the same bytes.
+    bool GetKtx2Format(const std::string& type, Ktx2Format& format) {
+        auto astc = [&](int block, uint32_t vk_format) {
+            format.vk_format = vk_format;
+            format.color_model = KHR_DF_MODEL_ASTC;
+            format.transfer = KHR_DF_TRANSFER_SRGB;
+            format.block_width = block;
+            format.block_height = block;
+            format.block_bytes = 16;
+            format.samples = { { 0, 127, 0, 0xFFFFFFFFu } };
+        };
 
-        for (int by = 0; by < num_blocks_y; ++by) {
-            for (int bx = 0; bx < num_blocks_x; ++bx) {
+        if (type == "ASTC_4x4") astc(4, 158);           // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+        else if (type == "ASTC_6x6") astc(6, 166);      // VK_FORMAT_ASTC_6x6_SRGB_BLOCK
+        else if (type == "ASTC_8x8") astc(8, 172);      // VK_FORMAT_ASTC_8x8_SRGB_BLOCK
+        else if (type == "ETC2_RGBA8") {
+            format.vk_format = 152;                     // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+            format.color_model = KHR_DF_MODEL_ETC2;
+            format.transfer = KHR_DF_TRANSFER_SRGB;
+            format.block_width = 4;
+            format.block_height = 4;
+            format.block_bytes = 16;
+            format.samples = { { 0, 63, 15, 0xFFFFFFFFu }, { 64, 63, 2, 0xFFFFFFFFu } };
+        }
+        else if (type == "RGB565_LE") {
+            format.vk_format = 4;                       // VK_FORMAT_R5G6B5_UNORM_PACK16
+            format.type_size = 2;
+            format.color_model = KHR_DF_MODEL_RGBSDA;
+            format.transfer = KHR_DF_TRANSFER_LINEAR;
+            format.block_bytes = 2;
+            format.samples = { { 0, 4, 2, 31 }, { 5, 5, 1, 63 }, { 11, 4, 0, 31 } };
+        }
+        else if (type == "L8") {
+            format.vk_format = 15;                      // VK_FORMAT_R8_SRGB
+            format.color_model = KHR_DF_MODEL_RGBSDA;
+            format.transfer = KHR_DF_TRANSFER_SRGB;
+            format.block_bytes = 1;
+            format.samples = { { 0, 7, 0, 255 } };
+            format.swizzle = "rrr1";
+        }
+        else if (type == "RGBA") {
+            format.vk_format = 43;                      // VK_FORMAT_R8G8B8A8_SRGB
+            format.color_model = KHR_DF_MODEL_RGBSDA;
+            format.transfer = KHR_DF_TRANSFER_SRGB;
+            format.block_bytes = 4;
+            format.samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, 0x1F, 255 } };
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
 
-                etcdec_eac_rgba(src_ptr, block_pixels, 16);
+    void AppendU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i)
+            out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
 
+    void AppendU64(std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; ++i)
+            out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    }
 
-                src_ptr += block_size;
+    void AppendKeyValue(std::vector<uint8_t>& out, const char* key, const char* value) {
+        size_t key_size = std::strlen(key) + 1;
+        size_t value_size = std::strlen(value) + 1;
+        AppendU32(out, static_cast<uint32_t>(key_size + value_size));
+        out.insert(out.end(), key, key + key_size);
+        out.insert(out.end(), value, value + value_size);
+        while (out.size() % 4)
+            out.push_back(0);
+    }
 
+    // Single level, single layer 2D KTX2 file around level_data.
+    std::vector<uint8_t> WriteKtx2(const Ktx2Format& format, int width, int height,
+        const uint8_t* level_data, size_t level_size) {
+        static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+        static constexpr size_t HEADER_SIZE = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+        static constexpr size_t LEVEL_INDEX_SIZE = 3 * 8;
+
+        std::vector<uint8_t> dfd;
+        const uint32_t block_size = 24 + 16 * static_cast<uint32_t>(format.samples.size());
+        AppendU32(dfd, 4 + block_size);
+        AppendU32(dfd, 0);                              // vendor Khronos, basic descriptor block
+        AppendU32(dfd, 2 | (block_size << 16));         // version 1.3
+        dfd.push_back(format.color_model);
+        dfd.push_back(1);                               // BT.709 primaries
+        dfd.push_back(format.transfer);
+        dfd.push_back(0);                               // straight alpha
+        dfd.push_back(static_cast<uint8_t>(format.block_width - 1));
+        dfd.push_back(static_cast<uint8_t>(format.block_height - 1));
+        dfd.push_back(0);
+        dfd.push_back(0);
+        dfd.push_back(static_cast<uint8_t>(format.block_bytes));
+        dfd.insert(dfd.end(), 7, 0);
+        for (const Ktx2Sample& sample : format.samples) {
+            dfd.push_back(static_cast<uint8_t>(sample.bit_offset));
+            dfd.push_back(static_cast<uint8_t>(sample.bit_offset >> 8));
+            dfd.push_back(sample.bit_length);
+            dfd.push_back(sample.channel);
+            AppendU32(dfd, 0);                          // sample position
+            AppendU32(dfd, 0);                          // lower
+            AppendU32(dfd, sample.upper);
+        }
 
-                for (int y = 0; y < block_height; ++y) {
-                    for (int x = 0; x < block_width; ++x) {
+        std::vector<uint8_t> kvd;
+        if (format.swizzle)
+            AppendKeyValue(kvd, "KTXswizzle", format.swizzle);
+        AppendKeyValue(kvd, "KTXwriter", "CZN ASSet Ripper");
+
+        const size_t dfd_offset = HEADER_SIZE + LEVEL_INDEX_SIZE;
+        const size_t kvd_offset = dfd_offset + dfd.size();
+        // Level data starts on a multiple of lcm(block bytes, 4).
+        size_t alignment = format.block_bytes % 4 == 0 ? format.block_bytes : 4;
+        size_t level_offset = kvd_offset + kvd.size();
+        level_offset = (level_offset + alignment - 1) / alignment * alignment;
+
+        std::vector<uint8_t> out;
+        out.reserve(level_offset + level_size);
+        out.insert(out.end(), identifier, identifier + 12);
+        AppendU32(out, format.vk_format);
+        AppendU32(out, format.type_size);
+        AppendU32(out, static_cast<uint32_t>(width));
+        AppendU32(out, static_cast<uint32_t>(height));
+        AppendU32(out, 0);                              // pixelDepth
+        AppendU32(out, 0);                              // layerCount
+        AppendU32(out, 1);                              // faceCount
+        AppendU32(out, 1);                              // levelCount
+        AppendU32(out, 0);                              // no supercompression
+        AppendU32(out, static_cast<uint32_t>(dfd_offset));
+        AppendU32(out, static_cast<uint32_t>(dfd.size()));
+        AppendU32(out, static_cast<uint32_t>(kvd_offset));
+        AppendU32(out, static_cast<uint32_t>(kvd.size()));
+        AppendU64(out, 0);                              // no supercompression global data
+        AppendU64(out, 0);
+        AppendU64(out, level_offset);
+        AppendU64(out, level_size);
+        AppendU64(out, level_size);
+        out.insert(out.end(), dfd.begin(), dfd.end());
+        out.insert(out.end(), kvd.begin(), kvd.end());
+        out.resize(level_offset, 0);
+        out.insert(out.end(), level_data, level_data + level_size);
+        return out;
+    }
 
-                        int final_x = bx * block_width + x;
-                        int final_y = by * block_height + y;
+    // Decodes a payload of the given format into rgba (width * height * 4
+    // bytes). Returns false if the payload is too small for the image or a
+    // block decoder rejects it.
+    bool DecodePayload(const std::string& type, const uint8_t* payload, size_t payload_size,
+        int width, int height, uint8_t* rgba, bool verbose) {
+        const size_t pixel_count = static_cast<size_t>(width) * height;
+
+        if (type == "L8") {
+            if (verbose) std::cout << "Decoding L8...\n";
+            if (payload_size < pixel_count)
+                return false;
+            PixelConvert::L8ToRGBA(payload, pixel_count, rgba);
+        }
+        else if (type == "RGB565_LE") {
+            if (verbose) std::cout << "Decoding RGB565 Little Endian...\n";
+            if (payload_size / 2 < pixel_count)
+                return false;
+            PixelConvert::RGB565ToRGBA(payload, pixel_count, rgba);
+        }
+        else if (type == "ETC2_RGBA8") {
+            if (verbose) std::cout << "Decoding ETC2 RGBA8...\n";
+            DecodeETC2RGBA8(payload, payload_size, width, height, rgba, verbose);
+        }
+        else if (type == "ASTC_4x4" || type == "ASTC_6x6" || type == "ASTC_8x8") {
+            int block = type == "ASTC_4x4" ? 4 : type == "ASTC_6x6" ? 6 : 8;
+            if (verbose) std::cout << "Decoding ASTC " << block << "x" << block << "...\n";
+            if (!DecodeASTC(payload, payload_size, width, height, block, block, rgba)) {
+                LogError("ASTC " + std::to_string(block) + "x" + std::to_string(block) + " decode failed");
+                return false;
+            }
+        }
+        else {
+            if (verbose) std::cout << "Using raw " << type << " data\n";
+            if (payload_size / 4 < pixel_count)
+                return false;
+            std::memcpy(rgba, payload, pixel_count * 4);
+        }
+        return true;
+    }
 
+    bool GetBlockSize(const std::string& type, int& block_width, int& block_height) {
+        if (type == "ETC2_RGBA8" || type == "ASTC_4x4")
+            block_width = block_height = 4;
+        else if (type == "ASTC_6x6")
+            block_width = block_height = 6;
+        else if (type == "ASTC_8x8")
+            block_width = block_height = 8;
+        else
+            return false;
+        return true;
+    }
 
+    // Scales the longer side down to max_size, keeping the aspect ratio.
+    void ThumbnailSize(int width, int height, int max_size, int& thumb_width, int& thumb_height) {
+        int longer = std::max(width, height);
+        if (longer <= max_size) {
+            thumb_width = width;
+            thumb_height = height;
+            return;
+        }
+        thumb_width = std::max(1, static_cast<int>((static_cast<int64_t>(width) * max_size + longer / 2) / longer));
+        thumb_height = std::max(1, static_cast<int>((static_cast<int64_t>(height) * max_size + longer / 2) / longer));
+    }
 
-                        if (final_x < width && final_y < height) {
-                            size_t block_idx = (y * block_width + x) * 4;
-                            size_t final_idx = (final_y * width + final_x) * 4;
+    // Copies an evenly spaced subset of blocks, about two pixels per thumbnail
+    // pixel in each direction, into a smaller block image. Skipped blocks are
+    // never decoded. Edge blocks are only kept when every block is, so the
+    // sample never contains padding pixels.
+    void SampleBlocks(const uint8_t* blocks, int width, int height, int block_width, int block_height,
+        int thumb_width, int thumb_height, std::vector<uint8_t>& sample, int& sample_width, int& sample_height) {
+        int blocks_x = (width + block_width - 1) / block_width;
+        int blocks_y = (height + block_height - 1) / block_height;
+        int keep_x = std::min(blocks_x, (2 * thumb_width + block_width - 1) / block_width);
+        int keep_y = std::min(blocks_y, (2 * thumb_height + block_height - 1) / block_height);
+        sample_width = keep_x == blocks_x ? width : keep_x * block_width;
+        sample_height = keep_y == blocks_y ? height : keep_y * block_height;
+
+        sample.resize(static_cast<size_t>(keep_x) * keep_y * 16);
+        uint8_t* dst = sample.data();
+        for (int y = 0; y < keep_y; ++y) {
+            size_t row = static_cast<size_t>(y) * blocks_y / keep_y;
+            for (int x = 0; x < keep_x; ++x) {
+                size_t column = static_cast<size_t>(x) * blocks_x / keep_x;
+                std::memcpy(dst, blocks + (row * blocks_x + column) * 16, 16);
+                dst += 16;
+            }
+        }
+    }
 
-                            rgba[final_idx + 0] = block_pixels[block_idx + 0];
-                            rgba[final_idx + 1] = block_pixels[block_idx + 1];
-                            rgba[final_idx + 2] = block_pixels[block_idx + 2];
-                            rgba[final_idx + 3] = block_pixels[block_idx + 3];
-                        }
+    // Averages the source pixels covered by each thumbnail pixel. Only scales down.
+    void BoxFilter(const uint8_t* src, int src_width, int src_height, uint8_t* out, int width, int height) {
+        std::vector<int> column_start(width + 1);
+        for (int x = 0; x <= width; ++x)
+            column_start[x] = static_cast<int>(static_cast<int64_t>(x) * src_width / width);
+
+        std::vector<uint32_t> sums(static_cast<size_t>(width) * 4);
+        for (int y = 0; y < height; ++y) {
+            int row_start = static_cast<int>(static_cast<int64_t>(y) * src_height / height);
+            int row_end = static_cast<int>(static_cast<int64_t>(y + 1) * src_height / height);
+            std::fill(sums.begin(), sums.end(), 0);
+            for (int sy = row_start; sy < row_end; ++sy) {
+                const uint8_t* row = src + static_cast<size_t>(sy) * src_width * 4;
+                for (int x = 0; x < width; ++x) {
+                    uint32_t* sum = &sums[x * 4];
+                    for (int sx = column_start[x]; sx < column_start[x + 1]; ++sx) {
+                        const uint8_t* p = row + sx * 4;
+                        sum[0] += p[0];
+                        sum[1] += p[1];
+                        sum[2] += p[2];
+                        sum[3] += p[3];
                     }
                 }
             }
+            uint8_t* dst = out + static_cast<size_t>(y) * width * 4;
+            for (int x = 0; x < width; ++x) {
+                uint32_t count = static_cast<uint32_t>(row_end - row_start) * (column_start[x + 1] - column_start[x]);
+                for (int c = 0; c < 4; ++c)
+                    dst[x * 4 + c] = static_cast<uint8_t>((sums[x * 4 + c] + count / 2) / count);
+            }
         }
+    }
 
-        return rgba;
+    // Takes the pixel at the centre of each thumbnail cell, converting one
+    // gathered row at a time.
+    void SamplePixels(const uint8_t* pixels, const std::string& type, int bytes_per_pixel,
+        int width, int height, uint8_t* out, int thumb_width, int thumb_height) {
+        std::vector<size_t> columns(thumb_width);
+        for (int x = 0; x < thumb_width; ++x)
+            columns[x] = static_cast<size_t>((static_cast<int64_t>(2 * x + 1) * width) / (2 * thumb_width));
+
+        std::vector<uint8_t> gathered(static_cast<size_t>(thumb_width) * bytes_per_pixel);
+        for (int y = 0; y < thumb_height; ++y) {
+            size_t sy = static_cast<size_t>((static_cast<int64_t>(2 * y + 1) * height) / (2 * thumb_height));
+            const uint8_t* row = pixels + sy * width * bytes_per_pixel;
+            for (int x = 0; x < thumb_width; ++x)
+                std::memcpy(&gathered[static_cast<size_t>(x) * bytes_per_pixel], row + columns[x] * bytes_per_pixel, bytes_per_pixel);
+
+            uint8_t* dst = out + static_cast<size_t>(y) * thumb_width * 4;
+            if (type == "L8")
+                PixelConvert::L8ToRGBA(gathered.data(), thumb_width, dst);
+            else if (type == "RGB565_LE")
+                PixelConvert::RGB565ToRGBA(gathered.data(), thumb_width, dst);
+            else
+                std::memcpy(dst, gathered.data(), gathered.size());
+        }
     }
+
+    // Buffers above this are freed after each call instead of being kept for
+    // the next one; it covers a 4096x4096 RGBA image.
+    static constexpr size_t MAX_RETAINED_BYTES = 64 * 1024 * 1024;
+
+    void TrimContext(DecodeContext& context) {
+        for (std::vector<uint8_t>* buffer : { &context.payload, &context.sample, &context.pixels }) {
+            if (buffer->capacity() > MAX_RETAINED_BYTES)
+                std::vector<uint8_t>().swap(*buffer);
+        }
     }
 
-    RGBAImage ConvertToRGBA(const std::vector<uint8_t>& data, bool verbose) {
+    // Reads the header and payload and decodes into the buffer that target
+    // returns for the image size, or fails if target returns nullptr.
+    template <typename Target>
+    bool DecodeImage(const uint8_t* data, size_t size, DecodeContext& context, bool verbose,
+        const std::string& caller, int& width, int& height, Target&& target) {
         try {
-            Format format_type = DetectFormat(data);
             Header header;
-            std::vector<uint8_t> image_data;
             PixelFormatInfo format_info;
+            const uint8_t* payload = nullptr;
+            size_t payload_size = 0;
+            if (!ReadPayload(data, size, verbose, header, format_info, context.payload, payload, payload_size))
+                return false;
 
-            if (format_type == Format::SCT2) {
-                header = ParseSCT2Header(data);
-                size_t image_data_start = header.data_offset;
-                image_data.assign(data.begin() + image_data_start, data.end());
-
-                if (header.raw_data || header.has_alpha) {
-                    if (ShouldDecompressIntelligently(image_data, header.width, header.height,
-                        header.pixel_format, verbose)) {
-                        try {
-                            image_data = LZ4Decompress(image_data);
-                            if (verbose) std::cout << "LZ4 decompression applied: " << image_data.size() << " bytes\n";
-                        }
-                        catch (...) {
-                            if (verbose) std::cout << "Decompression failed, using raw data\n";
-                        }
-                    }
-                }
-                else if (header.pixel_format == 40 || header.compressed) {
-                    try {
-                        image_data = LZ4Decompress(image_data);
-                        if (verbose) std::cout << "Decompression successful: " << image_data.size() << " bytes\n";
-                    }
-                    catch (...) {
-                        if (verbose) std::cout << "Decompression failed\n";
-                    }
-                }
-
-                format_info = GetPixelFormatInfo(header.pixel_format);
+            width = header.width;
+            height = header.height;
+            if (width <= 0 || height <= 0 || width > 16384 || height > 16384) {
+                LogError(caller + ": invalid dimensions");
+                return false;
+            }
 
+            uint8_t* rgba = target(width, height);
+            if (!rgba) {
+                LogError(caller + ": output buffer too small");
+                return false;
+            }
+            if (!DecodePayload(format_info.type, payload, payload_size, width, height, rgba, verbose)) {
+                if (verbose) std::cout << "Error: No valid image data produced\n";
+                LogError(caller + ": RGBA buffer invalid size");
+                return false;
             }
-            else if (format_type == Format::SCT) {
-                header = ParseSCTHeader(data);
-                size_t image_data_start = header.data_offset;
-                image_data.assign(data.begin() + image_data_start, data.end());
+            return true;
+        }
+        catch (const std::exception& e) {
+            if (verbose) std::cout << "Error during conversion: " << e.what() << "\n";
+            LogError(caller + " exception: " + e.what());
+            return false;
+        }
+    }
+    }
 
-                if (verbose) std::cout << "Decompressing data...\n";
-                try {
-                    image_data = LZ4Decompress(image_data);
-                    if (verbose) std::cout << "Decompressed: " << image_data.size() << " bytes\n";
-                }
-                catch (const std::exception& e) {
-                    if (verbose) std::cout << "Error during decompression: " << e.what() << "\n";
-                    throw;
-                }
+    DecodeContext& ThreadDecodeContext() {
+        thread_local DecodeContext context;
+        return context;
+    }
+
+    bool DecodeRGBA(const uint8_t* data, size_t size, uint8_t* dst, size_t dst_size,
+        DecodeContext& context, bool verbose) {
+        int width = 0;
+        int height = 0;
+        bool decoded = DecodeImage(data, size, context, verbose, "SCT DecodeRGBA", width, height,
+            [&](int w, int h) { return dst_size >= static_cast<size_t>(w) * h * 4 ? dst : nullptr; });
+        TrimContext(context);
+        return decoded;
+    }
 
-                format_info = GetPixelFormatInfo(header.pixel_format);
+    bool DecodeRGBA(const uint8_t* data, size_t size, RGBAImage& image, DecodeContext& context, bool verbose) {
+        bool decoded = DecodeImage(data, size, context, verbose, "SCT DecodeRGBA", image.width, image.height,
+            [&](int w, int h) {
+                image.data.resize(static_cast<size_t>(w) * h * 4);
+                return image.data.data();
+            });
+        TrimContext(context);
+        if (!decoded) {
+            image.data.clear();
+            image.width = 0;
+            image.height = 0;
+        }
+        return decoded;
+    }
 
-            }
-            else {
-                if (verbose) std::cout << "Unsupported format\n";
+    RGBAImage ConvertToRGBA(const std::vector<uint8_t>& data, bool verbose) {
+        RGBAImage image;
+        DecodeRGBA(data.data(), data.size(), image, ThreadDecodeContext(), verbose);
+        return image;
+    }
+
+    RGBAImage ConvertToThumbnail(const std::vector<uint8_t>& data, int max_size, bool verbose) {
+        DecodeContext& context = ThreadDecodeContext();
+        RGBAImage result;
+        try {
+            Header header;
+            PixelFormatInfo format_info;
+            const uint8_t* payload = nullptr;
+            size_t payload_size = 0;
+            if (max_size <= 0 || !ReadPayload(data.data(), data.size(), verbose, header, format_info,
+                context.payload, payload, payload_size))
                 return {};
-            }
 
             int width = header.width;
             int height = header.height;
             if (width <= 0 || height <= 0 || width > 16384 || height > 16384) {
-                LogError("SCT ConvertToRGBA: invalid dimensions");
+                LogError("SCT ConvertToThumbnail: invalid dimensions");
                 return {};
             }
-            std::vector<uint8_t> final_rgba_data;
 
-            if(format_info.type == "L8")
-            {
-                if (verbose) std::cout<< "Decoding L8...\n";
-                final_rgba_data = L8ToRGBA(image_data);
-            }
-            else if (format_info.type == "RGB565_LE") {
-                if (verbose) std::cout << "Decoding RGB565 Little Endian...\n";
-                auto rgb_data = RGB565LEToRGB(image_data);
-                final_rgba_data = RGBToRGBA(rgb_data);
-            }
-            else if (format_info.type == "ETC2_RGBA8") {
-                if (verbose) std::cout << "Decoding ETC2 RGBA8...\n";
-                final_rgba_data = DecodeETC2RGBA8(image_data, width, height, verbose);
-            }
-            else if (format_info.type == "ASTC_4x4") {
-                if (verbose) std::cout << "Decoding ASTC 4x4...\n";
-                final_rgba_data = DecodeASTC(image_data, width, height, 4, 4);
-                if (final_rgba_data.empty()) { LogError("ASTC 4x4 decode failed"); return {}; }
-                BGRASwapRB(final_rgba_data);
-            }
-            else if(format_info.type == "ASTC_6x6"){
-                if (verbose) std::cout << "Decoding ASTC 6x6...\n";
-                final_rgba_data = DecodeASTC(image_data, width, height, 6, 6);
-                if(final_rgba_data.empty()) { LogError("ASTC 6x6 decode failed"); return {};}
-                BGRASwapRB(final_rgba_data);
+            ThumbnailSize(width, height, max_size, result.width, result.height);
+            result.data.resize(static_cast<size_t>(result.width) * result.height * 4);
+            const std::string& type = format_info.type;
+            int block_width = 0;
+            int block_height = 0;
+            bool decoded = true;
+
+            if (result.width == width && result.height == height) {
+                decoded = DecodePayload(type, payload, payload_size, width, height, result.data.data(), verbose);
             }
-            else if (format_info.type == "ASTC_8x8") {
-                if (verbose) std::cout << "Decoding ASTC 8x8...\n";
-                final_rgba_data = DecodeASTC(image_data, width, height, 8, 8);
-                if (final_rgba_data.empty()) { LogError("ASTC 8x8 decode failed"); return {}; }
-                BGRASwapRB(final_rgba_data);
+            else if (GetBlockSize(type, block_width, block_height)) {
+                size_t blocks = static_cast<size_t>((width + block_width - 1) / block_width) *
+                    ((height + block_height - 1) / block_height);
+                if (payload_size < blocks * 16) {
+                    LogError("SCT ConvertToThumbnail: " + type + " data too small");
+                    return {};
+                }
+                int sample_width = 0;
+                int sample_height = 0;
+                SampleBlocks(payload, width, height, block_width, block_height,
+                    result.width, result.height, context.sample, sample_width, sample_height);
+                if (verbose) std::cout << "Decoding " << type << " sample " << sample_width << "x" << sample_height << "\n";
+                context.pixels.resize(static_cast<size_t>(sample_width) * sample_height * 4);
+                decoded = DecodePayload(type, context.sample.data(), context.sample.size(),
+                    sample_width, sample_height, context.pixels.data(), verbose);
+                if (decoded)
+                    BoxFilter(context.pixels.data(), sample_width, sample_height, result.data.data(), result.width, result.height);
             }
             else {
-                if (verbose) std::cout << "Using raw " << format_info.type << " data\n";
-                final_rgba_data = image_data;
+                int bytes_per_pixel = type == "L8" ? 1 : type == "RGB565_LE" ? 2 : 4;
+                if (payload_size < static_cast<size_t>(width) * height * bytes_per_pixel) {
+                    LogError("SCT ConvertToThumbnail: " + type + " data too small");
+                    return {};
+                }
+                SamplePixels(payload, type, bytes_per_pixel, width, height, result.data.data(), result.width, result.height);
             }
+            TrimContext(context);
 
-            if (final_rgba_data.empty() || final_rgba_data.size() < static_cast<size_t>(width) * height * 4) {
-                if (verbose) std::cout << "Error: No valid image data produced\n";
-                LogError("SCT ConvertToRGBA: RGBA buffer invalid size");
+            if (!decoded) {
+                LogError("SCT ConvertToThumbnail: " + type + " decode failed");
                 return {};
             }
-
-            RGBAImage result;
-            result.data = std::move(final_rgba_data);
-            result.width = width;
-            result.height = height;
             return result;
-
         }
         catch (const std::exception& e) {
+            TrimContext(context);
             if (verbose) std::cout << "Error during conversion: " << e.what() << "\n";
-            LogError(std::string("SCT ConvertToRGBA exception: ") + e.what());
+            LogError(std::string("SCT ConvertToThumbnail exception: ") + e.what());
             return {};
         }
     }
 
-    std::vector<uint8_t> ConvertToPNG(const std::vector<uint8_t>& data, bool verbose) {
-        RGBAImage rgba = ConvertToRGBA(data, verbose);
-        if (rgba.data.empty()) return {};
+    bool ConvertToPNG(const uint8_t* data, size_t size, PngWriter::Level level, std::vector<uint8_t>& out,
+        DecodeContext& context, bool verbose) {
+        int width = 0;
+        int height = 0;
+        bool decoded = DecodeImage(data, size, context, verbose, "SCT ConvertToPNG", width, height,
+            [&](int w, int h) {
+                context.pixels.resize(static_cast<size_t>(w) * h * 4);
+                return context.pixels.data();
+            });
+        bool encoded = decoded && PngWriter::EncodeRGBA(context.pixels.data(), width, height, level, out);
+        TrimContext(context);
+        if (decoded && !encoded) {
+            if (verbose) std::cout << "Error: PNG encoding failed\n";
+            LogError("SCT ConvertToPNG: PNG encoding failed");
+        }
+        return encoded;
+    }
 
+    std::vector<uint8_t> ConvertToPNG(const std::vector<uint8_t>& data, bool verbose, PngWriter::Level level) {
         std::vector<uint8_t> png_data;
-        auto write_func = [](void* context, void* data, int size) {
-            auto* vec = static_cast<std::vector<uint8_t>*>(context);
-            uint8_t* bytes = static_cast<uint8_t*>(data);
-            vec->insert(vec->end(), bytes, bytes + size);
-        };
+        if (!ConvertToPNG(data.data(), data.size(), level, png_data, ThreadDecodeContext(), verbose))
+            return {};
+        return png_data;
+    }
 
-        int result = stbi_write_png_to_func(write_func, &png_data, rgba.width, rgba.height, 4,
-            rgba.data.data(), rgba.width * 4);
+    std::vector<uint8_t> ConvertToKTX2(const std::vector<uint8_t>& data, bool verbose) {
+        DecodeContext& context = ThreadDecodeContext();
+        try {
+            Header header;
+            PixelFormatInfo format_info;
+            const uint8_t* payload = nullptr;
+            size_t payload_size = 0;
+            if (!ReadPayload(data.data(), data.size(), verbose, header, format_info, context.payload, payload, payload_size))
+                return {};
 
-        if (result == 0) {
-            if (verbose) std::cout << "Error: PNG encoding failed\n";
-            LogError("SCT ConvertToPNG: PNG encoding failed");
+            Ktx2Format format;
+            if (!GetKtx2Format(format_info.type, format)) {
+                LogError("SCT ConvertToKTX2: no KTX2 format for " + format_info.type);
+                return {};
+            }
+
+            int width = header.width;
+            int height = header.height;
+            if (width <= 0 || height <= 0 || width > 16384 || height > 16384) {
+                LogError("SCT ConvertToKTX2: invalid dimensions");
+                return {};
+            }
+
+            // Only the base level is kept; anything past it is dropped.
+            size_t blocks_x = (width + format.block_width - 1) / format.block_width;
+            size_t blocks_y = (height + format.block_height - 1) / format.block_height;
+            size_t level_size = blocks_x * blocks_y * format.block_bytes;
+            if (payload_size < level_size) {
+                LogError("SCT ConvertToKTX2: " + format_info.type + " data too small: expected " +
+                    std::to_string(level_size) + ", got " + std::to_string(payload_size));
+                return {};
+            }
+
+            if (verbose) std::cout << "Wrapping " << format_info.type << " in KTX2 (" << level_size << " bytes)\n";
+            std::vector<uint8_t> ktx2 = WriteKtx2(format, width, height, payload, level_size);
+            TrimContext(context);
+            return ktx2;
+        }
+        catch (const std::exception& e) {
+            TrimContext(context);
+            if (verbose) std::cout << "Error during conversion: " << e.what() << "\n";
+            LogError(std::string("SCT ConvertToKTX2 exception: ") + e.what());
             return {};
         }
+    }
 
-        return png_data;
+    bool Probe(const uint8_t* data, size_t size, ProbeInfo& info) {
+        Format format_type = DetectFormat(data, size);
+        Header header;
+        if (format_type == Format::SCT2 && size >= 34)
+            header = ParseSCT2Header(data, size);
+        else if (format_type == Format::SCT && size >= 9)
+            header = ParseSCTHeader(data, size);
+        else
+            return false;
+        if (header.data_offset < 0 || static_cast<size_t>(header.data_offset) > size)
+            return false;
+
+        const uint8_t* payload = data + header.data_offset;
+        size_t payload_size = size - header.data_offset;
+        uint64_t declared = 0;
+        bool lz4 = false;
+        // Same decisions as ReadPayload, taken from the header and the size
+        // prefix instead of by decompressing.
+        if (format_type == Format::SCT) {
+            lz4 = PeekLZ4Size(payload, payload_size, declared);
+        }
+        else if (header.raw_data || header.has_alpha) {
+            int expected = ExpectedRawSize(header.width, header.height, header.pixel_format);
+            lz4 = expected > 0 && payload_size < expected * 0.95 &&
+                PeekLZ4Size(payload, payload_size, declared) && declared > payload_size;
+        }
+        else if (header.pixel_format == 40 || header.compressed) {
+            lz4 = PeekLZ4Size(payload, payload_size, declared);
+        }
+
+        info.container = format_type == Format::SCT2 ? "SCT2" : "SCT";
+        info.pixel_format = header.pixel_format;
+        info.pixel_type = GetPixelFormatInfo(header.pixel_format).type;
+        info.width = header.width;
+        info.height = header.height;
+        info.texture_width = header.texture_width;
+        info.texture_height = header.texture_height;
+        info.flags = header.flags;
+        info.lz4 = lz4;
+        info.compressed_size = payload_size;
+        info.decompressed_size = lz4 ? declared : payload_size;
+        return true;
     }
 
 }
@@ -5,6 +5,7 @@
 #include <map>
 #include <tuple>
 #include <astcenc.h>
+#include "PngWriter.h"
 
 namespace SCTParser {
     struct RGBAImage {
@@ -13,6 +14,57 @@ namespace SCTParser {
         int height = 0;
     };
 
+    // Scratch buffers reused from one decode to the next, so repeated calls stop
+    // allocating once they have seen their largest texture. Buffers over 64 MiB
+    // are freed after each call. A context must not be used by two threads at once.
+    struct DecodeContext {
+        std::vector<uint8_t> payload;       // LZ4 output
+        std::vector<uint8_t> sample;        // block subset for thumbnails
+        std::vector<uint8_t> pixels;        // RGBA staging for PNG and thumbnails
+    };
+
+    // The calling thread's own context; the functions without a context
+    // parameter use it.
+    DecodeContext& ThreadDecodeContext();
+
+    // Decode straight from data without copying it. The dst form needs
+    // width * height * 4 bytes, which Probe reports up front; the RGBAImage
+    // form resizes image.data, reusing its capacity.
+    bool DecodeRGBA(const uint8_t* data, size_t size, uint8_t* dst, size_t dst_size,
+        DecodeContext& context, bool verbose = false);
+    bool DecodeRGBA(const uint8_t* data, size_t size, RGBAImage& image, DecodeContext& context, bool verbose = false);
+    // Appends the PNG to out; the decoded pixels are staged in context.
+    bool ConvertToPNG(const uint8_t* data, size_t size, PngWriter::Level level, std::vector<uint8_t>& out,
+        DecodeContext& context, bool verbose = false);
+
     RGBAImage ConvertToRGBA(const std::vector<uint8_t>& data, bool verbose = false);
-    std::vector<uint8_t> ConvertToPNG(const std::vector<uint8_t>& data, bool verbose = false);
+    // Decodes a reduced copy whose longer side is at most max_size; smaller
+    // images come back at full size. ASTC/ETC2 decode only an evenly spaced
+    // subset of blocks and box-filter it down, so fine detail can alias. Raw
+    // formats sample one pixel per thumbnail pixel.
+    RGBAImage ConvertToThumbnail(const std::vector<uint8_t>& data, int max_size, bool verbose = false);
+    std::vector<uint8_t> ConvertToPNG(const std::vector<uint8_t>& data, bool verbose = false,
+        PngWriter::Level level = PngWriter::Level::Default);
+    // Wraps the stored ASTC/ETC2 blocks (or raw pixels) in a KTX2 file without
+    // decoding them. Returns empty for formats KTX2 cannot describe.
+    std::vector<uint8_t> ConvertToKTX2(const std::vector<uint8_t>& data, bool verbose = false);
+
+    // Header fields of an SCT/SCT2 file, read without decompressing or decoding.
+    struct ProbeInfo {
+        std::string container;              // "SCT" or "SCT2"
+        int pixel_format = 0;               // format code as stored
+        std::string pixel_type;             // e.g. "ASTC_4x4", "ETC2_RGBA8", "UNKNOWN"
+        int width = 0;
+        int height = 0;
+        int texture_width = 0;
+        int texture_height = 0;
+        uint8_t flags = 0;                  // SCT2 flag byte, 0 for SCT
+        bool lz4 = false;                   // payload is LZ4 compressed
+        uint64_t compressed_size = 0;       // payload bytes as stored
+        uint64_t decompressed_size = 0;     // payload bytes after LZ4 (compressed_size if stored raw)
+    };
+
+    // size is the size of the whole file; only the header and the LZ4 size
+    // prefix are read. Returns false if data is not a complete SCT/SCT2 header.
+    bool Probe(const uint8_t* data, size_t size, ProbeInfo& info);
 }
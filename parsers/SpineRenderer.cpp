@@ -2,14 +2,14 @@
 #include "SpineRenderer.h"
 #include "SpineDictionary.h"
 #include "archive/IArchive.h"
-#include "SCSPParser.h"
+#include "SCSPSkeletonData.h"
 #include "SCTParser.h"
 
 #include "core/Logger.h"
-#include "json.hpp"
 
 #include <SDL.h>
 #include <SDL_image.h>
+#include <cmath>
 #include <cstring>
 #include <algorithm>
 
@@ -262,7 +262,8 @@ void SpineViewer::unload() {
     textureLoader.clearTextures();
     boneOverrides.clear();
     textureSwaps.clear();
-    originalJson.clear();
+    scspReader.reset();
+    failedAnimations.clear();
     errorMsg.clear();
     selectedBoneIndex = -1;
     boundsComputed = false;
@@ -301,14 +302,12 @@ bool SpineViewer::loadSkeleton(const SpineDictionary& dict, IArchive& pack, cons
 
     dict.EnsureDetailsLoaded(pack, entry);
 
-    // 1. Read and convert SCSP to JSON
-    std::string jsonStr;
+    // 1. Read and decode SCSP
     try {
         std::vector<uint8_t> scspData = pack.GetFileData(*entry.scsp_node);
         if (scspData.empty()) { errorMsg = "Failed to read SCSP file"; LogError("SpineViewer: " + errorMsg); return false; }
-        jsonStr = SCSPParser::ConvertSCSPToJson(scspData);
-        if (jsonStr.empty()) { errorMsg = "Failed to convert SCSP to JSON"; LogError("SpineViewer: " + errorMsg); return false; }
-        originalJson = jsonStr;
+        scspReader = std::make_unique<SCSPParser::SkeletonReader>(scspData);
+        failedAnimations.assign(scspReader->GetAnimations().size(), false);
     } catch (const std::exception& e) {
         errorMsg = std::string("SCSP parse error: ") + e.what();
         LogError("SpineViewer: " + errorMsg);
@@ -415,13 +414,13 @@ bool SpineViewer::loadSkeleton(const SpineDictionary& dict, IArchive& pack, cons
         return false;
     }
 
-    // 5. Load skeleton data from JSON
+    // 5. Build skeleton data from the decoded SCSP
     try {
-        spine::SkeletonJson json(atlas);
-        json.setScale(1.0f);
-        skeletonData = json.readSkeletonData(jsonStr.c_str());
+        spine::AtlasAttachmentLoader loader(atlas);
+        std::string buildError;
+        skeletonData = SCSPParser::BuildSkeletonData(scspReader->GetSkeleton(), loader, buildError);
         if (!skeletonData) {
-            errorMsg = "Failed to parse skeleton JSON";
+            errorMsg = "Failed to build skeleton: " + buildError;
             LogError("SpineViewer: " + errorMsg);
             return false;
         }
@@ -445,9 +444,9 @@ bool SpineViewer::loadSkeleton(const SpineDictionary& dict, IArchive& pack, cons
         stateData->setDefaultMix(0.2f);
         animState = new spine::AnimationState(stateData);
 
-        auto& anims = skeletonData->getAnimations();
-        if (anims.size() > 0) {
-            animState->setAnimation(0, anims[0]->getName(), true);
+        spine::Animation* first = scspReader->GetAnimations().empty() ? nullptr : loadAnimation(0);
+        if (first) {
+            animState->setAnimation(0, first, true);
         }
     } catch (const std::exception& e) {
         errorMsg = std::string("Exception creating skeleton instance: ") + e.what();
@@ -934,9 +933,8 @@ void SpineViewer::cleanupFBO() {
 std::vector<std::string> SpineViewer::getAnimationNames() const {
     std::vector<std::string> names;
     if (!skeletonData) return names;
-    auto& anims = skeletonData->getAnimations();
-    for (size_t i = 0; i < anims.size(); i++) {
-        names.push_back(std::string(anims[i]->getName().buffer()));
+    for (const auto& anim : scspReader->GetAnimations()) {
+        names.push_back(anim.name);
     }
     return names;
 }
@@ -951,14 +949,36 @@ std::vector<std::string> SpineViewer::getSkinNames() const {
     return names;
 }
 
+// Builds the animation from the SCSP on first use; later calls find it in
+// skeletonData. Returns nullptr (and logs, once) when it does not resolve.
+spine::Animation* SpineViewer::loadAnimation(size_t index) {
+    if (failedAnimations[index]) return nullptr;
+    const SCSPParser::AnimationEntry& entry = scspReader->GetAnimations()[index];
+    spine::Animation* anim = skeletonData->findAnimation(spine::String(entry.name.c_str()));
+    if (anim) return anim;
+
+    std::string buildError;
+    anim = SCSPParser::BuildAnimation(*skeletonData, entry.name, scspReader->ReadAnimation(index), buildError);
+    if (!anim) {
+        LogError("SpineViewer: Failed to build animation " + entry.name + ": " + buildError);
+        failedAnimations[index] = true;
+        return nullptr;
+    }
+    skeletonData->getAnimations().add(anim);
+    return anim;
+}
+
 void SpineViewer::setAnimation(const std::string& name, bool loop) {
     if (!animState || !skeletonData) return;
-    animState->setAnimation(0, spine::String(name.c_str()), loop);
-    // Track current index for autoplay
-    auto& anims = skeletonData->getAnimations();
+    auto& anims = scspReader->GetAnimations();
     for (size_t i = 0; i < anims.size(); i++) {
-        if (std::string(anims[i]->getName().buffer()) == name) {
-            currentAnimIndex = (int)i;
+        if (anims[i].name == name) {
+            spine::Animation* anim = loadAnimation(i);
+            if (anim) {
+                animState->setAnimation(0, anim, loop);
+                // Track current index for autoplay
+                currentAnimIndex = (int)i;
+            }
             break;
         }
     }
@@ -966,10 +986,18 @@ void SpineViewer::setAnimation(const std::string& name, bool loop) {
 
 void SpineViewer::nextAnimation() {
     if (!animState || !skeletonData) return;
-    auto& anims = skeletonData->getAnimations();
+    auto& anims = scspReader->GetAnimations();
     if (anims.size() == 0) return;
-    currentAnimIndex = (currentAnimIndex + 1) % (int)anims.size();
-    animState->setAnimation(0, anims[currentAnimIndex]->getName(), !autoplayNext);
+    // Skips animations that fail to build rather than stopping on them.
+    for (size_t step = 1; step <= anims.size(); step++) {
+        size_t index = (currentAnimIndex + step) % anims.size();
+        spine::Animation* anim = loadAnimation(index);
+        if (anim) {
+            animState->setAnimation(0, anim, !autoplayNext);
+            currentAnimIndex = (int)index;
+            return;
+        }
+    }
 }
 
 void SpineViewer::setSkin(const std::string& name) {
@@ -1221,32 +1249,27 @@ void SpineViewer::resetTextureSwaps() {
 // ============================================================================
 
 std::string SpineViewer::getModifiedSkeletonJson() const {
-    if (originalJson.empty()) return "";
-    if (boneOverrides.empty()) return originalJson;
+    if (!scspReader) return "";
 
     try {
-        // Parse, modify bone scales, re-serialize
-        // Using nlohmann json (already included via json.hpp)
-        auto j = nlohmann::ordered_json::parse(originalJson);
-        if (j.contains("bones") && j["bones"].is_array()) {
-            for (auto& bone : j["bones"]) {
-                if (!bone.contains("name")) continue;
-                std::string name = bone["name"].get<std::string>();
-                auto it = boneOverrides.find(name);
-                if (it != boneOverrides.end()) {
-                    bone["x"] = it->second.x;
-                    bone["y"] = it->second.y;
-                    bone["rotation"] = it->second.rotation;
-                    bone["scaleX"] = it->second.scaleX;
-                    bone["scaleY"] = it->second.scaleY;
-                    bone["shearX"] = it->second.shearX;
-                    bone["shearY"] = it->second.shearY;
-                }
-            }
+        // JSON is only produced here, from a full decode with the bone edits applied
+        SCSPParser::Skeleton modified = scspReader->ReadAll();
+        if (boneOverrides.empty()) return SCSPParser::ToJson(modified);
+
+        for (auto& bone : modified.bones) {
+            auto it = boneOverrides.find(bone.name);
+            if (it == boneOverrides.end()) continue;
+            bone.x = it->second.x;
+            bone.y = it->second.y;
+            bone.rotation = it->second.rotation;
+            bone.scale_x = it->second.scaleX;
+            bone.scale_y = it->second.scaleY;
+            bone.shear_x = it->second.shearX;
+            bone.shear_y = it->second.shearY;
         }
-        return j.dump(2);
+        return SCSPParser::ToJson(modified);
     } catch (const std::exception& e) {
         LogError("getModifiedSkeletonJson: " + std::string(e.what()));
-        return originalJson;
+        return "";
     }
 }
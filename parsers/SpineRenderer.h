@@ -8,6 +8,8 @@
 #include <vector>
 #include <memory>
 
+#include "SCSPParser.h"
+
 class IArchive;
 struct SpineEntry;
 class SpineDictionary;
@@ -179,6 +181,7 @@ private:
     void computeStableBounds();
     void screenToWorld(float sx, float sy, int vpW, int vpH, float& wx, float& wy);
     void applyBoneOverrides();
+    spine::Animation* loadAnimation(size_t index);
 
     // Spine objects
     PackTextureLoader textureLoader;
@@ -221,8 +224,11 @@ private:
     std::map<std::string, std::string> textureSwaps;
     std::vector<GLuint> swappedTextures; // GL textures to clean up
 
-    // Original JSON for export
-    std::string originalJson;
+    // SCSP the skeleton data was built from; exported as JSON. Animations are
+    // decoded and added to skeletonData the first time they are played.
+    std::unique_ptr<SCSPParser::SkeletonReader> scspReader;
+    // Animations that failed to build, by index, so they are not decoded again.
+    std::vector<bool> failedAnimations;
 
     std::vector<GLuint> ownedTextures;
 };
@@ -0,0 +1,226 @@
+// Differential check of Core::LZ4DecodeBlock: round trips through
+// LZ4CompressBlock, hand-built edge cases, and corrupted blocks decoded by both
+// the fast decoder and a byte-at-a-time reference that follows the format.
+#include "core/LZ4.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void fail(const std::string& message)
+    {
+        if (++failures <= 20)
+            std::fprintf(stderr, "FAIL: %s\n", message.c_str());
+    }
+
+    // Same contract as LZ4DecodeBlock, without fast paths or wild copies.
+    size_t reference_decode(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size, bool& ok)
+    {
+        size_t ip = 0, op = 0;
+        ok = true;
+        auto read_length = [&](size_t& length)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= src_size)
+                    return false;
+                b = src[ip++];
+                length += b;
+            } while (b == 255);
+            return true;
+        };
+
+        while (ip < src_size && op < dst_size)
+        {
+            uint8_t token = src[ip++];
+            size_t literal_length = token >> 4;
+            if (literal_length == 15 && !read_length(literal_length))
+                return ok = false, op;
+            if (literal_length > src_size - ip)
+                return ok = false, op;
+            if (literal_length > dst_size - op)
+            {
+                std::memcpy(dst + op, src + ip, dst_size - op);
+                return dst_size;
+            }
+            std::memcpy(dst + op, src + ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+            if (ip >= src_size || op >= dst_size)
+                break;
+
+            if (src_size - ip < 2)
+                return ok = false, op;
+            size_t offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > op)
+                return ok = false, op;
+            size_t match_length = token & 0x0F;
+            if (match_length == 15 && !read_length(match_length))
+                return ok = false, op;
+            match_length += 4;
+            for (size_t i = 0; i < match_length && op < dst_size; ++i, ++op)
+                dst[op] = dst[op - offset];
+        }
+        return op;
+    }
+
+    // Decodes with both decoders into exactly dst_size bytes (so ASan sees any
+    // overrun) and checks they agree on validity and on the bytes written.
+    void compare(const std::vector<uint8_t>& block, size_t dst_size, const std::string& what)
+    {
+        std::vector<uint8_t> fast(dst_size), reference(dst_size);
+        bool fast_ok = true, reference_ok = true;
+        size_t fast_written = Core::LZ4DecodeBlock(block.data(), block.size(), fast.data(), fast.size(), &fast_ok);
+        size_t reference_written = reference_decode(block.data(), block.size(), reference.data(), reference.size(), reference_ok);
+        if (fast_ok != reference_ok || fast_written != reference_written)
+        {
+            fail(what + ": decoders disagree (ok " + std::to_string(fast_ok) + "/" + std::to_string(reference_ok) +
+                 ", written " + std::to_string(fast_written) + "/" + std::to_string(reference_written) + ")");
+            return;
+        }
+        if (fast_written && std::memcmp(fast.data(), reference.data(), fast_written) != 0)
+            fail(what + ": decoded bytes differ");
+    }
+
+    void round_trip(const std::vector<uint8_t>& input, const std::string& what)
+    {
+        std::vector<uint8_t> block;
+        Core::LZ4CompressBlock(input.data(), input.size(), block);
+        std::vector<uint8_t> out(input.size());
+        bool ok = false;
+        size_t written = Core::LZ4DecodeBlock(block.data(), block.size(), out.data(), out.size(), &ok);
+        if (!ok || written != input.size() || out != input)
+            fail(what + ": round trip failed");
+
+        // Smaller destinations keep the prefix that fits.
+        for (size_t dst_size : { input.size() / 2, input.size() > 7 ? input.size() - 7 : size_t(0), size_t(1) })
+        {
+            if (dst_size > input.size())
+                continue;
+            std::vector<uint8_t> prefix(dst_size);
+            written = Core::LZ4DecodeBlock(block.data(), block.size(), prefix.data(), prefix.size(), &ok);
+            if (!ok || written != dst_size || !std::equal(prefix.begin(), prefix.end(), input.begin()))
+                fail(what + ": truncated decode to " + std::to_string(dst_size) + " failed");
+        }
+        compare(block, input.size(), what);
+    }
+
+    std::vector<uint8_t> make_input(std::mt19937& rng, size_t size)
+    {
+        std::vector<uint8_t> data;
+        data.reserve(size);
+        while (data.size() < size)
+        {
+            switch (rng() % 4)
+            {
+            case 0: // noise
+                for (uint32_t n = rng() % 64; n > 0; --n)
+                    data.push_back(static_cast<uint8_t>(rng()));
+                break;
+            case 1: // run of one byte
+                data.insert(data.end(), 1 + rng() % 600, static_cast<uint8_t>(rng()));
+                break;
+            default: // repeat a short recent pattern, overlapping matches
+                if (data.empty())
+                    break;
+                size_t offset = 1 + rng() % std::min<size_t>(data.size(), rng() % 2 ? 20 : 70000);
+                for (uint32_t n = 4 + rng() % 300; n > 0; --n)
+                    data.push_back(data[data.size() - offset]);
+                break;
+            }
+        }
+        data.resize(size);
+        return data;
+    }
+
+    void expect_rejected(const std::vector<uint8_t>& block, size_t dst_size, const std::string& what)
+    {
+        std::vector<uint8_t> out(dst_size);
+        bool ok = true;
+        Core::LZ4DecodeBlock(block.data(), block.size(), out.data(), out.size(), &ok);
+        if (ok)
+            fail(what + ": malformed block accepted");
+        compare(block, dst_size, what);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(20240611);
+
+    for (size_t size : { 0, 1, 5, 12, 13, 16, 17, 31, 64, 255, 256, 4096, 65536, 300000 })
+        round_trip(make_input(rng, size), "size " + std::to_string(size));
+    for (int seed = 0; seed < 200; ++seed)
+        round_trip(make_input(rng, rng() % 20000), "random input " + std::to_string(seed));
+
+    // Literal and match lengths continued past 255, short overlapping offsets.
+    {
+        std::vector<uint8_t> block = { 0xFF, 255, 255, 10 };
+        block.insert(block.end(), 15 + 255 + 255 + 10, 'a');
+        block.insert(block.end(), { 1, 0, 255, 40 });
+        block.push_back(0x50);
+        block.insert(block.end(), 5, 'z');
+        compare(block, (15 + 255 + 255 + 10) + (15 + 255 + 40 + 4) + 5, "long lengths");
+    }
+    for (int offset = 1; offset <= 20; ++offset)
+    {
+        std::vector<uint8_t> block;
+        if (offset < 15)
+            block.push_back(static_cast<uint8_t>(offset << 4 | 0x0F));
+        else
+            block.insert(block.end(), { 0xFF, static_cast<uint8_t>(offset - 15) });
+        for (int i = 0; i < offset; ++i)
+            block.push_back(static_cast<uint8_t>('A' + i));
+        block.insert(block.end(), { static_cast<uint8_t>(offset), 0, 50 });
+        compare(block, offset + 69, "offset " + std::to_string(offset));
+        compare(block, offset + 30, "offset " + std::to_string(offset) + " into short dst");
+    }
+
+    // Blocks every decoder must refuse.
+    expect_rejected({ 0x10, 'a', 0, 0 }, 64, "zero offset");
+    expect_rejected({ 0x10, 'a', 2, 0 }, 64, "offset before output start");
+    expect_rejected({ 0xF0, 255, 255 }, 64, "truncated literal length");
+    expect_rejected({ 0x50, 'a', 'b' }, 64, "literals past input end");
+    expect_rejected({ 0x1F, 'a', 1, 0, 255 }, 64, "truncated match length");
+    expect_rejected({ 0x10, 'a', 1 }, 64, "truncated offset");
+
+    // Corrupted and truncated blocks: both decoders must agree byte for byte.
+    for (int seed = 0; seed < 3000; ++seed)
+    {
+        std::vector<uint8_t> input = make_input(rng, 1 + rng() % 4000);
+        std::vector<uint8_t> block;
+        Core::LZ4CompressBlock(input.data(), input.size(), block);
+        switch (seed % 3)
+        {
+        case 0:
+            for (uint32_t n = 1 + rng() % 4; n > 0; --n)
+                block[rng() % block.size()] = static_cast<uint8_t>(rng());
+            break;
+        case 1:
+            block.resize(rng() % block.size());
+            break;
+        default:
+            for (auto& b : block)
+                b = static_cast<uint8_t>(rng());
+            break;
+        }
+        size_t dst_size = rng() % 2 ? input.size() : rng() % (2 * input.size() + 1);
+        compare(block, dst_size, "corrupted block " + std::to_string(seed));
+    }
+
+    if (failures)
+    {
+        std::fprintf(stderr, "%d LZ4 checks failed\n", failures);
+        return 1;
+    }
+    std::printf("LZ4 decoder checks passed\n");
+    return 0;
+}
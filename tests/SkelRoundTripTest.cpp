@@ -0,0 +1,161 @@
+// Synthetic SCSP skeletons written as .skel and as JSON must load in
+// spine-cpp into the same skeleton data that BuildSkeletonData builds
+// directly: bones, slots, skins, attachments and animation timelines.
+#include "bench/SyntheticPack.h"
+#include "parsers/SCSPParser.h"
+#include "parsers/SCSPSkeletonData.h"
+#include <spine/spine.h>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+spine::SpineExtension* spine::getDefaultExtension()
+{
+    return new spine::DefaultSpineExtension();
+}
+
+namespace
+{
+    int failures = 0;
+
+    void fail(const std::string& message)
+    {
+        if (++failures <= 20)
+            std::fprintf(stderr, "FAIL: %s\n", message.c_str());
+    }
+
+    // Attachments without an atlas; only their names and kinds matter here.
+    class StubLoader : public spine::AttachmentLoader
+    {
+    public:
+        spine::RegionAttachment* newRegionAttachment(spine::Skin&, const spine::String& name, const spine::String&) override { return new spine::RegionAttachment(name); }
+        spine::MeshAttachment* newMeshAttachment(spine::Skin&, const spine::String& name, const spine::String&) override { return new spine::MeshAttachment(name); }
+        spine::BoundingBoxAttachment* newBoundingBoxAttachment(spine::Skin&, const spine::String& name) override { return new spine::BoundingBoxAttachment(name); }
+        spine::PathAttachment* newPathAttachment(spine::Skin&, const spine::String& name) override { return new spine::PathAttachment(name); }
+        spine::PointAttachment* newPointAttachment(spine::Skin&, const spine::String& name) override { return new spine::PointAttachment(name); }
+        spine::ClippingAttachment* newClippingAttachment(spine::Skin&, const spine::String& name) override { return new spine::ClippingAttachment(name); }
+        void configureAttachment(spine::Attachment*) override {}
+    };
+
+    std::string name_of(const spine::String& name)
+    {
+        return name.buffer() ? name.buffer() : "";
+    }
+
+    // One line per fact compared, so a mismatch can name the first difference.
+    std::vector<std::string> summarize(spine::SkeletonData& data)
+    {
+        std::vector<std::string> lines;
+        auto& bones = data.getBones();
+        for (size_t i = 0; i < bones.size(); ++i)
+            lines.push_back("bone " + name_of(bones[i]->getName()) + " parent " + (bones[i]->getParent() ? name_of(bones[i]->getParent()->getName()) : "-"));
+        auto& slots = data.getSlots();
+        for (size_t i = 0; i < slots.size(); ++i)
+            lines.push_back("slot " + name_of(slots[i]->getName()) + " bone " + name_of(slots[i]->getBoneData().getName()) + " attachment " + name_of(slots[i]->getAttachmentName()));
+        auto& skins = data.getSkins();
+        for (size_t i = 0; i < skins.size(); ++i)
+        {
+            size_t count = 0;
+            for (auto entries = skins[i]->getAttachments(); entries.hasNext(); entries.next())
+                ++count;
+            lines.push_back("skin " + name_of(skins[i]->getName()) + " attachments " + std::to_string(count));
+        }
+        auto& animations = data.getAnimations();
+        for (size_t i = 0; i < animations.size(); ++i)
+        {
+            // Durations go through text in the JSON, so compare them to a millisecond.
+            std::string line = "animation " + name_of(animations[i]->getName()) + " duration " + std::to_string(std::lround(animations[i]->getDuration() * 1000.0f)) + " timelines";
+            auto& timelines = animations[i]->getTimelines();
+            for (size_t t = 0; t < timelines.size(); ++t)
+            {
+                // A deform timeline's id includes a process-wide attachment
+                // counter, so it names the slot and attachment instead.
+                if (timelines[t]->getRTTI().isExactly(spine::DeformTimeline::rtti))
+                {
+                    auto* deform = static_cast<spine::DeformTimeline*>(timelines[t]);
+                    line += " deform " + std::to_string(deform->getSlotIndex()) + " " + name_of(deform->getAttachment()->getName());
+                }
+                else
+                    line += " " + std::to_string(timelines[t]->getPropertyId());
+            }
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    void compare(const std::vector<std::string>& expected, const std::vector<std::string>& actual, const std::string& what)
+    {
+        for (size_t i = 0; i < expected.size() && i < actual.size(); ++i)
+        {
+            if (expected[i] != actual[i])
+            {
+                fail(what + ": \"" + actual[i] + "\", expected \"" + expected[i] + "\"");
+                return;
+            }
+        }
+        if (expected.size() != actual.size())
+            fail(what + ": " + std::to_string(actual.size()) + " entries, expected " + std::to_string(expected.size()));
+    }
+
+    void check(uint32_t seed)
+    {
+        const std::string what = "seed " + std::to_string(seed);
+        SCSPParser::Skeleton skeleton = SCSPParser::ReadSkeleton(Bench::MakeSCSP(seed, 8 + seed % 24, 1 + seed % 4));
+        StubLoader loader;
+
+        std::string error;
+        std::unique_ptr<spine::SkeletonData> built(SCSPParser::BuildSkeletonData(skeleton, loader, error));
+        if (!built)
+        {
+            fail(what + ": BuildSkeletonData failed: " + error);
+            return;
+        }
+        std::vector<std::string> expected = summarize(*built);
+
+        std::vector<uint8_t> skel = SCSPParser::ToBinary(skeleton);
+        spine::SkeletonBinary binary(&loader);
+        std::unique_ptr<spine::SkeletonData> from_binary(binary.readSkeletonData(skel.data(), static_cast<int>(skel.size())));
+        if (from_binary)
+            compare(expected, summarize(*from_binary), what + " .skel");
+        else
+            fail(what + ": SkeletonBinary failed: " + name_of(binary.getError()));
+
+        // spine-cpp 3.8 reads booleans as numbers and takes true and false for 0.
+        std::string json = SCSPParser::ToJson(skeleton);
+        for (size_t at; (at = json.find(": true")) != std::string::npos;)
+            json.replace(at, 6, ": 1");
+        for (size_t at; (at = json.find(": false")) != std::string::npos;)
+            json.replace(at, 7, ": 0");
+        spine::SkeletonJson reader(&loader);
+        std::unique_ptr<spine::SkeletonData> from_json(reader.readSkeletonData(json.c_str()));
+        if (from_json)
+            compare(expected, summarize(*from_json), what + " JSON");
+        else
+            fail(what + ": SkeletonJson failed: " + name_of(reader.getError()));
+    }
+}
+
+int main()
+{
+    for (uint32_t seed = 1; seed <= 40; ++seed)
+    {
+        try
+        {
+            check(seed);
+        }
+        catch (const std::exception& e)
+        {
+            fail("seed " + std::to_string(seed) + ": " + e.what());
+        }
+    }
+
+    if (failures)
+    {
+        std::fprintf(stderr, "%d skeleton round trips failed\n", failures);
+        return 1;
+    }
+    std::printf("Skeleton round trips passed\n");
+    return 0;
+}